@@ -10,156 +10,28 @@ Authors:
 #include <limits>
 #include <cctype>
 
-using namespace std;
-
-/**
-* Function to create an array of integers of size n
-* @param n the size of the array
-* @return the pointer to the array
- */
-int* createArray(int n) {
-    int* arr = new int[n];
-    return arr;
-}
+#include "BatchMode.h"
+#include "Benchmarks.h"
+#include "MyArray.h"
+#include "Triangle.h"
 
-/**
-* Function to initialize the array with values from 0 to n-1
-* @param arr the array to initialize
-* @param n the size of the array
- */
-
-void initializeArray(int* arr, int n) {
-    for (int i = 0; i < n; i++) {
-        arr[i] = i;
-    }
-}
+using namespace std;
 
 /**
 * Function to print the array
 * @param arr the array to print
  */
-void printArray(int* arr, int n) {
+void printArray(const MyArray<int>& arr) {
     cout << "Array: [";
-    for (int i = 0; i < n; i++) {
+    for (size_t i = 0; i < arr.size(); i++) {
         cout << arr[i];
-        if (i < n - 1) {
+        if (i < arr.size() - 1) {
             cout << ", ";
         }
     }
     cout << "]\n";
 }
 
-/**
-* Function to delete the array
-* @param arr the array to delete
- */
-void deleteArray(int* arr) {
-    delete[] arr;
-}
-
-// Point class definition
-class Point {
-private:
-    int x, y, z;
-
-public:
-    Point(int x = 0, int y = 0, int z = 0) : x(x), y(y), z(z) {}
-
-    ~Point() {
-        cout << "Point (" << x << ", " << y << ", " << z << ") destroyed.\n";
-    }
-
-    /** 
-    * Translate the point along the specified axis by the given distance.
-    * @param d the distance to translate
-    * @param axis the axis to translate along ('x', 'y', or 'z')
-    * @return 0 if successful, -1 if invalid axis, -2 if distance is not finite
-     */
-    int translate(int d, char axis) {
-        if (!std::isfinite(static_cast<double>(d))) {
-            return -2;
-        }
-        switch (axis) {
-        case 'x':
-            x += d;
-            break;
-        case 'y':
-            y += d;
-            break;
-        case 'z':
-            z += d;
-            break;
-        default:
-            return -1;
-        }
-        return 0;
-    }
-
-    /** 
-    * Display the point in the format (x, y, z).
-     */
-    void display() const {
-        cout << "(" << x << ", " << y << ", " << z << ")";
-    }
-
-    friend class Triangle;
-};
-
-// Triangle class definition
-class Triangle {
-private:
-    Point* vertex_1, * vertex_2, * vertex_3;
-
-public:
-    Triangle() : vertex_1(nullptr), vertex_2(nullptr), vertex_3(nullptr) {}
-
-    Triangle(Point* p1, Point* p2, Point* p3) : vertex_1(p1), vertex_2(p2), vertex_3(p3) {}
-
-    ~Triangle() {
-        delete vertex_1;
-        delete vertex_2;
-        delete vertex_3;
-        cout << "Triangle destroyed.\n";
-    }
-
-    /**
-    * Translate the triangle along the specified axis by the given distance.
-    * @param d the distance to translate
-    * @param axis the axis to translate along ('x', 'y', or 'z')
-     */
-    void translate(int d, char axis) {
-        if (vertex_1) vertex_1->translate(d, axis);
-        if (vertex_2) vertex_2->translate(d, axis);
-        if (vertex_3) vertex_3->translate(d, axis);
-    }
-
-    /**
-    * Calculate the area of the triangle.
-    * @return the area of the triangle
-     */
-    double calcArea() const {
-        double a = sqrt(pow(vertex_2->x - vertex_1->x, 2) + pow(vertex_2->y - vertex_1->y, 2) + pow(vertex_2->z - vertex_1->z, 2));
-        double b = sqrt(pow(vertex_3->x - vertex_2->x, 2) + pow(vertex_3->y - vertex_2->y, 2) + pow(vertex_3->z - vertex_2->z, 2));
-        double c = sqrt(pow(vertex_1->x - vertex_3->x, 2) + pow(vertex_1->y - vertex_3->y, 2) + pow(vertex_1->z - vertex_3->z, 2));
-        double s = (a + b + c) / 2;
-        return sqrt(s * (s - a) * (s - b) * (s - c));
-    }
-
-    /**
-    * Display the triangle vertices.
-     */
-    void display() const {
-        cout << "Triangle vertices:\n";
-        if (vertex_1) vertex_1->display(); else cout << "(null)";
-        cout << "\n";
-        if (vertex_2) vertex_2->display(); else cout << "(null)";
-        cout << "\n";
-        if (vertex_3) vertex_3->display(); else cout << "(null)";
-        cout << "\n";
-    }
-};
-
-
 /**
 * Get a valid integer input from the user.
 * @return the valid integer input
@@ -284,13 +156,22 @@ void menu() {
 }
 
 // Main function
-int main() {
+int main(int argc, char** argv) {
+    // Benchmarks run instead of the menu
+    if (isBenchmarkCommand(argc, argv)) {
+        return runBenchmark(argc, argv);
+    }
+
+    // Commands from a file or standard input instead of the menu
+    if (isBatchCommand(argc, argv)) {
+        return runBatch(argc, argv);
+    }
+
     // Test array functions
-    int* arr = createArray(10);
-    printArray(arr, 10);
-    initializeArray(arr, 10);
-    printArray(arr, 10);
-    deleteArray(arr);
+    MyArray<int> arr(10);
+    printArray(arr);
+    arr.iota(0);
+    printArray(arr);
 
 
     // Start menu
@@ -0,0 +1,332 @@
+#include "BatchMode.h"
+#include "GeometryArena.h"
+#include "Triangle.h"
+
+#include <charconv>
+#include <climits>
+#include <cstring>
+#include <vector>
+
+namespace {
+    // Bytes read from the input stream at a time
+    constexpr size_t kReadBlock = 1 << 20;
+
+    // Output is handed to the stream once this much has built up
+    constexpr size_t kFlushBytes = 1 << 16;
+
+    const size_t kNoTriangle = static_cast<size_t>(-1);
+
+    bool isSpace(char c) {
+        return c == ' ' || c == '\t' || c == '\r';
+    }
+
+    /**
+    * Splits one line into words and integers in place, without iostreams or copies.
+     */
+    class LineTokenizer {
+    public:
+        LineTokenizer(const char* begin, const char* end) : p(begin), end(end) {}
+
+        bool atEnd() {
+            skipSpaces();
+            return p == end;
+        }
+
+        /**
+        * Read the next run of non-space characters.
+        * @return false if the line has no more words
+         */
+        bool word(const char*& start, size_t& length) {
+            skipSpaces();
+            start = p;
+            while (p != end && !isSpace(*p)) {
+                p++;
+            }
+            length = static_cast<size_t>(p - start);
+            return length > 0;
+        }
+
+        /**
+        * Read a decimal integer with an optional sign.
+        * @return false if the next word is not an integer that fits in an int
+         */
+        bool integer(int& value) {
+            skipSpaces();
+            bool negative = false;
+            if (p != end && (*p == '-' || *p == '+')) {
+                negative = *p == '-';
+                p++;
+            }
+            if (p == end || *p < '0' || *p > '9') {
+                return false;
+            }
+            long long magnitude = 0;
+            for (; p != end && *p >= '0' && *p <= '9'; p++) {
+                magnitude = magnitude * 10 + (*p - '0');
+                if (magnitude > static_cast<long long>(INT_MAX) + 1) {
+                    return false;
+                }
+            }
+            const long long result = negative ? -magnitude : magnitude;
+            if (result > INT_MAX || (p != end && !isSpace(*p))) {
+                return false;
+            }
+            value = static_cast<int>(result);
+            return true;
+        }
+
+    private:
+        void skipSpaces() {
+            while (p != end && isSpace(*p)) {
+                p++;
+            }
+        }
+
+        const char* p;
+        const char* end;
+    };
+
+    bool sameWord(const char* start, size_t length, const char* expected) {
+        return length == std::strlen(expected) && std::memcmp(start, expected, length) == 0;
+    }
+
+    /**
+    * Runs commands one line at a time against triangles kept in an arena, appending the
+    * results to a string that is handed to the output stream in large blocks.
+     */
+    class BatchInterpreter {
+    public:
+        BatchInterpreter(std::string& out, std::FILE* sink)
+            : out(out), sink(sink), current(kNoTriangle), lineNumber(0), result{ 0, 0 }, logging(destructorLogging()) {
+            // The results are the only output; the triangles are released silently at the end
+            destructorLogging() = false;
+        }
+
+        ~BatchInterpreter() {
+            arena.release();
+            destructorLogging() = logging;
+        }
+
+        /**
+        * Run one line, given without its newline.
+         */
+        void runLine(const char* begin, const char* end) {
+            lineNumber++;
+            LineTokenizer tokens(begin, end);
+            const char* name;
+            size_t length;
+            if (!tokens.word(name, length) || name[0] == '#') {
+                return;
+            }
+            result.commands++;
+            if (sameWord(name, length, "create")) {
+                create(tokens);
+            }
+            else if (sameWord(name, length, "translate")) {
+                translate(tokens);
+            }
+            else if (sameWord(name, length, "area")) {
+                area(tokens);
+            }
+            else if (sameWord(name, length, "display")) {
+                display(tokens);
+            }
+            else {
+                fail("unknown command");
+            }
+            if (sink && out.size() >= kFlushBytes) {
+                flush();
+            }
+        }
+
+        void flush() {
+            if (sink && !out.empty()) {
+                std::fwrite(out.data(), 1, out.size(), sink);
+                out.clear();
+            }
+        }
+
+        BatchResult counts() const { return result; }
+
+    private:
+        void create(LineTokenizer& tokens) {
+            int c[9];
+            for (int& value : c) {
+                if (!tokens.integer(value)) {
+                    fail("expected 9 integer coordinates");
+                    return;
+                }
+            }
+            if (!tokens.atEnd()) {
+                fail("expected 9 integer coordinates");
+                return;
+            }
+            current = triangles.size();
+            triangles.push_back(arena.makeTriangle(c[0], c[1], c[2], c[3], c[4], c[5], c[6], c[7], c[8]));
+        }
+
+        void translate(LineTokenizer& tokens) {
+            int d;
+            const char* axis;
+            size_t length;
+            if (!tokens.integer(d) || !tokens.word(axis, length) || length != 1 || (axis[0] != 'x' && axis[0] != 'y' && axis[0] != 'z')) {
+                fail("expected a distance and an axis (x, y or z)");
+                return;
+            }
+            if (Triangle* triangle = target(tokens)) {
+                triangle->translate(d, axis[0]);
+            }
+        }
+
+        void area(LineTokenizer& tokens) {
+            if (Triangle* triangle = target(tokens)) {
+                out += "Area: ";
+                appendDouble(triangle->calcArea());
+                out += '\n';
+            }
+        }
+
+        void display(LineTokenizer& tokens) {
+            if (Triangle* triangle = target(tokens)) {
+                out += "Triangle vertices:\n";
+                for (int i = 0; i < 3; i++) {
+                    const Point* vertex = triangle->getVertex(i);
+                    if (!vertex) {
+                        out += "(null)\n";
+                        continue;
+                    }
+                    out += '(';
+                    appendInt(vertex->getX());
+                    out += ", ";
+                    appendInt(vertex->getY());
+                    out += ", ";
+                    appendInt(vertex->getZ());
+                    out += ")\n";
+                }
+            }
+        }
+
+        /**
+        * The triangle named by an optional trailing index, or the current one.
+        * @return null after reporting the problem if there is no such triangle
+         */
+        Triangle* target(LineTokenizer& tokens) {
+            if (!tokens.atEnd()) {
+                int requested;
+                if (!tokens.integer(requested) || !tokens.atEnd()) {
+                    fail("expected a triangle number at the end");
+                    return nullptr;
+                }
+                if (requested < 0 || static_cast<size_t>(requested) >= triangles.size()) {
+                    fail("no triangle with that number");
+                    return nullptr;
+                }
+                return triangles[requested];
+            }
+            if (current == kNoTriangle) {
+                fail("no triangle created");
+                return nullptr;
+            }
+            return triangles[current];
+        }
+
+        void fail(const char* message) {
+            result.errors++;
+            out += "line ";
+            appendInt(static_cast<long long>(lineNumber));
+            out += ": ";
+            out += message;
+            out += '\n';
+        }
+
+        void appendInt(long long value) {
+            char digits[24];
+            const std::to_chars_result written = std::to_chars(digits, digits + sizeof(digits), value);
+            out.append(digits, written.ptr);
+        }
+
+        // Six significant digits, the way cout prints a double by default
+        void appendDouble(double value) {
+            char digits[32];
+            const std::to_chars_result written = std::to_chars(digits, digits + sizeof(digits), value, std::chars_format::general, 6);
+            out.append(digits, written.ptr);
+        }
+
+        GeometryArena arena;
+        std::vector<Triangle*> triangles;
+        std::string& out;
+        std::FILE* sink;
+        size_t current;
+        size_t lineNumber;
+        BatchResult result;
+        bool logging;
+    };
+}
+
+bool isBatchCommand(int argc, char** argv) {
+    return argc >= 2 && std::strcmp(argv[1], "--batch") == 0;
+}
+
+int runBatch(int argc, char** argv) {
+    const bool useStdin = argc < 3 || std::strcmp(argv[2], "-") == 0;
+    std::FILE* in = useStdin ? stdin : std::fopen(argv[2], "rb");
+    if (!in) {
+        std::fprintf(stderr, "Could not open %s\n", argv[2]);
+        return 1;
+    }
+    const BatchResult result = runBatchCommands(in, stdout);
+    if (!useStdin) {
+        std::fclose(in);
+    }
+    std::fflush(stdout);
+    std::fprintf(stderr, "%zu commands, %zu errors\n", result.commands, result.errors);
+    return result.errors == 0 ? 0 : 1;
+}
+
+BatchResult runBatchCommands(std::FILE* in, std::FILE* out) {
+    std::string output;
+    output.reserve(kFlushBytes + 4096);
+    BatchResult result;
+    {
+        BatchInterpreter interpreter(output, out);
+        // Complete lines are run straight out of the read buffer; a partial last line is
+        // moved to the front and finished by the next read
+        std::vector<char> buffer(kReadBlock);
+        size_t filled = 0;
+        while (true) {
+            if (filled == buffer.size()) {
+                buffer.resize(buffer.size() * 2);
+            }
+            const size_t read = std::fread(buffer.data() + filled, 1, buffer.size() - filled, in);
+            filled += read;
+            const char* lineStart = buffer.data();
+            const char* end = buffer.data() + filled;
+            for (const char* newline; (newline = static_cast<const char*>(std::memchr(lineStart, '\n', end - lineStart))) != nullptr; lineStart = newline + 1) {
+                interpreter.runLine(lineStart, newline);
+            }
+            filled = static_cast<size_t>(end - lineStart);
+            std::memmove(buffer.data(), lineStart, filled);
+            if (read == 0) {
+                break;
+            }
+        }
+        if (filled > 0) {
+            interpreter.runLine(buffer.data(), buffer.data() + filled);
+        }
+        interpreter.flush();
+        result = interpreter.counts();
+    }
+    return result;
+}
+
+BatchResult runBatchCommands(const char* begin, const char* end, std::string& out) {
+    BatchInterpreter interpreter(out, nullptr);
+    const char* lineStart = begin;
+    for (const char* newline; (newline = static_cast<const char*>(std::memchr(lineStart, '\n', end - lineStart))) != nullptr; lineStart = newline + 1) {
+        interpreter.runLine(lineStart, newline);
+    }
+    if (lineStart != end) {
+        interpreter.runLine(lineStart, end);
+    }
+    return interpreter.counts();
+}
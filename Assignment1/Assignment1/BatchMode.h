@@ -0,0 +1,62 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdio>
+#include <string>
+
+/**
+* Commands per second the batch mode is expected to sustain on a release build. The
+* "--bench-command" benchmark fails when it falls short.
+ */
+constexpr double kBatchTargetCommandsPerSecond = 2e6;
+
+/**
+* Counts from one batch run.
+ */
+struct BatchResult {
+    size_t commands;
+    size_t errors;
+};
+
+/**
+* Check whether the command line selects batch mode instead of the menu.
+* @param argc argument count from main
+* @param argv argument vector from main
+* @return true if argv[1] is --batch
+ */
+bool isBatchCommand(int argc, char** argv);
+
+/**
+* Run the commands in the file named by argv[2], or on standard input when there is none or
+* it is "-", and write the results to standard output.
+*
+* One command per line; blank lines and lines starting with # are skipped:
+*   create x1 y1 z1 x2 y2 z2 x3 y3 z3   add a triangle and make it the current one
+*   translate d axis [n]                 move the current triangle, or triangle n, along x, y or z
+*   area [n]                             print "Area: " and the area, as the menu does
+*   display [n]                          print the vertices, as the menu does
+* Triangles are numbered from 0 in the order they were created. A bad line prints
+* "line N: " and the problem, and the run carries on.
+*
+* @param argc argument count from main
+* @param argv argument vector from main
+* @return 0 if every command succeeded, otherwise 1
+ */
+int runBatch(int argc, char** argv);
+
+/**
+* Run batch commands read from a stream, writing the results to another in large blocks.
+* @param in the commands
+* @param out receives the results
+* @return the number of commands run and how many of them failed
+ */
+BatchResult runBatchCommands(std::FILE* in, std::FILE* out);
+
+/**
+* Run batch commands that are already in memory.
+* @param begin the first character of the commands
+* @param end one past the last character
+* @param out the results are appended here
+* @return the number of commands run and how many of them failed
+ */
+BatchResult runBatchCommands(const char* begin, const char* end, std::string& out);
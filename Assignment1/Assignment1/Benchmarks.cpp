@@ -0,0 +1,561 @@
+#include "Benchmarks.h"
+#include "BatchMode.h"
+#include "GeometryArena.h"
+#include "MemoryStats.h"
+#include "MyArray.h"
+#include "Triangle.h"
+#include "TriangleBatch.h"
+
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <cstdlib>
+#include <cstdint>
+#include <cstring>
+#include <functional>
+#include <iostream>
+#include <numeric>
+#include <random>
+#include <sstream>
+#include <streambuf>
+#include <string>
+#include <vector>
+
+namespace {
+    typedef std::chrono::steady_clock Clock;
+
+    /**
+    * Run the callable the given number of times and return the fastest run in seconds.
+     */
+    double bestOf(int iterations, const std::function<void()>& run) {
+        double best = 1e30;
+        for (int i = 0; i < iterations; i++) {
+            Clock::time_point start = Clock::now();
+            run();
+            std::chrono::duration<double> elapsed = Clock::now() - start;
+            best = std::min(best, elapsed.count());
+        }
+        return best;
+    }
+
+    /**
+    * A stream buffer that throws away everything written to it, to time the destructor
+    * messages without a console in the way.
+     */
+    class NullBuffer : public std::streambuf {
+    private:
+        char sink[256];
+
+    protected:
+        int overflow(int c) override {
+            setp(sink, sink + sizeof(sink));
+            return traits_type::not_eof(c);
+        }
+    };
+
+    /**
+    * Integer triangle coordinates, nine per triangle, as entered in the menu.
+     */
+    std::vector<int> randomCoordinates(size_t count) {
+        std::mt19937 random(12345);
+        std::uniform_int_distribution<int> coordinate(-1000, 1000);
+        std::vector<int> coordinates(count * 9);
+        for (int& value : coordinates) {
+            value = coordinate(random);
+        }
+        return coordinates;
+    }
+
+    /**
+    * Largest area difference between a batch and the reference areas, relative to the squared
+    * longest edge of each triangle, the scale at which either formula loses precision.
+     */
+    double maxAreaError(const std::vector<int>& coordinates, const std::vector<double>& reference, const double* areas) {
+        double worst = 0.0;
+        for (size_t t = 0; t < reference.size(); t++) {
+            const int* c = &coordinates[t * 9];
+            double longest = 1.0;
+            for (int v = 0; v < 3; v++) {
+                const int* a = c + v * 3;
+                const int* b = c + ((v + 1) % 3) * 3;
+                const double dx = b[0] - a[0], dy = b[1] - a[1], dz = b[2] - a[2];
+                longest = std::max(longest, dx * dx + dy * dy + dz * dz);
+            }
+            worst = std::max(worst, std::fabs(areas[t] - reference[t]) / longest);
+        }
+        return worst;
+    }
+
+    template <typename T>
+    bool benchBatchType(const char* typeName, const std::vector<int>& coordinates, const std::vector<double>& reference,
+                        double legacyAreaSeconds, double tolerance) {
+        const size_t count = reference.size();
+        TriangleBatch<T> batch;
+        batch.reserve(count);
+        for (size_t t = 0; t < count; t++) {
+            const int* c = &coordinates[t * 9];
+            batch.add(T(c[0]), T(c[1]), T(c[2]), T(c[3]), T(c[4]), T(c[5]), T(c[6]), T(c[7]), T(c[8]));
+        }
+
+        bool ok = true;
+        std::vector<BatchKernel> kernels = { BatchKernel::Scalar };
+        if (TriangleBatch<T>::bestKernel() == BatchKernel::AVX2) {
+            kernels.push_back(BatchKernel::AVX2);
+        }
+        std::vector<T> areas(count);
+        std::vector<double> widened(count);
+        for (BatchKernel kernel : kernels) {
+            batch.setKernel(kernel);
+            const double areaSeconds = bestOf(5, [&]() { batch.areas(areas.data()); });
+            const double translateSeconds = bestOf(5, [&]() { batch.translate(T(1), 'x'); batch.translate(T(-1), 'x'); }) / 2.0;
+            T minimum[3], maximum[3];
+            const double boundsSeconds = bestOf(5, [&]() { batch.bounds(minimum, maximum); });
+
+            std::copy(areas.begin(), areas.end(), widened.begin());
+            const double error = maxAreaError(coordinates, reference, widened.data());
+            ok = ok && error <= tolerance;
+            std::cout << "  " << typeName << (kernel == BatchKernel::AVX2 ? " AVX2  " : " scalar") << ": area "
+                      << count / areaSeconds / 1e6 << " Mtri/s (" << legacyAreaSeconds / areaSeconds << "x), translate "
+                      << count / translateSeconds / 1e6 << " Mtri/s, bounds " << count / boundsSeconds / 1e6
+                      << " Mtri/s, max area error " << error << (error <= tolerance ? "" : " (TOO LARGE)") << "\n";
+        }
+        return ok;
+    }
+
+    int benchBatch(int argc, char** argv) {
+        std::vector<size_t> counts;
+        for (int i = 2; i < argc; i++) {
+            counts.push_back(static_cast<size_t>(std::max(1, std::atoi(argv[i]))));
+        }
+        if (counts.empty()) {
+            counts = { 100000, 1000000 };
+        }
+
+        bool ok = true;
+        for (size_t count : counts) {
+            const std::vector<int> coordinates = randomCoordinates(count);
+
+            // The existing classes: three heap-allocated Points per Triangle
+            std::vector<Triangle*> triangles(count);
+            for (size_t t = 0; t < count; t++) {
+                const int* c = &coordinates[t * 9];
+                triangles[t] = new Triangle(new Point(c[0], c[1], c[2]), new Point(c[3], c[4], c[5]), new Point(c[6], c[7], c[8]));
+            }
+            std::vector<double> reference(count);
+            const double areaSeconds = bestOf(3, [&]() {
+                for (size_t t = 0; t < count; t++) {
+                    reference[t] = triangles[t]->calcArea();
+                }
+            });
+            const double translateSeconds = bestOf(3, [&]() {
+                for (Triangle* triangle : triangles) {
+                    triangle->translate(1, 'x');
+                }
+                for (Triangle* triangle : triangles) {
+                    triangle->translate(-1, 'x');
+                }
+            }) / 2.0;
+            destructorLogging() = false;
+            for (Triangle* triangle : triangles) {
+                delete triangle;
+            }
+            destructorLogging() = true;
+
+            std::cout << count << " triangles\n";
+            std::cout << "  Triangle objects: area " << count / areaSeconds / 1e6 << " Mtri/s, translate "
+                      << count / translateSeconds / 1e6 << " Mtri/s\n";
+            ok = benchBatchType<double>("double", coordinates, reference, areaSeconds, 1e-7) && ok;
+            ok = benchBatchType<float>("float ", coordinates, reference, areaSeconds, 1e-5) && ok;
+        }
+        std::cout.flush();
+        return ok ? 0 : 1;
+    }
+
+    /**
+    * MyArray allocator hook that counts heap allocations, to show the growth policy at work.
+     */
+    struct CountingAllocator {
+        size_t allocations = 0;
+
+        void* allocate(size_t bytes, size_t alignment) {
+            allocations++;
+            return AlignedAllocator().allocate(bytes, alignment);
+        }
+
+        void deallocate(void* memory, size_t bytes, size_t alignment) {
+            AlignedAllocator().deallocate(memory, bytes, alignment);
+        }
+    };
+
+    /**
+    * Seconds per pass of run, repeating small sizes so each timing covers about ten million elements.
+     */
+    double secondsPerPass(size_t count, const std::function<void()>& run) {
+        const size_t passes = std::max<size_t>(1, 10000000 / count);
+        return bestOf(3, [&]() {
+            for (size_t p = 0; p < passes; p++) {
+                run();
+            }
+        }) / passes;
+    }
+
+    void printArrayResult(const char* name, size_t count, double vectorSeconds, double arraySeconds) {
+        std::cout << "  " << name << "std::vector " << count / vectorSeconds / 1e6 << " M/s, MyArray "
+                  << count / arraySeconds / 1e6 << " M/s (" << vectorSeconds / arraySeconds << "x)";
+    }
+
+    int benchArray(int argc, char** argv) {
+        std::vector<size_t> counts;
+        for (int i = 2; i < argc; i++) {
+            counts.push_back(static_cast<size_t>(std::max(1, std::atoi(argv[i]))));
+        }
+        if (counts.empty()) {
+            counts = { 1000, 10000, 100000, 1000000, 10000000, 100000000 };
+        }
+
+        // Unsigned so the sums wrap instead of overflowing, and every summation order agrees
+        typedef unsigned int Element;
+        bool ok = true;
+        for (size_t count : counts) {
+            // One container at a time, so the largest sizes fit in memory. The sink keeps the
+            // compiler from discarding the push_back loops.
+            volatile Element sink = 0;
+            Element vectorSum = 0;
+            double vectorPush, vectorIota, vectorReduce;
+            {
+                vectorPush = secondsPerPass(count, [&]() {
+                    std::vector<Element> fresh;
+                    for (size_t i = 0; i < count; i++) {
+                        fresh.push_back(static_cast<Element>(i));
+                    }
+                    sink = fresh.back();
+                });
+                std::vector<Element> values(count);
+                vectorIota = secondsPerPass(count, [&]() { std::iota(values.begin(), values.end(), Element(0)); });
+                vectorReduce = secondsPerPass(count, [&]() { vectorSum = std::accumulate(values.begin(), values.end(), Element(0)); });
+            }
+
+            Element arraySum = 0;
+            size_t allocations = 0;
+            bool aligned, sequence;
+            double arrayPush, arrayIota, arrayReduce;
+            {
+                arrayPush = secondsPerPass(count, [&]() {
+                    MyArray<Element, 16, CountingAllocator> fresh;
+                    for (size_t i = 0; i < count; i++) {
+                        fresh.push_back(static_cast<Element>(i));
+                    }
+                    sink = fresh.back();
+                    allocations = fresh.getAllocator().allocations;
+                });
+                MyArray<Element> values(count);
+                arrayIota = secondsPerPass(count, [&]() { values.iota(0); });
+                arrayReduce = secondsPerPass(count, [&]() { arraySum = values.reduce(0, std::plus<Element>()); });
+                aligned = reinterpret_cast<uintptr_t>(values.data()) % kMyArrayAlignment == 0;
+                sequence = values[0] == 0 && values[count - 1] == static_cast<Element>(count - 1);
+            }
+
+            const bool matched = aligned && sequence && arraySum == vectorSum;
+            ok = ok && matched;
+            std::cout << count << " elements\n";
+            printArrayResult("push_back: ", count, vectorPush, arrayPush);
+            std::cout << ", " << allocations << " allocations\n";
+            printArrayResult("iota:      ", count, vectorIota, arrayIota);
+            std::cout << (aligned ? ", 64-byte aligned" : ", MISALIGNED") << (sequence ? "" : ", WRONG VALUES") << "\n";
+            printArrayResult("reduce:    ", count, vectorReduce, arrayReduce);
+            std::cout << (arraySum == vectorSum ? ", sums match" : ", SUMS DIFFER") << "\n";
+        }
+        std::cout.flush();
+        return ok ? 0 : 1;
+    }
+
+    double secondsSince(Clock::time_point start) {
+        return std::chrono::duration<double>(Clock::now() - start).count();
+    }
+
+    double megabytes(size_t bytes) {
+        return bytes / (1024.0 * 1024.0);
+    }
+
+    /**
+    * Memory and time taken to build triangles one way, measured from the point it was created.
+     */
+    struct BuildReport {
+        Clock::time_point start;
+        AllocationCounts counts;
+        size_t rss;
+
+        BuildReport() : start(Clock::now()), counts(allocationCounts()), rss(currentRss()) {}
+
+        void print(const char* name, double buildSeconds, double areaSeconds) const {
+            const AllocationCounts now = allocationCounts();
+            const size_t grown = currentRss() > rss ? currentRss() - rss : 0;
+            std::cout << "  " << name << "build " << buildSeconds * 1e3 << " ms, " << now.allocations - counts.allocations
+                      << " allocations, +" << megabytes(grown) << " MB resident, area pass " << areaSeconds * 1e3 << " ms";
+        }
+    };
+
+    /**
+    * Build, walk and free the triangles with new and delete, as the menu does.
+    * @return the sum of the areas
+     */
+    double benchHeapTriangles(const std::vector<int>& coordinates, size_t count) {
+        BuildReport report;
+        std::vector<Triangle*> triangles(count);
+        for (size_t t = 0; t < count; t++) {
+            const int* c = &coordinates[t * 9];
+            triangles[t] = new Triangle(new Point(c[0], c[1], c[2]), new Point(c[3], c[4], c[5]), new Point(c[6], c[7], c[8]));
+        }
+        const double buildSeconds = secondsSince(report.start);
+        double total = 0.0;
+        Clock::time_point start = Clock::now();
+        for (Triangle* triangle : triangles) {
+            total += triangle->calcArea();
+        }
+        const double areaSeconds = secondsSince(start);
+        report.print("heap:  ", buildSeconds, areaSeconds);
+
+        destructorLogging() = false;
+        start = Clock::now();
+        for (Triangle* triangle : triangles) {
+            delete triangle;
+        }
+        destructorLogging() = true;
+        std::cout << ", teardown " << secondsSince(start) * 1e3 << " ms";
+
+#if TRIANGLE_LOG_DESTRUCTORS
+        // Once more with the messages on, written to a stream that discards them
+        for (size_t t = 0; t < count; t++) {
+            const int* c = &coordinates[t * 9];
+            triangles[t] = new Triangle(new Point(c[0], c[1], c[2]), new Point(c[3], c[4], c[5]), new Point(c[6], c[7], c[8]));
+        }
+        NullBuffer nullBuffer;
+        std::streambuf* console = std::cout.rdbuf(&nullBuffer);
+        start = Clock::now();
+        for (Triangle* triangle : triangles) {
+            delete triangle;
+        }
+        const double loggedSeconds = secondsSince(start);
+        std::cout.rdbuf(console);
+        std::cout << " (" << loggedSeconds * 1e3 << " ms with destructor messages)\n";
+#else
+        std::cout << " (destructor messages compiled out)\n";
+#endif
+        return total;
+    }
+
+    /**
+    * Build, walk and free the triangles in a GeometryArena.
+    * @return the sum of the areas
+     */
+    double benchArenaTriangles(const std::vector<int>& coordinates, size_t count) {
+        BuildReport report;
+        GeometryArena arena;
+        for (size_t t = 0; t < count; t++) {
+            const int* c = &coordinates[t * 9];
+            arena.makeTriangle(c[0], c[1], c[2], c[3], c[4], c[5], c[6], c[7], c[8]);
+        }
+        const double buildSeconds = secondsSince(report.start);
+        double total = 0.0;
+        Clock::time_point start = Clock::now();
+        arena.forEachTriangle([&total](Triangle& triangle) { total += triangle.calcArea(); });
+        const double areaSeconds = secondsSince(start);
+        report.print("arena: ", buildSeconds, areaSeconds);
+
+        destructorLogging() = false;
+        start = Clock::now();
+        arena.release();
+        destructorLogging() = true;
+        std::cout << ", release " << secondsSince(start) * 1e3 << " ms\n";
+        return total;
+    }
+
+    int benchArena(int argc, char** argv) {
+        std::vector<size_t> counts;
+        bool heap = true, arena = true;
+        for (int i = 2; i < argc; i++) {
+            if (std::strcmp(argv[i], "heap") == 0) {
+                arena = false;
+            }
+            else if (std::strcmp(argv[i], "arena") == 0) {
+                heap = false;
+            }
+            else {
+                counts.push_back(static_cast<size_t>(std::max(1, std::atoi(argv[i]))));
+            }
+        }
+        if (counts.empty()) {
+            counts = { 1000000 };
+        }
+
+        bool ok = true;
+        for (size_t count : counts) {
+            const std::vector<int> coordinates = randomCoordinates(count);
+            std::cout << count << " triangles\n";
+            // The arena goes first: memory the heap run frees may stay resident and hide its growth
+            const double arenaTotal = arena ? benchArenaTriangles(coordinates, count) : 0.0;
+            const double heapTotal = heap ? benchHeapTriangles(coordinates, count) : 0.0;
+            if (heap && arena && arenaTotal != heapTotal) {
+                std::cout << "  AREAS DIFFER: " << arenaTotal << " against " << heapTotal << "\n";
+                ok = false;
+            }
+        }
+        std::cout << "Peak resident memory " << megabytes(peakRss()) << " MB\n";
+        std::cout.flush();
+        return ok ? 0 : 1;
+    }
+
+    /**
+    * A batch script of count commands: a quarter create, then translate, area and display in
+    * decreasing shares, some addressing an earlier triangle by number.
+     */
+    std::string randomScript(size_t count) {
+        std::mt19937 random(12345);
+        std::uniform_int_distribution<int> coordinate(-1000, 1000);
+        std::uniform_int_distribution<int> percent(0, 99);
+        const char axes[3] = { 'x', 'y', 'z' };
+        std::string script;
+        size_t triangles = 0;
+        for (size_t i = 0; i < count; i++) {
+            const int roll = triangles == 0 ? 0 : percent(random);
+            if (roll < 25) {
+                script += "create";
+                for (int c = 0; c < 9; c++) {
+                    script += ' ';
+                    script += std::to_string(coordinate(random));
+                }
+                triangles++;
+            }
+            else if (roll < 60) {
+                script += "translate " + std::to_string(coordinate(random)) + ' ' + axes[random() % 3];
+            }
+            else if (roll < 90) {
+                script += "area";
+            }
+            else {
+                script += "display";
+            }
+            if (roll >= 25 && roll % 5 == 0) {
+                script += ' ' + std::to_string(random() % triangles);
+            }
+            script += '\n';
+        }
+        return script;
+    }
+
+    /**
+    * Run a script the slow way, with Triangle objects and iostreams, for the expected output.
+     */
+    std::string referenceOutput(const std::string& script) {
+        std::vector<Triangle*> triangles;
+        std::ostringstream output;
+        std::streambuf* console = std::cout.rdbuf(output.rdbuf());
+        std::istringstream lines(script);
+        std::string line;
+        while (std::getline(lines, line)) {
+            std::istringstream words(line);
+            std::string command;
+            words >> command;
+            if (command == "create") {
+                int c[9];
+                for (int& value : c) {
+                    words >> value;
+                }
+                triangles.push_back(new Triangle(new Point(c[0], c[1], c[2]), new Point(c[3], c[4], c[5]), new Point(c[6], c[7], c[8])));
+                continue;
+            }
+            int d = 0;
+            char axis = 'x';
+            if (command == "translate") {
+                words >> d >> axis;
+            }
+            size_t index = triangles.size() - 1;
+            words >> index;
+            if (command == "translate") {
+                triangles[index]->translate(d, axis);
+            }
+            else if (command == "area") {
+                std::cout << "Area: " << triangles[index]->calcArea() << "\n";
+            }
+            else {
+                triangles[index]->display();
+            }
+        }
+        std::cout.rdbuf(console);
+        destructorLogging() = false;
+        for (Triangle* triangle : triangles) {
+            delete triangle;
+        }
+        destructorLogging() = true;
+        return output.str();
+    }
+
+    int benchCommand(int argc, char** argv) {
+        std::vector<size_t> counts;
+        for (int i = 2; i < argc; i++) {
+            counts.push_back(static_cast<size_t>(std::max(1, std::atoi(argv[i]))));
+        }
+        if (counts.empty()) {
+            counts = { 1000000, 5000000 };
+        }
+
+        // The output must match what the menu's iostream code prints, character for character
+        const std::string sample = randomScript(20000);
+        std::string sampleOutput;
+        const BatchResult sampleResult = runBatchCommands(sample.data(), sample.data() + sample.size(), sampleOutput);
+        bool ok = sampleResult.errors == 0 && sampleOutput == referenceOutput(sample);
+        std::cout << "20000 command sample " << (ok ? "matches" : "DOES NOT MATCH") << " the iostream output\n";
+
+        for (size_t count : counts) {
+            const std::string script = randomScript(count);
+            std::string output;
+            BatchResult result = { 0, 0 };
+            const double seconds = bestOf(3, [&]() {
+                output.clear();
+                result = runBatchCommands(script.data(), script.data() + script.size(), output);
+            });
+            const double rate = count / seconds;
+            const bool passed = result.errors == 0 && result.commands == count && rate >= kBatchTargetCommandsPerSecond;
+            ok = ok && passed;
+            std::cout << count << " commands: " << seconds * 1e3 << " ms, " << rate / 1e6 << " M commands/s, "
+                      << script.size() / seconds / 1e6 << " MB/s in, " << output.size() / seconds / 1e6 << " MB/s out, "
+                      << result.errors << " errors (target " << kBatchTargetCommandsPerSecond / 1e6 << " M commands/s: "
+                      << (passed ? "PASS" : "FAIL") << ")\n";
+        }
+        std::cout.flush();
+        return ok ? 0 : 1;
+    }
+
+    struct BenchmarkEntry {
+        const char* name;
+        int (*run)(int argc, char** argv);
+    };
+
+    const BenchmarkEntry kBenchmarks[] = {
+        { "--bench-batch", benchBatch },
+        { "--bench-array", benchArray },
+        { "--bench-arena", benchArena },
+        { "--bench-command", benchCommand },
+    };
+}
+
+bool isBenchmarkCommand(int argc, char** argv) {
+    if (argc < 2) {
+        return false;
+    }
+    for (const BenchmarkEntry& entry : kBenchmarks) {
+        if (std::strcmp(argv[1], entry.name) == 0) {
+            return true;
+        }
+    }
+    return false;
+}
+
+int runBenchmark(int argc, char** argv) {
+    for (const BenchmarkEntry& entry : kBenchmarks) {
+        if (std::strcmp(argv[1], entry.name) == 0) {
+            return entry.run(argc, argv);
+        }
+    }
+    return 1;
+}
@@ -0,0 +1,32 @@
+#pragma once
+
+/**
+* Check whether the command line selects one of the benchmark modes instead of the menu.
+* @param argc argument count from main
+* @param argv argument vector from main
+* @return true if argv[1] names a benchmark
+ */
+bool isBenchmarkCommand(int argc, char** argv);
+
+/**
+* Run the benchmark named by argv[1] and print its results.
+*
+* Benchmarks:
+*   --bench-batch [count ...]   Area, translate and bounding box over many triangles: Triangle
+*                               objects against TriangleBatch, scalar and AVX2, float and double
+*                               (default 100000 and 1000000 triangles)
+*   --bench-array [count ...]   push_back, iota and reduce: std::vector against MyArray
+*                               (default 1000 up to 100000000 elements, by powers of ten)
+*   --bench-arena [count ...] [heap|arena]
+*                               Build, walk and free triangles with new and delete against a
+*                               GeometryArena: time, allocation count and resident memory
+*                               (default 1000000 triangles; name one mode to see its own peak)
+*   --bench-command [count ...]  Batch mode commands per second against
+*                               kBatchTargetCommandsPerSecond, plus a check that its output
+*                               matches the iostream code (default 1000000 and 5000000 commands)
+*
+* @param argc argument count from main
+* @param argv argument vector from main
+* @return 0 if the benchmark ran and its results matched, otherwise 1
+ */
+int runBenchmark(int argc, char** argv);
@@ -0,0 +1,36 @@
+#include "GeometryArena.h"
+
+GeometryArena::GeometryArena(size_t slabBytes) : triangles(slabBytes), points(slabBytes) {}
+
+GeometryArena::~GeometryArena() {
+    release();
+}
+
+Point* GeometryArena::makePoint(int x, int y, int z) {
+    return new (points.allocate()) Point(x, y, z);
+}
+
+Triangle* GeometryArena::makeTriangle(int x1, int y1, int z1, int x2, int y2, int z2, int x3, int y3, int z3) {
+    TriangleRecord* record = new (triangles.allocate()) TriangleRecord(x1, y1, z1, x2, y2, z2, x3, y3, z3);
+    return &record->triangle;
+}
+
+void GeometryArena::release() {
+    // Point and Triangle hold nothing but their coordinates and vertex pointers, so their
+    // destructors only matter for the messages
+#if TRIANGLE_LOG_DESTRUCTORS
+    if (destructorLogging()) {
+        triangles.forEach([](TriangleRecord& record) {
+            // Same messages, in the same order, as deleting a heap Triangle
+            for (Point& point : record.points) {
+                point.~Point();
+            }
+            record.triangle.vertex_1 = record.triangle.vertex_2 = record.triangle.vertex_3 = nullptr;
+            record.triangle.~Triangle();
+        });
+        points.forEach([](Point& point) { point.~Point(); });
+    }
+#endif
+    triangles.release();
+    points.release();
+}
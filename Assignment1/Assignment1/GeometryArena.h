@@ -0,0 +1,116 @@
+#pragma once
+
+#include "Triangle.h"
+
+#include <algorithm>
+#include <cstddef>
+#include <new>
+#include <vector>
+
+/**
+* Carves Points and Triangles out of large slabs and frees them all at once, instead of
+* four new and four delete calls per triangle.
+*
+* A triangle and its three points share one 64-byte record, so walking the triangles in
+* creation order reads memory front to back. Objects made here must not be deleted: release()
+* or the arena's destructor frees them, and only runs their destructors when destructor
+* logging is on, so that the messages still appear.
+ */
+class GeometryArena {
+public:
+    /**
+    * @param slabBytes the size of each block taken from the heap
+     */
+    explicit GeometryArena(size_t slabBytes = 1 << 20);
+    ~GeometryArena();
+
+    GeometryArena(const GeometryArena&) = delete;
+    GeometryArena& operator=(const GeometryArena&) = delete;
+
+    Point* makePoint(int x, int y, int z);
+
+    /**
+    * Create a triangle together with its three vertices.
+    * @return the triangle, valid until release()
+     */
+    Triangle* makeTriangle(int x1, int y1, int z1, int x2, int y2, int z2, int x3, int y3, int z3);
+
+    /**
+    * Call f(Triangle&) for every triangle, in creation order.
+     */
+    template <typename F>
+    void forEachTriangle(F f) {
+        triangles.forEach([&f](TriangleRecord& record) { f(record.triangle); });
+    }
+
+    /**
+    * Free every object made by this arena.
+     */
+    void release();
+
+    size_t triangleCount() const { return triangles.size(); }
+    size_t pointCount() const { return points.size(); }
+
+    // Heap blocks currently held
+    size_t slabCount() const { return triangles.slabCount() + points.slabCount(); }
+
+private:
+    struct alignas(64) TriangleRecord {
+        TriangleRecord(int x1, int y1, int z1, int x2, int y2, int z2, int x3, int y3, int z3)
+            : triangle(&points[0], &points[1], &points[2]), points{ Point(x1, y1, z1), Point(x2, y2, z2), Point(x3, y3, z3) } {}
+
+        Triangle triangle;
+        Point points[3];
+    };
+
+    /**
+    * Fixed-size slots of one type, handed out in order from blocks of slabBytes.
+     */
+    template <typename T>
+    class Slabs {
+    public:
+        explicit Slabs(size_t slabBytes) : perSlab(std::max<size_t>(1, slabBytes / sizeof(T))), count(0) {}
+
+        ~Slabs() { release(); }
+
+        // Uninitialized storage for one T
+        void* allocate() {
+            if (count == slabs.size() * perSlab) {
+                slabs.push_back(static_cast<T*>(::operator new(perSlab * sizeof(T), std::align_val_t(alignof(T)))));
+            }
+            T* slot = slabs.back() + (count - (slabs.size() - 1) * perSlab);
+            count++;
+            return slot;
+        }
+
+        template <typename F>
+        void forEach(F f) {
+            for (size_t s = 0; s < slabs.size(); s++) {
+                const size_t n = std::min(perSlab, count - s * perSlab);
+                for (size_t i = 0; i < n; i++) {
+                    f(slabs[s][i]);
+                }
+            }
+        }
+
+        // Free the blocks; the objects in them must already be destroyed or not need it
+        void release() {
+            for (T* slab : slabs) {
+                ::operator delete(slab, std::align_val_t(alignof(T)));
+            }
+            slabs.clear();
+            count = 0;
+        }
+
+        size_t size() const { return count; }
+        size_t slabCount() const { return slabs.size(); }
+
+    private:
+        std::vector<T*> slabs;
+        size_t perSlab;
+        size_t count;
+    };
+
+    Slabs<TriangleRecord> triangles;
+    Slabs<Point> points;
+};
@@ -0,0 +1,130 @@
+#include "MemoryStats.h"
+
+#include <atomic>
+#include <cstdlib>
+#include <new>
+
+#if defined(_WIN32)
+#define WIN32_LEAN_AND_MEAN
+#define NOMINMAX
+#include <windows.h>
+#include <psapi.h>
+#pragma comment(lib, "psapi.lib")
+#else
+#include <cstdio>
+#include <sys/resource.h>
+#include <unistd.h>
+#endif
+
+namespace {
+    std::atomic<size_t> allocationCount(0);
+    std::atomic<size_t> deallocationCount(0);
+
+    /**
+    * malloc with the operator new contract: retry through the new handler, then throw.
+     */
+    void* allocateCounted(size_t bytes, size_t alignment) {
+        allocationCount.fetch_add(1, std::memory_order_relaxed);
+        if (bytes == 0) {
+            bytes = 1;
+        }
+        while (true) {
+#if defined(_WIN32)
+            void* memory = alignment ? _aligned_malloc(bytes, alignment) : std::malloc(bytes);
+#else
+            // aligned_alloc wants the size to be a multiple of the alignment
+            void* memory = alignment ? std::aligned_alloc(alignment, (bytes + alignment - 1) / alignment * alignment) : std::malloc(bytes);
+#endif
+            if (memory) {
+                return memory;
+            }
+            std::new_handler handler = std::get_new_handler();
+            if (!handler) {
+                throw std::bad_alloc();
+            }
+            handler();
+        }
+    }
+
+    void freeCounted(void* memory, bool aligned) {
+        if (!memory) {
+            return;
+        }
+        deallocationCount.fetch_add(1, std::memory_order_relaxed);
+#if defined(_WIN32)
+        if (aligned) {
+            _aligned_free(memory);
+            return;
+        }
+#else
+        (void)aligned;
+#endif
+        std::free(memory);
+    }
+}
+
+// The array and nothrow forms forward to these by default
+void* operator new(size_t bytes) {
+    return allocateCounted(bytes, 0);
+}
+
+void operator delete(void* memory) noexcept {
+    freeCounted(memory, false);
+}
+
+void operator delete(void* memory, size_t) noexcept {
+    freeCounted(memory, false);
+}
+
+void* operator new(size_t bytes, std::align_val_t alignment) {
+    return allocateCounted(bytes, static_cast<size_t>(alignment));
+}
+
+void operator delete(void* memory, std::align_val_t) noexcept {
+    freeCounted(memory, true);
+}
+
+void operator delete(void* memory, size_t, std::align_val_t) noexcept {
+    freeCounted(memory, true);
+}
+
+AllocationCounts allocationCounts() {
+    AllocationCounts counts;
+    counts.allocations = allocationCount.load(std::memory_order_relaxed);
+    counts.deallocations = deallocationCount.load(std::memory_order_relaxed);
+    return counts;
+}
+
+size_t currentRss() {
+#if defined(_WIN32)
+    PROCESS_MEMORY_COUNTERS counters;
+    return GetProcessMemoryInfo(GetCurrentProcess(), &counters, sizeof(counters)) ? counters.WorkingSetSize : 0;
+#else
+    // The second field of statm is the resident page count
+    std::FILE* statm = std::fopen("/proc/self/statm", "r");
+    if (!statm) {
+        return 0;
+    }
+    unsigned long size = 0, resident = 0;
+    const int fields = std::fscanf(statm, "%lu %lu", &size, &resident);
+    std::fclose(statm);
+    return fields == 2 ? resident * static_cast<size_t>(sysconf(_SC_PAGESIZE)) : 0;
+#endif
+}
+
+size_t peakRss() {
+#if defined(_WIN32)
+    PROCESS_MEMORY_COUNTERS counters;
+    return GetProcessMemoryInfo(GetCurrentProcess(), &counters, sizeof(counters)) ? counters.PeakWorkingSetSize : 0;
+#else
+    struct rusage usage;
+    if (getrusage(RUSAGE_SELF, &usage) != 0) {
+        return 0;
+    }
+#if defined(__APPLE__)
+    return static_cast<size_t>(usage.ru_maxrss);
+#else
+    return static_cast<size_t>(usage.ru_maxrss) * 1024;
+#endif
+#endif
+}
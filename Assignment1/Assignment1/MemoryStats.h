@@ -0,0 +1,28 @@
+#pragma once
+
+#include <cstddef>
+
+/**
+* Heap calls made through operator new and operator delete since the program started.
+ */
+struct AllocationCounts {
+    size_t allocations;
+    size_t deallocations;
+};
+
+/**
+* Read the allocation counters. MemoryStats.cpp replaces the global operator new and delete
+* to keep them, so every allocation in the program is counted.
+ */
+AllocationCounts allocationCounts();
+
+/**
+* Resident memory of this process in bytes, or 0 if the platform does not report it.
+ */
+size_t currentRss();
+
+/**
+* Highest resident memory of this process so far in bytes, or 0 if the platform does not
+* report it.
+ */
+size_t peakRss();
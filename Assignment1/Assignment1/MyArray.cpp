@@ -1 +1,41 @@
 #include "MyArray.h"
+
+#include <atomic>
+#include <thread>
+#include <vector>
+
+void* AlignedAllocator::allocate(size_t bytes, size_t alignment) {
+    return ::operator new(bytes, std::align_val_t(alignment));
+}
+
+void AlignedAllocator::deallocate(void* memory, size_t, size_t alignment) {
+    ::operator delete(memory, std::align_val_t(alignment));
+}
+
+void parallelChunks(size_t count, size_t grain, const std::function<void(size_t, size_t, size_t)>& body) {
+    const size_t chunks = (count + grain - 1) / grain;
+    const size_t threads = count < kMyArrayParallelThreshold ? 1 : std::min<size_t>(std::thread::hardware_concurrency(), chunks);
+    if (threads <= 1) {
+        for (size_t chunk = 0; chunk < chunks; chunk++) {
+            body(chunk, chunk * grain, std::min(count, (chunk + 1) * grain));
+        }
+        return;
+    }
+
+    // Workers claim chunks one at a time, so an unlucky slow thread does not hold up the rest
+    std::atomic<size_t> next(0);
+    auto work = [&]() {
+        for (size_t chunk = next++; chunk < chunks; chunk = next++) {
+            body(chunk, chunk * grain, std::min(count, (chunk + 1) * grain));
+        }
+    };
+    std::vector<std::thread> workers;
+    workers.reserve(threads - 1);
+    for (size_t t = 1; t < threads; t++) {
+        workers.emplace_back(work);
+    }
+    work();
+    for (std::thread& worker : workers) {
+        worker.join();
+    }
+}
@@ -1,6 +1,391 @@
 #pragma once
-class MyArray
-{
 
+#include <algorithm>
+#include <cstddef>
+#include <cstring>
+#include <functional>
+#include <initializer_list>
+#include <limits>
+#include <memory>
+#include <new>
+#include <stdexcept>
+#include <type_traits>
+#include <utility>
+
+// Keeps the rare growth path out of the inlined push_back loop
+#if defined(_MSC_VER)
+#define MYARRAY_NOINLINE __declspec(noinline)
+#else
+#define MYARRAY_NOINLINE __attribute__((noinline))
+#endif
+
+// Alignment of MyArray storage: one cache line, which also suits any SIMD load
+constexpr size_t kMyArrayAlignment = 64;
+
+// Bulk operations on fewer elements than this stay on the calling thread
+constexpr size_t kMyArrayParallelThreshold = 1 << 16;
+
+// Elements a worker claims at a time in the bulk operations
+constexpr size_t kMyArrayParallelGrain = 1 << 15;
+
+/**
+* Default MyArray allocator: the aligned global operator new.
+*
+* Any type with these two members can be used instead, e.g. to count allocations or to carve
+* storage out of an arena. It is stored in the array, so it may carry state.
+ */
+struct AlignedAllocator {
+    void* allocate(size_t bytes, size_t alignment);
+    void deallocate(void* memory, size_t bytes, size_t alignment);
 };
 
+/**
+* Split [0, count) into chunks of grain elements and run body(chunk, begin, end) for each chunk.
+* Above kMyArrayParallelThreshold the chunks are shared out between the hardware threads;
+* body must not throw.
+* @param count the number of elements
+* @param grain the elements per chunk
+* @param body called once per chunk
+ */
+void parallelChunks(size_t count, size_t grain, const std::function<void(size_t, size_t, size_t)>& body);
+
+/**
+* A growable array with 64-byte-aligned storage.
+*
+* The first InlineCapacity elements live inside the object itself, so short arrays never touch
+* the heap; by default that is one cache line's worth. Past that, the capacity doubles each
+* time it runs out, so push_back is amortized constant time.
+*
+* fill, iota, transform and reduce split large arrays over all hardware threads.
+*
+* @tparam T the element type
+* @tparam InlineCapacity the number of elements stored without a heap allocation
+* @tparam Allocator provides allocate(bytes, alignment) and deallocate(memory, bytes, alignment)
+ */
+template <typename T, size_t InlineCapacity = (sizeof(T) <= kMyArrayAlignment ? kMyArrayAlignment / sizeof(T) : 0),
+          typename Allocator = AlignedAllocator>
+class MyArray {
+public:
+    typedef T value_type;
+    typedef T* iterator;
+    typedef const T* const_iterator;
+
+    explicit MyArray(const Allocator& allocator = Allocator())
+        : elements(inlineData()), count(0), capacityCount(InlineCapacity), allocator(allocator) {}
+
+    /**
+    * Create an array of n value-initialized elements.
+     */
+    explicit MyArray(size_t n, const Allocator& allocator = Allocator()) : MyArray(allocator) {
+        resize(n);
+    }
+
+    MyArray(size_t n, const T& value, const Allocator& allocator = Allocator()) : MyArray(allocator) {
+        resize(n, value);
+    }
+
+    MyArray(std::initializer_list<T> values, const Allocator& allocator = Allocator()) : MyArray(allocator) {
+        reserve(values.size());
+        for (const T& value : values) {
+            new (elements + count) T(value);
+            count++;
+        }
+    }
+
+    MyArray(const MyArray& other) : MyArray(other.allocator) {
+        copyFrom(other);
+    }
+
+    MyArray(MyArray&& other) noexcept : MyArray(std::move(other.allocator)) {
+        takeFrom(other);
+    }
+
+    MyArray& operator=(const MyArray& other) {
+        if (this != &other) {
+            clear();
+            copyFrom(other);
+        }
+        return *this;
+    }
+
+    MyArray& operator=(MyArray&& other) noexcept {
+        if (this != &other) {
+            clear();
+            releaseHeap();
+            allocator = std::move(other.allocator);
+            takeFrom(other);
+        }
+        return *this;
+    }
+
+    ~MyArray() {
+        clear();
+        releaseHeap();
+    }
+
+    size_t size() const { return count; }
+    size_t capacity() const { return capacityCount; }
+    bool empty() const { return count == 0; }
+
+    // True while the elements live in the inline buffer
+    bool isInline() const { return elements == inlineData(); }
+
+    T* data() { return elements; }
+    const T* data() const { return elements; }
+    iterator begin() { return elements; }
+    iterator end() { return elements + count; }
+    const_iterator begin() const { return elements; }
+    const_iterator end() const { return elements + count; }
+
+    T& operator[](size_t i) { return elements[i]; }
+    const T& operator[](size_t i) const { return elements[i]; }
+
+    /**
+    * Bounds-checked element access.
+    * @throws std::out_of_range if i >= size()
+     */
+    T& at(size_t i) {
+        checkIndex(i);
+        return elements[i];
+    }
+
+    const T& at(size_t i) const {
+        checkIndex(i);
+        return elements[i];
+    }
+
+    T& front() { return elements[0]; }
+    T& back() { return elements[count - 1]; }
+    const T& front() const { return elements[0]; }
+    const T& back() const { return elements[count - 1]; }
+
+    const Allocator& getAllocator() const { return allocator; }
+
+    /**
+    * Make room for at least n elements without further allocations.
+     */
+    void reserve(size_t n) {
+        if (n > capacityCount) {
+            reallocate(n);
+        }
+    }
+
+    void resize(size_t n) {
+        reserve(n);
+        for (; count < n; count++) {
+            new (elements + count) T();
+        }
+        shrinkTo(n);
+    }
+
+    void resize(size_t n, const T& value) {
+        if (n > capacityCount) {
+            // value may be one of our own elements, so copy it before the storage moves
+            T copy(value);
+            reallocate(n);
+            resize(n, copy);
+            return;
+        }
+        for (; count < n; count++) {
+            new (elements + count) T(value);
+        }
+        shrinkTo(n);
+    }
+
+    // Destroy every element; the capacity is kept
+    void clear() { shrinkTo(0); }
+
+    void push_back(const T& value) { emplace_back(value); }
+    void push_back(T&& value) { emplace_back(std::move(value)); }
+
+    template <typename... Args>
+    T& emplace_back(Args&&... args) {
+        if (count == capacityCount) {
+            return emplaceGrow(std::forward<Args>(args)...);
+        }
+        T* slot = new (elements + count) T(std::forward<Args>(args)...);
+        count++;
+        return *slot;
+    }
+
+    void pop_back() {
+        count--;
+        elements[count].~T();
+    }
+
+    /**
+    * Set every element to value.
+     */
+    void fill(const T& value) {
+        T* out = elements;
+        parallelChunks(count, kMyArrayParallelGrain, [out, &value](size_t, size_t begin, size_t end) {
+            std::fill(out + begin, out + end, value);
+        });
+    }
+
+    /**
+    * Set element i to start + i, replacing the old initializeArray.
+    * @param start the value of the first element
+     */
+    void iota(T start) {
+        T* out = elements;
+        parallelChunks(count, kMyArrayParallelGrain, [out, &start](size_t, size_t begin, size_t end) {
+            for (size_t i = begin; i < end; i++) {
+                out[i] = start + static_cast<T>(i);
+            }
+        });
+    }
+
+    /**
+    * Replace every element with op(element).
+    * @param op called concurrently from several threads, so it must not touch shared state
+     */
+    template <typename Op>
+    void transform(Op op) {
+        T* out = elements;
+        parallelChunks(count, kMyArrayParallelGrain, [out, &op](size_t, size_t begin, size_t end) {
+            for (size_t i = begin; i < end; i++) {
+                out[i] = op(out[i]);
+            }
+        });
+    }
+
+    /**
+    * Combine init and every element with op. Each chunk is folded on its own and the chunk
+    * results are then combined in order, so op must be associative; the result does not
+    * depend on the number of threads.
+    * @param init combined once, before the elements
+    * @param op associative binary operation
+    * @return op(init, op(... op(element 0, element 1) ...))
+     */
+    template <typename Op>
+    T reduce(T init, Op op) const {
+        if (count == 0) {
+            return init;
+        }
+        const T* in = elements;
+        const size_t chunks = (count + kMyArrayParallelGrain - 1) / kMyArrayParallelGrain;
+        std::unique_ptr<T[]> partials(new T[chunks]);
+        parallelChunks(count, kMyArrayParallelGrain, [in, &op, &partials](size_t chunk, size_t begin, size_t end) {
+            T partial = in[begin];
+            for (size_t i = begin + 1; i < end; i++) {
+                partial = op(partial, in[i]);
+            }
+            partials[chunk] = partial;
+        });
+        for (size_t chunk = 0; chunk < chunks; chunk++) {
+            init = op(init, partials[chunk]);
+        }
+        return init;
+    }
+
+private:
+    T* inlineData() { return reinterpret_cast<T*>(inlineStorage); }
+    const T* inlineData() const { return reinterpret_cast<const T*>(inlineStorage); }
+
+    void checkIndex(size_t i) const {
+        if (i >= count) {
+            throw std::out_of_range("MyArray index out of range");
+        }
+    }
+
+    size_t grownCapacity(size_t required) const {
+        const size_t maximum = std::numeric_limits<size_t>::max() / sizeof(T);
+        if (required > maximum) {
+            throw std::length_error("MyArray too large");
+        }
+        const size_t grown = capacityCount < maximum / 2 ? capacityCount * 2 : maximum;
+        return std::max(required, std::max<size_t>(grown, 8));
+    }
+
+    T* allocateElements(size_t n) {
+        return static_cast<T*>(allocator.allocate(n * sizeof(T), kStorageAlignment));
+    }
+
+    void releaseHeap() {
+        if (!isInline()) {
+            allocator.deallocate(elements, capacityCount * sizeof(T), kStorageAlignment);
+            elements = inlineData();
+            capacityCount = InlineCapacity;
+        }
+    }
+
+    // Move n elements to uninitialized storage, leaving the source destroyed
+    static void relocate(T* from, size_t n, T* to) {
+        if constexpr (std::is_trivially_copyable<T>::value) {
+            if (n > 0) {
+                std::memcpy(static_cast<void*>(to), static_cast<const void*>(from), n * sizeof(T));
+            }
+            return;
+        }
+        for (size_t i = 0; i < n; i++) {
+            new (to + i) T(std::move(from[i]));
+            from[i].~T();
+        }
+    }
+
+    void reallocate(size_t newCapacity) {
+        T* fresh = allocateElements(newCapacity);
+        relocate(elements, count, fresh);
+        releaseHeap();
+        elements = fresh;
+        capacityCount = newCapacity;
+    }
+
+    template <typename... Args>
+    MYARRAY_NOINLINE T& emplaceGrow(Args&&... args) {
+        const size_t newCapacity = grownCapacity(count + 1);
+        T* fresh = allocateElements(newCapacity);
+        // Build the new element first: args may refer to an element of the old storage
+        try {
+            new (fresh + count) T(std::forward<Args>(args)...);
+        } catch (...) {
+            allocator.deallocate(fresh, newCapacity * sizeof(T), kStorageAlignment);
+            throw;
+        }
+        relocate(elements, count, fresh);
+        releaseHeap();
+        elements = fresh;
+        capacityCount = newCapacity;
+        count++;
+        return elements[count - 1];
+    }
+
+    void shrinkTo(size_t n) {
+        while (count > n) {
+            count--;
+            elements[count].~T();
+        }
+    }
+
+    void copyFrom(const MyArray& other) {
+        reserve(other.count);
+        for (; count < other.count; count++) {
+            new (elements + count) T(other.elements[count]);
+        }
+    }
+
+    // Take other's elements, leaving it empty; the allocators must already match
+    void takeFrom(MyArray& other) {
+        if (other.isInline()) {
+            relocate(other.elements, other.count, elements);
+            count = other.count;
+            other.count = 0;
+            return;
+        }
+        elements = other.elements;
+        count = other.count;
+        capacityCount = other.capacityCount;
+        other.elements = other.inlineData();
+        other.count = 0;
+        other.capacityCount = InlineCapacity;
+    }
+
+    static constexpr size_t kStorageAlignment = alignof(T) > kMyArrayAlignment ? alignof(T) : kMyArrayAlignment;
+
+    alignas(kStorageAlignment) unsigned char inlineStorage[InlineCapacity > 0 ? InlineCapacity * sizeof(T) : 1];
+    T* elements;
+    size_t count;
+    size_t capacityCount;
+    Allocator allocator;
+};
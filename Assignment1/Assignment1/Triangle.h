@@ -0,0 +1,145 @@
+#pragma once
+
+#include <cmath>
+#include <iostream>
+
+// Define TRIANGLE_FAST_MODE to compile the destructor messages out entirely
+#ifndef TRIANGLE_FAST_MODE
+#define TRIANGLE_LOG_DESTRUCTORS 1
+#else
+#define TRIANGLE_LOG_DESTRUCTORS 0
+#endif
+
+/**
+* Whether ~Point and ~Triangle print a message. On by default; has no effect in fast mode.
+* @return the switch, which can be assigned to
+ */
+inline bool& destructorLogging() {
+    static bool enabled = true;
+    return enabled;
+}
+
+// Point class definition
+class Point {
+private:
+    int x, y, z;
+
+public:
+    Point(int x = 0, int y = 0, int z = 0) : x(x), y(y), z(z) {}
+
+    ~Point() {
+#if TRIANGLE_LOG_DESTRUCTORS
+        if (destructorLogging()) {
+            std::cout << "Point (" << x << ", " << y << ", " << z << ") destroyed.\n";
+        }
+#endif
+    }
+
+    /** 
+    * Translate the point along the specified axis by the given distance.
+    * @param d the distance to translate
+    * @param axis the axis to translate along ('x', 'y', or 'z')
+    * @return 0 if successful, -1 if invalid axis, -2 if distance is not finite
+     */
+    int translate(int d, char axis) {
+        if (!std::isfinite(static_cast<double>(d))) {
+            return -2;
+        }
+        switch (axis) {
+        case 'x':
+            x += d;
+            break;
+        case 'y':
+            y += d;
+            break;
+        case 'z':
+            z += d;
+            break;
+        default:
+            return -1;
+        }
+        return 0;
+    }
+
+    int getX() const { return x; }
+    int getY() const { return y; }
+    int getZ() const { return z; }
+
+    /** 
+    * Display the point in the format (x, y, z).
+     */
+    void display() const {
+        std::cout << "(" << x << ", " << y << ", " << z << ")";
+    }
+
+    friend class Triangle;
+};
+
+// Triangle class definition
+class Triangle {
+private:
+    Point* vertex_1, * vertex_2, * vertex_3;
+
+public:
+    Triangle() : vertex_1(nullptr), vertex_2(nullptr), vertex_3(nullptr) {}
+
+    Triangle(Point* p1, Point* p2, Point* p3) : vertex_1(p1), vertex_2(p2), vertex_3(p3) {}
+
+    ~Triangle() {
+        delete vertex_1;
+        delete vertex_2;
+        delete vertex_3;
+#if TRIANGLE_LOG_DESTRUCTORS
+        if (destructorLogging()) {
+            std::cout << "Triangle destroyed.\n";
+        }
+#endif
+    }
+
+    /**
+    * Translate the triangle along the specified axis by the given distance.
+    * @param d the distance to translate
+    * @param axis the axis to translate along ('x', 'y', or 'z')
+     */
+    void translate(int d, char axis) {
+        if (vertex_1) vertex_1->translate(d, axis);
+        if (vertex_2) vertex_2->translate(d, axis);
+        if (vertex_3) vertex_3->translate(d, axis);
+    }
+
+    /**
+    * Calculate the area of the triangle.
+    * @return the area of the triangle
+     */
+    double calcArea() const {
+        double a = std::sqrt(std::pow(vertex_2->x - vertex_1->x, 2) + std::pow(vertex_2->y - vertex_1->y, 2) + std::pow(vertex_2->z - vertex_1->z, 2));
+        double b = std::sqrt(std::pow(vertex_3->x - vertex_2->x, 2) + std::pow(vertex_3->y - vertex_2->y, 2) + std::pow(vertex_3->z - vertex_2->z, 2));
+        double c = std::sqrt(std::pow(vertex_1->x - vertex_3->x, 2) + std::pow(vertex_1->y - vertex_3->y, 2) + std::pow(vertex_1->z - vertex_3->z, 2));
+        double s = (a + b + c) / 2;
+        return std::sqrt(s * (s - a) * (s - b) * (s - c));
+    }
+
+    /**
+    * Get one of the vertices.
+    * @param i 0, 1 or 2
+    * @return the vertex, which may be null
+     */
+    const Point* getVertex(int i) const {
+        return i == 0 ? vertex_1 : i == 1 ? vertex_2 : vertex_3;
+    }
+
+    /**
+    * Display the triangle vertices.
+     */
+    void display() const {
+        std::cout << "Triangle vertices:\n";
+        if (vertex_1) vertex_1->display(); else std::cout << "(null)";
+        std::cout << "\n";
+        if (vertex_2) vertex_2->display(); else std::cout << "(null)";
+        std::cout << "\n";
+        if (vertex_3) vertex_3->display(); else std::cout << "(null)";
+        std::cout << "\n";
+    }
+
+    friend class GeometryArena;
+};
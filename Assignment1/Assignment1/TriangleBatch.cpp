@@ -0,0 +1,306 @@
+#include "TriangleBatch.h"
+
+#include <algorithm>
+#include <cmath>
+
+#if defined(_M_X64) || defined(__x86_64__)
+#define BATCH_X86 1
+#include <immintrin.h>
+#if defined(_MSC_VER)
+#include <intrin.h>
+#define BATCH_AVX2_TARGET
+#else
+#define BATCH_AVX2_TARGET __attribute__((target("avx2")))
+#endif
+#endif
+
+namespace {
+    // totalArea works through the batch in blocks this size so the areas stay in cache
+    constexpr size_t kAreaBlock = 1024;
+
+    /**
+    * Raw pointers to the vertex lanes for the kernels.
+     */
+    template <typename T>
+    struct Lanes {
+        const T* x[3];
+        const T* y[3];
+        const T* z[3];
+    };
+
+    template <typename T>
+    Lanes<T> lanesOf(const std::vector<T> (&x)[3], const std::vector<T> (&y)[3], const std::vector<T> (&z)[3]) {
+        Lanes<T> lanes;
+        for (int v = 0; v < 3; v++) {
+            lanes.x[v] = x[v].data();
+            lanes.y[v] = y[v].data();
+            lanes.z[v] = z[v].data();
+        }
+        return lanes;
+    }
+
+    template <typename T>
+    T areaScalar(const Lanes<T>& s, size_t i) {
+        const T ax = s.x[1][i] - s.x[0][i], ay = s.y[1][i] - s.y[0][i], az = s.z[1][i] - s.z[0][i];
+        const T bx = s.x[2][i] - s.x[0][i], by = s.y[2][i] - s.y[0][i], bz = s.z[2][i] - s.z[0][i];
+        const T cx = ay * bz - az * by;
+        const T cy = az * bx - ax * bz;
+        const T cz = ax * by - ay * bx;
+        return T(0.5) * std::sqrt(cx * cx + cy * cy + cz * cz);
+    }
+
+    template <typename T>
+    void areasScalar(const Lanes<T>& s, size_t begin, size_t end, T* out) {
+        for (size_t i = begin; i < end; i++) {
+            out[i - begin] = areaScalar(s, i);
+        }
+    }
+
+    template <typename T>
+    void addScalar(T* lane, size_t begin, size_t end, T d) {
+        for (size_t i = begin; i < end; i++) {
+            lane[i] += d;
+        }
+    }
+
+    template <typename T>
+    void boundsScalar(const T* lane, size_t begin, size_t end, T& minimum, T& maximum) {
+        for (size_t i = begin; i < end; i++) {
+            minimum = std::min(minimum, lane[i]);
+            maximum = std::max(maximum, lane[i]);
+        }
+    }
+
+#ifdef BATCH_X86
+    /**
+    * The AVX2 operations the kernels need, for float (8 lanes) and double (4 lanes).
+     */
+    template <typename T>
+    struct Avx2;
+
+    template <>
+    struct Avx2<float> {
+        typedef __m256 V;
+        static const size_t width = 8;
+        BATCH_AVX2_TARGET static V load(const float* p) { return _mm256_loadu_ps(p); }
+        BATCH_AVX2_TARGET static void store(float* p, V v) { _mm256_storeu_ps(p, v); }
+        BATCH_AVX2_TARGET static V set1(float value) { return _mm256_set1_ps(value); }
+        BATCH_AVX2_TARGET static V add(V a, V b) { return _mm256_add_ps(a, b); }
+        BATCH_AVX2_TARGET static V sub(V a, V b) { return _mm256_sub_ps(a, b); }
+        BATCH_AVX2_TARGET static V mul(V a, V b) { return _mm256_mul_ps(a, b); }
+        BATCH_AVX2_TARGET static V sqrt(V a) { return _mm256_sqrt_ps(a); }
+        BATCH_AVX2_TARGET static V min(V a, V b) { return _mm256_min_ps(a, b); }
+        BATCH_AVX2_TARGET static V max(V a, V b) { return _mm256_max_ps(a, b); }
+    };
+
+    template <>
+    struct Avx2<double> {
+        typedef __m256d V;
+        static const size_t width = 4;
+        BATCH_AVX2_TARGET static V load(const double* p) { return _mm256_loadu_pd(p); }
+        BATCH_AVX2_TARGET static void store(double* p, V v) { _mm256_storeu_pd(p, v); }
+        BATCH_AVX2_TARGET static V set1(double value) { return _mm256_set1_pd(value); }
+        BATCH_AVX2_TARGET static V add(V a, V b) { return _mm256_add_pd(a, b); }
+        BATCH_AVX2_TARGET static V sub(V a, V b) { return _mm256_sub_pd(a, b); }
+        BATCH_AVX2_TARGET static V mul(V a, V b) { return _mm256_mul_pd(a, b); }
+        BATCH_AVX2_TARGET static V sqrt(V a) { return _mm256_sqrt_pd(a); }
+        BATCH_AVX2_TARGET static V min(V a, V b) { return _mm256_min_pd(a, b); }
+        BATCH_AVX2_TARGET static V max(V a, V b) { return _mm256_max_pd(a, b); }
+    };
+
+    template <typename T>
+    BATCH_AVX2_TARGET void areasAVX2(const Lanes<T>& s, size_t begin, size_t end, T* out) {
+        typedef Avx2<T> A;
+        const typename A::V half = A::set1(T(0.5));
+        size_t i = begin;
+        for (; i + A::width <= end; i += A::width) {
+            const typename A::V x0 = A::load(s.x[0] + i), y0 = A::load(s.y[0] + i), z0 = A::load(s.z[0] + i);
+            const typename A::V ax = A::sub(A::load(s.x[1] + i), x0);
+            const typename A::V ay = A::sub(A::load(s.y[1] + i), y0);
+            const typename A::V az = A::sub(A::load(s.z[1] + i), z0);
+            const typename A::V bx = A::sub(A::load(s.x[2] + i), x0);
+            const typename A::V by = A::sub(A::load(s.y[2] + i), y0);
+            const typename A::V bz = A::sub(A::load(s.z[2] + i), z0);
+            const typename A::V cx = A::sub(A::mul(ay, bz), A::mul(az, by));
+            const typename A::V cy = A::sub(A::mul(az, bx), A::mul(ax, bz));
+            const typename A::V cz = A::sub(A::mul(ax, by), A::mul(ay, bx));
+            const typename A::V squared = A::add(A::add(A::mul(cx, cx), A::mul(cy, cy)), A::mul(cz, cz));
+            A::store(out + (i - begin), A::mul(half, A::sqrt(squared)));
+        }
+        areasScalar(s, i, end, out + (i - begin));
+    }
+
+    template <typename T>
+    BATCH_AVX2_TARGET void addAVX2(T* lane, size_t begin, size_t end, T d) {
+        typedef Avx2<T> A;
+        const typename A::V offset = A::set1(d);
+        size_t i = begin;
+        for (; i + A::width <= end; i += A::width) {
+            A::store(lane + i, A::add(A::load(lane + i), offset));
+        }
+        addScalar(lane, i, end, d);
+    }
+
+    template <typename T>
+    BATCH_AVX2_TARGET void boundsAVX2(const T* lane, size_t begin, size_t end, T& minimum, T& maximum) {
+        typedef Avx2<T> A;
+        size_t i = begin;
+        if (end - begin >= A::width) {
+            typename A::V low = A::load(lane + i), high = low;
+            for (i += A::width; i + A::width <= end; i += A::width) {
+                const typename A::V v = A::load(lane + i);
+                low = A::min(low, v);
+                high = A::max(high, v);
+            }
+            T lows[A::width], highs[A::width];
+            A::store(lows, low);
+            A::store(highs, high);
+            for (size_t k = 0; k < A::width; k++) {
+                minimum = std::min(minimum, lows[k]);
+                maximum = std::max(maximum, highs[k]);
+            }
+        }
+        boundsScalar(lane, i, end, minimum, maximum);
+    }
+#endif
+
+    template <typename T>
+    void computeAreas(BatchKernel kernel, const Lanes<T>& s, size_t begin, size_t end, T* out) {
+#ifdef BATCH_X86
+        if (kernel == BatchKernel::AVX2) {
+            areasAVX2(s, begin, end, out);
+            return;
+        }
+#endif
+        (void)kernel;
+        areasScalar(s, begin, end, out);
+    }
+}
+
+template <typename T>
+void TriangleBatch<T>::reserve(size_t count) {
+    for (int v = 0; v < 3; v++) {
+        x[v].reserve(count);
+        y[v].reserve(count);
+        z[v].reserve(count);
+    }
+}
+
+template <typename T>
+void TriangleBatch<T>::clear() {
+    for (int v = 0; v < 3; v++) {
+        x[v].clear();
+        y[v].clear();
+        z[v].clear();
+    }
+}
+
+template <typename T>
+size_t TriangleBatch<T>::add(T x1, T y1, T z1, T x2, T y2, T z2, T x3, T y3, T z3) {
+    x[0].push_back(x1);
+    y[0].push_back(y1);
+    z[0].push_back(z1);
+    x[1].push_back(x2);
+    y[1].push_back(y2);
+    z[1].push_back(z2);
+    x[2].push_back(x3);
+    y[2].push_back(y3);
+    z[2].push_back(z3);
+    return size() - 1;
+}
+
+template <typename T>
+int TriangleBatch<T>::translate(T d, char axis) {
+    std::vector<T>* lanes;
+    switch (axis) {
+    case 'x':
+        lanes = x;
+        break;
+    case 'y':
+        lanes = y;
+        break;
+    case 'z':
+        lanes = z;
+        break;
+    default:
+        return -1;
+    }
+    for (int v = 0; v < 3; v++) {
+#ifdef BATCH_X86
+        if (selectedKernel == BatchKernel::AVX2) {
+            addAVX2(lanes[v].data(), 0, size(), d);
+            continue;
+        }
+#endif
+        addScalar(lanes[v].data(), 0, size(), d);
+    }
+    return 0;
+}
+
+template <typename T>
+void TriangleBatch<T>::areas(T* out) const {
+    computeAreas(selectedKernel, lanesOf(x, y, z), 0, size(), out);
+}
+
+template <typename T>
+double TriangleBatch<T>::totalArea() const {
+    const Lanes<T> lanes = lanesOf(x, y, z);
+    T block[kAreaBlock];
+    double total = 0.0;
+    for (size_t begin = 0; begin < size(); begin += kAreaBlock) {
+        const size_t end = std::min(size(), begin + kAreaBlock);
+        computeAreas(selectedKernel, lanes, begin, end, block);
+        for (size_t i = 0; i < end - begin; i++) {
+            total += block[i];
+        }
+    }
+    return total;
+}
+
+template <typename T>
+bool TriangleBatch<T>::bounds(T minimum[3], T maximum[3]) const {
+    if (size() == 0) {
+        return false;
+    }
+    const std::vector<T>* axes[3] = { x, y, z };
+    for (int axis = 0; axis < 3; axis++) {
+        minimum[axis] = maximum[axis] = axes[axis][0][0];
+        for (int v = 0; v < 3; v++) {
+#ifdef BATCH_X86
+            if (selectedKernel == BatchKernel::AVX2) {
+                boundsAVX2(axes[axis][v].data(), 0, size(), minimum[axis], maximum[axis]);
+                continue;
+            }
+#endif
+            boundsScalar(axes[axis][v].data(), 0, size(), minimum[axis], maximum[axis]);
+        }
+    }
+    return true;
+}
+
+template <typename T>
+BatchKernel TriangleBatch<T>::bestKernel() {
+#ifdef BATCH_X86
+#if defined(_MSC_VER)
+    int info[4];
+    __cpuid(info, 0);
+    const int maxLeaf = info[0];
+    __cpuid(info, 1);
+    const bool avx = (info[2] & (1 << 28)) && (info[2] & (1 << 27)) && (_xgetbv(0) & 6) == 6;
+    // Leaf 7 holds the AVX2 bit; older CPUs do not have it and answer with another leaf's data
+    bool avx2 = false;
+    if (avx && maxLeaf >= 7) {
+        __cpuidex(info, 7, 0);
+        avx2 = (info[1] & (1 << 5)) != 0;
+    }
+#else
+    const bool avx2 = __builtin_cpu_supports("avx2");
+#endif
+    return avx2 ? BatchKernel::AVX2 : BatchKernel::Scalar;
+#else
+    return BatchKernel::Scalar;
+#endif
+}
+
+template class TriangleBatch<float>;
+template class TriangleBatch<double>;
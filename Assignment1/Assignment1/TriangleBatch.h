@@ -0,0 +1,86 @@
+#pragma once
+
+#include <cstddef>
+#include <vector>
+
+/**
+* Instruction set used by the TriangleBatch kernels.
+ */
+enum class BatchKernel {
+    Scalar,
+    AVX2 // 8 floats or 4 doubles per step
+};
+
+/**
+* Many triangles stored as structure-of-arrays: one contiguous lane per vertex and axis, so
+* the bulk kernels stream through memory instead of chasing three Point pointers per triangle.
+*
+* Areas use the cross product form 0.5 * |(v2 - v1) x (v3 - v1)|, which needs one square root
+* per triangle instead of Heron's four square roots and six pow calls. Each kernel has a scalar
+* and an AVX2 path; the AVX2 one is used when the CPU supports it.
+*
+* @tparam T float or double
+ */
+template <typename T>
+class TriangleBatch {
+public:
+    TriangleBatch() : selectedKernel(bestKernel()) {}
+
+    void reserve(size_t count);
+    void clear();
+
+    /**
+    * Append a triangle.
+    * @return the index of the new triangle
+     */
+    size_t add(T x1, T y1, T z1, T x2, T y2, T z2, T x3, T y3, T z3);
+
+    size_t size() const { return x[0].size(); }
+
+    /**
+    * Translate every triangle along the specified axis by the given distance.
+    * @param d the distance to translate
+    * @param axis the axis to translate along ('x', 'y', or 'z')
+    * @return 0 if successful, -1 if invalid axis
+     */
+    int translate(T d, char axis);
+
+    /**
+    * Calculate the area of every triangle.
+    * @param out receives size() areas
+     */
+    void areas(T* out) const;
+
+    /**
+    * Calculate the sum of all triangle areas, accumulated in double.
+     */
+    double totalArea() const;
+
+    /**
+    * Calculate the axis-aligned bounding box of every vertex in the batch.
+    * @param minimum receives the smallest x, y and z
+    * @param maximum receives the largest x, y and z
+    * @return false if the batch is empty
+     */
+    bool bounds(T minimum[3], T maximum[3]) const;
+
+    /**
+    * Pick the kernel the bulk operations use; the default is the widest the CPU supports.
+    * AVX2 falls back to the scalar kernel on a CPU without it.
+     */
+    void setKernel(BatchKernel kernel) {
+        selectedKernel = kernel == BatchKernel::AVX2 && bestKernel() != BatchKernel::AVX2 ? BatchKernel::Scalar : kernel;
+    }
+    BatchKernel kernel() const { return selectedKernel; }
+
+    /**
+    * The widest kernel this CPU can run.
+     */
+    static BatchKernel bestKernel();
+
+    // Vertex lanes: x[0] holds the x coordinate of every triangle's first vertex, and so on
+    std::vector<T> x[3], y[3], z[3];
+
+private:
+    BatchKernel selectedKernel;
+};
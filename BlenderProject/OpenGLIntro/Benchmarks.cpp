@@ -0,0 +1,1997 @@
+#include "Benchmarks.h"
+#include "FramePipeline.h"
+#include "Headless.h"
+#include "Instancing.h"
+#include "MappedFile.h"
+#include "MeshAnalytics.h"
+#include "MeshBvh.h"
+#include "MeshCache.h"
+#include "MeshIndexer.h"
+#include "MeshOptimizer.h"
+#include "MeshSimplifier.h"
+#include "Meshlets.h"
+#include "ObjParser.h"
+#include "Profiler.h"
+#include "RenderQueue.h"
+#include "SceneTransforms.h"
+#include "ShaderCache.h"
+#include "SoftwareRasterizer.h"
+#include "Telemetry.h"
+#include "ThreadPool.h"
+#include "UploadManager.h"
+#include "VertexQuantization.h"
+
+#include <GL/glew.h>
+#include <GLFW/glfw3.h>
+
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <filesystem>
+#include <functional>
+#include <glm/gtc/matrix_transform.hpp>
+#include <glm/gtc/type_ptr.hpp>
+#include <iostream>
+#include <random>
+#include <string>
+#include <thread>
+#include <vector>
+
+namespace
+{
+    using Clock = std::chrono::steady_clock;
+
+    /**
+     * @brief Runs the callable the given number of times and returns the fastest run in seconds.
+     */
+    double bestOf(int iterations, const std::function<void()> &run)
+    {
+        double best = 1e30;
+        for (int i = 0; i < iterations; ++i)
+        {
+            Clock::time_point start = Clock::now();
+            run();
+            std::chrono::duration<double> elapsed = Clock::now() - start;
+            best = std::min(best, elapsed.count());
+        }
+        return best;
+    }
+
+    int iterationsArg(int argc, char **argv, int index, int fallback)
+    {
+        return argc > index ? std::max(1, std::atoi(argv[index])) : fallback;
+    }
+
+    bool sameMesh(const std::vector<Vertex> &a, const std::vector<Vertex> &b)
+    {
+        return a.size() == b.size() && std::memcmp(a.data(), b.data(), a.size() * sizeof(Vertex)) == 0;
+    }
+
+    int benchObj(int argc, char **argv)
+    {
+        if (argc < 3)
+        {
+            std::cerr << "Usage: " << argv[0] << " --bench-obj <file.obj> [iterations]" << std::endl;
+            return 1;
+        }
+        const std::string path = argv[2];
+        const int iterations = iterationsArg(argc, argv, 3, 5);
+
+        MappedFile file(path);
+        if (!file.isOpen())
+        {
+            std::cerr << "Failed to open OBJ file: " << path << std::endl;
+            return 1;
+        }
+        const double megabytes = file.size() / (1024.0 * 1024.0);
+
+        std::vector<Vertex> streamVertices, fastVertices;
+        std::vector<unsigned int> streamIndices, fastIndices;
+        bool ok = true;
+
+        double streamSeconds = bestOf(iterations, [&]()
+        {
+            streamVertices.clear();
+            streamIndices.clear();
+            ok = loadOBJStream(path, streamVertices, streamIndices) && ok;
+        });
+        double fastSeconds = bestOf(iterations, [&]()
+        {
+            fastVertices.clear();
+            fastIndices.clear();
+            ok = loadOBJ(path, fastVertices, fastIndices) && ok;
+        });
+
+        const double fastMBps = megabytes / fastSeconds;
+        const bool matches = sameMesh(streamVertices, fastVertices) && streamIndices == fastIndices;
+        const bool passed = ok && matches && fastMBps >= kObjParseTargetMBps;
+
+        std::cout << "file: " << path << " (" << megabytes << " MB, " << fastIndices.size() / 3 << " triangles)\n"
+                  << "istringstream loader: " << streamSeconds * 1000.0 << " ms, " << megabytes / streamSeconds << " MB/s\n"
+                  << "mapped loader:        " << fastSeconds * 1000.0 << " ms, " << fastMBps << " MB/s\n"
+                  << "speedup: " << streamSeconds / fastSeconds << "x\n"
+                  << "output matches reference: " << (matches ? "yes" : "no") << "\n"
+                  << "target: " << kObjParseTargetMBps << " MB/s -> " << (passed ? "PASS" : "FAIL") << std::endl;
+        return passed ? 0 : 1;
+    }
+
+    int benchObjThreads(int argc, char **argv)
+    {
+        if (argc < 3)
+        {
+            std::cerr << "Usage: " << argv[0] << " --bench-obj-threads <file.obj> [maxThreads] [iterations]" << std::endl;
+            return 1;
+        }
+        const std::string path = argv[2];
+        const unsigned int maxThreads = argc > 3 ? static_cast<unsigned int>(std::max(1, std::atoi(argv[3])))
+                                                 : std::max(1u, std::thread::hardware_concurrency());
+        const int iterations = iterationsArg(argc, argv, 4, 3);
+
+        MappedFile file(path);
+        if (!file.isOpen())
+        {
+            std::cerr << "Failed to open OBJ file: " << path << std::endl;
+            return 1;
+        }
+        const double megabytes = file.size() / (1024.0 * 1024.0);
+
+        std::vector<unsigned int> threadCounts;
+        for (unsigned int threads = 1; threads < maxThreads; threads *= 2)
+        {
+            threadCounts.push_back(threads);
+        }
+        threadCounts.push_back(maxThreads);
+
+        std::vector<Vertex> serialVertices;
+        std::vector<unsigned int> serialIndices;
+        double serialSeconds = 0.0;
+        bool allMatch = true;
+
+        std::cout << "file: " << path << " (" << megabytes << " MB), hardware threads: "
+                  << std::thread::hardware_concurrency() << "\n"
+                  << "threads\tms\tMB/s\tspeedup\tidentical\n";
+        for (unsigned int threads : threadCounts)
+        {
+            std::vector<Vertex> vertices;
+            std::vector<unsigned int> indices;
+            bool ok = true;
+            double seconds = bestOf(iterations, [&]()
+            {
+                vertices.clear();
+                indices.clear();
+                ok = loadOBJ(path, vertices, indices, threads) && ok;
+            });
+            if (!ok)
+            {
+                return 1;
+            }
+            if (threads == 1)
+            {
+                serialVertices = vertices;
+                serialIndices = indices;
+                serialSeconds = seconds;
+            }
+            const bool identical = sameMesh(serialVertices, vertices) && serialIndices == indices;
+            allMatch = allMatch && identical;
+            std::cout << threads << "\t" << seconds * 1000.0 << "\t" << megabytes / seconds << "\t"
+                      << serialSeconds / seconds << "x\t" << (identical ? "yes" : "no") << "\n";
+        }
+        std::cout.flush();
+        return allMatch ? 0 : 1;
+    }
+
+    int benchWeld(int argc, char **argv)
+    {
+        if (argc < 3)
+        {
+            std::cerr << "Usage: " << argv[0] << " --bench-weld <file.obj> [iterations]" << std::endl;
+            return 1;
+        }
+        const std::string path = argv[2];
+        const int iterations = iterationsArg(argc, argv, 3, 5);
+
+        ObjData data;
+        if (!loadOBJData(path, data, 0))
+        {
+            return 1;
+        }
+
+        std::vector<Vertex> expandedVertices, weldedVertices;
+        std::vector<unsigned int> expandedIndices, weldedIndices;
+        WeldStats stats;
+        double expandSeconds = bestOf(iterations, [&]()
+        {
+            expandedVertices.clear();
+            expandedIndices.clear();
+            expandOBJ(data, expandedVertices, expandedIndices);
+        });
+        double weldSeconds = bestOf(iterations, [&]()
+        {
+            weldedVertices.clear();
+            weldedIndices.clear();
+            weldOBJ(data, weldedVertices, weldedIndices, &stats);
+        });
+
+        // Every welded corner must still produce the vertex the unwelded mesh had there
+        bool matches = weldedIndices.size() == expandedIndices.size();
+        for (size_t i = 0; matches && i < weldedIndices.size(); ++i)
+        {
+            matches = std::memcmp(&weldedVertices[weldedIndices[i]], &expandedVertices[expandedIndices[i]], sizeof(Vertex)) == 0;
+        }
+
+        printWeldStats(path, stats);
+        std::cout << "expand: " << expandSeconds * 1000.0 << " ms, weld: " << weldSeconds * 1000.0 << " ms ("
+                  << stats.inputVertices / weldSeconds / 1e6 << " M corners/s)\n"
+                  << "welded mesh matches: " << (matches ? "yes" : "no") << std::endl;
+        return matches ? 0 : 1;
+    }
+
+    int benchStartup(int argc, char **argv)
+    {
+        if (argc < 3)
+        {
+            std::cerr << "Usage: " << argv[0] << " --bench-startup <file.obj> [iterations]" << std::endl;
+            return 1;
+        }
+        const std::string path = argv[2];
+        const int iterations = iterationsArg(argc, argv, 3, 5);
+        const std::string cachePath = meshCachePath(path);
+
+        // Reading one byte per page stands in for the upload, which would touch every page
+        auto touchPages = [](const void *data, size_t bytes)
+        {
+            const volatile char *p = static_cast<const char *>(data);
+            unsigned int sum = 0;
+            for (size_t offset = 0; offset < bytes; offset += 4096)
+            {
+                sum += static_cast<unsigned char>(p[offset]);
+            }
+            return sum;
+        };
+
+        size_t vertexCount = 0, indexCount = 0;
+        bool coldOk = true, warmOk = true;
+        double coldSeconds = bestOf(iterations, [&]()
+        {
+            std::remove(cachePath.c_str());
+            CachedMesh mesh;
+            coldOk = loadMeshWithCache(path, mesh, 0, defaultLodRatios()) && !mesh.fromCache && coldOk;
+            touchPages(mesh.vertexData, mesh.vertexCount * sizeof(Vertex));
+            touchPages(mesh.indexData, mesh.indexCount * sizeof(unsigned int));
+        });
+        double warmSeconds = bestOf(iterations, [&]()
+        {
+            CachedMesh mesh;
+            warmOk = loadMeshWithCache(path, mesh, 0, defaultLodRatios()) && mesh.fromCache && warmOk;
+            touchPages(mesh.vertexData, mesh.vertexCount * sizeof(Vertex));
+            touchPages(mesh.indexData, mesh.indexCount * sizeof(unsigned int));
+            vertexCount = mesh.vertexCount;
+            indexCount = mesh.indexCount;
+        });
+
+        std::cout << "file: " << path << " (" << vertexCount << " vertices, " << indexCount / 3 << " triangles)\n"
+                  << "cold (parse + weld + LODs + write cache): " << coldSeconds * 1000.0 << " ms\n"
+                  << "warm (mapped cache):                      " << warmSeconds * 1000.0 << " ms\n"
+                  << "speedup: " << coldSeconds / warmSeconds << "x" << std::endl;
+        return coldOk && warmOk ? 0 : 1;
+    }
+
+    int benchVertexCache(int argc, char **argv)
+    {
+        if (argc < 3)
+        {
+            std::cerr << "Usage: " << argv[0] << " --bench-vcache <file.obj>" << std::endl;
+            return 1;
+        }
+        const std::string path = argv[2];
+
+        std::vector<Vertex> vertices;
+        std::vector<unsigned int> indices;
+        if (!loadOBJIndexed(path, vertices, indices, nullptr, 0))
+        {
+            return 1;
+        }
+        const std::vector<Vertex> originalVertices = vertices;
+        const std::vector<unsigned int> originalIndices = indices;
+
+        MeshOptimizeStats stats;
+        optimizeMesh(vertices, indices, &stats);
+        printMeshOptimizeStats(path, stats);
+
+        // The reordered mesh must contain the same triangles, in any order and rotation
+        auto canonicalTriangles = [](const std::vector<Vertex> &v, const std::vector<unsigned int> &idx)
+        {
+            std::vector<std::vector<float>> triangles;
+            for (size_t t = 0; t + 2 < idx.size(); t += 3)
+            {
+                std::vector<std::vector<float>> corners;
+                for (int c = 0; c < 3; ++c)
+                {
+                    const Vertex &vertex = v[idx[t + c]];
+                    corners.push_back({vertex.Position.x, vertex.Position.y, vertex.Position.z,
+                                       vertex.Normal.x, vertex.Normal.y, vertex.Normal.z});
+                }
+                size_t first = std::min_element(corners.begin(), corners.end()) - corners.begin();
+                std::vector<float> triangle;
+                for (int c = 0; c < 3; ++c)
+                {
+                    const std::vector<float> &corner = corners[(first + c) % 3];
+                    triangle.insert(triangle.end(), corner.begin(), corner.end());
+                }
+                triangles.push_back(triangle);
+            }
+            std::sort(triangles.begin(), triangles.end());
+            return triangles;
+        };
+        const bool sameTriangles = canonicalTriangles(originalVertices, originalIndices) == canonicalTriangles(vertices, indices);
+
+        std::cout << "triangles " << stats.after.triangles << ", vertices " << originalVertices.size() << " -> " << vertices.size() << "\n";
+        for (unsigned int cacheSize : {8u, 16u, 32u})
+        {
+            std::cout << "FIFO " << cacheSize << ": ACMR " << analyzeVertexCache(originalIndices, originalVertices.size(), cacheSize).acmr()
+                      << " -> " << analyzeVertexCache(indices, vertices.size(), cacheSize).acmr() << "\n";
+        }
+        std::cout << "same triangles: " << (sameTriangles ? "yes" : "no") << std::endl;
+        return sameTriangles ? 0 : 1;
+    }
+
+    int benchQuantize(int argc, char **argv)
+    {
+        if (argc < 3)
+        {
+            std::cerr << "Usage: " << argv[0] << " --bench-quantize <file.obj>" << std::endl;
+            return 1;
+        }
+        const std::string path = argv[2];
+
+        std::vector<Vertex> vertices;
+        std::vector<unsigned int> indices;
+        if (!loadOBJIndexed(path, vertices, indices, nullptr, 0))
+        {
+            return 1;
+        }
+
+        const size_t indexBytes = indices.size() * sizeof(unsigned int);
+        for (NormalEncoding encoding : {NormalEncoding::Octahedral16, NormalEncoding::Packed1010102})
+        {
+            QuantizedMesh packed;
+            QuantizationStats stats;
+            Clock::time_point start = Clock::now();
+            quantizeMesh(vertices.data(), vertices.size(), encoding, packed, &stats);
+            std::chrono::duration<double> elapsed = Clock::now() - start;
+            printQuantizationStats(path, encoding, stats);
+            std::cout << "  vertex + index buffers: " << (stats.floatBytes + indexBytes) / 1024 << " KB -> "
+                      << (stats.packedBytes + indexBytes) / 1024 << " KB, quantize + verify " << elapsed.count() * 1000.0 << " ms\n";
+        }
+        std::cout.flush();
+        return 0;
+    }
+
+    int benchMeshlets(int argc, char **argv)
+    {
+        if (argc < 3)
+        {
+            std::cerr << "Usage: " << argv[0] << " --bench-meshlets <file.obj> [cameraSteps]" << std::endl;
+            return 1;
+        }
+        const std::string path = argv[2];
+        const int steps = iterationsArg(argc, argv, 3, 360);
+
+        std::vector<Vertex> vertices;
+        std::vector<unsigned int> indices;
+        if (!loadOBJIndexed(path, vertices, indices, nullptr, 0))
+        {
+            return 1;
+        }
+        optimizeMesh(vertices, indices);
+
+        MeshletSet set;
+        double buildSeconds = bestOf(1, [&]()
+        {
+            buildMeshlets(vertices.data(), vertices.size(), indices.data(), indices.size(), set);
+        });
+        const size_t meshletCount = set.meshlets.size();
+        std::cout << "triangles " << indices.size() / 3 << ", meshlets " << meshletCount << " (avg "
+                  << static_cast<double>(indices.size() / 3) / std::max<size_t>(1, meshletCount)
+                  << " triangles), built in " << buildSeconds * 1000.0 << " ms\n";
+
+        glm::vec3 minimum(0.0f), maximum(0.0f);
+        if (!vertices.empty())
+        {
+            minimum = maximum = vertices[0].Position;
+        }
+        for (const Vertex &vertex : vertices)
+        {
+            minimum = glm::min(minimum, vertex.Position);
+            maximum = glm::max(maximum, vertex.Position);
+        }
+        const glm::vec3 center = (minimum + maximum) * 0.5f;
+        const float radius = std::max(glm::length(maximum - minimum) * 0.5f, 1e-6f);
+
+        // A rotated, uniformly scaled object, as the viewer produces
+        const glm::mat4 model = glm::scale(glm::rotate(glm::mat4(1.0f), glm::radians(30.0f), glm::vec3(0.0f, 1.0f, 0.0f)),
+                                           glm::vec3(1.5f));
+        const glm::vec3 worldCenter = glm::vec3(model * glm::vec4(center, 1.0f));
+        const float worldRadius = radius * 1.5f;
+        const glm::mat4 projection = glm::perspective(glm::radians(45.0f), 800.0f / 600.0f, worldRadius * 0.01f, worldRadius * 100.0f);
+
+        // A culled meshlet must really be invisible: every vertex outside one clip plane, or every
+        // triangle facing away from the camera
+        auto conservative = [&](const Meshlet &meshlet, bool frustumCulled, const glm::mat4 &view) -> bool
+        {
+            const glm::mat4 clip = projection * view * model;
+            const glm::vec3 eye = glm::vec3(glm::inverse(view * model) * glm::vec4(0.0f, 0.0f, 0.0f, 1.0f));
+            bool outside[6] = {true, true, true, true, true, true};
+            for (unsigned int i = 0; i < meshlet.triangleCount * 3; i += 3)
+            {
+                const unsigned int *triangle = &indices[meshlet.firstIndex + i];
+                const glm::vec3 &a = vertices[triangle[0]].Position;
+                if (!frustumCulled)
+                {
+                    glm::vec3 normal = glm::cross(vertices[triangle[1]].Position - a, vertices[triangle[2]].Position - a);
+                    if (glm::dot(normal, a - eye) < 0.0f)
+                    {
+                        return false;
+                    }
+                    continue;
+                }
+                for (int corner = 0; corner < 3; ++corner)
+                {
+                    glm::vec4 p = clip * glm::vec4(vertices[triangle[corner]].Position, 1.0f);
+                    outside[0] = outside[0] && p.x < -p.w;
+                    outside[1] = outside[1] && p.x > p.w;
+                    outside[2] = outside[2] && p.y < -p.w;
+                    outside[3] = outside[3] && p.y > p.w;
+                    outside[4] = outside[4] && p.z < -p.w;
+                    outside[5] = outside[5] && p.z > p.w;
+                }
+            }
+            return !frustumCulled || outside[0] || outside[1] || outside[2] || outside[3] || outside[4] || outside[5];
+        };
+
+        bool ok = true;
+        struct Orbit
+        {
+            const char *name;
+            float distance; // In bounding radii from the center
+        };
+        for (const Orbit &orbit : {Orbit{"far orbit", 3.0f}, Orbit{"near orbit", 0.8f}})
+        {
+            MeshletCullOptions frustumOnly;
+            frustumOnly.backface = false;
+            MeshletDrawList frustumList, drawList;
+            size_t frustumCulled = 0, backfaceCulled = 0, visibleTriangles = 0, draws = 0, violations = 0;
+            double cullSeconds = 0.0;
+            for (int step = 0; step < steps; ++step)
+            {
+                const float angle = glm::radians(360.0f * step / steps);
+                const glm::vec3 eye = worldCenter + worldRadius * orbit.distance *
+                                      glm::vec3(std::cos(angle), 0.3f, std::sin(angle));
+                const glm::mat4 view = glm::lookAt(eye, worldCenter, glm::vec3(0.0f, 1.0f, 0.0f));
+
+                Clock::time_point start = Clock::now();
+                cullMeshlets(set, model, view, projection, MeshletCullOptions(), drawList);
+                std::chrono::duration<double> elapsed = Clock::now() - start;
+                cullSeconds += elapsed.count();
+
+                cullMeshlets(set, model, view, projection, frustumOnly, frustumList);
+                for (size_t m = 0; m < meshletCount; ++m)
+                {
+                    if (!drawList.visible[m] && !conservative(set.meshlets[m], !frustumList.visible[m], view))
+                    {
+                        ++violations;
+                    }
+                }
+                frustumCulled += drawList.frustumCulled;
+                backfaceCulled += drawList.backfaceCulled;
+                visibleTriangles += drawList.visibleTriangles;
+                draws += drawList.counts.size();
+            }
+
+            const double total = static_cast<double>(meshletCount) * steps;
+            std::cout << orbit.name << " (" << steps << " cameras): culled " << (frustumCulled + backfaceCulled) / total * 100.0
+                      << "% of meshlets (frustum " << frustumCulled / total * 100.0 << "%, back-face " << backfaceCulled / total * 100.0
+                      << "%), triangles drawn " << visibleTriangles / (static_cast<double>(indices.size() / 3) * steps) * 100.0
+                      << "%, " << static_cast<double>(draws) / steps << " draws/frame, cull "
+                      << cullSeconds / total * 1e9 << " ns/meshlet, wrongly culled " << violations << "\n";
+            ok = ok && violations == 0;
+        }
+        std::cout.flush();
+        return ok ? 0 : 1;
+    }
+
+    int benchSimplify(int argc, char **argv)
+    {
+        if (argc < 3)
+        {
+            std::cerr << "Usage: " << argv[0] << " --bench-simplify <file.obj> [ratio ...]" << std::endl;
+            return 1;
+        }
+        const std::string path = argv[2];
+        std::vector<float> ratios;
+        for (int i = 3; i < argc; ++i)
+        {
+            ratios.push_back(static_cast<float>(std::atof(argv[i])));
+        }
+        if (ratios.empty())
+        {
+            ratios = {0.5f, 0.25f, 0.125f, 0.0625f};
+        }
+
+        std::vector<Vertex> vertices;
+        std::vector<unsigned int> indices;
+        if (!loadOBJIndexed(path, vertices, indices, nullptr, 0))
+        {
+            return 1;
+        }
+        optimizeMesh(vertices, indices);
+
+        LodChain chain;
+        buildLodChain(vertices.data(), vertices.size(), indices.data(), indices.size(), ratios, chain);
+        printLodChain(path, chain);
+
+        // Split into two ranges, as two materials would, the chain must not crack along the seam
+        const size_t half = indices.size() / 6 * 3;
+        const std::vector<IndexRange> halves = {{0, half}, {half, indices.size() - half}};
+        LodChain split;
+        buildLodChain(vertices.data(), vertices.size(), indices.data(), indices.size(), ratios, split, SimplifyOptions(), &halves);
+        const size_t sourceOpen = countOpenEdges(vertices.data(), vertices.size(), indices.data(), indices.size());
+        size_t cracked = 0;
+        for (const LodChain *lods : {&chain, &split})
+        {
+            std::cout << (lods == &chain ? "open edges, whole:" : "open edges, two ranges:");
+            for (const MeshLod &level : lods->levels)
+            {
+                const size_t open = countOpenEdges(vertices.data(), vertices.size(), &lods->indices[level.firstIndex], level.indexCount);
+                cracked += open > sourceOpen ? 1 : 0;
+                std::cout << " " << open;
+            }
+            std::cout << "\n";
+        }
+
+        // Every simplified level must index the shared vertex buffer and contain no collapsed triangles
+        size_t invalid = 0;
+        for (size_t l = 1; l < chain.levels.size(); ++l)
+        {
+            const MeshLod &level = chain.levels[l];
+            for (size_t i = level.firstIndex; i + 2 < level.firstIndex + level.indexCount; i += 3)
+            {
+                const unsigned int *triangle = &chain.indices[i];
+                if (triangle[0] >= vertices.size() || triangle[1] >= vertices.size() || triangle[2] >= vertices.size() ||
+                    vertices[triangle[0]].Position == vertices[triangle[1]].Position ||
+                    vertices[triangle[1]].Position == vertices[triangle[2]].Position ||
+                    vertices[triangle[0]].Position == vertices[triangle[2]].Position)
+                {
+                    ++invalid;
+                }
+            }
+        }
+        std::cout << (indices.size() / 3) / chain.seconds / 1e6 << " M input triangles/s, invalid triangles " << invalid
+                  << ", levels with more open edges than the mesh " << cracked << std::endl;
+        return invalid == 0 && cracked == 0 ? 0 : 1;
+    }
+
+    /**
+     * @brief Per-frame cost of animating, writing and uploading instance data through an
+     * InstanceBuffer. Needs a GL context; creates a hidden window for it.
+     */
+    double benchInstanceUpload(std::vector<InstanceTRS> &instances, InstanceFormat format, bool persistent, int frames,
+                               bool &usedPersistent)
+    {
+        GLuint vao = 0;
+        glGenVertexArrays(1, &vao);
+        InstanceBuffer buffer;
+        if (!buffer.create(vao, format, instances.size(), persistent))
+        {
+            glDeleteVertexArrays(1, &vao);
+            return -1.0;
+        }
+        usedPersistent = buffer.isPersistent();
+
+        glFinish();
+        Clock::time_point start = Clock::now();
+        for (int frame = 0; frame < frames; ++frame)
+        {
+            updateInstanceRotations(instances.data(), instances.size(), frame / 60.0f);
+            void *data = buffer.map(instances.size());
+            if (data)
+            {
+                writeInstances(instances.data(), instances.size(), format, data);
+            }
+            buffer.unmap();
+            buffer.draw(0, 0, instances.size());
+        }
+        glFinish();
+        std::chrono::duration<double> elapsed = Clock::now() - start;
+
+        buffer.destroy();
+        glDeleteVertexArrays(1, &vao);
+        return elapsed.count() / frames;
+    }
+
+    int benchInstances(int argc, char **argv)
+    {
+        std::vector<size_t> counts;
+        for (int i = 2; i < argc; ++i)
+        {
+            counts.push_back(static_cast<size_t>(std::max(1, std::atoi(argv[i]))));
+        }
+        if (counts.empty())
+        {
+            counts = {10000, 100000};
+        }
+        const int frames = 120;
+
+        // A hidden window is enough for a context; on a headless machine Mesa's llvmpipe provides one
+        GLFWwindow *window = nullptr;
+        if (glfwInit())
+        {
+            glfwWindowHint(GLFW_CONTEXT_VERSION_MAJOR, 3);
+            glfwWindowHint(GLFW_CONTEXT_VERSION_MINOR, 3);
+            glfwWindowHint(GLFW_OPENGL_PROFILE, GLFW_OPENGL_CORE_PROFILE);
+            glfwWindowHint(GLFW_VISIBLE, GLFW_FALSE);
+            window = glfwCreateWindow(64, 64, "Instance benchmark", NULL, NULL);
+            if (window)
+            {
+                glfwMakeContextCurrent(window);
+                if (glewInit() != GLEW_OK)
+                {
+                    glfwDestroyWindow(window);
+                    window = nullptr;
+                }
+            }
+        }
+        if (!window)
+        {
+            std::cout << "No OpenGL context, measuring preparation only\n";
+        }
+
+        for (size_t count : counts)
+        {
+            std::vector<InstanceTRS> instances;
+            makeInstanceGrid(count, 1.0f, instances);
+            for (InstanceFormat format : {InstanceFormat::CompactTRS, InstanceFormat::Matrix})
+            {
+                const size_t bytes = count * instanceStride(format);
+                std::vector<unsigned char> staging(bytes);
+                int frame = 0;
+                double prepare = bestOf(frames, [&]()
+                {
+                    updateInstanceRotations(instances.data(), instances.size(), frame++ / 60.0f);
+                    writeInstances(instances.data(), instances.size(), format, staging.data());
+                });
+                std::cout << count << " instances, " << (format == InstanceFormat::Matrix ? "mat4" : "TRS ")
+                          << " (" << bytes / 1024 << " KB/frame): prepare " << prepare * 1000.0 << " ms";
+
+                if (window)
+                {
+                    for (bool persistent : {false, true})
+                    {
+                        bool usedPersistent = false;
+                        double upload = benchInstanceUpload(instances, format, persistent, frames, usedPersistent);
+                        if (upload < 0.0 || usedPersistent != persistent)
+                        {
+                            continue;
+                        }
+                        std::cout << ", " << (persistent ? "persistent" : "orphaned") << " " << upload * 1000.0 << " ms ("
+                                  << bytes / upload / (1024.0 * 1024.0) << " MB/s)";
+                    }
+                }
+                std::cout << "\n";
+            }
+        }
+        std::cout.flush();
+
+        if (window)
+        {
+            glfwDestroyWindow(window);
+        }
+        glfwTerminate();
+        return 0;
+    }
+
+    /**
+     * @brief World matrix built the way the viewer used to, one glm call per step.
+     */
+    glm::mat4 glmChain(const glm::vec3 &translation, const glm::vec3 &radians, const glm::vec3 &scale)
+    {
+        glm::mat4 transform = glm::translate(glm::mat4(1.0f), translation);
+        transform = glm::rotate(transform, radians.x, glm::vec3(1.0f, 0.0f, 0.0f));
+        transform = glm::rotate(transform, radians.y, glm::vec3(0.0f, 1.0f, 0.0f));
+        transform = glm::rotate(transform, radians.z, glm::vec3(0.0f, 0.0f, 1.0f));
+        return glm::scale(transform, scale);
+    }
+
+    const char *kernelName(TransformKernel kernel)
+    {
+        return kernel == TransformKernel::AVX ? "AVX" : kernel == TransformKernel::SSE ? "SSE" : "scalar";
+    }
+
+    int benchTransforms(int argc, char **argv)
+    {
+        std::vector<size_t> counts;
+        for (int i = 2; i < argc; ++i)
+        {
+            counts.push_back(static_cast<size_t>(std::max(1, std::atoi(argv[i]))));
+        }
+        if (counts.empty())
+        {
+            counts = {1000, 100000, 1000000};
+        }
+        const int iterations = 10;
+        ThreadPool pool;
+        std::vector<TransformKernel> kernels = {TransformKernel::Scalar};
+        if (TransformSystem::bestKernel() != TransformKernel::Scalar)
+        {
+            kernels.push_back(TransformKernel::SSE);
+        }
+        if (TransformSystem::bestKernel() == TransformKernel::AVX)
+        {
+            kernels.push_back(TransformKernel::AVX);
+        }
+
+        int status = 0;
+        for (size_t count : counts)
+        {
+            std::vector<glm::vec3> translations(count), rotations(count), scales(count);
+            TransformSystem scene;
+            for (size_t i = 0; i < count; ++i)
+            {
+                const float f = static_cast<float>(i);
+                translations[i] = glm::vec3(std::fmod(f, 97.0f), std::fmod(f * 0.37f, 53.0f), -std::fmod(f * 0.11f, 31.0f));
+                rotations[i] = glm::vec3(f * 0.013f, f * 0.029f, f * 0.041f);
+                scales[i] = glm::vec3(0.5f + std::fmod(f, 7.0f) * 0.25f, 1.0f, 2.0f - std::fmod(f, 5.0f) * 0.1f);
+                size_t id = scene.add();
+                scene.setTranslation(id, translations[i]);
+                scene.setRotation(id, rotations[i]);
+                scene.setScale(id, scales[i]);
+            }
+
+            std::vector<glm::mat4> reference(count);
+            double chain = bestOf(iterations, [&]()
+            {
+                for (size_t i = 0; i < count; ++i)
+                {
+                    reference[i] = glmChain(translations[i], rotations[i], scales[i]);
+                }
+            });
+            std::cout << count << " objects: glm chain " << chain * 1000.0 << " ms";
+
+            for (TransformKernel kernel : kernels)
+            {
+                scene.setKernel(kernel);
+                double single = bestOf(iterations, [&]()
+                {
+                    scene.markAllDirty();
+                    scene.update();
+                });
+
+                // Every kernel must match the glm chain it replaces
+                float maxError = 0.0f;
+                const std::vector<glm::mat4> &worlds = scene.worldMatrices();
+                for (size_t i = 0; i < count; ++i)
+                {
+                    for (int c = 0; c < 4; ++c)
+                    {
+                        for (int r = 0; r < 4; ++r)
+                        {
+                            maxError = std::max(maxError, std::fabs(worlds[i][c][r] - reference[i][c][r]));
+                        }
+                    }
+                }
+                if (maxError > 1e-4f)
+                {
+                    status = 1;
+                }
+                std::cout << ", " << kernelName(kernel) << " " << single * 1000.0 << " ms (" << chain / single
+                          << "x, max error " << maxError << ")";
+            }
+
+            scene.setKernel(TransformSystem::bestKernel());
+            double threaded = bestOf(iterations, [&]()
+            {
+                scene.markAllDirty();
+                scene.update(&pool);
+            });
+            std::cout << ", " << pool.size() << " threads " << threaded * 1000.0 << " ms (" << chain / threaded << "x)";
+
+            // A typical frame where one object in ten moved; objects that stay put are skipped
+            int frame = 0;
+            double sparse = bestOf(iterations, [&]()
+            {
+                ++frame;
+                for (size_t i = 0; i < count / 10; ++i)
+                {
+                    scene.setTranslation(i, translations[i] + glm::vec3(0.0f, frame * 0.01f, 0.0f));
+                }
+                scene.update(&pool);
+            });
+            std::cout << ", 10% dirty " << sparse * 1000.0 << " ms\n";
+        }
+        std::cout.flush();
+        return status;
+    }
+
+    /**
+     * @brief Covers the whole target with a jittered grid of triangles; with the top-left rule
+     * every pixel must be written exactly once.
+     */
+    bool rasterIsWatertight(int width, int height)
+    {
+        const int columns = 23, rows = 17;
+        std::vector<Vertex> vertices;
+        for (int y = 0; y <= rows; ++y)
+        {
+            for (int x = 0; x <= columns; ++x)
+            {
+                float fx = static_cast<float>(x) / columns, fy = static_cast<float>(y) / rows;
+                if (x > 0 && x < columns && y > 0 && y < rows)
+                {
+                    fx += 0.3f / columns * std::sin(x * 12.9898f + y * 78.233f);
+                    fy += 0.3f / rows * std::cos(x * 39.346f + y * 11.135f);
+                }
+                vertices.push_back({glm::vec3(fx * 2.0f - 1.0f, fy * 2.0f - 1.0f, 0.0f), glm::vec3(0.0f, 0.0f, 1.0f)});
+            }
+        }
+        std::vector<unsigned int> indices;
+        for (int y = 0; y < rows; ++y)
+        {
+            for (int x = 0; x < columns; ++x)
+            {
+                unsigned int a = y * (columns + 1) + x, b = a + 1, c = a + columns + 1, d = c + 1;
+                // Alternate the diagonal so edges of every slope meet
+                if ((x + y) & 1)
+                {
+                    indices.insert(indices.end(), {a, b, d, a, d, c});
+                }
+                else
+                {
+                    indices.insert(indices.end(), {a, b, c, b, d, c});
+                }
+            }
+        }
+
+        SoftwareRasterizer rasterizer(width, height);
+        rasterizer.clear(glm::vec3(0.0f));
+        RasterOptions options;
+        options.depthTest = false;
+        const glm::mat4 identity(1.0f);
+        RasterStats stats = rasterizer.draw(vertices.data(), vertices.size(), indices.data(), indices.size(),
+                                            identity, identity, identity, options);
+        size_t untouched = 0;
+        for (int y = 0; y < height; ++y)
+        {
+            for (int x = 0; x < width; ++x)
+            {
+                untouched += rasterizer.pixel(x, y) == 0xFF000000u;
+            }
+        }
+        const size_t expected = static_cast<size_t>(width) * height;
+        std::cout << "watertight check: " << stats.pixels << " pixels written for " << expected << ", " << untouched
+                  << " missed\n";
+        return stats.pixels == expected && untouched == 0;
+    }
+
+    int benchRaster(int argc, char **argv)
+    {
+        if (argc < 3)
+        {
+            std::cerr << "Usage: " << argv[0] << " --bench-raster <file.obj> [frames]" << std::endl;
+            return 1;
+        }
+        const std::string path = argv[2];
+        const int frames = iterationsArg(argc, argv, 3, 20);
+        const int width = 800, height = 600;
+
+        int status = rasterIsWatertight(width, height) ? 0 : 1;
+
+        std::vector<Vertex> vertices;
+        std::vector<unsigned int> indices;
+        if (!loadOBJIndexed(path, vertices, indices, nullptr, 0))
+        {
+            return 1;
+        }
+        optimizeMesh(vertices, indices);
+
+        glm::vec3 minimum(0.0f), maximum(0.0f);
+        if (!vertices.empty())
+        {
+            minimum = maximum = vertices[0].Position;
+        }
+        for (const Vertex &vertex : vertices)
+        {
+            minimum = glm::min(minimum, vertex.Position);
+            maximum = glm::max(maximum, vertex.Position);
+        }
+        const glm::vec3 center = (minimum + maximum) * 0.5f;
+        const float radius = std::max(glm::length(maximum - minimum) * 0.5f, 1e-6f);
+        const glm::mat4 view = glm::lookAt(center + glm::vec3(0.0f, 0.0f, radius * 2.5f), center, glm::vec3(0.0f, 1.0f, 0.0f));
+        const glm::mat4 projection = glm::perspective(glm::radians(45.0f), static_cast<float>(width) / height, radius * 0.1f, radius * 10.0f);
+        const size_t triangles = indices.size() / 3;
+        std::cout << path << ": " << triangles << " triangles at " << width << "x" << height << "\n";
+
+        SoftwareRasterizer rasterizer(width, height);
+        std::vector<unsigned int> threadCounts = {1};
+        if (std::thread::hardware_concurrency() > 1)
+        {
+            threadCounts.push_back(std::thread::hardware_concurrency());
+        }
+        for (unsigned int threads : threadCounts)
+        {
+            ThreadPool pool(threads);
+            for (RasterMode mode : {RasterMode::Fill, RasterMode::Wireframe})
+            {
+                RasterOptions options;
+                options.mode = mode;
+                options.depthTest = mode == RasterMode::Fill; // The viewer draws its wireframe without depth
+                RasterStats stats;
+                int frame = 0;
+                double seconds = bestOf(frames, [&]()
+                {
+                    // Orbit so every frame bins differently
+                    const glm::mat4 transform = glm::translate(glm::mat4(1.0f), center) *
+                                                glm::rotate(glm::mat4(1.0f), frame++ * 0.1f, glm::vec3(0.0f, 1.0f, 0.0f)) *
+                                                glm::translate(glm::mat4(1.0f), -center);
+                    rasterizer.clear(glm::vec3(0.2f, 0.3f, 0.3f));
+                    stats = rasterizer.draw(vertices.data(), vertices.size(), indices.data(), indices.size(),
+                                            transform, view, projection, options, &pool);
+                });
+                std::cout << (mode == RasterMode::Fill ? "fill     " : "wireframe") << " " << threads << " threads: "
+                          << seconds * 1000.0 << " ms/frame, " << triangles / seconds / 1e6 << " Mtris/s, "
+                          << stats.pixels / seconds / 1e6 << " Mpix/s (" << stats.rasterizedTriangles << " triangles, "
+                          << stats.pixels << " pixels drawn)\n";
+            }
+        }
+        std::cout.flush();
+        return status;
+    }
+
+    /**
+     * @brief Nearest hit by testing every triangle, the loop the BVH replaces.
+     */
+    RayHit bruteForceHit(const std::vector<Vertex> &vertices, const std::vector<unsigned int> &indices, const Ray &ray)
+    {
+        RayHit best;
+        best.t = ray.tMax;
+        for (size_t triangle = 0; triangle * 3 + 2 < indices.size(); ++triangle)
+        {
+            const glm::vec3 &v0 = vertices[indices[triangle * 3]].Position;
+            const glm::vec3 e1 = vertices[indices[triangle * 3 + 1]].Position - v0;
+            const glm::vec3 e2 = vertices[indices[triangle * 3 + 2]].Position - v0;
+            const glm::vec3 p = glm::cross(ray.direction, e2);
+            const float det = glm::dot(e1, p);
+            if (det == 0.0f)
+            {
+                continue;
+            }
+            const glm::vec3 s = ray.origin - v0;
+            const float u = glm::dot(s, p) / det;
+            const glm::vec3 q = glm::cross(s, e1);
+            const float v = glm::dot(ray.direction, q) / det;
+            const float t = glm::dot(e2, q) / det;
+            if (u >= 0.0f && v >= 0.0f && u + v <= 1.0f && t > ray.tMin && t < best.t)
+            {
+                best.t = t;
+                best.u = u;
+                best.v = v;
+                best.triangle = static_cast<unsigned int>(triangle);
+            }
+        }
+        if (!best.hit())
+        {
+            best.t = std::numeric_limits<float>::infinity();
+        }
+        return best;
+    }
+
+    int benchBvh(int argc, char **argv)
+    {
+        if (argc < 3)
+        {
+            std::cerr << "Usage: " << argv[0] << " --bench-bvh <file.obj> [iterations]" << std::endl;
+            return 1;
+        }
+        const std::string path = argv[2];
+        const int iterations = iterationsArg(argc, argv, 3, 5);
+
+        std::vector<Vertex> vertices;
+        std::vector<unsigned int> indices;
+        if (!loadOBJIndexed(path, vertices, indices, nullptr, 0))
+        {
+            return 1;
+        }
+        std::cout << path << ": " << indices.size() / 3 << " triangles\n";
+
+        // Build on one thread and on all of them; the trees must come out the same
+        MeshBvh bvh, parallelBvh;
+        BvhBuildStats stats, parallelStats;
+        ThreadPool pool;
+        const double serialSeconds = bestOf(iterations, [&]() { stats = bvh.build(vertices.data(), vertices.size(), indices.data(), indices.size()); });
+        const double parallelSeconds = bestOf(iterations, [&]()
+        {
+            parallelStats = parallelBvh.build(vertices.data(), vertices.size(), indices.data(), indices.size(), &pool);
+        });
+        const bool sameTree = bvh.nodes().size() == parallelBvh.nodes().size() &&
+                              std::memcmp(bvh.nodes().data(), parallelBvh.nodes().data(), bvh.nodes().size() * sizeof(BvhNode)) == 0;
+        std::cout << "build: " << serialSeconds * 1000.0 << " ms on 1 thread, " << parallelSeconds * 1000.0 << " ms on "
+                  << pool.size() << " threads" << (sameTree ? "" : " (TREES DIFFER)") << "; " << stats.nodes << " nodes, "
+                  << stats.leaves << " leaves, depth " << stats.depth << ", SAH cost " << stats.sahCost << "\n";
+
+        // Camera rays through a 512x512 image, looking at the model from the front
+        glm::vec3 minimum(0.0f), maximum(0.0f);
+        if (!vertices.empty())
+        {
+            minimum = maximum = vertices[0].Position;
+        }
+        for (const Vertex &vertex : vertices)
+        {
+            minimum = glm::min(minimum, vertex.Position);
+            maximum = glm::max(maximum, vertex.Position);
+        }
+        const glm::vec3 center = (minimum + maximum) * 0.5f;
+        const float radius = std::max(glm::length(maximum - minimum) * 0.5f, 1e-6f);
+        const glm::vec3 eye = center + glm::vec3(0.0f, radius * 0.3f, radius * 2.5f);
+        const glm::mat4 toWorld = glm::inverse(glm::perspective(glm::radians(45.0f), 1.0f, radius * 0.1f, radius * 10.0f) *
+                                               glm::lookAt(eye, center, glm::vec3(0.0f, 1.0f, 0.0f)));
+        const int size = 512;
+        std::vector<Ray> rays(static_cast<size_t>(size) * size);
+        for (int y = 0; y < size; y += 2)
+        {
+            for (int x = 0; x < size; x += 2)
+            {
+                // Stored as 2x2 blocks so every four consecutive rays form a coherent packet
+                Ray *block = &rays[(static_cast<size_t>(y) * size + x * 2)];
+                for (int lane = 0; lane < 4; ++lane)
+                {
+                    const float ndcX = (x + (lane & 1) + 0.5f) / size * 2.0f - 1.0f;
+                    const float ndcY = 1.0f - (y + (lane >> 1) + 0.5f) / size * 2.0f;
+                    const glm::vec4 target = toWorld * glm::vec4(ndcX, ndcY, 1.0f, 1.0f);
+                    block[lane].origin = eye;
+                    block[lane].direction = glm::vec3(target) / target.w - eye;
+                }
+            }
+        }
+
+        std::vector<RayHit> hits(rays.size()), packetHits(rays.size());
+        const double singleSeconds = bestOf(iterations, [&]()
+        {
+            for (size_t i = 0; i < rays.size(); ++i)
+            {
+                hits[i] = RayHit();
+                bvh.intersect(rays[i], hits[i]);
+            }
+        });
+        const double packetSeconds = bestOf(iterations, [&]()
+        {
+            for (size_t i = 0; i < rays.size(); i += 4)
+            {
+                bvh.intersect4(&rays[i], &packetHits[i]);
+            }
+        });
+        size_t occludedCount = 0;
+        const double occlusionSeconds = bestOf(iterations, [&]()
+        {
+            occludedCount = 0;
+            for (const Ray &ray : rays)
+            {
+                occludedCount += bvh.occluded(ray);
+            }
+        });
+
+        size_t hitCount = 0, mismatches = 0;
+        for (size_t i = 0; i < rays.size(); ++i)
+        {
+            hitCount += hits[i].hit();
+            // Rays through a shared edge may report either triangle, so compare distances
+            mismatches += hits[i].hit() != packetHits[i].hit() || (hits[i].hit() && std::fabs(hits[i].t - packetHits[i].t) > 1e-5f * hits[i].t);
+        }
+        mismatches += occludedCount != hitCount;
+
+        // The brute-force loop is far too slow for every ray; compare on a sample
+        const size_t stride = std::max<size_t>(1, rays.size() / 256);
+        size_t sampled = 0;
+        Clock::time_point start = Clock::now();
+        for (size_t i = 0; i < rays.size(); i += stride, ++sampled)
+        {
+            const RayHit reference = bruteForceHit(vertices, indices, rays[i]);
+            if (reference.hit() != hits[i].hit() || (reference.hit() && std::fabs(reference.t - hits[i].t) > 1e-4f * reference.t))
+            {
+                ++mismatches;
+            }
+        }
+        std::chrono::duration<double> bruteSeconds = Clock::now() - start;
+
+        const double rayCount = static_cast<double>(rays.size());
+        std::cout << "single rays: " << rayCount / singleSeconds / 1e6 << " Mrays/s (" << hitCount << " of " << rays.size() << " hit)\n";
+        std::cout << "4-ray packets: " << rayCount / packetSeconds / 1e6 << " Mrays/s\n";
+        std::cout << "occlusion: " << rayCount / occlusionSeconds / 1e6 << " Mrays/s\n";
+        std::cout << "brute force: " << sampled / bruteSeconds.count() / 1e6 << " Mrays/s over " << sampled << " sampled rays\n";
+        std::cout << (mismatches == 0 ? "all queries agree" : "QUERIES DISAGREE") << " (" << mismatches << " mismatches)" << std::endl;
+        return sameTree && mismatches == 0 ? 0 : 1;
+    }
+
+    bool sameStats(const MeshStats &a, const MeshStats &b)
+    {
+        return a.triangles == b.triangles && a.vertices == b.vertices && a.degenerateTriangles == b.degenerateTriangles &&
+               a.surfaceArea == b.surfaceArea && a.signedVolume == b.signedVolume && a.boundsMin == b.boundsMin &&
+               a.boundsMax == b.boundsMax && a.sphereCenter == b.sphereCenter && a.sphereRadius == b.sphereRadius;
+    }
+
+    std::ostream &operator<<(std::ostream &out, const glm::vec3 &v)
+    {
+        return out << "(" << v.x << ", " << v.y << ", " << v.z << ")";
+    }
+
+    int benchAnalytics(int argc, char **argv)
+    {
+        if (argc < 3)
+        {
+            std::cerr << "Usage: " << argv[0] << " --bench-analytics <file.obj> [iterations]" << std::endl;
+            return 1;
+        }
+        const std::string path = argv[2];
+        const int iterations = iterationsArg(argc, argv, 3, 5);
+
+        std::vector<Vertex> vertices;
+        std::vector<unsigned int> indices;
+        bool loaded = true;
+        const double loadSeconds = bestOf(1, [&]() { loaded = loadOBJ(path, vertices, indices, 0); });
+        if (!loaded)
+        {
+            return 1;
+        }
+
+        // One thread and all of them; the sums must agree to the last bit
+        ThreadPool pool;
+        MeshStats stats, parallelStats;
+        const double serialSeconds = bestOf(iterations, [&]()
+        {
+            stats = computeMeshStats(vertices.data(), vertices.size(), indices.data(), indices.size());
+        });
+        const double parallelSeconds = bestOf(iterations, [&]()
+        {
+            parallelStats = computeMeshStats(vertices.data(), vertices.size(), indices.data(), indices.size(), &pool);
+        });
+        const bool sameResult = sameStats(stats, parallelStats);
+
+        std::vector<glm::vec3> faceNormals;
+        const double normalSeconds = bestOf(iterations, [&]()
+        {
+            computeTriangleNormals(vertices.data(), indices.data(), indices.size(), faceNormals, &pool);
+        });
+
+        // Drop the file's normals to time the fallback, then see how far it lands from them
+        size_t missing = 0;
+        for (const Vertex &vertex : vertices)
+        {
+            missing += vertex.Normal == glm::vec3(0.0f);
+        }
+        std::vector<Vertex> stripped = vertices;
+        size_t generated = 0;
+        double smoothSeconds = 1e30;
+        for (int i = 0; i < iterations; ++i)
+        {
+            for (Vertex &vertex : stripped)
+            {
+                vertex.Normal = glm::vec3(0.0f);
+            }
+            smoothSeconds = std::min(smoothSeconds, bestOf(1, [&]()
+            {
+                generated = generateSmoothNormals(stripped.data(), stripped.size(), indices.data(), indices.size(), &pool);
+            }));
+        }
+        double angleSum = 0.0;
+        size_t compared = 0;
+        for (size_t v = 0; v < vertices.size(); ++v)
+        {
+            if (vertices[v].Normal != glm::vec3(0.0f) && stripped[v].Normal != glm::vec3(0.0f))
+            {
+                const float cosine = glm::dot(glm::normalize(vertices[v].Normal), stripped[v].Normal);
+                angleSum += std::acos(std::min(1.0f, std::max(-1.0f, cosine)));
+                ++compared;
+            }
+        }
+
+        std::cout << path << ": " << stats.triangles << " triangles, " << stats.vertices << " vertices, "
+                  << stats.degenerateTriangles << " degenerate, loaded in " << loadSeconds * 1000.0 << " ms\n";
+        std::cout << "surface area " << stats.surfaceArea << ", signed volume " << stats.signedVolume << "\n";
+        std::cout << "bounds " << stats.boundsMin << " to " << stats.boundsMax << ", sphere " << stats.sphereCenter
+                  << " radius " << stats.sphereRadius << "\n";
+        std::cout << "stats: " << serialSeconds * 1000.0 << " ms on 1 thread, " << parallelSeconds * 1000.0 << " ms on "
+                  << pool.size() << " threads" << (sameResult ? ", identical" : " (RESULTS DIFFER)") << "\n";
+        std::cout << "triangle normals: " << normalSeconds * 1000.0 << " ms\n";
+        std::cout << "smooth normals: " << smoothSeconds * 1000.0 << " ms for " << generated << " vertices; the file has "
+                  << missing << " corners without vn";
+        if (compared > 0)
+        {
+            std::cout << ", generated normals are " << angleSum / compared * 180.0 / 3.14159265358979 << " degrees from the file's on average";
+        }
+        std::cout << std::endl;
+        return sameResult ? 0 : 1;
+    }
+
+    /**
+     * @brief Runs a synthetic frame loop at pipeline depths 0 to 2: the update busy-waits like
+     * CPU work and the render sleeps like a thread blocked in the driver, so deeper pipelines
+     * should approach the slower of the two per frame instead of their sum.
+     */
+    int benchPipeline(int argc, char **argv)
+    {
+        const int frames = iterationsArg(argc, argv, 2, 300);
+        const std::chrono::microseconds updateCost(3000);
+        const std::chrono::microseconds renderCost(4000);
+        std::cout << frames << " frames, " << updateCost.count() / 1000.0 << " ms update, " << renderCost.count() / 1000.0
+                  << " ms render\n";
+
+        struct Input
+        {
+            int frame;
+        };
+        struct State
+        {
+            int frame;
+        };
+
+        bool ok = true;
+        double sequentialFps = 0.0;
+        for (unsigned int depth = 0; depth <= 2; ++depth)
+        {
+            FramePipeline<Input, State> pipeline(depth, [&](const Input &input, State &state)
+            {
+                const Clock::time_point until = Clock::now() + updateCost;
+                while (Clock::now() < until)
+                {
+                }
+                state.frame = input.frame;
+            });
+
+            // Frames must come out in submission order with none skipped
+            int submitted = 0;
+            bool inOrder = true;
+            for (int rendered = 0; rendered < frames; ++rendered)
+            {
+                do
+                {
+                    pipeline.submit({submitted++});
+                } while (!pipeline.frameReady());
+                inOrder = inOrder && pipeline.acquire().frame == rendered;
+                std::this_thread::sleep_for(renderCost);
+                pipeline.release();
+            }
+
+            const PipelineStats stats = pipeline.stats();
+            printPipelineStats(stats);
+            if (depth == 0)
+            {
+                sequentialFps = stats.framesPerSecond;
+            }
+            else
+            {
+                std::cout << "  " << stats.framesPerSecond / sequentialFps << "x the frame rate of depth 0\n";
+            }
+            if (!inOrder)
+            {
+                std::cout << "  FRAMES OUT OF ORDER\n";
+                ok = false;
+            }
+        }
+        return ok ? 0 : 1;
+    }
+
+    size_t countLines(std::FILE *file)
+    {
+        std::rewind(file);
+        size_t lines = 0;
+        char buffer[1 << 16];
+        for (size_t read; (read = std::fread(buffer, 1, sizeof(buffer), file)) > 0;)
+        {
+            lines += std::count(buffer, buffer + read, '\n');
+        }
+        return lines;
+    }
+
+    /**
+     * @brief Logs bursts of transform-sized events the way the frame loop does, first through
+     * Telemetry and then with a synchronous formatted write and flush per event, and reports what
+     * each costs the logging thread. Both go to a temporary file, and every event must arrive.
+     */
+    int benchTelemetry(int argc, char **argv)
+    {
+        const int frames = iterationsArg(argc, argv, 2, 200);
+        const int eventsPerFrame = iterationsArg(argc, argv, 3, 100);
+        const size_t total = static_cast<size_t>(frames) * eventsPerFrame;
+        // Room for two frames, since the background thread drains while the next frame renders
+        const std::chrono::milliseconds frameGap(2);
+
+        std::FILE *asyncFile = std::tmpfile();
+        std::FILE *syncFile = std::tmpfile();
+        if (!asyncFile || !syncFile)
+        {
+            std::cerr << "Failed to create temporary files" << std::endl;
+            return 1;
+        }
+
+        double asyncSeconds = 0.0;
+        double worstFrame = 0.0;
+        TelemetryStats stats;
+        {
+            TelemetryOptions options;
+            options.text = asyncFile;
+            options.capacity = 2 * eventsPerFrame;
+            Telemetry telemetry(options);
+            for (int frame = 0; frame < frames; ++frame)
+            {
+                const Clock::time_point start = Clock::now();
+                for (int i = 0; i < eventsPerFrame; ++i)
+                {
+                    const float value = frame + i * 0.01f;
+                    TelemetryEvent event("transform");
+                    event.add("xOffset", value).add("yOffset", -value).add("scale", 1.0f).add("rotationX", value * 2.0f);
+                    event.add("rotationY", value * 3.0f).add("rotationZ", 0.0f);
+                    telemetry.log(event);
+                }
+                const double seconds = std::chrono::duration<double>(Clock::now() - start).count();
+                asyncSeconds += seconds;
+                worstFrame = std::max(worstFrame, seconds);
+                std::this_thread::sleep_for(frameGap);
+            }
+            telemetry.flush();
+            stats = telemetry.stats();
+        }
+
+        const double syncSeconds = bestOf(1, [&]()
+        {
+            for (int frame = 0; frame < frames; ++frame)
+            {
+                for (int i = 0; i < eventsPerFrame; ++i)
+                {
+                    const float value = frame + i * 0.01f;
+                    std::fprintf(syncFile, "xOffset: %g yOffset: %g scale: %g rotationX: %g rotationY: %g rotationZ: %g\n",
+                                 value, -value, 1.0, value * 2.0, value * 3.0, 0.0);
+                    std::fflush(syncFile);
+                }
+            }
+        });
+
+        // Sampling and rate limiting turn an event away before it is built
+        TelemetryChannel channel(4, 1000.0);
+        size_t admitted = 0;
+        const double admitSeconds = bestOf(3, [&]()
+        {
+            for (size_t i = 0; i < total; ++i)
+            {
+                admitted += channel.admit();
+            }
+        });
+
+        const size_t asyncLines = countLines(asyncFile);
+        const size_t syncLines = countLines(syncFile);
+        std::fclose(asyncFile);
+        std::fclose(syncFile);
+
+        const double asyncNanoseconds = asyncSeconds * 1e9 / total;
+        std::cout << frames << " frames of " << eventsPerFrame << " events\n";
+        std::cout << "telemetry: " << asyncNanoseconds << " ns per event on the logging thread, worst frame "
+                  << worstFrame * 1e6 << " us; " << stats.logged << " logged, " << stats.dropped << " dropped, "
+                  << asyncLines << " lines written\n";
+        std::cout << "fprintf + fflush: " << syncSeconds * 1e9 / total << " ns per event, " << syncLines << " lines written\n";
+        std::cout << "channel admit (1 in 4, 1000/s): " << admitSeconds * 1e9 / total << " ns per call\n";
+
+        bool ok = true;
+        if (stats.dropped > 0 || asyncLines != total || syncLines != total)
+        {
+            std::cout << "EVENTS LOST\n";
+            ok = false;
+        }
+        if (asyncNanoseconds > kTelemetryTargetLogNanoseconds)
+        {
+            std::cout << "SLOWER THAN TARGET (" << kTelemetryTargetLogNanoseconds << " ns per event)\n";
+            ok = false;
+        }
+        return ok ? 0 : 1;
+    }
+
+    /**
+     * @brief Times a loop of empty zones with profiling stopped and running, against the bare
+     * loop, then records zones on a second thread too and checks the trace has every one.
+     */
+    int benchProfiler(int argc, char **argv)
+    {
+        const int zones = iterationsArg(argc, argv, 2, 200000);
+        const char *tracePath = argc > 3 ? argv[3] : "bench-profile.json";
+        const int iterations = 3;
+        volatile uint64_t sink = 0;
+        auto bareLoop = [&]()
+        {
+            for (int i = 0; i < zones; ++i)
+            {
+                sink = sink + i;
+            }
+        };
+        auto zoneLoop = [&]()
+        {
+            for (int i = 0; i < zones; ++i)
+            {
+                ProfileZone zone("bench zone");
+                sink = sink + i;
+            }
+        };
+
+        const double bareSeconds = bestOf(iterations, bareLoop);
+        const double stoppedSeconds = bestOf(iterations, zoneLoop);
+        profilerStart();
+        profilerSetThreadName("main");
+        const double runningSeconds = bestOf(iterations, zoneLoop);
+        std::thread worker([&]()
+        {
+            profilerSetThreadName("worker");
+            zoneLoop();
+        });
+        worker.join();
+        profilerStop();
+        const long long written = profilerWriteTrace(tracePath);
+        const long long expected = static_cast<long long>(zones) * (iterations + 1);
+
+        std::cout << zones << " zones per loop\n";
+        std::cout << "profiling stopped: " << (stoppedSeconds - bareSeconds) * 1e9 / zones << " ns per zone\n";
+        std::cout << "profiling running: " << (runningSeconds - bareSeconds) * 1e9 / zones << " ns per zone\n";
+        std::cout << "PROFILE_ZONE markers in this build: " << (PROFILE_ZONES ? "compiled in" : "compiled out") << "\n";
+        std::cout << written << " of " << expected << " zones written to " << tracePath << "\n";
+        return written == expected ? 0 : 1;
+    }
+
+    // A vertex shader with enough work in it that the compile time is worth measuring; each
+    // variant unrolls differently
+    const char *kBenchVertexBody = R"glsl(
+    layout (location = 0) in vec3 aPos;
+    uniform mat4 transform;
+    uniform mat4 view;
+    uniform mat4 projection;
+    uniform vec4 waves[16];
+
+    void main() {
+        vec3 p = aPos;
+        for (int i = 0; i < 4 + VARIANT % 8; ++i) {
+            vec4 w = waves[(i + VARIANT) % 16];
+            p += w.xyz * sin(dot(p, w.xyz) * w.w + float(i * VARIANT));
+            p = mix(p, cross(p, w.zxy), 0.125);
+        }
+        gl_Position = projection * view * transform * vec4(p, 1.0);
+    }
+)glsl";
+
+    const char *kBenchFragmentBody = R"glsl(
+    out vec4 color;
+    void main() {
+        color = vec4(1.0, 1.0, 1.0, 1.0);
+    }
+)glsl";
+
+    /**
+     * @brief Builds every variant through a fresh ShaderCache over the given directory.
+     *
+     * @param nonce Goes into every source, so the driver's own shader cache cannot serve a
+     * cold run from an earlier one.
+     * @param requestAllFirst Request every program before asking for any, so the driver can
+     * compile them in parallel; otherwise each is requested and waited for in turn.
+     */
+    ShaderCacheStats buildShaderVariants(const std::string &directory, int variants, const std::string &nonce,
+                                         bool requestAllFirst, double &seconds)
+    {
+        std::vector<std::string> vertexSources, fragmentSources;
+        for (int v = 0; v < variants; ++v)
+        {
+            const std::string header = "#version 330 core\n// " + nonce + "\n#define VARIANT " + std::to_string(v) + "\n";
+            vertexSources.push_back(header + kBenchVertexBody);
+            fragmentSources.push_back(header + kBenchFragmentBody);
+        }
+        const Clock::time_point start = Clock::now();
+        ShaderCache cache(directory);
+        std::vector<size_t> handles;
+        for (int v = 0; v < variants; ++v)
+        {
+            handles.push_back(cache.request("variant", vertexSources[v].c_str(), fragmentSources[v].c_str()));
+            if (!requestAllFirst)
+            {
+                cache.program(handles.back());
+            }
+        }
+        for (size_t handle : handles)
+        {
+            cache.program(handle);
+        }
+        glFinish();
+        seconds = std::chrono::duration<double>(Clock::now() - start).count();
+        const ShaderCacheStats stats = cache.stats();
+        cache.destroy();
+        return stats;
+    }
+
+    /**
+     * @brief Cold and warm shader startup: variants compiled one at a time and all at once with
+     * an empty cache, then restored from the binaries the second run saved.
+     */
+    int benchShaders(int argc, char **argv)
+    {
+        const int variants = iterationsArg(argc, argv, 2, 16);
+        GLFWwindow *window = createOffscreenContext(64, 64, "bench-shaders");
+        if (!window)
+        {
+            return 1;
+        }
+        std::cout << glGetString(GL_RENDERER) << ", " << glGetString(GL_VERSION) << "\n";
+
+        const std::string directory = "bench-shadercache";
+        const std::string nonce = std::to_string(Clock::now().time_since_epoch().count());
+        std::error_code error;
+        std::filesystem::remove_all(directory, error);
+
+        double serialSeconds, batchSeconds, warmSeconds;
+        const ShaderCacheStats serial = buildShaderVariants(directory + "-serial", variants, nonce + "s", false, serialSeconds);
+        const ShaderCacheStats batch = buildShaderVariants(directory, variants, nonce + "b", true, batchSeconds);
+        const ShaderCacheStats warm = buildShaderVariants(directory, variants, nonce + "b", true, warmSeconds);
+        std::filesystem::remove_all(directory, error);
+        std::filesystem::remove_all(directory + "-serial", error);
+
+        std::cout << variants << " programs, " << (batch.binaries ? "program binaries" : "no program binaries") << ", "
+                  << (batch.parallelCompile ? "GL_KHR_parallel_shader_compile" : "no parallel compile") << "\n";
+        std::cout << "cold, one at a time: " << serialSeconds * 1000.0 << " ms, " << serial.compiled << " compiled\n";
+        std::cout << "cold, all requested first: " << batchSeconds * 1000.0 << " ms, " << batch.compiled << " compiled, "
+                  << batch.saved << " saved\n";
+        std::cout << "warm: " << warmSeconds * 1000.0 << " ms, " << warm.loaded << " loaded, " << warm.compiled << " compiled\n";
+
+        glfwDestroyWindow(window);
+        glfwTerminate();
+        const bool failed = serial.failed + batch.failed + warm.failed > 0;
+        if (failed)
+        {
+            std::cout << "PROGRAMS FAILED\n";
+        }
+        if (batch.binaries && warm.loaded != static_cast<size_t>(variants))
+        {
+            std::cout << "WARM RUN DID NOT USE THE CACHE\n";
+            return 1;
+        }
+        return failed ? 1 : 0;
+    }
+
+    // The same draw for both submission paths: one through plain uniforms, one through the
+    // RenderQueue's uniform blocks
+    const char *kSubmissionUniformsHeader = R"glsl(
+    uniform mat4 transform;
+    uniform mat4 view;
+    uniform mat4 projection;
+)glsl";
+
+    const char *kSubmissionBlocksHeader = R"glsl(
+    layout (std140) uniform ObjectBlock {
+        mat4 transform;
+    };
+    layout (std140) uniform FrameBlock {
+        mat4 view;
+        mat4 projection;
+    };
+)glsl";
+
+    const char *kSubmissionVertexBody = R"glsl(
+    layout (location = 0) in vec3 aPos;
+    void main() {
+        gl_Position = projection * view * transform * vec4(aPos * (1.0 + 0.01 * float(VARIANT)), 1.0);
+    }
+)glsl";
+
+    struct SubmissionObject
+    {
+        size_t program;
+        size_t vertexArray;
+        unsigned int material;
+        glm::mat4 transform;
+    };
+
+    /**
+     * @brief Draw submission cost with and without the RenderQueue: objects spread over a few
+     * programs, vertex arrays and materials, submitted in a shuffled order.
+     */
+    int benchSubmission(int argc, char **argv)
+    {
+        const int objectCount = iterationsArg(argc, argv, 2, 4096);
+        const int frames = iterationsArg(argc, argv, 3, 60);
+        const int programCount = 4;
+        const int vertexArrayCount = 8;
+        const unsigned int materialCount = 16;
+        GLFWwindow *window = createOffscreenContext(64, 64, "bench-submission");
+        if (!window)
+        {
+            return 1;
+        }
+        std::cout << glGetString(GL_RENDERER) << ", " << glGetString(GL_VERSION) << "\n";
+
+        const std::string directory = "bench-shadercache-submission";
+        ShaderCache shaders(directory);
+        std::vector<size_t> uniformHandles, blockHandles;
+        std::vector<std::string> sources;
+        for (int v = 0; v < programCount; ++v)
+        {
+            const std::string header = "#version 330 core\n#define VARIANT " + std::to_string(v) + "\n";
+            sources.push_back(header + kSubmissionUniformsHeader + kSubmissionVertexBody);
+            sources.push_back(header + kSubmissionBlocksHeader + kSubmissionVertexBody);
+            sources.push_back(header + kBenchFragmentBody);
+        }
+        for (int v = 0; v < programCount; ++v)
+        {
+            uniformHandles.push_back(shaders.request("uniforms", sources[v * 3].c_str(), sources[v * 3 + 2].c_str()));
+            blockHandles.push_back(shaders.request("blocks", sources[v * 3 + 1].c_str(), sources[v * 3 + 2].c_str()));
+        }
+
+        RenderQueue queue;
+        queue.create(static_cast<size_t>(objectCount));
+        struct UniformProgram
+        {
+            GLuint program;
+            GLint transform, view, projection;
+        };
+        std::vector<UniformProgram> uniformPrograms;
+        std::vector<GLuint> blockPrograms;
+        for (int v = 0; v < programCount; ++v)
+        {
+            const GLuint program = shaders.program(uniformHandles[v]);
+            uniformPrograms.push_back({program, glGetUniformLocation(program, "transform"), glGetUniformLocation(program, "view"),
+                                       glGetUniformLocation(program, "projection")});
+            blockPrograms.push_back(shaders.program(blockHandles[v]));
+            queue.attachProgram(blockPrograms.back());
+        }
+
+        // One triangle per vertex array, each in its own buffers
+        const float triangle[] = {-0.5f, -0.5f, 0.0f, 0.5f, -0.5f, 0.0f, 0.0f, 0.5f, 0.0f};
+        const unsigned int triangleIndices[] = {0, 1, 2};
+        std::vector<GLuint> vertexArrays(vertexArrayCount), buffers(vertexArrayCount * 2);
+        glGenVertexArrays(vertexArrayCount, vertexArrays.data());
+        glGenBuffers(vertexArrayCount * 2, buffers.data());
+        for (int a = 0; a < vertexArrayCount; ++a)
+        {
+            glBindVertexArray(vertexArrays[a]);
+            glBindBuffer(GL_ARRAY_BUFFER, buffers[a * 2]);
+            glBufferData(GL_ARRAY_BUFFER, sizeof(triangle), triangle, GL_STATIC_DRAW);
+            glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, buffers[a * 2 + 1]);
+            glBufferData(GL_ELEMENT_ARRAY_BUFFER, sizeof(triangleIndices), triangleIndices, GL_STATIC_DRAW);
+            glVertexAttribPointer(0, 3, GL_FLOAT, GL_FALSE, 3 * sizeof(float), (void *)0);
+            glEnableVertexAttribArray(0);
+        }
+        glBindVertexArray(0);
+        glBindBuffer(GL_ARRAY_BUFFER, 0);
+
+        std::mt19937 random(7);
+        std::vector<SubmissionObject> objects(static_cast<size_t>(objectCount));
+        for (SubmissionObject &object : objects)
+        {
+            object.program = random() % programCount;
+            object.vertexArray = random() % vertexArrayCount;
+            object.material = random() % materialCount;
+            object.transform = glm::translate(glm::mat4(1.0f), glm::vec3((random() % 200) / 100.0f - 1.0f, (random() % 200) / 100.0f - 1.0f, 0.0f));
+        }
+        const glm::mat4 view = glm::translate(glm::mat4(1.0f), glm::vec3(0.0f, 0.0f, -3.0f));
+        const glm::mat4 projection = glm::perspective(glm::radians(45.0f), 1.0f, 0.1f, 100.0f);
+
+        // Every object sets its program, vertex array and three matrices, as the viewer used to
+        SubmissionStats naive;
+        auto naiveFrame = [&]()
+        {
+            naive = SubmissionStats();
+            naive.packets = objects.size();
+            for (const SubmissionObject &object : objects)
+            {
+                const UniformProgram &program = uniformPrograms[object.program];
+                glUseProgram(program.program);
+                glBindVertexArray(vertexArrays[object.vertexArray]);
+                glUniformMatrix4fv(program.transform, 1, GL_FALSE, glm::value_ptr(object.transform));
+                glUniformMatrix4fv(program.view, 1, GL_FALSE, glm::value_ptr(view));
+                glUniformMatrix4fv(program.projection, 1, GL_FALSE, glm::value_ptr(projection));
+                glDrawElements(GL_TRIANGLES, 3, GL_UNSIGNED_INT, (void *)0);
+            }
+            naive.programBinds = naive.vertexArrayBinds = objects.size();
+            naive.uploads = objects.size() * 3;
+            naive.apiCalls = objects.size() * 6;
+            glFinish();
+        };
+        SubmissionStats sorted;
+        auto queueFrame = [&]()
+        {
+            queue.beginFrame(view, projection);
+            for (const SubmissionObject &object : objects)
+            {
+                DrawPacket packet;
+                packet.program = blockPrograms[object.program];
+                packet.vertexArray = vertexArrays[object.vertexArray];
+                packet.material = object.material;
+                packet.object = queue.addObject(object.transform);
+                packet.indexCount = 3;
+                queue.submit(packet);
+            }
+            sorted = queue.flush();
+            glFinish();
+        };
+        const double naiveSeconds = bestOf(frames, naiveFrame);
+        const double queueSeconds = bestOf(frames, queueFrame);
+
+        std::cout << objectCount << " objects over " << programCount << " programs, " << vertexArrayCount << " vertex arrays and "
+                  << materialCount << " materials, object stride " << queue.objectStride() << " bytes\n";
+        printSubmissionStats("per object", naive);
+        std::cout << "  " << naiveSeconds * 1000.0 << " ms per frame\n";
+        printSubmissionStats("sorted queue", sorted);
+        std::cout << "  " << queueSeconds * 1000.0 << " ms per frame, " << naiveSeconds / queueSeconds << "x\n";
+
+        queue.destroy();
+        glDeleteVertexArrays(vertexArrayCount, vertexArrays.data());
+        glDeleteBuffers(vertexArrayCount * 2, buffers.data());
+        const bool failed = shaders.stats().failed > 0;
+        shaders.destroy();
+        std::error_code error;
+        std::filesystem::remove_all(directory, error);
+        glfwDestroyWindow(window);
+        glfwTerminate();
+        if (failed)
+        {
+            std::cout << "PROGRAMS FAILED\n";
+            return 1;
+        }
+        // Sorting can only merge binds, never add them
+        return sorted.stateChanges() <= naive.stateChanges() && sorted.packets == naive.packets ? 0 : 1;
+    }
+
+    /**
+     * @brief Uploads a buffer in full and then a sixteenth of it per frame, returning the seconds
+     * for each; allowPersistent picks the staging ring or plain glBufferSubData. Reads the buffer
+     * back afterwards and reports whether it matches.
+     */
+    bool benchUploadPath(const std::vector<unsigned char> &data, int frames, bool allowPersistent, UploadStats &full,
+                         UploadStats &partial, double &fullSeconds, double &partialSeconds)
+    {
+        UploadManager uploads;
+        if (!uploads.create(kUploadChunkBytes, kUploadRingChunks, allowPersistent))
+        {
+            return false;
+        }
+        glFinish();
+        Clock::time_point start = Clock::now();
+        const GLuint buffer = uploads.createBuffer(data.data(), data.size(), true);
+        glFinish();
+        fullSeconds = std::chrono::duration<double>(Clock::now() - start).count();
+        full = uploads.stats();
+
+        // A mesh that changes every frame: one dirty range, moving through the buffer
+        const size_t dirty = std::max<size_t>(data.size() / 16, 1);
+        start = Clock::now();
+        for (int frame = 0; frame < frames; ++frame)
+        {
+            const size_t offset = (frame % 16) * dirty;
+            uploads.upload(buffer, offset, data.data() + offset, std::min(dirty, data.size() - offset));
+        }
+        glFinish();
+        partialSeconds = std::chrono::duration<double>(Clock::now() - start).count();
+        partial = uploads.stats();
+        partial.bytes -= full.bytes;
+        partial.chunks -= full.chunks;
+        partial.stalls -= full.stalls;
+        partial.seconds = partialSeconds;
+
+        std::vector<unsigned char> readBack(data.size());
+        glBindBuffer(GL_COPY_READ_BUFFER, buffer);
+        glGetBufferSubData(GL_COPY_READ_BUFFER, 0, static_cast<GLsizeiptr>(readBack.size()), readBack.data());
+        glBindBuffer(GL_COPY_READ_BUFFER, 0);
+        glDeleteBuffers(1, &buffer);
+        uploads.destroy();
+        return readBack == data;
+    }
+
+    /**
+     * @brief Upload throughput and host memory: one blocking glBufferData against streaming in
+     * chunks, in full and as per-frame partial updates.
+     */
+    int benchUpload(int argc, char **argv)
+    {
+        const size_t megabytes = static_cast<size_t>(iterationsArg(argc, argv, 2, 64));
+        const int frames = iterationsArg(argc, argv, 3, 120);
+        GLFWwindow *window = createOffscreenContext(64, 64, "bench-upload");
+        if (!window)
+        {
+            return 1;
+        }
+        std::cout << glGetString(GL_RENDERER) << ", " << glGetString(GL_VERSION) << "\n";
+
+        std::vector<unsigned char> data(megabytes * 1024 * 1024);
+        for (size_t i = 0; i < data.size(); ++i)
+        {
+            data[i] = static_cast<unsigned char>((i * 2654435761u) >> 24);
+        }
+        const size_t baseResident = peakResidentBytes();
+        std::cout << megabytes << " MB buffer, " << kUploadChunkBytes / 1024 << " KB chunks, " << kUploadRingChunks
+                  << " ring slots, peak resident " << baseResident / (1024 * 1024) << " MB before uploading\n";
+
+        // The old way: the whole buffer in one call, which the driver may copy before it returns
+        GLuint buffer = 0;
+        glGenBuffers(1, &buffer);
+        glFinish();
+        Clock::time_point start = Clock::now();
+        glBindBuffer(GL_ARRAY_BUFFER, buffer);
+        glBufferData(GL_ARRAY_BUFFER, static_cast<GLsizeiptr>(data.size()), data.data(), GL_STATIC_DRAW);
+        glFinish();
+        const double bufferDataSeconds = std::chrono::duration<double>(Clock::now() - start).count();
+        glBindBuffer(GL_ARRAY_BUFFER, 0);
+        glDeleteBuffers(1, &buffer);
+        const size_t bufferDataResident = peakResidentBytes();
+        std::cout << "glBufferData: " << megabytes / bufferDataSeconds << " MB/s, peak resident +"
+                  << (bufferDataResident - baseResident) / (1024 * 1024) << " MB\n";
+
+        bool ok = true;
+        for (bool persistent : {false, true})
+        {
+            UploadStats full, partial;
+            double fullSeconds = 0.0, partialSeconds = 0.0;
+            const size_t before = peakResidentBytes();
+            if (!benchUploadPath(data, frames, persistent, full, partial, fullSeconds, partialSeconds))
+            {
+                std::cout << (persistent ? "staging ring" : "glBufferSubData") << ": READ BACK DOES NOT MATCH\n";
+                ok = false;
+                continue;
+            }
+            if (full.persistent != persistent)
+            {
+                continue; // No GL_ARB_buffer_storage
+            }
+            // The call returns before the GPU is done; the time includes the glFinish after it
+            full.seconds = fullSeconds;
+            printUploadStats(persistent ? "full, staging ring" : "full, glBufferSubData", full);
+            printUploadStats(persistent ? "per frame, staging ring" : "per frame, glBufferSubData", partial);
+            std::cout << "  peak resident +" << (peakResidentBytes() - before) / (1024 * 1024) << " MB\n";
+        }
+
+        glfwDestroyWindow(window);
+        glfwTerminate();
+        return ok ? 0 : 1;
+    }
+
+    int benchMaterials(int argc, char **argv)
+    {
+        if (argc < 3)
+        {
+            std::cerr << "Usage: " << argv[0] << " --bench-materials <file.obj> [iterations]" << std::endl;
+            return 1;
+        }
+        const std::string path = argv[2];
+        const int iterations = iterationsArg(argc, argv, 3, 5);
+
+        MappedFile file(path);
+        if (!file.isOpen())
+        {
+            std::cerr << "Failed to open OBJ file: " << path << std::endl;
+            return 1;
+        }
+        const double megabytes = file.size() / (1024.0 * 1024.0);
+
+        // Single-threaded parse, so the usemtl bookkeeping shows up rather than the thread count
+        ObjData data, grouped;
+        bool ok = true;
+        double parseSeconds = bestOf(iterations, [&]()
+        {
+            data = ObjData();
+            ok = parseOBJData(file.data(), file.data() + file.size(), path, data) && ok;
+        });
+        double groupSeconds = bestOf(iterations, [&]()
+        {
+            grouped = data;
+            groupOBJByMaterial(grouped);
+        });
+        // The copy in each iteration is not part of the grouping
+        groupSeconds -= bestOf(iterations, [&]() { grouped = data; });
+        groupOBJByMaterial(grouped);
+        if (!ok)
+        {
+            return 1;
+        }
+
+        // Every material must get exactly its own corners back, in the order they were written
+        bool matches = grouped.corners.size() == data.corners.size();
+        for (const ObjMaterialRange &range : grouped.materialRanges)
+        {
+            size_t next = range.firstCorner;
+            for (const ObjMaterialRange &source : data.materialRanges)
+            {
+                if (source.material != range.material)
+                {
+                    continue;
+                }
+                for (size_t c = source.firstCorner; matches && c < source.firstCorner + source.cornerCount; ++c, ++next)
+                {
+                    const ObjCorner &a = data.corners[c];
+                    const ObjCorner &b = grouped.corners[next];
+                    matches = a.position == b.position && a.texCoord == b.texCoord && a.normal == b.normal;
+                }
+            }
+            matches = matches && next == range.firstCorner + range.cornerCount;
+        }
+
+        std::vector<ObjMaterial> library;
+        const std::filesystem::path directory = std::filesystem::path(path).parent_path();
+        for (const std::string &name : data.materialLibraries)
+        {
+            loadMTL((directory / name).string(), library);
+        }
+
+        std::cout << "file: " << path << " (" << megabytes << " MB, " << data.corners.size() / 3 << " triangles)\n"
+                  << "parse: " << parseSeconds * 1000.0 << " ms, " << megabytes / parseSeconds << " MB/s\n"
+                  << "group: " << std::max(groupSeconds, 0.0) * 1000.0 << " ms\n"
+                  << data.materialNames.size() << " materials used, " << library.size() << " defined in "
+                  << data.materialLibraries.size() << " libraries\n";
+        for (const ObjMaterialRange &range : grouped.materialRanges)
+        {
+            const std::string &name = grouped.materialNames[range.material];
+            std::cout << "  " << (name.empty() ? "(none)" : name) << ": " << range.cornerCount / 3 << " faces\n";
+        }
+        // Without grouping every usemtl run is its own draw
+        const size_t naiveDraws = std::max<size_t>(data.materialRanges.size(), 1);
+        const size_t batchedDraws = std::max<size_t>(grouped.materialRanges.size(), 1);
+        std::cout << "draws per frame: " << naiveDraws << " per usemtl run, " << batchedDraws << " per material\n"
+                  << "grouped corners match: " << (matches ? "yes" : "no") << std::endl;
+        return matches ? 0 : 1;
+    }
+
+    struct BenchmarkEntry
+    {
+        const char *name;
+        int (*run)(int argc, char **argv);
+    };
+
+    const BenchmarkEntry kBenchmarks[] = {
+        {"--bench-obj", benchObj},
+        {"--bench-obj-threads", benchObjThreads},
+        {"--bench-weld", benchWeld},
+        {"--bench-startup", benchStartup},
+        {"--bench-vcache", benchVertexCache},
+        {"--bench-quantize", benchQuantize},
+        {"--bench-meshlets", benchMeshlets},
+        {"--bench-simplify", benchSimplify},
+        {"--bench-instances", benchInstances},
+        {"--bench-transforms", benchTransforms},
+        {"--bench-raster", benchRaster},
+        {"--bench-bvh", benchBvh},
+        {"--bench-analytics", benchAnalytics},
+        {"--bench-pipeline", benchPipeline},
+        {"--bench-telemetry", benchTelemetry},
+        {"--bench-profiler", benchProfiler},
+        {"--bench-shaders", benchShaders},
+        {"--bench-submission", benchSubmission},
+        {"--bench-upload", benchUpload},
+        {"--bench-materials", benchMaterials},
+    };
+}
+
+bool isBenchmarkCommand(int argc, char **argv)
+{
+    if (argc < 2)
+    {
+        return false;
+    }
+    for (const BenchmarkEntry &entry : kBenchmarks)
+    {
+        if (std::strcmp(argv[1], entry.name) == 0)
+        {
+            return true;
+        }
+    }
+    return false;
+}
+
+int runBenchmark(int argc, char **argv)
+{
+    for (const BenchmarkEntry &entry : kBenchmarks)
+    {
+        if (argc > 1 && std::strcmp(argv[1], entry.name) == 0)
+        {
+            return entry.run(argc, argv);
+        }
+    }
+    return 1;
+}
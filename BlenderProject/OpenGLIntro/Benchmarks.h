@@ -0,0 +1,61 @@
+#pragma once
+
+/**
+ * @brief Checks whether the command line selects one of the benchmark modes instead of the viewer.
+ *
+ * @param argc Argument count from main.
+ * @param argv Argument vector from main.
+ * @return true if argv[1] names a benchmark.
+ */
+bool isBenchmarkCommand(int argc, char **argv);
+
+/**
+ * @brief Runs the benchmark named by argv[1] and prints its results to stdout.
+ *
+ * Benchmarks:
+ *   --bench-obj <file.obj> [iterations]   OBJ parse throughput against kObjParseTargetMBps
+ *   --bench-obj-threads <file.obj> [maxThreads] [iterations]
+ *                                         Parallel loadOBJ scaling from 1 to maxThreads threads
+ *   --bench-weld <file.obj> [iterations]  Vertex welding time, reduction ratio and memory saved
+ *   --bench-startup <file.obj> [iterations]
+ *                                         Cold text load and LOD build against the warm binary mesh cache
+ *   --bench-vcache <file.obj>             ACMR/ATVR before and after the mesh optimizer
+ *   --bench-quantize <file.obj>           Packed vertex error bounds and memory footprint
+ *   --bench-meshlets <file.obj> [cameraSteps]
+ *                                         Fraction of meshlets culled for orbiting cameras
+ *   --bench-simplify <file.obj> [ratio ...]
+ *                                         LOD chain build time, triangle counts and errors, and open
+ *                                         edges per level, whole and split into two ranges
+ *   --bench-instances [count ...]         Per-frame instance data preparation and upload (default
+ *                                         10000 and 100000 instances)
+ *   --bench-transforms [count ...]        World matrix update per kernel and thread count against
+ *                                         the glm chain (default 1000, 100000 and 1000000 objects)
+ *   --bench-raster <file.obj> [frames]    Software rasterizer Mtris/s and Mpix/s, filled and wireframe,
+ *                                         plus a check that shared edges leave no gaps or overlaps
+ *   --bench-bvh <file.obj> [iterations]   BVH build time and Mrays/s for single rays, 4-ray packets
+ *                                         and occlusion queries, checked against a brute-force loop
+ *   --bench-analytics <file.obj> [iterations]
+ *                                         Surface area, volume, bounds and normals of the mesh, with
+ *                                         timings and a check that the thread count does not change them
+ *   --bench-pipeline [frames]             Frame rate, latency and waits of the update/render pipeline
+ *                                         at depths 0, 1 and 2 with synthetic costs, checking frame order
+ *   --bench-telemetry [frames] [eventsPerFrame]
+ *                                         Cost of a telemetry event on the logging thread against
+ *                                         kTelemetryTargetLogNanoseconds and a synchronous fprintf
+ *   --bench-profiler [zones] [trace.json] Cost of a profiling zone while stopped and running, and a
+ *                                         check that the Chrome trace holds every zone recorded
+ *   --bench-shaders [programs]            Cold and warm shader startup through ShaderCache, offscreen;
+ *                                         fails if the warm run compiles anything
+ *   --bench-submission [objects] [frames] State changes, GL calls and frame time for per-object uniforms
+ *                                         against the sorted RenderQueue, offscreen (default 4096 objects)
+ *   --bench-upload [megabytes] [frames]   Upload MB/s and peak resident memory for glBufferData against
+ *                                         chunked streaming, in full and per frame, checked by read back
+ *   --bench-materials <file.obj> [iterations]
+ *                                         Parse and material grouping time, faces per material and
+ *                                         draws per frame per usemtl run against per material
+ *
+ * @param argc Argument count from main.
+ * @param argv Argument vector from main.
+ * @return 0 if the benchmark ran and met its target, otherwise 1.
+ */
+int runBenchmark(int argc, char **argv);
@@ -0,0 +1,190 @@
+#include "FramePipeline.h"
+
+#include <algorithm>
+#include <cmath>
+#include <iostream>
+
+namespace
+{
+    // Spins and yields before a waiting side starts to nap
+    constexpr int kSpinIterations = 64;
+    constexpr int kYieldIterations = 256;
+    constexpr std::chrono::microseconds kNap(100);
+
+    /**
+     * @brief Waits until ready() or stop is set. Frames hand off every few milliseconds, so a
+     * short spin usually catches the other side; a long wait, such as the update thread idling
+     * through a vsync, naps instead of burning a core.
+     *
+     * @return false if stop was set first.
+     */
+    template <typename Ready>
+    bool waitFor(Ready ready, const std::atomic<bool> &stop)
+    {
+        for (int i = 0; !ready(); ++i)
+        {
+            if (stop.load(std::memory_order_relaxed))
+            {
+                return false;
+            }
+            if (i < kSpinIterations)
+            {
+                continue;
+            }
+            if (i < kSpinIterations + kYieldIterations)
+            {
+                std::this_thread::yield();
+            }
+            else
+            {
+                std::this_thread::sleep_for(kNap);
+            }
+        }
+        return true;
+    }
+
+    uint64_t nanosecondsSince(std::chrono::steady_clock::time_point start)
+    {
+        return static_cast<uint64_t>(std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::steady_clock::now() - start).count());
+    }
+
+    double percentile(std::vector<double> values, double fraction)
+    {
+        std::sort(values.begin(), values.end());
+        const size_t rank = static_cast<size_t>(std::ceil(fraction * values.size()));
+        return values[std::min(values.size() - 1, rank > 0 ? rank - 1 : 0)];
+    }
+}
+
+FrameHandoff::FrameHandoff(unsigned int depth, std::function<void(size_t, size_t)> update)
+    : pipelineDepth(std::min(depth, kMaxPipelineDepth)), slotCount(pipelineDepth + 1), update(std::move(update)),
+      inputTimes(slotCount), stateTimes(slotCount)
+{
+    latencies.reserve(kPipelineLatencyWindow);
+    if (pipelineDepth > 0)
+    {
+        worker = std::thread(&FrameHandoff::updateLoop, this);
+    }
+}
+
+FrameHandoff::~FrameHandoff()
+{
+    stopping.store(true);
+    if (worker.joinable())
+    {
+        worker.join();
+    }
+}
+
+size_t FrameHandoff::beginInput()
+{
+    const size_t written = inputsWritten.load(std::memory_order_relaxed);
+    waitFor([&]() { return written - inputsRead.load(std::memory_order_acquire) < slotCount; }, stopping);
+    return written % slotCount;
+}
+
+void FrameHandoff::commitInput()
+{
+    const size_t written = inputsWritten.load(std::memory_order_relaxed);
+    inputTimes[written % slotCount] = Clock::now();
+    inputsWritten.store(written + 1, std::memory_order_release);
+    if (pipelineDepth == 0)
+    {
+        runUpdate(written);
+    }
+}
+
+void FrameHandoff::updateLoop()
+{
+    for (size_t frame = 0;; ++frame)
+    {
+        const Clock::time_point waitStart = Clock::now();
+        const bool ready = waitFor([&]()
+        {
+            return inputsWritten.load(std::memory_order_acquire) > frame &&
+                   frame - statesRead.load(std::memory_order_acquire) < slotCount;
+        }, stopping);
+        if (!ready)
+        {
+            return;
+        }
+        updateWaitNanoseconds.fetch_add(nanosecondsSince(waitStart), std::memory_order_relaxed);
+        runUpdate(frame);
+    }
+}
+
+void FrameHandoff::runUpdate(size_t frame)
+{
+    const size_t slot = frame % slotCount;
+    const Clock::time_point start = Clock::now();
+    update(slot, slot);
+    updateNanoseconds.fetch_add(nanosecondsSince(start), std::memory_order_relaxed);
+    stateTimes[slot] = inputTimes[slot];
+    inputsRead.store(frame + 1, std::memory_order_release);
+    statesWritten.store(frame + 1, std::memory_order_release);
+}
+
+size_t FrameHandoff::acquireState()
+{
+    const size_t read = statesRead.load(std::memory_order_relaxed);
+    const Clock::time_point waitStart = Clock::now();
+    waitFor([&]() { return statesWritten.load(std::memory_order_acquire) > read; }, stopping);
+    renderWaitNanoseconds += nanosecondsSince(waitStart);
+    return read % slotCount;
+}
+
+void FrameHandoff::releaseState()
+{
+    const size_t read = statesRead.load(std::memory_order_relaxed);
+    const Clock::time_point now = Clock::now();
+    const double latency = std::chrono::duration<double, std::milli>(now - stateTimes[read % slotCount]).count();
+    if (latencies.size() < kPipelineLatencyWindow)
+    {
+        latencies.push_back(latency);
+    }
+    else
+    {
+        latencies[read % kPipelineLatencyWindow] = latency;
+    }
+    if (read == 0)
+    {
+        firstRelease = now;
+    }
+    lastRelease = now;
+    statesRead.store(read + 1, std::memory_order_release);
+}
+
+PipelineStats FrameHandoff::stats() const
+{
+    PipelineStats stats;
+    stats.depth = pipelineDepth;
+    stats.frames = statesRead.load(std::memory_order_acquire);
+    if (stats.frames == 0)
+    {
+        return stats;
+    }
+    const double frames = static_cast<double>(stats.frames);
+    double sum = 0.0;
+    for (double latency : latencies)
+    {
+        sum += latency;
+    }
+    stats.latencyMean = sum / latencies.size();
+    stats.latencyP95 = percentile(latencies, 0.95);
+    stats.latencyMax = *std::max_element(latencies.begin(), latencies.end());
+    stats.updateMilliseconds = updateNanoseconds.load(std::memory_order_relaxed) / 1e6 / frames;
+    stats.updateWaitMilliseconds = updateWaitNanoseconds.load(std::memory_order_relaxed) / 1e6 / frames;
+    stats.renderWaitMilliseconds = renderWaitNanoseconds / 1e6 / frames;
+    const double seconds = std::chrono::duration<double>(lastRelease - firstRelease).count();
+    stats.framesPerSecond = stats.frames > 1 && seconds > 0.0 ? (frames - 1.0) / seconds : 0.0;
+    return stats;
+}
+
+void printPipelineStats(const PipelineStats &stats)
+{
+    std::cout << "Frame pipeline: depth " << stats.depth << ", " << stats.frames << " frames, " << stats.framesPerSecond
+              << " fps, latency " << stats.latencyMean << " ms mean, " << stats.latencyP95 << " ms p95, "
+              << stats.latencyMax << " ms max; update " << stats.updateMilliseconds << " ms, update waited "
+              << stats.updateWaitMilliseconds << " ms, render waited " << stats.renderWaitMilliseconds << " ms per frame"
+              << std::endl;
+}
@@ -0,0 +1,171 @@
+#pragma once
+
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
+#include <functional>
+#include <thread>
+#include <vector>
+
+// Frames the update thread may run ahead of the render thread
+constexpr unsigned int kMaxPipelineDepth = 3;
+
+// Frames the latency statistics are taken over
+constexpr size_t kPipelineLatencyWindow = 1024;
+
+/**
+ * @brief How a FramePipeline has been running, for tuning its depth.
+ */
+struct PipelineStats
+{
+    unsigned int depth = 0;
+    size_t frames = 0; // Frames rendered
+    // Input submitted to frame released by the render thread, over the last kPipelineLatencyWindow frames
+    double latencyMean = 0.0;
+    double latencyP95 = 0.0;
+    double latencyMax = 0.0;
+    double updateMilliseconds = 0.0;     // Mean time spent in the update function per frame
+    double updateWaitMilliseconds = 0.0; // Mean time the update thread waited for input or a free slot
+    double renderWaitMilliseconds = 0.0; // Mean time acquire() waited for the update thread
+    double framesPerSecond = 0.0;        // Frames released since the first one, per second
+};
+
+/**
+ * @brief Prints the depth, frame rate, latency and waits of a pipeline on one line.
+ */
+void printPipelineStats(const PipelineStats &stats);
+
+/**
+ * @brief The slot bookkeeping, waiting and statistics behind FramePipeline, independent of the
+ * input and state types.
+ *
+ * Inputs and states each live in a ring of depth + 1 slots. Each ring has one writer and one
+ * reader that only ever advance their own counter, so the handoff is two atomic counters per
+ * ring and no locks. A side that has to wait spins briefly, then yields, then naps.
+ */
+class FrameHandoff
+{
+public:
+    /**
+     * @param depth Frames the update may run ahead of rendering, at most kMaxPipelineDepth. 0 runs
+     * the update on the calling thread inside submit(), which is the plain sequential loop.
+     * @param update Called with the input slot and state slot of each frame.
+     */
+    FrameHandoff(unsigned int depth, std::function<void(size_t inputSlot, size_t stateSlot)> update);
+    ~FrameHandoff();
+
+    FrameHandoff(const FrameHandoff &) = delete;
+    FrameHandoff &operator=(const FrameHandoff &) = delete;
+
+    unsigned int depth() const { return pipelineDepth; }
+    size_t slots() const { return slotCount; }
+
+    // Main thread: the slot to fill before commitInput(); waits while the input ring is full
+    size_t beginInput();
+    void commitInput();
+
+    // Render thread: the slot of the oldest unrendered state; waits for the update if needed
+    size_t acquireState();
+    void releaseState();
+
+    // Inputs submitted whose frames have not been released yet
+    size_t inFlight() const { return inputsWritten.load(std::memory_order_acquire) - statesRead.load(std::memory_order_relaxed); }
+
+    PipelineStats stats() const;
+
+private:
+    using Clock = std::chrono::steady_clock;
+
+    void updateLoop();
+    void runUpdate(size_t frame);
+
+    unsigned int pipelineDepth;
+    size_t slotCount;
+    std::function<void(size_t, size_t)> update;
+
+    // Each counter has a single writer; the rings index them modulo slotCount
+    alignas(64) std::atomic<size_t> inputsWritten{0};
+    alignas(64) std::atomic<size_t> inputsRead{0};
+    alignas(64) std::atomic<size_t> statesWritten{0};
+    alignas(64) std::atomic<size_t> statesRead{0};
+    std::atomic<bool> stopping{false};
+
+    // When each slot's input was committed, carried through to its state
+    std::vector<Clock::time_point> inputTimes;
+    std::vector<Clock::time_point> stateTimes;
+
+    // Written by the update thread only
+    std::atomic<uint64_t> updateNanoseconds{0};
+    std::atomic<uint64_t> updateWaitNanoseconds{0};
+
+    // Written by the render thread only
+    uint64_t renderWaitNanoseconds = 0;
+    std::vector<double> latencies;
+    Clock::time_point firstRelease;
+    Clock::time_point lastRelease;
+
+    std::thread worker;
+};
+
+/**
+ * @brief Runs the per-frame update (input handling, transforms, culling, instance data) on its
+ * own thread, up to depth frames ahead of the thread that submits the frames to OpenGL.
+ *
+ * The main thread samples the input for a frame and calls submit(); the update thread turns it
+ * into a State; the render thread acquire()s the oldest finished State, draws it and
+ * release()s it. Frames come out in the order their inputs went in, none are skipped, and the
+ * states are built from the inputs alone, so a scripted run renders the same frames at every
+ * depth. Depth 1 is double buffering: one state is drawn while the next is built.
+ *
+ * @tparam Input What the main thread samples per frame.
+ * @tparam State What the update produces and the renderer draws; reused between frames, so its
+ * buffers keep their capacity.
+ */
+template <typename Input, typename State>
+class FramePipeline
+{
+public:
+    using UpdateFunction = std::function<void(const Input &input, State &state)>;
+
+    FramePipeline(unsigned int depth, UpdateFunction update)
+        : inputs(std::min(depth, kMaxPipelineDepth) + 1), states(std::min(depth, kMaxPipelineDepth) + 1),
+          handoff(depth, [this, update](size_t inputSlot, size_t stateSlot) { update(inputs[inputSlot], states[stateSlot]); })
+    {
+    }
+
+    /**
+     * @brief Queues the input of the next frame. Waits while the update thread is depth frames
+     * ahead; at depth 0 the update runs here.
+     */
+    void submit(const Input &input)
+    {
+        inputs[handoff.beginInput()] = input;
+        handoff.commitInput();
+    }
+
+    /**
+     * @brief True once depth frames are queued behind the oldest one, the point at which the
+     * render thread should draw.
+     */
+    bool frameReady() const { return handoff.inFlight() > handoff.depth(); }
+
+    /**
+     * @brief The oldest frame not yet rendered; waits for the update thread if it is not done.
+     */
+    const State &acquire() { return states[handoff.acquireState()]; }
+
+    /**
+     * @brief Hands the acquired state back for reuse.
+     */
+    void release() { handoff.releaseState(); }
+
+    unsigned int depth() const { return handoff.depth(); }
+    PipelineStats stats() const { return handoff.stats(); }
+
+private:
+    std::vector<Input> inputs;
+    std::vector<State> states;
+    FrameHandoff handoff; // Last, so its thread stops before the slots go away
+};
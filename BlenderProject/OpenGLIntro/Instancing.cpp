@@ -0,0 +1,223 @@
+#include "Instancing.h"
+
+#include <algorithm>
+#include <cmath>
+#include <cstring>
+#include <iostream>
+
+size_t instanceStride(InstanceFormat format)
+{
+    return format == InstanceFormat::Matrix ? sizeof(glm::mat4) : sizeof(InstanceTRS);
+}
+
+void makeInstanceGrid(size_t count, float spacing, std::vector<InstanceTRS> &out)
+{
+    out.resize(count);
+    const size_t side = static_cast<size_t>(std::ceil(std::sqrt(static_cast<double>(count))));
+    const float half = (static_cast<float>(side) - 1.0f) * 0.5f;
+    for (size_t i = 0; i < count; ++i)
+    {
+        InstanceTRS &instance = out[i];
+        instance.rotation = glm::vec4(0.0f, 0.0f, 0.0f, 1.0f);
+        instance.translation = glm::vec3((static_cast<float>(i % side) - half) * spacing, 0.0f,
+                                         (static_cast<float>(i / side) - half) * spacing);
+        instance.scale = 1.0f;
+    }
+}
+
+void updateInstanceRotations(InstanceTRS *instances, size_t count, float seconds)
+{
+    for (size_t i = 0; i < count; ++i)
+    {
+        // Between 0.5 and 1.5 radians per second, varying with the index
+        float speed = 0.5f + static_cast<float>((i * 2654435761u) & 1023u) / 1023.0f;
+        float half = seconds * speed * 0.5f;
+        instances[i].rotation = glm::vec4(0.0f, std::sin(half), 0.0f, std::cos(half));
+    }
+}
+
+void writeInstances(const InstanceTRS *instances, size_t count, InstanceFormat format, void *destination)
+{
+    if (format == InstanceFormat::CompactTRS)
+    {
+        std::memcpy(destination, instances, count * sizeof(InstanceTRS));
+        return;
+    }
+
+    // Rotation matrix from the quaternion, columns scaled, translation in the last column
+    float *out = static_cast<float *>(destination);
+    for (size_t i = 0; i < count; ++i, out += 16)
+    {
+        const glm::vec4 &q = instances[i].rotation;
+        const glm::vec3 &t = instances[i].translation;
+        const float s = instances[i].scale;
+        const float xx = q.x * q.x, yy = q.y * q.y, zz = q.z * q.z;
+        const float xy = q.x * q.y, xz = q.x * q.z, yz = q.y * q.z;
+        const float wx = q.w * q.x, wy = q.w * q.y, wz = q.w * q.z;
+
+        out[0] = (1.0f - 2.0f * (yy + zz)) * s;
+        out[1] = 2.0f * (xy + wz) * s;
+        out[2] = 2.0f * (xz - wy) * s;
+        out[3] = 0.0f;
+        out[4] = 2.0f * (xy - wz) * s;
+        out[5] = (1.0f - 2.0f * (xx + zz)) * s;
+        out[6] = 2.0f * (yz + wx) * s;
+        out[7] = 0.0f;
+        out[8] = 2.0f * (xz + wy) * s;
+        out[9] = 2.0f * (yz - wx) * s;
+        out[10] = (1.0f - 2.0f * (xx + yy)) * s;
+        out[11] = 0.0f;
+        out[12] = t.x;
+        out[13] = t.y;
+        out[14] = t.z;
+        out[15] = 1.0f;
+    }
+}
+
+InstanceBuffer::~InstanceBuffer()
+{
+    destroy();
+}
+
+bool InstanceBuffer::create(unsigned int vertexArray, InstanceFormat format, size_t capacity, bool allowPersistent)
+{
+    destroy();
+    vao = vertexArray;
+    layout = format;
+    maxInstances = capacity;
+    stride = instanceStride(format);
+    persistent = allowPersistent && GLEW_ARB_buffer_storage;
+
+    glGenBuffers(1, &buffer);
+    glBindBuffer(GL_ARRAY_BUFFER, buffer);
+    if (persistent)
+    {
+        const GLbitfield flags = GL_MAP_WRITE_BIT | GL_MAP_PERSISTENT_BIT | GL_MAP_COHERENT_BIT;
+        const GLsizeiptr size = static_cast<GLsizeiptr>(capacity * stride * kInstanceBufferRegions);
+        glBufferStorage(GL_ARRAY_BUFFER, size, NULL, flags);
+        mapped = static_cast<unsigned char *>(glMapBufferRange(GL_ARRAY_BUFFER, 0, size, flags));
+        if (!mapped)
+        {
+            std::cerr << "Failed to map instance buffer persistently" << std::endl;
+            glBindBuffer(GL_ARRAY_BUFFER, 0);
+            destroy();
+            return false;
+        }
+    }
+    else
+    {
+        glBufferData(GL_ARRAY_BUFFER, static_cast<GLsizeiptr>(capacity * stride), NULL, GL_STREAM_DRAW);
+    }
+
+    glBindVertexArray(vao);
+    bindAttributes(0);
+    const unsigned int slots = format == InstanceFormat::Matrix ? 4 : 2;
+    for (unsigned int slot = 0; slot < slots; ++slot)
+    {
+        glEnableVertexAttribArray(kInstanceAttributeLocation + slot);
+        glVertexAttribDivisor(kInstanceAttributeLocation + slot, 1);
+    }
+    glBindVertexArray(0);
+    glBindBuffer(GL_ARRAY_BUFFER, 0);
+    return true;
+}
+
+void *InstanceBuffer::map(size_t count)
+{
+    if (count > maxInstances)
+    {
+        std::cerr << "Instance buffer holds " << maxInstances << " instances, " << count << " requested" << std::endl;
+        return nullptr;
+    }
+
+    if (persistent)
+    {
+        // Wait until the GPU is done with the draw that last read this region
+        if (fences[region])
+        {
+            while (glClientWaitSync(fences[region], GL_SYNC_FLUSH_COMMANDS_BIT, 1000000) == GL_TIMEOUT_EXPIRED)
+            {
+            }
+            glDeleteSync(fences[region]);
+            fences[region] = 0;
+        }
+        return mapped + region * maxInstances * stride;
+    }
+
+    // Orphan the storage, then map it without synchronizing against the previous frame's draw
+    glBindBuffer(GL_ARRAY_BUFFER, buffer);
+    glBufferData(GL_ARRAY_BUFFER, static_cast<GLsizeiptr>(maxInstances * stride), NULL, GL_STREAM_DRAW);
+    return glMapBufferRange(GL_ARRAY_BUFFER, 0, static_cast<GLsizeiptr>(std::max<size_t>(count, 1) * stride),
+                            GL_MAP_WRITE_BIT | GL_MAP_INVALIDATE_BUFFER_BIT | GL_MAP_UNSYNCHRONIZED_BIT);
+}
+
+void InstanceBuffer::unmap()
+{
+    if (persistent)
+    {
+        // Coherent mapping: the writes are visible to the next draw, only the offset changes
+        glBindVertexArray(vao);
+        glBindBuffer(GL_ARRAY_BUFFER, buffer);
+        bindAttributes(region * maxInstances * stride);
+        glBindVertexArray(0);
+    }
+    else
+    {
+        glUnmapBuffer(GL_ARRAY_BUFFER);
+    }
+    glBindBuffer(GL_ARRAY_BUFFER, 0);
+}
+
+void InstanceBuffer::draw(size_t firstIndex, size_t indexCount, size_t instanceCount)
+{
+    glBindVertexArray(vao);
+    glDrawElementsInstanced(GL_TRIANGLES, static_cast<GLsizei>(indexCount), GL_UNSIGNED_INT,
+                            reinterpret_cast<const void *>(firstIndex * sizeof(unsigned int)),
+                            static_cast<GLsizei>(instanceCount));
+    fence();
+}
+
+void InstanceBuffer::fence()
+{
+    if (persistent)
+    {
+        fences[region] = glFenceSync(GL_SYNC_GPU_COMMANDS_COMPLETE, 0);
+        region = (region + 1) % kInstanceBufferRegions;
+    }
+}
+
+void InstanceBuffer::destroy()
+{
+    for (GLsync &fence : fences)
+    {
+        if (fence)
+        {
+            glDeleteSync(fence);
+            fence = 0;
+        }
+    }
+    if (buffer)
+    {
+        if (mapped)
+        {
+            glBindBuffer(GL_ARRAY_BUFFER, buffer);
+            glUnmapBuffer(GL_ARRAY_BUFFER);
+            glBindBuffer(GL_ARRAY_BUFFER, 0);
+            mapped = nullptr;
+        }
+        glDeleteBuffers(1, &buffer);
+        buffer = 0;
+    }
+    region = 0;
+}
+
+void InstanceBuffer::bindAttributes(size_t offset) const
+{
+    // Expects the VAO and the instance buffer to be bound
+    const unsigned int slots = layout == InstanceFormat::Matrix ? 4 : 2;
+    for (unsigned int slot = 0; slot < slots; ++slot)
+    {
+        glVertexAttribPointer(kInstanceAttributeLocation + slot, 4, GL_FLOAT, GL_FALSE, static_cast<GLsizei>(stride),
+                              reinterpret_cast<const void *>(offset + slot * sizeof(glm::vec4)));
+    }
+}
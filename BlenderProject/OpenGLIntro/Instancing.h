@@ -0,0 +1,135 @@
+#pragma once
+
+#include <GL/glew.h>
+#include <glm/glm.hpp>
+
+#include <cstddef>
+#include <vector>
+
+// First vertex attribute location used by the per-instance data; a matrix takes four slots
+constexpr unsigned int kInstanceAttributeLocation = 3;
+
+// Regions of a persistently mapped instance buffer, so the CPU writes one while the GPU reads another
+constexpr unsigned int kInstanceBufferRegions = 3;
+
+/**
+ * @brief How each instance is stored in the instance buffer.
+ */
+enum class InstanceFormat
+{
+    Matrix,    // mat4 model matrix, 64 bytes, attributes 3-6
+    CompactTRS // InstanceTRS as is, 32 bytes, attributes 3-4
+};
+
+/**
+ * @brief Compact per-instance transform: rotation quaternion, translation and uniform scale.
+ */
+struct InstanceTRS
+{
+    glm::vec4 rotation; // x, y, z, w
+    glm::vec3 translation;
+    float scale;
+};
+static_assert(sizeof(InstanceTRS) == 32, "InstanceTRS is read as two vec4 attributes");
+
+/**
+ * @brief Bytes per instance in the given format.
+ */
+size_t instanceStride(InstanceFormat format);
+
+/**
+ * @brief Lays out instances on a square grid in the XZ plane, centered on the origin.
+ *
+ * @param count Number of instances.
+ * @param spacing Distance between neighboring instances.
+ * @param out Receives the instances.
+ */
+void makeInstanceGrid(size_t count, float spacing, std::vector<InstanceTRS> &out);
+
+/**
+ * @brief Spins every instance about the Y axis; each one turns at its own speed.
+ *
+ * @param instances Instances to update.
+ * @param count Number of instances.
+ * @param seconds Time since the start.
+ */
+void updateInstanceRotations(InstanceTRS *instances, size_t count, float seconds);
+
+/**
+ * @brief Writes instances into instance buffer memory in the given format.
+ *
+ * @param instances Source instances.
+ * @param count Number of instances.
+ * @param format Layout to write.
+ * @param destination Mapped buffer memory with room for count * instanceStride(format) bytes.
+ */
+void writeInstances(const InstanceTRS *instances, size_t count, InstanceFormat format, void *destination);
+
+/**
+ * @brief A per-instance vertex buffer attached to an existing VAO, rewritten every frame.
+ *
+ * With GL_ARB_buffer_storage the buffer is mapped once, persistently, and split into
+ * kInstanceBufferRegions regions guarded by fences. Otherwise each frame orphans the buffer and
+ * maps it unsynchronized, so the driver never stalls on data the GPU is still reading.
+ */
+class InstanceBuffer
+{
+public:
+    InstanceBuffer() = default;
+    InstanceBuffer(const InstanceBuffer &) = delete;
+    InstanceBuffer &operator=(const InstanceBuffer &) = delete;
+    ~InstanceBuffer();
+
+    /**
+     * @brief Creates the buffer and adds the instance attributes to the VAO.
+     *
+     * @param vertexArray VAO set up by setupBuffers.
+     * @param format Per-instance layout.
+     * @param capacity Most instances drawn in one frame.
+     * @param allowPersistent Use persistent mapping when the driver supports it.
+     * @return false if the buffer could not be created or mapped.
+     */
+    bool create(unsigned int vertexArray, InstanceFormat format, size_t capacity, bool allowPersistent = true);
+
+    /**
+     * @brief Returns memory to write this frame's instances to; call unmap when done.
+     */
+    void *map(size_t count);
+
+    /**
+     * @brief Finishes the write and points the instance attributes at the new data.
+     */
+    void unmap();
+
+    /**
+     * @brief Draws instanceCount copies of an index range with glDrawElementsInstanced. Call once
+     * per frame after unmap; it also fences the region that was just used.
+     */
+    void draw(size_t firstIndex, size_t indexCount, size_t instanceCount);
+
+    /**
+     * @brief Fences the region that was just drawn from and moves on to the next. draw() calls
+     * it; call it directly after issuing the instanced draw some other way, such as from a
+     * RenderQueue.
+     */
+    void fence();
+
+    void destroy();
+
+    bool isPersistent() const { return persistent; }
+    size_t capacity() const { return maxInstances; }
+    InstanceFormat format() const { return layout; }
+
+private:
+    void bindAttributes(size_t offset) const;
+
+    unsigned int vao = 0;
+    unsigned int buffer = 0;
+    InstanceFormat layout = InstanceFormat::CompactTRS;
+    size_t maxInstances = 0;
+    size_t stride = 0;
+    bool persistent = false;
+    unsigned char *mapped = nullptr; // Persistent mapping of all regions
+    unsigned int region = 0;
+    GLsync fences[kInstanceBufferRegions] = {};
+};
@@ -0,0 +1,49 @@
+#pragma once
+
+#include <cstddef>
+#include <string>
+
+/**
+ * @brief Read-only view of a whole file, memory-mapped where the platform allows it.
+ *
+ * The mapping is released when the object goes out of scope. Empty files are reported
+ * as open with a null data pointer and a size of zero.
+ */
+class MappedFile
+{
+public:
+    MappedFile() = default;
+    explicit MappedFile(const std::string &path) { open(path); }
+    ~MappedFile() { close(); }
+
+    MappedFile(const MappedFile &) = delete;
+    MappedFile &operator=(const MappedFile &) = delete;
+    MappedFile(MappedFile &&other) noexcept;
+    MappedFile &operator=(MappedFile &&other) noexcept;
+
+    /**
+     * @brief Maps the file at the given path, closing any previous mapping.
+     *
+     * @param path The file to map.
+     * @return true if the file could be opened and mapped.
+     */
+    bool open(const std::string &path);
+
+    /**
+     * @brief Unmaps the file. Safe to call more than once.
+     */
+    void close();
+
+    bool isOpen() const { return opened; }
+    const char *data() const { return bytes; }
+    size_t size() const { return length; }
+
+private:
+    const char *bytes = nullptr;
+    size_t length = 0;
+    bool opened = false;
+#ifdef _WIN32
+    void *fileHandle = nullptr;
+    void *mappingHandle = nullptr;
+#endif
+};
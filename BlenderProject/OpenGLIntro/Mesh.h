@@ -0,0 +1,21 @@
+#pragma once
+
+#include <glm/glm.hpp>
+
+#include <cstddef>
+
+// Struct to store OBJ data
+struct Vertex
+{
+    glm::vec3 Position;
+    glm::vec3 Normal;
+};
+
+/**
+ * @brief A run of triangle list indices, such as the faces that share a material.
+ */
+struct IndexRange
+{
+    size_t firstIndex;
+    size_t indexCount;
+};
@@ -0,0 +1,321 @@
+#include "MeshAnalytics.h"
+#include "ThreadPool.h"
+
+#include <algorithm>
+#include <atomic>
+#include <cmath>
+#include <cstdint>
+#include <cstring>
+#include <functional>
+
+namespace
+{
+    // Vertices per block for the bounding box and sphere passes
+    constexpr size_t kVertexBlock = 4096;
+
+    const unsigned int kEmptySlot = 0xffffffffu;
+
+    void runParallel(ThreadPool *pool, size_t count, size_t grain, const std::function<void(size_t, size_t)> &body)
+    {
+        if (pool)
+        {
+            pool->parallelFor(count, grain, body);
+        }
+        else if (count > 0)
+        {
+            body(0, count);
+        }
+    }
+
+    /**
+     * @brief Adds the values by recursive halving, so each one passes through about log2(count)
+     * additions instead of up to count.
+     */
+    double pairwiseSum(const double *values, size_t count)
+    {
+        if (count <= 8)
+        {
+            double sum = 0.0;
+            for (size_t i = 0; i < count; ++i)
+            {
+                sum += values[i];
+            }
+            return sum;
+        }
+        const size_t half = count / 2;
+        return pairwiseSum(values, half) + pairwiseSum(values + half, count - half);
+    }
+
+    struct Double3
+    {
+        double x, y, z;
+    };
+
+    Double3 toDouble(const glm::vec3 &v)
+    {
+        return {v.x, v.y, v.z};
+    }
+
+    Double3 sub(const Double3 &a, const Double3 &b)
+    {
+        return {a.x - b.x, a.y - b.y, a.z - b.z};
+    }
+
+    Double3 cross(const Double3 &a, const Double3 &b)
+    {
+        return {a.y * b.z - a.z * b.y, a.z * b.x - a.x * b.z, a.x * b.y - a.y * b.x};
+    }
+
+    double dot(const Double3 &a, const Double3 &b)
+    {
+        return a.x * b.x + a.y * b.y + a.z * b.z;
+    }
+
+    struct BoundsBlock
+    {
+        glm::vec3 minimum;
+        glm::vec3 maximum;
+    };
+
+    // Bit pattern of a position, with -0 folded into +0 so the two weld together
+    struct PositionKey
+    {
+        uint32_t bits[3];
+
+        explicit PositionKey(const glm::vec3 &p)
+        {
+            const float folded[3] = {p.x + 0.0f, p.y + 0.0f, p.z + 0.0f};
+            std::memcpy(bits, folded, sizeof(bits));
+        }
+
+        bool operator==(const PositionKey &other) const
+        {
+            return bits[0] == other.bits[0] && bits[1] == other.bits[1] && bits[2] == other.bits[2];
+        }
+
+        uint32_t hash() const
+        {
+            uint64_t h = bits[0] * 0x9E3779B97F4A7C15ull;
+            h ^= (bits[1] + 0x632BE59BD9B4E019ull) * 0xC2B2AE3D27D4EB4Full;
+            h ^= (bits[2] + 0x8CB92BA72F3D8DD7ull) * 0x165667B19E3779F9ull;
+            h ^= h >> 29;
+            return static_cast<uint32_t>(h ^ (h >> 32));
+        }
+    };
+
+    /**
+     * @brief Numbers the distinct vertex positions in order of first appearance.
+     *
+     * @param outGroups Receives the position number of every vertex.
+     * @return Number of distinct positions.
+     */
+    size_t groupByPosition(const Vertex *vertices, size_t vertexCount, std::vector<unsigned int> &outGroups)
+    {
+        size_t tableSize = 16;
+        while (tableSize < vertexCount * 2)
+        {
+            tableSize <<= 1;
+        }
+        // Slots hold the first vertex with each position, which doubles as the key
+        std::vector<unsigned int> slots(tableSize, kEmptySlot);
+        const size_t mask = tableSize - 1;
+        outGroups.resize(vertexCount);
+        size_t groupCount = 0;
+        for (size_t v = 0; v < vertexCount; ++v)
+        {
+            const PositionKey key(vertices[v].Position);
+            size_t slot = key.hash() & mask;
+            while (slots[slot] != kEmptySlot && !(PositionKey(vertices[slots[slot]].Position) == key))
+            {
+                slot = (slot + 1) & mask;
+            }
+            if (slots[slot] == kEmptySlot)
+            {
+                slots[slot] = static_cast<unsigned int>(v);
+                outGroups[v] = static_cast<unsigned int>(groupCount++);
+            }
+            else
+            {
+                outGroups[v] = outGroups[slots[slot]];
+            }
+        }
+        return groupCount;
+    }
+}
+
+MeshStats computeMeshStats(const Vertex *vertices, size_t vertexCount, const unsigned int *indices, size_t indexCount,
+                           ThreadPool *pool)
+{
+    MeshStats stats;
+    stats.triangles = indexCount / 3;
+    stats.vertices = vertexCount;
+
+    const size_t triangleBlocks = (stats.triangles + kAnalyticsBlockTriangles - 1) / kAnalyticsBlockTriangles;
+    std::vector<double> blockAreas(triangleBlocks), blockVolumes(triangleBlocks);
+    std::vector<size_t> blockDegenerates(triangleBlocks);
+    runParallel(pool, triangleBlocks, 4, [&](size_t beginBlock, size_t endBlock)
+    {
+        double areas[kAnalyticsBlockTriangles], volumes[kAnalyticsBlockTriangles];
+        for (size_t block = beginBlock; block < endBlock; ++block)
+        {
+            const size_t first = block * kAnalyticsBlockTriangles;
+            const size_t count = std::min(kAnalyticsBlockTriangles, stats.triangles - first);
+            size_t degenerates = 0;
+            for (size_t i = 0; i < count; ++i)
+            {
+                const unsigned int *corner = indices + 3 * (first + i);
+                const Double3 a = toDouble(vertices[corner[0]].Position);
+                const Double3 b = toDouble(vertices[corner[1]].Position);
+                const Double3 c = toDouble(vertices[corner[2]].Position);
+                const Double3 normal = cross(sub(b, a), sub(c, a));
+                const double doubleArea = std::sqrt(dot(normal, normal));
+                degenerates += doubleArea == 0.0;
+                areas[i] = 0.5 * doubleArea;
+                // Signed volume of the tetrahedron from the origin to the triangle
+                volumes[i] = dot(a, cross(b, c)) / 6.0;
+            }
+            blockAreas[block] = pairwiseSum(areas, count);
+            blockVolumes[block] = pairwiseSum(volumes, count);
+            blockDegenerates[block] = degenerates;
+        }
+    });
+    stats.surfaceArea = pairwiseSum(blockAreas.data(), triangleBlocks);
+    stats.signedVolume = pairwiseSum(blockVolumes.data(), triangleBlocks);
+    for (size_t degenerates : blockDegenerates)
+    {
+        stats.degenerateTriangles += degenerates;
+    }
+
+    if (vertexCount == 0)
+    {
+        return stats;
+    }
+
+    // Minimum and maximum do not depend on order, so the blocks can be combined any way
+    const size_t vertexBlocks = (vertexCount + kVertexBlock - 1) / kVertexBlock;
+    std::vector<BoundsBlock> bounds(vertexBlocks);
+    runParallel(pool, vertexBlocks, 4, [&](size_t beginBlock, size_t endBlock)
+    {
+        for (size_t block = beginBlock; block < endBlock; ++block)
+        {
+            const size_t end = std::min(vertexCount, (block + 1) * kVertexBlock);
+            glm::vec3 minimum = vertices[block * kVertexBlock].Position, maximum = minimum;
+            for (size_t v = block * kVertexBlock + 1; v < end; ++v)
+            {
+                minimum = glm::min(minimum, vertices[v].Position);
+                maximum = glm::max(maximum, vertices[v].Position);
+            }
+            bounds[block] = {minimum, maximum};
+        }
+    });
+    stats.boundsMin = bounds[0].minimum;
+    stats.boundsMax = bounds[0].maximum;
+    for (const BoundsBlock &block : bounds)
+    {
+        stats.boundsMin = glm::min(stats.boundsMin, block.minimum);
+        stats.boundsMax = glm::max(stats.boundsMax, block.maximum);
+    }
+
+    stats.sphereCenter = (stats.boundsMin + stats.boundsMax) * 0.5f;
+    std::vector<float> blockRadii(vertexBlocks);
+    runParallel(pool, vertexBlocks, 4, [&](size_t beginBlock, size_t endBlock)
+    {
+        for (size_t block = beginBlock; block < endBlock; ++block)
+        {
+            const size_t end = std::min(vertexCount, (block + 1) * kVertexBlock);
+            float farthest = 0.0f;
+            for (size_t v = block * kVertexBlock; v < end; ++v)
+            {
+                const glm::vec3 offset = vertices[v].Position - stats.sphereCenter;
+                farthest = std::max(farthest, glm::dot(offset, offset));
+            }
+            blockRadii[block] = farthest;
+        }
+    });
+    stats.sphereRadius = std::sqrt(*std::max_element(blockRadii.begin(), blockRadii.end()));
+    return stats;
+}
+
+void computeTriangleNormals(const Vertex *vertices, const unsigned int *indices, size_t indexCount,
+                            std::vector<glm::vec3> &outNormals, ThreadPool *pool)
+{
+    outNormals.resize(indexCount / 3);
+    runParallel(pool, outNormals.size(), kAnalyticsBlockTriangles, [&](size_t begin, size_t end)
+    {
+        for (size_t t = begin; t < end; ++t)
+        {
+            const glm::vec3 &a = vertices[indices[3 * t]].Position;
+            const glm::vec3 normal = glm::cross(vertices[indices[3 * t + 1]].Position - a, vertices[indices[3 * t + 2]].Position - a);
+            const float length = glm::length(normal);
+            outNormals[t] = length > 0.0f ? normal / length : glm::vec3(0.0f);
+        }
+    });
+}
+
+size_t generateSmoothNormals(Vertex *vertices, size_t vertexCount, const unsigned int *indices, size_t indexCount,
+                             ThreadPool *pool)
+{
+    const size_t triangleCount = indexCount / 3;
+    std::vector<unsigned int> groups;
+    const size_t groupCount = groupByPosition(vertices, vertexCount, groups);
+
+    // Unnormalized face normals: their length is twice the area, which is the weight we want
+    std::vector<glm::vec3> faceNormals(triangleCount);
+    runParallel(pool, triangleCount, kAnalyticsBlockTriangles, [&](size_t begin, size_t end)
+    {
+        for (size_t t = begin; t < end; ++t)
+        {
+            const glm::vec3 &a = vertices[indices[3 * t]].Position;
+            faceNormals[t] = glm::cross(vertices[indices[3 * t + 1]].Position - a, vertices[indices[3 * t + 2]].Position - a);
+        }
+    });
+
+    // The triangles around each position, listed in index buffer order
+    std::vector<unsigned int> firstFace(groupCount + 1, 0);
+    for (size_t c = 0; c < triangleCount * 3; ++c)
+    {
+        ++firstFace[groups[indices[c]] + 1];
+    }
+    for (size_t g = 0; g < groupCount; ++g)
+    {
+        firstFace[g + 1] += firstFace[g];
+    }
+    std::vector<unsigned int> faces(triangleCount * 3);
+    std::vector<unsigned int> fill(firstFace.begin(), firstFace.end() - 1);
+    for (size_t c = 0; c < triangleCount * 3; ++c)
+    {
+        faces[fill[groups[indices[c]]]++] = static_cast<unsigned int>(c / 3);
+    }
+
+    std::vector<glm::vec3> groupNormals(groupCount);
+    runParallel(pool, groupCount, 4096, [&](size_t begin, size_t end)
+    {
+        for (size_t g = begin; g < end; ++g)
+        {
+            glm::vec3 sum(0.0f);
+            for (unsigned int f = firstFace[g]; f < firstFace[g + 1]; ++f)
+            {
+                sum += faceNormals[faces[f]];
+            }
+            const float length = glm::length(sum);
+            groupNormals[g] = length > 0.0f ? sum / length : glm::vec3(0.0f);
+        }
+    });
+
+    std::atomic<size_t> filled{0};
+    runParallel(pool, vertexCount, kVertexBlock, [&](size_t begin, size_t end)
+    {
+        size_t count = 0;
+        for (size_t v = begin; v < end; ++v)
+        {
+            const glm::vec3 &normal = groupNormals[groups[v]];
+            if (vertices[v].Normal == glm::vec3(0.0f) && normal != glm::vec3(0.0f))
+            {
+                vertices[v].Normal = normal;
+                ++count;
+            }
+        }
+        filled += count;
+    });
+    return filled.load();
+}
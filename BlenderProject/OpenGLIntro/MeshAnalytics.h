@@ -0,0 +1,71 @@
+#pragma once
+
+#include "Mesh.h"
+
+#include <cstddef>
+#include <vector>
+
+class ThreadPool;
+
+// Triangles summed per block before the block totals are combined; fixes the summation order
+constexpr size_t kAnalyticsBlockTriangles = 1024;
+
+/**
+ * @brief Whole-mesh measurements for asset checks.
+ */
+struct MeshStats
+{
+    size_t triangles = 0;
+    size_t vertices = 0;
+    size_t degenerateTriangles = 0; // Zero area, so no normal
+    double surfaceArea = 0.0;
+    double signedVolume = 0.0; // Positive for a closed mesh with counter-clockwise outward faces
+    glm::vec3 boundsMin = glm::vec3(0.0f);
+    glm::vec3 boundsMax = glm::vec3(0.0f);
+    glm::vec3 sphereCenter = glm::vec3(0.0f); // Sphere around the box center holding every vertex
+    float sphereRadius = 0.0f;
+};
+
+/**
+ * @brief Surface area, signed volume, bounding box and bounding sphere of a triangle mesh.
+ *
+ * Sums are taken per triangle in double precision, added pairwise within blocks of
+ * kAnalyticsBlockTriangles, and the block totals are then added pairwise in order. The
+ * result is the same for any thread count, and the rounding error grows with the log of the
+ * triangle count instead of the count itself.
+ *
+ * @param vertices Vertex buffer.
+ * @param vertexCount Number of vertices.
+ * @param indices Triangle list indices.
+ * @param indexCount Number of indices.
+ * @param pool Optional; spreads the blocks over its threads.
+ * @return The measurements.
+ */
+MeshStats computeMeshStats(const Vertex *vertices, size_t vertexCount, const unsigned int *indices, size_t indexCount,
+                           ThreadPool *pool = nullptr);
+
+/**
+ * @brief Unit normal of every triangle, following the counter-clockwise winding. Degenerate
+ * triangles get a zero normal.
+ *
+ * @param outNormals Resized to one normal per triangle.
+ */
+void computeTriangleNormals(const Vertex *vertices, const unsigned int *indices, size_t indexCount,
+                            std::vector<glm::vec3> &outNormals, ThreadPool *pool = nullptr);
+
+/**
+ * @brief Fills in smooth normals for vertices that have none, as loadOBJ leaves corners without vn.
+ *
+ * Vertices at the same position share a normal: the sum of the unnormalized face normals of
+ * every triangle touching that position, which weights each face by its area. Each position
+ * adds its faces up in index buffer order, so the result is the same for any thread count.
+ *
+ * @param vertices Vertex buffer; only vertices with a zero normal are written.
+ * @param vertexCount Number of vertices.
+ * @param indices Triangle list indices.
+ * @param indexCount Number of indices.
+ * @param pool Optional; spreads the per-triangle and per-position work over its threads.
+ * @return Number of vertices that were given a normal.
+ */
+size_t generateSmoothNormals(Vertex *vertices, size_t vertexCount, const unsigned int *indices, size_t indexCount,
+                             ThreadPool *pool = nullptr);
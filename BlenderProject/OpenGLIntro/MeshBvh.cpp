@@ -0,0 +1,709 @@
+#include "MeshBvh.h"
+#include "ThreadPool.h"
+
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <functional>
+
+#if defined(_M_X64) || defined(__x86_64__) || defined(__SSE2__)
+#define BVH_SSE 1
+#include <emmintrin.h>
+#endif
+
+namespace
+{
+    // Below this depth the SAH search is skipped in favour of splitting the range in half, which
+    // bounds the depth of degenerate inputs and so the traversal stack
+    constexpr unsigned int kMaxSahDepth = 48;
+    constexpr unsigned int kTraversalStackSize = 96;
+
+    // SAH costs, in units of one triangle test
+    constexpr float kTraversalCost = 1.0f;
+
+    struct Bounds
+    {
+        glm::vec3 min = glm::vec3(std::numeric_limits<float>::max());
+        glm::vec3 max = glm::vec3(-std::numeric_limits<float>::max());
+
+        void grow(const glm::vec3 &point)
+        {
+            min = glm::min(min, point);
+            max = glm::max(max, point);
+        }
+
+        void grow(const Bounds &other)
+        {
+            min = glm::min(min, other.min);
+            max = glm::max(max, other.max);
+        }
+
+        float area() const
+        {
+            const glm::vec3 size = max - min;
+            return size.x < 0.0f ? 0.0f : 2.0f * (size.x * size.y + size.y * size.z + size.z * size.x);
+        }
+    };
+
+    /**
+     * @brief Per-triangle inputs to the build and the reference array that gets partitioned.
+     */
+    struct BuildInput
+    {
+        std::vector<Bounds> bounds;
+        std::vector<glm::vec3> centroids;
+        std::vector<unsigned int> references; // Triangle indices, reordered so every node owns a range
+    };
+
+    /**
+     * @brief Decides how to split references[begin, end) and partitions the range accordingly.
+     *
+     * @param node Receives the range's bounds; for a split, its axis.
+     * @param mid Receives the first reference of the second child.
+     * @return false if the range should become a leaf.
+     */
+    bool splitRange(BuildInput &input, size_t begin, size_t end, unsigned int depth, BvhNode &node, size_t &mid)
+    {
+        Bounds bounds, centroidBounds;
+        for (size_t i = begin; i < end; ++i)
+        {
+            const unsigned int triangle = input.references[i];
+            bounds.grow(input.bounds[triangle]);
+            centroidBounds.grow(input.centroids[triangle]);
+        }
+        node.boundsMin = bounds.min;
+        node.boundsMax = bounds.max;
+        node.axis = 0;
+
+        const size_t count = end - begin;
+        if (count <= 1)
+        {
+            return false;
+        }
+
+        // Bin the centroids on every axis, then sweep the bin boundaries from both sides
+        int bestAxis = -1;
+        unsigned int bestBin = 0;
+        float bestCost = std::numeric_limits<float>::max();
+        const glm::vec3 extent = centroidBounds.max - centroidBounds.min;
+        if (depth < kMaxSahDepth)
+        {
+            for (int axis = 0; axis < 3; ++axis)
+            {
+                if (!(extent[axis] > 0.0f))
+                {
+                    continue;
+                }
+                Bounds binBounds[kBvhBins];
+                size_t binCounts[kBvhBins] = {};
+                const float scale = kBvhBins / extent[axis];
+                for (size_t i = begin; i < end; ++i)
+                {
+                    const unsigned int triangle = input.references[i];
+                    const unsigned int bin = std::min(kBvhBins - 1, static_cast<unsigned int>((input.centroids[triangle][axis] - centroidBounds.min[axis]) * scale));
+                    binBounds[bin].grow(input.bounds[triangle]);
+                    ++binCounts[bin];
+                }
+
+                float rightCost[kBvhBins] = {};
+                Bounds right;
+                size_t rightCount = 0;
+                for (unsigned int bin = kBvhBins - 1; bin > 0; --bin)
+                {
+                    right.grow(binBounds[bin]);
+                    rightCount += binCounts[bin];
+                    rightCost[bin] = right.area() * rightCount;
+                }
+                Bounds left;
+                size_t leftCount = 0;
+                for (unsigned int bin = 1; bin < kBvhBins; ++bin)
+                {
+                    left.grow(binBounds[bin - 1]);
+                    leftCount += binCounts[bin - 1];
+                    const float cost = left.area() * leftCount + rightCost[bin];
+                    if (leftCount > 0 && leftCount < count && cost < bestCost)
+                    {
+                        bestCost = cost;
+                        bestAxis = axis;
+                        bestBin = bin;
+                    }
+                }
+            }
+        }
+
+        if (bestAxis >= 0)
+        {
+            const float area = bounds.area();
+            const float splitCost = kTraversalCost + (area > 0.0f ? bestCost / area : static_cast<float>(count));
+            if (count <= kBvhLeafTriangles && splitCost >= static_cast<float>(count))
+            {
+                return false;
+            }
+            const float scale = kBvhBins / extent[bestAxis];
+            const float origin = centroidBounds.min[bestAxis];
+            auto first = input.references.begin() + begin;
+            mid = begin + (std::partition(first, input.references.begin() + end, [&](unsigned int triangle)
+            {
+                return std::min(kBvhBins - 1, static_cast<unsigned int>((input.centroids[triangle][bestAxis] - origin) * scale)) < bestBin;
+            }) - first);
+            node.axis = static_cast<uint16_t>(bestAxis);
+            return true;
+        }
+
+        // Every centroid in the same place, or too deep: split the range in half
+        if (count <= kBvhLeafTriangles)
+        {
+            return false;
+        }
+        mid = begin + count / 2;
+        const glm::vec3 size = bounds.max - bounds.min;
+        node.axis = static_cast<uint16_t>(size.x >= size.y && size.x >= size.z ? 0 : size.y >= size.z ? 1 : 2);
+        return true;
+    }
+
+    /**
+     * @brief Builds the subtree for references[begin, end) depth first into nodes. Leaves point at
+     * their first reference until the triangle blocks are made.
+     */
+    void buildSubtree(BuildInput &input, size_t begin, size_t end, unsigned int depth, std::vector<BvhNode> &nodes)
+    {
+        const size_t index = nodes.size();
+        nodes.emplace_back();
+        BvhNode node = {};
+        size_t mid = 0;
+        if (!splitRange(input, begin, end, depth, node, mid))
+        {
+            node.offset = static_cast<unsigned int>(begin);
+            node.count = static_cast<uint16_t>(end - begin);
+            nodes[index] = node;
+            return;
+        }
+        buildSubtree(input, begin, mid, depth + 1, nodes);
+        node.offset = static_cast<unsigned int>(nodes.size());
+        nodes[index] = node;
+        buildSubtree(input, mid, end, depth + 1, nodes);
+    }
+
+    /**
+     * @brief The serially built top of the tree. Each branch ends in a task: a range whose
+     * subtree is built on its own thread.
+     */
+    struct TopNode
+    {
+        BvhNode node;
+        int children[2] = {-1, -1}; // Indices into the top node list; -1 for a task
+        size_t begin = 0, end = 0;
+        unsigned int depth = 0;
+        std::vector<BvhNode> subtree; // Tasks only
+    };
+
+    int splitTop(BuildInput &input, size_t begin, size_t end, unsigned int depth, size_t taskSize, std::vector<TopNode> &top)
+    {
+        const int index = static_cast<int>(top.size());
+        top.emplace_back();
+        top[index].begin = begin;
+        top[index].end = end;
+        top[index].depth = depth;
+        if (end - begin <= taskSize)
+        {
+            return index;
+        }
+        BvhNode node = {};
+        size_t mid = 0;
+        if (!splitRange(input, begin, end, depth, node, mid))
+        {
+            return index;
+        }
+        top[index].node = node;
+        const int left = splitTop(input, begin, mid, depth + 1, taskSize, top);
+        const int right = splitTop(input, mid, end, depth + 1, taskSize, top);
+        top[index].children[0] = left;
+        top[index].children[1] = right;
+        return index;
+    }
+
+    void spliceTop(std::vector<TopNode> &top, int index, std::vector<BvhNode> &nodes)
+    {
+        TopNode &entry = top[index];
+        if (entry.children[0] < 0)
+        {
+            const unsigned int base = static_cast<unsigned int>(nodes.size());
+            for (BvhNode node : entry.subtree)
+            {
+                if (node.count == 0)
+                {
+                    node.offset += base;
+                }
+                nodes.push_back(node);
+            }
+            return;
+        }
+        const size_t slot = nodes.size();
+        nodes.push_back(entry.node);
+        spliceTop(top, entry.children[0], nodes);
+        nodes[slot].offset = static_cast<unsigned int>(nodes.size());
+        spliceTop(top, entry.children[1], nodes);
+    }
+
+    bool hitBounds(const BvhNode &node, const glm::vec3 &origin, const glm::vec3 &inverseDirection, float tMin, float tMax)
+    {
+        const glm::vec3 t0 = (node.boundsMin - origin) * inverseDirection;
+        const glm::vec3 t1 = (node.boundsMax - origin) * inverseDirection;
+        const glm::vec3 nearT = glm::min(t0, t1);
+        const glm::vec3 farT = glm::max(t0, t1);
+        const float enter = std::max(std::max(nearT.x, nearT.y), std::max(nearT.z, tMin));
+        const float exit = std::min(std::min(farT.x, farT.y), std::min(farT.z, tMax));
+        return enter <= exit;
+    }
+
+    /**
+     * @brief 1 / direction, with zero components replaced by a tiny value so the slab test never
+     * computes 0 * infinity.
+     */
+    glm::vec3 inverseOf(const glm::vec3 &direction)
+    {
+        glm::vec3 inverse;
+        for (int axis = 0; axis < 3; ++axis)
+        {
+            const float d = direction[axis];
+            inverse[axis] = 1.0f / (std::fabs(d) > 1e-30f ? d : std::copysign(1e-30f, d));
+        }
+        return inverse;
+    }
+
+    /**
+     * @brief Moller-Trumbore against the four triangles of a leaf.
+     *
+     * @return The lane of the nearest hit closer than tMax, or -1.
+     */
+    int intersectBlock(const BvhTriangleBlock &block, const Ray &ray, float tMax, float &t, float &u, float &v)
+    {
+#ifdef BVH_SSE
+        const __m128 dx = _mm_set1_ps(ray.direction.x), dy = _mm_set1_ps(ray.direction.y), dz = _mm_set1_ps(ray.direction.z);
+        const __m128 e1x = _mm_loadu_ps(block.e1x), e1y = _mm_loadu_ps(block.e1y), e1z = _mm_loadu_ps(block.e1z);
+        const __m128 e2x = _mm_loadu_ps(block.e2x), e2y = _mm_loadu_ps(block.e2y), e2z = _mm_loadu_ps(block.e2z);
+        const __m128 px = _mm_sub_ps(_mm_mul_ps(dy, e2z), _mm_mul_ps(dz, e2y));
+        const __m128 py = _mm_sub_ps(_mm_mul_ps(dz, e2x), _mm_mul_ps(dx, e2z));
+        const __m128 pz = _mm_sub_ps(_mm_mul_ps(dx, e2y), _mm_mul_ps(dy, e2x));
+        const __m128 det = _mm_add_ps(_mm_add_ps(_mm_mul_ps(e1x, px), _mm_mul_ps(e1y, py)), _mm_mul_ps(e1z, pz));
+        const __m128 inverse = _mm_div_ps(_mm_set1_ps(1.0f), det);
+        const __m128 sx = _mm_sub_ps(_mm_set1_ps(ray.origin.x), _mm_loadu_ps(block.v0x));
+        const __m128 sy = _mm_sub_ps(_mm_set1_ps(ray.origin.y), _mm_loadu_ps(block.v0y));
+        const __m128 sz = _mm_sub_ps(_mm_set1_ps(ray.origin.z), _mm_loadu_ps(block.v0z));
+        const __m128 hitU = _mm_mul_ps(_mm_add_ps(_mm_add_ps(_mm_mul_ps(sx, px), _mm_mul_ps(sy, py)), _mm_mul_ps(sz, pz)), inverse);
+        const __m128 qx = _mm_sub_ps(_mm_mul_ps(sy, e1z), _mm_mul_ps(sz, e1y));
+        const __m128 qy = _mm_sub_ps(_mm_mul_ps(sz, e1x), _mm_mul_ps(sx, e1z));
+        const __m128 qz = _mm_sub_ps(_mm_mul_ps(sx, e1y), _mm_mul_ps(sy, e1x));
+        const __m128 hitV = _mm_mul_ps(_mm_add_ps(_mm_add_ps(_mm_mul_ps(dx, qx), _mm_mul_ps(dy, qy)), _mm_mul_ps(dz, qz)), inverse);
+        const __m128 hitT = _mm_mul_ps(_mm_add_ps(_mm_add_ps(_mm_mul_ps(e2x, qx), _mm_mul_ps(e2y, qy)), _mm_mul_ps(e2z, qz)), inverse);
+
+        const __m128 zero = _mm_setzero_ps();
+        __m128 mask = _mm_cmpneq_ps(det, zero);
+        mask = _mm_and_ps(mask, _mm_cmpge_ps(hitU, zero));
+        mask = _mm_and_ps(mask, _mm_cmpge_ps(hitV, zero));
+        mask = _mm_and_ps(mask, _mm_cmple_ps(_mm_add_ps(hitU, hitV), _mm_set1_ps(1.0f)));
+        mask = _mm_and_ps(mask, _mm_cmpgt_ps(hitT, _mm_set1_ps(ray.tMin)));
+        mask = _mm_and_ps(mask, _mm_cmplt_ps(hitT, _mm_set1_ps(tMax)));
+        int lanes = _mm_movemask_ps(mask);
+        if (!lanes)
+        {
+            return -1;
+        }
+        float ts[4], us[4], vs[4];
+        _mm_storeu_ps(ts, hitT);
+        _mm_storeu_ps(us, hitU);
+        _mm_storeu_ps(vs, hitV);
+        int best = -1;
+        for (int lane = 0; lane < 4; ++lane)
+        {
+            if ((lanes >> lane & 1) && (best < 0 || ts[lane] < ts[best]))
+            {
+                best = lane;
+            }
+        }
+        t = ts[best];
+        u = us[best];
+        v = vs[best];
+        return best;
+#else
+        int best = -1;
+        for (int lane = 0; lane < 4; ++lane)
+        {
+            const glm::vec3 e1(block.e1x[lane], block.e1y[lane], block.e1z[lane]);
+            const glm::vec3 e2(block.e2x[lane], block.e2y[lane], block.e2z[lane]);
+            const glm::vec3 p = glm::cross(ray.direction, e2);
+            const float det = glm::dot(e1, p);
+            if (det == 0.0f)
+            {
+                continue;
+            }
+            const float inverse = 1.0f / det;
+            const glm::vec3 s = ray.origin - glm::vec3(block.v0x[lane], block.v0y[lane], block.v0z[lane]);
+            const float hitU = glm::dot(s, p) * inverse;
+            const glm::vec3 q = glm::cross(s, e1);
+            const float hitV = glm::dot(ray.direction, q) * inverse;
+            const float hitT = glm::dot(e2, q) * inverse;
+            if (hitU >= 0.0f && hitV >= 0.0f && hitU + hitV <= 1.0f && hitT > ray.tMin && hitT < tMax)
+            {
+                tMax = t = hitT;
+                u = hitU;
+                v = hitV;
+                best = lane;
+            }
+        }
+        return best;
+#endif
+    }
+}
+
+BvhBuildStats MeshBvh::build(const Vertex *vertices, size_t vertexCount, const unsigned int *indices, size_t indexCount,
+                             ThreadPool *pool)
+{
+    const std::chrono::steady_clock::time_point start = std::chrono::steady_clock::now();
+    nodeArray.clear();
+    blocks.clear();
+    BvhBuildStats stats;
+
+    // Drop triangles with out-of-range indices up front so the build never has to check
+    const size_t triangleCount = indexCount / 3;
+    BuildInput input;
+    input.bounds.resize(triangleCount);
+    input.centroids.resize(triangleCount);
+    input.references.reserve(triangleCount);
+    for (size_t triangle = 0; triangle < triangleCount; ++triangle)
+    {
+        const unsigned int *corner = indices + triangle * 3;
+        if (corner[0] >= vertexCount || corner[1] >= vertexCount || corner[2] >= vertexCount)
+        {
+            continue;
+        }
+        Bounds &bounds = input.bounds[triangle];
+        for (int i = 0; i < 3; ++i)
+        {
+            bounds.grow(vertices[corner[i]].Position);
+        }
+        input.centroids[triangle] = (bounds.min + bounds.max) * 0.5f;
+        input.references.push_back(static_cast<unsigned int>(triangle));
+    }
+    if (input.references.empty())
+    {
+        return stats;
+    }
+
+    // Serial top splits until every thread has a few subtrees to build, then build those in
+    // parallel and splice them together in depth-first order
+    const size_t referenceCount = input.references.size();
+    const size_t threads = pool ? pool->size() : 1;
+    const size_t taskSize = threads > 1 ? std::max<size_t>(1024, referenceCount / (threads * 4)) : referenceCount;
+    std::vector<TopNode> top;
+    splitTop(input, 0, referenceCount, 0, taskSize, top);
+    std::vector<size_t> tasks;
+    for (size_t i = 0; i < top.size(); ++i)
+    {
+        if (top[i].children[0] < 0)
+        {
+            tasks.push_back(i);
+        }
+    }
+    auto buildTasks = [&](size_t begin, size_t end)
+    {
+        for (size_t i = begin; i < end; ++i)
+        {
+            TopNode &task = top[tasks[i]];
+            buildSubtree(input, task.begin, task.end, task.depth, task.subtree);
+        }
+    };
+    if (pool)
+    {
+        pool->parallelFor(tasks.size(), 1, buildTasks);
+    }
+    else
+    {
+        buildTasks(0, tasks.size());
+    }
+    size_t nodeCount = top.size() - tasks.size();
+    for (size_t task : tasks)
+    {
+        nodeCount += top[task].subtree.size();
+    }
+    nodeArray.reserve(nodeCount);
+    spliceTop(top, 0, nodeArray);
+
+    // Copy each leaf's triangles into its SIMD block
+    for (BvhNode &node : nodeArray)
+    {
+        if (node.count == 0)
+        {
+            continue;
+        }
+        BvhTriangleBlock block = {};
+        for (unsigned int lane = 0; lane < 4; ++lane)
+        {
+            block.triangle[lane] = kBvhNoHit;
+            if (lane >= node.count)
+            {
+                continue;
+            }
+            const unsigned int triangle = input.references[node.offset + lane];
+            const unsigned int *corner = indices + static_cast<size_t>(triangle) * 3;
+            const glm::vec3 &v0 = vertices[corner[0]].Position;
+            const glm::vec3 e1 = vertices[corner[1]].Position - v0;
+            const glm::vec3 e2 = vertices[corner[2]].Position - v0;
+            block.v0x[lane] = v0.x;
+            block.v0y[lane] = v0.y;
+            block.v0z[lane] = v0.z;
+            block.e1x[lane] = e1.x;
+            block.e1y[lane] = e1.y;
+            block.e1z[lane] = e1.z;
+            block.e2x[lane] = e2.x;
+            block.e2y[lane] = e2.y;
+            block.e2z[lane] = e2.z;
+            block.triangle[lane] = triangle;
+        }
+        node.offset = static_cast<unsigned int>(blocks.size());
+        blocks.push_back(block);
+    }
+
+    // Shape statistics: depth and the SAH cost relative to the root's surface area
+    Bounds root;
+    root.min = nodeArray[0].boundsMin;
+    root.max = nodeArray[0].boundsMax;
+    const float rootArea = std::max(root.area(), 1e-30f);
+    std::vector<std::pair<unsigned int, unsigned int>> stack = {{0u, 1u}};
+    while (!stack.empty())
+    {
+        const unsigned int index = stack.back().first;
+        const unsigned int depth = stack.back().second;
+        stack.pop_back();
+        const BvhNode &node = nodeArray[index];
+        Bounds bounds;
+        bounds.min = node.boundsMin;
+        bounds.max = node.boundsMax;
+        stats.depth = std::max(stats.depth, depth);
+        if (node.count > 0)
+        {
+            ++stats.leaves;
+            stats.sahCost += bounds.area() / rootArea * node.count;
+            continue;
+        }
+        stats.sahCost += bounds.area() / rootArea * kTraversalCost;
+        stack.push_back({index + 1, depth + 1});
+        stack.push_back({node.offset, depth + 1});
+    }
+    stats.nodes = nodeArray.size();
+    std::chrono::duration<double> elapsed = std::chrono::steady_clock::now() - start;
+    stats.seconds = elapsed.count();
+    return stats;
+}
+
+template <bool AnyHit>
+bool MeshBvh::traverse(const Ray &ray, RayHit &hit) const
+{
+    if (nodeArray.empty())
+    {
+        return false;
+    }
+    const glm::vec3 inverseDirection = inverseOf(ray.direction);
+    const bool negative[3] = {ray.direction.x < 0.0f, ray.direction.y < 0.0f, ray.direction.z < 0.0f};
+    float tMax = ray.tMax;
+    bool found = false;
+
+    unsigned int stack[kTraversalStackSize];
+    unsigned int stackSize = 0;
+    unsigned int index = 0;
+    for (;;)
+    {
+        const BvhNode &node = nodeArray[index];
+        if (hitBounds(node, ray.origin, inverseDirection, ray.tMin, tMax))
+        {
+            if (node.count == 0)
+            {
+                // Front to back: the child on the side the ray comes from first
+                unsigned int nearChild = index + 1, farChild = node.offset;
+                if (negative[node.axis])
+                {
+                    std::swap(nearChild, farChild);
+                }
+                stack[stackSize++] = farChild;
+                index = nearChild;
+                continue;
+            }
+            float t, u, v;
+            const int lane = intersectBlock(blocks[node.offset], ray, tMax, t, u, v);
+            if (lane >= 0)
+            {
+                found = true;
+                if (AnyHit)
+                {
+                    return true;
+                }
+                tMax = t;
+                hit.t = t;
+                hit.u = u;
+                hit.v = v;
+                hit.triangle = blocks[node.offset].triangle[lane];
+            }
+        }
+        if (stackSize == 0)
+        {
+            break;
+        }
+        index = stack[--stackSize];
+    }
+    return found;
+}
+
+bool MeshBvh::intersect(const Ray &ray, RayHit &hit) const
+{
+    RayHit result;
+    if (!traverse<false>(ray, result))
+    {
+        return false;
+    }
+    hit = result;
+    return true;
+}
+
+bool MeshBvh::occluded(const Ray &ray) const
+{
+    RayHit unused;
+    return traverse<true>(ray, unused);
+}
+
+void MeshBvh::intersect4(const Ray rays[4], RayHit hits[4]) const
+{
+#ifdef BVH_SSE
+    for (int lane = 0; lane < 4; ++lane)
+    {
+        hits[lane] = RayHit();
+    }
+    if (nodeArray.empty())
+    {
+        return;
+    }
+
+    // The packet as structure-of-arrays, one ray per lane
+    alignas(16) float values[11][4];
+    glm::vec3 directionSum(0.0f);
+    for (int lane = 0; lane < 4; ++lane)
+    {
+        const glm::vec3 inverse = inverseOf(rays[lane].direction);
+        for (int axis = 0; axis < 3; ++axis)
+        {
+            values[axis][lane] = rays[lane].origin[axis];
+            values[3 + axis][lane] = rays[lane].direction[axis];
+            values[6 + axis][lane] = inverse[axis];
+        }
+        values[9][lane] = rays[lane].tMin;
+        values[10][lane] = rays[lane].tMax;
+        directionSum += rays[lane].direction;
+    }
+    const __m128 ox = _mm_load_ps(values[0]), oy = _mm_load_ps(values[1]), oz = _mm_load_ps(values[2]);
+    const __m128 dx = _mm_load_ps(values[3]), dy = _mm_load_ps(values[4]), dz = _mm_load_ps(values[5]);
+    const __m128 ix = _mm_load_ps(values[6]), iy = _mm_load_ps(values[7]), iz = _mm_load_ps(values[8]);
+    const __m128 tMin = _mm_load_ps(values[9]);
+    __m128 tMax = _mm_load_ps(values[10]);
+    __m128 bestU = _mm_setzero_ps(), bestV = _mm_setzero_ps();
+    __m128i bestTriangle = _mm_set1_epi32(-1);
+    const bool negative[3] = {directionSum.x < 0.0f, directionSum.y < 0.0f, directionSum.z < 0.0f};
+    const __m128 zero = _mm_setzero_ps(), one = _mm_set1_ps(1.0f);
+
+    unsigned int stack[kTraversalStackSize];
+    unsigned int stackSize = 0;
+    unsigned int index = 0;
+    for (;;)
+    {
+        const BvhNode &node = nodeArray[index];
+        // Slab test of the box against all four rays
+        const __m128 t0x = _mm_mul_ps(_mm_sub_ps(_mm_set1_ps(node.boundsMin.x), ox), ix);
+        const __m128 t1x = _mm_mul_ps(_mm_sub_ps(_mm_set1_ps(node.boundsMax.x), ox), ix);
+        const __m128 t0y = _mm_mul_ps(_mm_sub_ps(_mm_set1_ps(node.boundsMin.y), oy), iy);
+        const __m128 t1y = _mm_mul_ps(_mm_sub_ps(_mm_set1_ps(node.boundsMax.y), oy), iy);
+        const __m128 t0z = _mm_mul_ps(_mm_sub_ps(_mm_set1_ps(node.boundsMin.z), oz), iz);
+        const __m128 t1z = _mm_mul_ps(_mm_sub_ps(_mm_set1_ps(node.boundsMax.z), oz), iz);
+        const __m128 enter = _mm_max_ps(_mm_max_ps(_mm_min_ps(t0x, t1x), _mm_min_ps(t0y, t1y)), _mm_max_ps(_mm_min_ps(t0z, t1z), tMin));
+        const __m128 exit = _mm_min_ps(_mm_min_ps(_mm_max_ps(t0x, t1x), _mm_max_ps(t0y, t1y)), _mm_min_ps(_mm_max_ps(t0z, t1z), tMax));
+        if (_mm_movemask_ps(_mm_cmple_ps(enter, exit)))
+        {
+            if (node.count == 0)
+            {
+                unsigned int nearChild = index + 1, farChild = node.offset;
+                if (negative[node.axis])
+                {
+                    std::swap(nearChild, farChild);
+                }
+                stack[stackSize++] = farChild;
+                index = nearChild;
+                continue;
+            }
+
+            // Each triangle of the leaf against all four rays
+            const BvhTriangleBlock &block = blocks[node.offset];
+            for (unsigned int k = 0; k < node.count; ++k)
+            {
+                const __m128 e1x = _mm_set1_ps(block.e1x[k]), e1y = _mm_set1_ps(block.e1y[k]), e1z = _mm_set1_ps(block.e1z[k]);
+                const __m128 e2x = _mm_set1_ps(block.e2x[k]), e2y = _mm_set1_ps(block.e2y[k]), e2z = _mm_set1_ps(block.e2z[k]);
+                const __m128 px = _mm_sub_ps(_mm_mul_ps(dy, e2z), _mm_mul_ps(dz, e2y));
+                const __m128 py = _mm_sub_ps(_mm_mul_ps(dz, e2x), _mm_mul_ps(dx, e2z));
+                const __m128 pz = _mm_sub_ps(_mm_mul_ps(dx, e2y), _mm_mul_ps(dy, e2x));
+                const __m128 det = _mm_add_ps(_mm_add_ps(_mm_mul_ps(e1x, px), _mm_mul_ps(e1y, py)), _mm_mul_ps(e1z, pz));
+                const __m128 inverse = _mm_div_ps(one, det);
+                const __m128 sx = _mm_sub_ps(ox, _mm_set1_ps(block.v0x[k]));
+                const __m128 sy = _mm_sub_ps(oy, _mm_set1_ps(block.v0y[k]));
+                const __m128 sz = _mm_sub_ps(oz, _mm_set1_ps(block.v0z[k]));
+                const __m128 hitU = _mm_mul_ps(_mm_add_ps(_mm_add_ps(_mm_mul_ps(sx, px), _mm_mul_ps(sy, py)), _mm_mul_ps(sz, pz)), inverse);
+                const __m128 qx = _mm_sub_ps(_mm_mul_ps(sy, e1z), _mm_mul_ps(sz, e1y));
+                const __m128 qy = _mm_sub_ps(_mm_mul_ps(sz, e1x), _mm_mul_ps(sx, e1z));
+                const __m128 qz = _mm_sub_ps(_mm_mul_ps(sx, e1y), _mm_mul_ps(sy, e1x));
+                const __m128 hitV = _mm_mul_ps(_mm_add_ps(_mm_add_ps(_mm_mul_ps(dx, qx), _mm_mul_ps(dy, qy)), _mm_mul_ps(dz, qz)), inverse);
+                const __m128 hitT = _mm_mul_ps(_mm_add_ps(_mm_add_ps(_mm_mul_ps(e2x, qx), _mm_mul_ps(e2y, qy)), _mm_mul_ps(e2z, qz)), inverse);
+
+                __m128 mask = _mm_cmpneq_ps(det, zero);
+                mask = _mm_and_ps(mask, _mm_cmpge_ps(hitU, zero));
+                mask = _mm_and_ps(mask, _mm_cmpge_ps(hitV, zero));
+                mask = _mm_and_ps(mask, _mm_cmple_ps(_mm_add_ps(hitU, hitV), one));
+                mask = _mm_and_ps(mask, _mm_cmpgt_ps(hitT, tMin));
+                mask = _mm_and_ps(mask, _mm_cmplt_ps(hitT, tMax));
+                if (!_mm_movemask_ps(mask))
+                {
+                    continue;
+                }
+                tMax = _mm_or_ps(_mm_and_ps(mask, hitT), _mm_andnot_ps(mask, tMax));
+                bestU = _mm_or_ps(_mm_and_ps(mask, hitU), _mm_andnot_ps(mask, bestU));
+                bestV = _mm_or_ps(_mm_and_ps(mask, hitV), _mm_andnot_ps(mask, bestV));
+                const __m128i lanes = _mm_castps_si128(mask);
+                bestTriangle = _mm_or_si128(_mm_and_si128(lanes, _mm_set1_epi32(static_cast<int>(block.triangle[k]))),
+                                            _mm_andnot_si128(lanes, bestTriangle));
+            }
+        }
+        if (stackSize == 0)
+        {
+            break;
+        }
+        index = stack[--stackSize];
+    }
+
+    alignas(16) float ts[4], us[4], vs[4];
+    alignas(16) unsigned int triangles[4];
+    _mm_store_ps(ts, tMax);
+    _mm_store_ps(us, bestU);
+    _mm_store_ps(vs, bestV);
+    _mm_store_si128(reinterpret_cast<__m128i *>(triangles), bestTriangle);
+    for (int lane = 0; lane < 4; ++lane)
+    {
+        if (triangles[lane] != kBvhNoHit)
+        {
+            hits[lane].t = ts[lane];
+            hits[lane].u = us[lane];
+            hits[lane].v = vs[lane];
+            hits[lane].triangle = triangles[lane];
+        }
+    }
+#else
+    for (int lane = 0; lane < 4; ++lane)
+    {
+        hits[lane] = RayHit();
+        intersect(rays[lane], hits[lane]);
+    }
+#endif
+}
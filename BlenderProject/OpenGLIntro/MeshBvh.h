@@ -0,0 +1,133 @@
+#pragma once
+
+#include "Mesh.h"
+
+#include <cstddef>
+#include <cstdint>
+#include <limits>
+#include <vector>
+
+class ThreadPool;
+
+// Leaves hold at most this many triangles, one SIMD batch
+constexpr unsigned int kBvhLeafTriangles = 4;
+
+// Centroid bins per axis for the SAH split search
+constexpr unsigned int kBvhBins = 16;
+
+// Triangle index of a ray that hit nothing
+constexpr unsigned int kBvhNoHit = 0xffffffffu;
+
+/**
+ * @brief A node of the flattened tree, 32 bytes so two share a cache line.
+ *
+ * Nodes are stored depth first: an inner node's first child is the next node, so only the second
+ * child's index is stored.
+ */
+struct BvhNode
+{
+    glm::vec3 boundsMin;
+    unsigned int offset; // Inner: index of the second child. Leaf: index of its triangle block
+    glm::vec3 boundsMax;
+    uint16_t count; // Triangles in the leaf, 0 for inner nodes
+    uint16_t axis;  // Inner nodes: axis the children were split on, for front-to-back order
+};
+
+/**
+ * @brief The triangles of one leaf as structure-of-arrays, ready for a 4-wide intersection test.
+ * Unused lanes hold degenerate triangles that never hit.
+ */
+struct BvhTriangleBlock
+{
+    float v0x[4], v0y[4], v0z[4];
+    float e1x[4], e1y[4], e1z[4]; // v1 - v0
+    float e2x[4], e2y[4], e2z[4]; // v2 - v0
+    unsigned int triangle[4];     // Index of the triangle in the index buffer, kBvhNoHit if unused
+};
+
+struct Ray
+{
+    glm::vec3 origin;
+    glm::vec3 direction; // Need not be normalized; hit distances are in units of its length
+    float tMin = 0.0f;
+    float tMax = std::numeric_limits<float>::infinity();
+};
+
+struct RayHit
+{
+    float t = std::numeric_limits<float>::infinity();
+    unsigned int triangle = kBvhNoHit; // Index of the triangle: indices[3 * triangle] is its first corner
+    float u = 0.0f, v = 0.0f;          // Barycentrics of corners 1 and 2
+
+    bool hit() const { return triangle != kBvhNoHit; }
+};
+
+struct BvhBuildStats
+{
+    double seconds = 0.0;
+    size_t nodes = 0;
+    size_t leaves = 0;
+    unsigned int depth = 0;
+    float sahCost = 0.0f; // Expected traversal steps plus triangle tests for a random ray
+};
+
+/**
+ * @brief A bounding volume hierarchy over an indexed triangle mesh for ray casts on the CPU:
+ * picking, visibility queries and ray-traced previews.
+ *
+ * The tree is built top-down with a binned SAH split search over kBvhBins centroid bins on all
+ * three axes. With a thread pool, the top splits run serially until there are a few subtrees per
+ * thread, which are then built in parallel and spliced into one depth-first array; the result
+ * does not depend on the thread count.
+ *
+ * Traversal visits the nearer child first. A single ray tests a leaf's four triangles at once with
+ * SSE; a packet of four rays tests each box and triangle against all four rays at once.
+ */
+class MeshBvh
+{
+public:
+    /**
+     * @brief Builds the tree, replacing any previous one. Vertex positions are copied, so the
+     * buffers need not outlive the tree.
+     *
+     * @param vertices Vertex buffer.
+     * @param vertexCount Number of vertices.
+     * @param indices Triangle list indices.
+     * @param indexCount Number of indices.
+     * @param pool Optional; builds the lower subtrees in parallel.
+     * @return Build time and tree shape.
+     */
+    BvhBuildStats build(const Vertex *vertices, size_t vertexCount, const unsigned int *indices, size_t indexCount,
+                        ThreadPool *pool = nullptr);
+
+    /**
+     * @brief Finds the nearest triangle the ray hits between ray.tMin and ray.tMax.
+     *
+     * @return true if anything was hit; hit is left unchanged otherwise.
+     */
+    bool intersect(const Ray &ray, RayHit &hit) const;
+
+    /**
+     * @brief Visibility query: true as soon as any triangle is found between ray.tMin and ray.tMax.
+     */
+    bool occluded(const Ray &ray) const;
+
+    /**
+     * @brief Nearest hits for four rays traced together. Faster than four intersect() calls when
+     * the rays are coherent, such as neighbouring camera rays.
+     *
+     * @param rays Four rays.
+     * @param hits Receives one result per ray; a ray that misses gets a default RayHit.
+     */
+    void intersect4(const Ray rays[4], RayHit hits[4]) const;
+
+    const std::vector<BvhNode> &nodes() const { return nodeArray; }
+    bool empty() const { return nodeArray.empty(); }
+
+private:
+    template <bool AnyHit>
+    bool traverse(const Ray &ray, RayHit &hit) const;
+
+    std::vector<BvhNode> nodeArray;
+    std::vector<BvhTriangleBlock> blocks; // One per leaf
+};
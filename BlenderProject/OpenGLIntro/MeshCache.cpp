@@ -0,0 +1,636 @@
+#include "MeshCache.h"
+#include "MeshIndexer.h"
+#include "MeshOptimizer.h"
+#include "ObjParser.h"
+#include "Profiler.h"
+
+#include <algorithm>
+#include <cstdio>
+#include <cstring>
+#include <filesystem>
+#include <fstream>
+#include <iostream>
+#include <unordered_map>
+
+namespace
+{
+    const char kMagic[8] = {'M', 'E', 'S', 'H', 'C', 'A', 'C', 'H'};
+    const uint32_t kEndianness = 0x01020304u;
+    const uint32_t kGLFloat = 0x1406; // GL_FLOAT
+    const uint64_t kSectionAlignment = 64;
+
+    uint64_t alignUp(uint64_t value)
+    {
+        return (value + kSectionAlignment - 1) & ~(kSectionAlignment - 1);
+    }
+
+    bool sectionFits(uint64_t offset, uint64_t count, uint64_t elementSize, uint64_t fileSize)
+    {
+        return offset % kSectionAlignment == 0 && offset <= fileSize && count <= (fileSize - offset) / elementSize;
+    }
+
+    inline uint64_t rotateLeft(uint64_t value, int bits)
+    {
+        return (value << bits) | (value >> (64 - bits));
+    }
+
+    inline uint64_t mixLane(uint64_t lane, uint64_t input)
+    {
+        lane += input * 0xC2B2AE3D27D4EB4Full;
+        lane = rotateLeft(lane, 31);
+        return lane * 0x9E3779B185EBCA87ull;
+    }
+
+    /**
+     * @brief Describes the current Vertex struct, so caches written with another layout are rejected.
+     */
+    std::vector<MeshCacheAttribute> currentLayout()
+    {
+        return {
+            {0, 3, kGLFloat, 0, static_cast<uint32_t>(offsetof(Vertex, Position)), 0},
+            {1, 3, kGLFloat, 0, static_cast<uint32_t>(offsetof(Vertex, Normal)), 0},
+        };
+    }
+
+    bool sourceInfo(const std::string &path, uint64_t &size, int64_t &time)
+    {
+        std::error_code error;
+        size = std::filesystem::file_size(path, error);
+        if (error)
+        {
+            return false;
+        }
+        time = static_cast<int64_t>(std::filesystem::last_write_time(path, error).time_since_epoch().count());
+        return !error;
+    }
+
+    /**
+     * @brief One MeshCacheMaterial per material range, with the parameters of the library entry
+     * of the same name. Materials the libraries do not define keep the MTL defaults.
+     */
+    std::string libraryPath(const std::string &objPath, const std::string &name)
+    {
+        return (std::filesystem::path(objPath).parent_path() / name).string();
+    }
+
+    std::vector<MeshCacheMaterial> buildMaterials(const std::string &objPath, const ObjData &data)
+    {
+        std::vector<ObjMaterial> library;
+        for (const std::string &file : data.materialLibraries)
+        {
+            // A missing library only costs the colours
+            loadMTL(libraryPath(objPath, file), library);
+        }
+        std::unordered_map<std::string, const ObjMaterial *> byName;
+        for (const ObjMaterial &material : library)
+        {
+            byName.emplace(material.name, &material);
+        }
+
+        std::vector<MeshCacheMaterial> materials;
+        const ObjMaterial fallback;
+        for (const ObjMaterialRange &range : data.materialRanges)
+        {
+            const std::string &name = data.materialNames[range.material];
+            const auto found = byName.find(name);
+            if (found == byName.end() && !name.empty())
+            {
+                std::cerr << objPath << ": material " << name << " is not in any mtllib" << std::endl;
+            }
+            const ObjMaterial &source = found != byName.end() ? *found->second : fallback;
+
+            MeshCacheMaterial material = {};
+            std::snprintf(material.name, sizeof(material.name), "%s", name.empty() ? "(none)" : name.c_str());
+            for (int c = 0; c < 3; ++c)
+            {
+                material.diffuse[c] = source.diffuse[c];
+                material.specular[c] = source.specular[c];
+            }
+            material.shininess = source.shininess;
+            material.firstIndex = static_cast<uint32_t>(range.firstCorner);
+            material.indexCount = static_cast<uint32_t>(range.cornerCount);
+            materials.push_back(material);
+        }
+        return materials;
+    }
+
+    /**
+     * @brief Whether the ranges follow each other without gaps from first and end at first + total,
+     * each a whole number of triangles.
+     */
+    template <typename Range>
+    bool coversInOrder(const Range *ranges, size_t count, uint64_t first, uint64_t total)
+    {
+        uint64_t next = first;
+        for (size_t r = 0; r < count; ++r)
+        {
+            if (ranges[r].firstIndex != next || ranges[r].indexCount % 3 != 0 || ranges[r].indexCount > first + total - next)
+            {
+                return false;
+            }
+            next += ranges[r].indexCount;
+        }
+        return next == first + total;
+    }
+
+    bool indicesInRange(const unsigned int *indices, size_t indexCount, size_t vertexCount)
+    {
+        unsigned int largest = 0;
+        for (size_t i = 0; i < indexCount; ++i)
+        {
+            largest = std::max(largest, indices[i]);
+        }
+        return indexCount % 3 == 0 && (indexCount == 0 || largest < vertexCount);
+    }
+
+    bool checksumFile(const std::string &path, uint64_t &checksum)
+    {
+        MappedFile source(path);
+        if (!source.isOpen())
+        {
+            return false;
+        }
+        checksum = meshCacheChecksum(source.data(), source.size());
+        return true;
+    }
+
+    /**
+     * @brief Whether the file still matches what was recorded. A touched but unchanged file does;
+     * only a different checksum tells it apart.
+     */
+    bool fileUnchanged(const std::string &path, uint64_t size, int64_t time, uint64_t checksum)
+    {
+        uint64_t currentSize;
+        int64_t currentTime;
+        if (!sourceInfo(path, currentSize, currentTime) || currentSize != size)
+        {
+            return false;
+        }
+        uint64_t currentChecksum;
+        return currentTime == time || (checksumFile(path, currentChecksum) && currentChecksum == checksum);
+    }
+
+    /**
+     * @brief Records an mtllib file for the cache, or marks it missing.
+     *
+     * @return false if the name does not fit.
+     */
+    bool describeLibrary(const std::string &objPath, const std::string &name, MeshCacheLibrary &out)
+    {
+        out = MeshCacheLibrary();
+        if (name.size() >= sizeof(out.name))
+        {
+            return false;
+        }
+        std::memcpy(out.name, name.c_str(), name.size() + 1);
+        const std::string path = libraryPath(objPath, name);
+        if (!sourceInfo(path, out.size, out.time) || !checksumFile(path, out.checksum))
+        {
+            out.size = UINT64_MAX;
+            out.time = 0;
+            out.checksum = 0;
+        }
+        return true;
+    }
+
+    bool libraryUnchanged(const std::string &objPath, const MeshCacheLibrary &library)
+    {
+        if (std::memchr(library.name, '\0', sizeof(library.name)) == nullptr)
+        {
+            return false;
+        }
+        const std::string path = libraryPath(objPath, library.name);
+        if (library.size == UINT64_MAX)
+        {
+            std::error_code error;
+            return !std::filesystem::exists(path, error);
+        }
+        return fileUnchanged(path, library.size, library.time, library.checksum);
+    }
+}
+
+uint64_t meshCacheChecksum(const void *data, size_t size)
+{
+    const unsigned char *bytes = static_cast<const unsigned char *>(data);
+    uint64_t lanes[4] = {0x9E3779B185EBCA87ull, 0xC2B2AE3D27D4EB4Full, 0x165667B19E3779F9ull, 0x85EBCA77C2B2AE63ull};
+
+    // Four independent lanes keep the multiplies pipelined over large inputs
+    size_t offset = 0;
+    for (; offset + 32 <= size; offset += 32)
+    {
+        for (int lane = 0; lane < 4; ++lane)
+        {
+            uint64_t word;
+            std::memcpy(&word, bytes + offset + lane * 8, sizeof(word));
+            lanes[lane] = mixLane(lanes[lane], word);
+        }
+    }
+
+    uint64_t hash = rotateLeft(lanes[0], 1) + rotateLeft(lanes[1], 7) + rotateLeft(lanes[2], 12) + rotateLeft(lanes[3], 18);
+    hash ^= size;
+    for (; offset < size; ++offset)
+    {
+        hash = (hash ^ bytes[offset]) * 0x100000001B3ull;
+    }
+
+    hash ^= hash >> 33;
+    hash *= 0xFF51AFD7ED558CCDull;
+    hash ^= hash >> 33;
+    return hash;
+}
+
+std::string meshCachePath(const std::string &objPath)
+{
+    return objPath + ".meshcache";
+}
+
+bool writeMeshCache(const std::string &cachePath, const std::string &sourcePath,
+                    const std::vector<Vertex> &vertices, const std::vector<unsigned int> &indices,
+                    const std::vector<MeshCacheMaterial> &materials, const std::vector<std::string> &materialLibraries,
+                    const std::vector<float> &lodRatios, const LodChain *lods)
+{
+    MeshCacheHeader header = {};
+    std::memcpy(header.magic, kMagic, sizeof(kMagic));
+    header.version = kMeshCacheVersion;
+    header.endianness = kEndianness;
+    if (!sourceInfo(sourcePath, header.sourceSize, header.sourceTime) || !checksumFile(sourcePath, header.sourceChecksum))
+    {
+        std::cerr << "Failed to read mesh cache source: " << sourcePath << std::endl;
+        return false;
+    }
+
+    std::vector<MeshCacheLibrary> libraries(materialLibraries.size());
+    for (size_t l = 0; l < libraries.size(); ++l)
+    {
+        if (!describeLibrary(sourcePath, materialLibraries[l], libraries[l]))
+        {
+            std::cerr << "Material library name too long for the mesh cache: " << materialLibraries[l] << std::endl;
+            return false;
+        }
+    }
+
+    std::vector<MeshCacheAttribute> layout = currentLayout();
+    header.vertexStride = sizeof(Vertex);
+    header.attributeCount = static_cast<uint32_t>(layout.size());
+    header.vertexCount = vertices.size();
+    header.indexCount = indices.size();
+    header.materialCount = materials.size();
+    header.attributeOffset = alignUp(sizeof(MeshCacheHeader));
+    header.vertexOffset = alignUp(header.attributeOffset + layout.size() * sizeof(MeshCacheAttribute));
+    header.indexOffset = alignUp(header.vertexOffset + vertices.size() * sizeof(Vertex));
+    header.materialOffset = alignUp(header.indexOffset + indices.size() * sizeof(unsigned int));
+
+    // The chain's indices start with level 0, which is the index blob itself
+    std::vector<MeshCacheLod> levels;
+    std::vector<MeshCacheRange> lodRanges;
+    const bool storeLods = lods && !lodRatios.empty() && lods->indices.size() >= indices.size();
+    if (storeLods)
+    {
+        for (const MeshLod &level : lods->levels)
+        {
+            levels.push_back({level.firstIndex, level.indexCount, level.error, 0});
+        }
+        for (const IndexRange &range : lods->ranges)
+        {
+            lodRanges.push_back({range.firstIndex, range.indexCount});
+        }
+        header.lodRatioCount = lodRatios.size();
+        header.lodCount = levels.size();
+        header.lodRangeCount = lodRanges.size();
+        header.lodIndexCount = lods->indices.size() - indices.size();
+        for (int c = 0; c < 3; ++c)
+        {
+            header.lodCenter[c] = lods->center[c];
+        }
+        header.lodRadius = lods->radius;
+    }
+    header.libraryCount = libraries.size();
+    header.libraryOffset = alignUp(header.materialOffset + materials.size() * sizeof(MeshCacheMaterial));
+    header.lodRatioOffset = alignUp(header.libraryOffset + libraries.size() * sizeof(MeshCacheLibrary));
+    header.lodOffset = alignUp(header.lodRatioOffset + header.lodRatioCount * sizeof(float));
+    header.lodRangeOffset = alignUp(header.lodOffset + levels.size() * sizeof(MeshCacheLod));
+    header.lodIndexOffset = alignUp(header.lodRangeOffset + lodRanges.size() * sizeof(MeshCacheRange));
+    const uint64_t totalSize = header.lodIndexOffset + header.lodIndexCount * sizeof(unsigned int);
+
+    // Assemble the payload in one buffer so it can be checksummed and written in a single call
+    std::vector<char> payload(static_cast<size_t>(totalSize - sizeof(MeshCacheHeader)), 0);
+    auto section = [&payload](uint64_t offset)
+    {
+        return payload.data() + (offset - sizeof(MeshCacheHeader));
+    };
+    std::memcpy(section(header.attributeOffset), layout.data(), layout.size() * sizeof(MeshCacheAttribute));
+    if (!vertices.empty())
+    {
+        std::memcpy(section(header.vertexOffset), vertices.data(), vertices.size() * sizeof(Vertex));
+    }
+    if (!indices.empty())
+    {
+        std::memcpy(section(header.indexOffset), indices.data(), indices.size() * sizeof(unsigned int));
+    }
+    if (!materials.empty())
+    {
+        std::memcpy(section(header.materialOffset), materials.data(), materials.size() * sizeof(MeshCacheMaterial));
+    }
+    if (!libraries.empty())
+    {
+        std::memcpy(section(header.libraryOffset), libraries.data(), libraries.size() * sizeof(MeshCacheLibrary));
+    }
+    if (storeLods)
+    {
+        std::memcpy(section(header.lodRatioOffset), lodRatios.data(), lodRatios.size() * sizeof(float));
+        std::memcpy(section(header.lodOffset), levels.data(), levels.size() * sizeof(MeshCacheLod));
+        std::memcpy(section(header.lodRangeOffset), lodRanges.data(), lodRanges.size() * sizeof(MeshCacheRange));
+        if (header.lodIndexCount > 0)
+        {
+            std::memcpy(section(header.lodIndexOffset), lods->indices.data() + indices.size(),
+                        static_cast<size_t>(header.lodIndexCount) * sizeof(unsigned int));
+        }
+    }
+    header.payloadChecksum = meshCacheChecksum(payload.data(), payload.size());
+
+    const std::string tempPath = cachePath + ".tmp";
+    {
+        std::ofstream file(tempPath, std::ios::binary | std::ios::trunc);
+        if (!file.is_open())
+        {
+            std::cerr << "Failed to write mesh cache: " << cachePath << std::endl;
+            return false;
+        }
+        file.write(reinterpret_cast<const char *>(&header), sizeof(header));
+        file.write(payload.data(), static_cast<std::streamsize>(payload.size()));
+        if (!file)
+        {
+            std::cerr << "Failed to write mesh cache: " << cachePath << std::endl;
+            file.close();
+            std::remove(tempPath.c_str());
+            return false;
+        }
+    }
+
+    std::error_code error;
+    std::filesystem::rename(tempPath, cachePath, error);
+    if (error)
+    {
+        std::cerr << "Failed to write mesh cache: " << cachePath << " (" << error.message() << ")" << std::endl;
+        std::remove(tempPath.c_str());
+        return false;
+    }
+    return true;
+}
+
+bool MeshCache::open(const std::string &cachePath, const std::string &sourcePath)
+{
+    if (!file.open(cachePath) || file.size() < sizeof(MeshCacheHeader))
+    {
+        file.close();
+        return false;
+    }
+
+    const MeshCacheHeader &h = header();
+    bool valid = std::memcmp(h.magic, kMagic, sizeof(kMagic)) == 0 &&
+                 h.version == kMeshCacheVersion &&
+                 h.endianness == kEndianness &&
+                 h.vertexStride == sizeof(Vertex);
+
+    // Every section has to lie inside the file
+    const uint64_t size = file.size();
+    valid = valid &&
+            sectionFits(h.attributeOffset, h.attributeCount, sizeof(MeshCacheAttribute), size) &&
+            sectionFits(h.vertexOffset, h.vertexCount, sizeof(Vertex), size) &&
+            sectionFits(h.indexOffset, h.indexCount, sizeof(unsigned int), size) &&
+            sectionFits(h.materialOffset, h.materialCount, sizeof(MeshCacheMaterial), size) &&
+            sectionFits(h.libraryOffset, h.libraryCount, sizeof(MeshCacheLibrary), size) &&
+            sectionFits(h.lodRatioOffset, h.lodRatioCount, sizeof(float), size) &&
+            sectionFits(h.lodOffset, h.lodCount, sizeof(MeshCacheLod), size) &&
+            sectionFits(h.lodRangeOffset, h.lodRangeCount, sizeof(MeshCacheRange), size) &&
+            sectionFits(h.lodIndexOffset, h.lodIndexCount, sizeof(unsigned int), size);
+
+    std::vector<MeshCacheAttribute> layout = currentLayout();
+    valid = valid && h.attributeCount == layout.size() &&
+            std::memcmp(attributes(), layout.data(), layout.size() * sizeof(MeshCacheAttribute)) == 0;
+
+    // The material colours come from the MTL files, so they are sources as much as the OBJ
+    valid = valid && fileUnchanged(sourcePath, h.sourceSize, h.sourceTime, h.sourceChecksum);
+    const MeshCacheLibrary *libraries = section<MeshCacheLibrary>(h.libraryOffset);
+    for (uint64_t l = 0; valid && l < h.libraryCount; ++l)
+    {
+        valid = libraryUnchanged(sourcePath, libraries[l]);
+    }
+
+    // A cache that matches its source can still be truncated or damaged on disk; out-of-range
+    // indices would reach every later pass and the GPU, so it has to check out byte for byte
+    if (valid)
+    {
+        const bool intact = meshCacheChecksum(file.data() + sizeof(MeshCacheHeader), size - sizeof(MeshCacheHeader)) == h.payloadChecksum &&
+                            indicesInRange(indices(), indexCount(), vertexCount()) &&
+                            (h.materialCount == 0 || coversInOrder(materials(), materialCount(), 0, h.indexCount)) &&
+                            lodChainInRange();
+        if (!intact)
+        {
+            std::cerr << "Mesh cache is corrupt, rebuilding it: " << cachePath << std::endl;
+        }
+        valid = intact;
+    }
+
+    if (!valid)
+    {
+        file.close();
+    }
+    return valid;
+}
+
+const MeshCacheAttribute *MeshCache::attributes() const
+{
+    return reinterpret_cast<const MeshCacheAttribute *>(file.data() + header().attributeOffset);
+}
+
+const Vertex *MeshCache::vertices() const
+{
+    return reinterpret_cast<const Vertex *>(file.data() + header().vertexOffset);
+}
+
+const unsigned int *MeshCache::indices() const
+{
+    return reinterpret_cast<const unsigned int *>(file.data() + header().indexOffset);
+}
+
+const MeshCacheMaterial *MeshCache::materials() const
+{
+    return reinterpret_cast<const MeshCacheMaterial *>(file.data() + header().materialOffset);
+}
+
+const unsigned int *MeshCache::lodIndices() const
+{
+    return section<unsigned int>(header().lodIndexOffset);
+}
+
+std::vector<std::string> MeshCache::materialLibraries() const
+{
+    const MeshCacheLibrary *libraries = section<MeshCacheLibrary>(header().libraryOffset);
+    std::vector<std::string> names;
+    for (uint64_t l = 0; l < header().libraryCount; ++l)
+    {
+        names.push_back(libraries[l].name);
+    }
+    return names;
+}
+
+bool MeshCache::lodChainInRange() const
+{
+    const MeshCacheHeader &h = header();
+    if (h.lodRatioCount == 0)
+    {
+        return h.lodCount == 0 && h.lodRangeCount == 0 && h.lodIndexCount == 0;
+    }
+
+    // Level 0 is the index blob, and every level is split the way the materials split it
+    const uint64_t rangesPerLevel = std::max<uint64_t>(h.materialCount, 1);
+    const MeshCacheLod *levels = section<MeshCacheLod>(h.lodOffset);
+    const MeshCacheRange *ranges = section<MeshCacheRange>(h.lodRangeOffset);
+    if (h.lodCount == 0 || h.lodRangeCount != h.lodCount * rangesPerLevel || levels[0].firstIndex != 0 ||
+        levels[0].indexCount != h.indexCount)
+    {
+        return false;
+    }
+    const uint64_t chainIndices = h.indexCount + h.lodIndexCount;
+    for (uint64_t l = 0; l < h.lodCount; ++l)
+    {
+        if (levels[l].firstIndex > chainIndices || levels[l].indexCount > chainIndices - levels[l].firstIndex ||
+            !coversInOrder(ranges + l * rangesPerLevel, static_cast<size_t>(rangesPerLevel), levels[l].firstIndex, levels[l].indexCount))
+        {
+            return false;
+        }
+    }
+    return indicesInRange(section<unsigned int>(h.lodIndexOffset), static_cast<size_t>(h.lodIndexCount), vertexCount());
+}
+
+bool MeshCache::hasLodChain(const std::vector<float> &ratios) const
+{
+    const MeshCacheHeader &h = header();
+    return !ratios.empty() && h.lodRatioCount == ratios.size() &&
+           std::memcmp(section<float>(h.lodRatioOffset), ratios.data(), ratios.size() * sizeof(float)) == 0;
+}
+
+void MeshCache::readLodChain(LodChain &out) const
+{
+    const MeshCacheHeader &h = header();
+    out.indices.clear();
+    const MeshCacheLod *levels = section<MeshCacheLod>(h.lodOffset);
+    out.levels.clear();
+    for (uint64_t l = 0; l < h.lodCount; ++l)
+    {
+        out.levels.push_back({static_cast<size_t>(levels[l].firstIndex), static_cast<size_t>(levels[l].indexCount), levels[l].error});
+    }
+    const MeshCacheRange *ranges = section<MeshCacheRange>(h.lodRangeOffset);
+    out.ranges.clear();
+    for (uint64_t r = 0; r < h.lodRangeCount; ++r)
+    {
+        out.ranges.push_back({static_cast<size_t>(ranges[r].firstIndex), static_cast<size_t>(ranges[r].indexCount)});
+    }
+    out.rangesPerLevel = static_cast<size_t>(h.lodRangeCount / h.lodCount);
+    out.center = glm::vec3(h.lodCenter[0], h.lodCenter[1], h.lodCenter[2]);
+    out.radius = h.lodRadius;
+    out.seconds = 0.0;
+}
+
+bool loadMeshWithCache(const std::string &objPath, CachedMesh &out, unsigned int threadCount, const std::vector<float> &lodRatios)
+{
+    PROFILE_FUNCTION();
+    const std::string cachePath = meshCachePath(objPath);
+    const bool cached = out.cache.open(cachePath, objPath);
+    if (cached && (lodRatios.empty() || out.cache.hasLodChain(lodRatios)))
+    {
+        out.vertexData = out.cache.vertices();
+        out.vertexCount = out.cache.vertexCount();
+        out.indexData = out.cache.indices();
+        out.indexCount = out.cache.indexCount();
+        out.materialData = out.cache.materials();
+        out.materialCount = out.cache.materialCount();
+        if (!lodRatios.empty())
+        {
+            out.lodIndexData = out.cache.lodIndices();
+            out.lodIndexCount = out.cache.lodIndexCount();
+            out.cache.readLodChain(out.lods);
+        }
+        out.fromCache = true;
+        return true;
+    }
+
+    std::vector<std::string> libraries;
+    if (cached)
+    {
+        // The mesh is good, only the LOD chain is missing or was built for other ratios. The
+        // mapping has to go before the rewritten cache can replace the file.
+        out.vertices.assign(out.cache.vertices(), out.cache.vertices() + out.cache.vertexCount());
+        out.indices.assign(out.cache.indices(), out.cache.indices() + out.cache.indexCount());
+        out.materials.assign(out.cache.materials(), out.cache.materials() + out.cache.materialCount());
+        libraries = out.cache.materialLibraries();
+        out.cache.close();
+    }
+    else
+    {
+        // Welding keeps the corner order, so grouping the corners groups the indices
+        ObjData data;
+        if (!loadOBJData(objPath, data, threadCount))
+        {
+            return false;
+        }
+        groupOBJByMaterial(data);
+        WeldStats stats;
+        weldOBJ(data, out.vertices, out.indices, &stats);
+        printWeldStats(objPath, stats);
+        out.materials = buildMaterials(objPath, data);
+        libraries.swap(data.materialLibraries);
+        data = ObjData();
+
+        // Optimize once here so the cache, and every later startup, gets the reordered mesh
+        const std::vector<IndexRange> ranges = materialRanges(out.materials.data(), out.materials.size());
+        MeshOptimizeStats optimizeStats;
+        optimizeMesh(out.vertices, out.indices, &optimizeStats, &ranges);
+        printMeshOptimizeStats(objPath, optimizeStats);
+    }
+
+    if (!lodRatios.empty())
+    {
+        const std::vector<IndexRange> ranges = materialRanges(out.materials.data(), out.materials.size());
+        buildLodChain(out.vertices.data(), out.vertices.size(), out.indices.data(), out.indices.size(), lodRatios, out.lods,
+                      SimplifyOptions(), &ranges);
+    }
+
+    // A cache that cannot be written only costs the next startup, so it is not an error
+    writeMeshCache(cachePath, objPath, out.vertices, out.indices, out.materials, libraries, lodRatios, &out.lods);
+
+    out.vertexData = out.vertices.data();
+    out.vertexCount = out.vertices.size();
+    out.indexData = out.indices.data();
+    out.indexCount = out.indices.size();
+    out.materialData = out.materials.data();
+    out.materialCount = out.materials.size();
+    if (out.lods.indices.size() > out.indices.size())
+    {
+        out.lodIndexData = out.lods.indices.data() + out.indices.size();
+        out.lodIndexCount = out.lods.indices.size() - out.indices.size();
+    }
+    out.fromCache = false;
+    return true;
+}
+
+std::vector<IndexRange> materialRanges(const MeshCacheMaterial *materials, size_t count)
+{
+    std::vector<IndexRange> ranges;
+    for (size_t m = 0; m < count; ++m)
+    {
+        ranges.push_back({materials[m].firstIndex, materials[m].indexCount});
+    }
+    return ranges;
+}
+
+void printMeshMaterials(const std::string &name, const MeshCacheMaterial *materials, size_t count)
+{
+    std::cout << name << ": " << count << " materials";
+    for (size_t m = 0; m < count; ++m)
+    {
+        std::cout << (m == 0 ? ", " : "; ") << materials[m].name << " " << materials[m].indexCount / 3 << " faces";
+    }
+    std::cout << std::endl;
+}
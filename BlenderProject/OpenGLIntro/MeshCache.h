@@ -0,0 +1,237 @@
+#pragma once
+
+#include "MappedFile.h"
+#include "Mesh.h"
+#include "MeshSimplifier.h"
+
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include <vector>
+
+/*
+ * Binary mesh cache (.meshcache), written next to the source OBJ.
+ *
+ * Layout, every section starting on a 64-byte boundary:
+ *   MeshCacheHeader
+ *   MeshCacheAttribute[attributeCount]   vertex layout descriptor
+ *   vertex blob                          vertexCount * vertexStride bytes, ready for glBufferData
+ *   index blob                           indexCount * 4 bytes (GL_UNSIGNED_INT)
+ *   MeshCacheMaterial[materialCount]     material table
+ *   MeshCacheLibrary[libraryCount]       the mtllib files the materials were read from
+ *   float[lodRatioCount]                 triangle ratios the LOD chain was built for
+ *   MeshCacheLod[lodCount]               LOD levels, level 0 being the index blob
+ *   MeshCacheRange[lodRangeCount]        each level split by material, lodCount * max(materialCount, 1)
+ *   LOD index blob                       lodIndexCount * 4 bytes, the levels after level 0
+ *
+ * The header records the size, modification time and checksum of the source OBJ, and the library
+ * table does the same for every MTL file it names. A cache whose sizes differ from the files is
+ * stale; one whose times differ is only stale if a checksum no longer matches. A library that
+ * was missing when the cache was written makes it stale once it exists. Any change to the file
+ * version or to the Vertex layout also invalidates it.
+ *
+ * Each material covers one contiguous range of the index blob, the faces that use it. The LOD
+ * sections are optional: a cache written without LOD ratios has none, and one built for other
+ * ratios still serves the mesh while the chain is rebuilt.
+ */
+
+constexpr uint32_t kMeshCacheVersion = 6;
+
+struct MeshCacheHeader
+{
+    char magic[8];       // "MESHCACH"
+    uint32_t version;    // kMeshCacheVersion
+    uint32_t endianness; // 0x01020304 as written by the producing machine
+    uint64_t sourceSize;
+    int64_t sourceTime;
+    uint64_t sourceChecksum;
+    uint32_t vertexStride;
+    uint32_t attributeCount;
+    uint64_t vertexCount;
+    uint64_t indexCount;
+    uint64_t materialCount;
+    uint64_t attributeOffset;
+    uint64_t vertexOffset;
+    uint64_t indexOffset;
+    uint64_t materialOffset;
+    uint64_t libraryCount;
+    uint64_t libraryOffset;
+    uint64_t lodRatioCount; // 0 when the cache holds no LOD chain
+    uint64_t lodCount;
+    uint64_t lodRangeCount;
+    uint64_t lodIndexCount;
+    uint64_t lodRatioOffset;
+    uint64_t lodOffset;
+    uint64_t lodRangeOffset;
+    uint64_t lodIndexOffset;
+    float lodCenter[3];
+    float lodRadius;
+    uint64_t payloadChecksum; // Over everything after the header
+};
+
+struct MeshCacheAttribute
+{
+    uint32_t location;   // Shader attribute location
+    uint32_t components; // 1-4
+    uint32_t type;       // GL type enum, e.g. GL_FLOAT
+    uint32_t normalized;
+    uint32_t offset; // Byte offset inside the vertex
+    uint32_t reserved;
+};
+
+struct MeshCacheMaterial
+{
+    char name[64];
+    float diffuse[3];
+    float specular[3];
+    float shininess;
+    uint32_t firstIndex;
+    uint32_t indexCount;
+    uint32_t reserved;
+};
+
+struct MeshCacheLibrary
+{
+    char name[256]; // As written after mtllib, relative to the OBJ's directory
+    uint64_t size;  // UINT64_MAX when the file did not exist
+    int64_t time;
+    uint64_t checksum;
+};
+
+struct MeshCacheLod
+{
+    uint64_t firstIndex; // Into the index blob followed by the LOD index blob
+    uint64_t indexCount;
+    float error;
+    uint32_t reserved;
+};
+
+struct MeshCacheRange
+{
+    uint64_t firstIndex;
+    uint64_t indexCount;
+};
+
+/**
+ * @brief Checksum used for the source file and the cache payload (64-bit, four mixing lanes).
+ */
+uint64_t meshCacheChecksum(const void *data, size_t size);
+
+/**
+ * @brief Path of the cache file that belongs to an OBJ file.
+ */
+std::string meshCachePath(const std::string &objPath);
+
+/**
+ * @brief Writes a cache for the given mesh. The file is written under a temporary name and
+ * renamed into place, so a crash never leaves a half-written cache behind.
+ *
+ * @param materialLibraries The mtllib names the materials came from, tracked like the source.
+ * @param lodRatios The ratios lods was built with; lods is ignored when this is empty.
+ * @param lods Optional LOD chain over indices, stored so later startups need not simplify.
+ * @return true if the cache was written.
+ */
+bool writeMeshCache(const std::string &cachePath, const std::string &sourcePath,
+                    const std::vector<Vertex> &vertices, const std::vector<unsigned int> &indices,
+                    const std::vector<MeshCacheMaterial> &materials = std::vector<MeshCacheMaterial>(),
+                    const std::vector<std::string> &materialLibraries = std::vector<std::string>(),
+                    const std::vector<float> &lodRatios = std::vector<float>(), const LodChain *lods = nullptr);
+
+/**
+ * @brief A validated, memory-mapped mesh cache. The vertex and index pointers point straight
+ * into the mapped pages and stay valid while the object lives.
+ */
+class MeshCache
+{
+public:
+    /**
+     * @brief Maps the cache and checks it against the current source file and Vertex layout,
+     * then verifies the payload checksum, that every index names a vertex and that the material
+     * ranges cover the index blob in order.
+     *
+     * @return false if the cache is missing, malformed, stale or corrupt.
+     */
+    bool open(const std::string &cachePath, const std::string &sourcePath);
+
+    void close() { file.close(); }
+
+    /**
+     * @brief Whether the cache holds a LOD chain built for exactly these ratios.
+     */
+    bool hasLodChain(const std::vector<float> &ratios) const;
+
+    /**
+     * @brief Copies the level and range tables of the stored LOD chain out. out.indices is left
+     * empty: the levels index the index blob followed by lodIndices(), which stay mapped.
+     */
+    void readLodChain(LodChain &out) const;
+
+    const MeshCacheHeader &header() const { return *reinterpret_cast<const MeshCacheHeader *>(file.data()); }
+    const MeshCacheAttribute *attributes() const;
+    const Vertex *vertices() const;
+    const unsigned int *indices() const;
+    const MeshCacheMaterial *materials() const;
+    const unsigned int *lodIndices() const;
+    size_t vertexCount() const { return static_cast<size_t>(header().vertexCount); }
+    size_t indexCount() const { return static_cast<size_t>(header().indexCount); }
+    size_t materialCount() const { return static_cast<size_t>(header().materialCount); }
+    size_t lodIndexCount() const { return static_cast<size_t>(header().lodIndexCount); }
+    std::vector<std::string> materialLibraries() const;
+
+private:
+    bool lodChainInRange() const;
+
+    template <typename T>
+    const T *section(uint64_t offset) const { return reinterpret_cast<const T *>(file.data() + offset); }
+
+    MappedFile file;
+};
+
+/**
+ * @brief A mesh that came either from the cache (mapped) or from parsing the OBJ (vectors).
+ */
+struct CachedMesh
+{
+    MeshCache cache;
+    std::vector<Vertex> vertices;
+    std::vector<unsigned int> indices;
+    std::vector<MeshCacheMaterial> materials;
+
+    const Vertex *vertexData = nullptr;
+    size_t vertexCount = 0;
+    const unsigned int *indexData = nullptr;
+    size_t indexCount = 0;
+    const MeshCacheMaterial *materialData = nullptr;
+    size_t materialCount = 0; // 0 when the OBJ has no usemtl
+    // The LOD levels after level 0, which the level offsets place right after indexData
+    const unsigned int *lodIndexData = nullptr;
+    size_t lodIndexCount = 0;
+    LodChain lods; // Empty unless loadMeshWithCache was given LOD ratios; no indices when from the cache
+    bool fromCache = false;
+};
+
+/**
+ * @brief The index range of every material, in material order.
+ */
+std::vector<IndexRange> materialRanges(const MeshCacheMaterial *materials, size_t count);
+
+/**
+ * @brief Prints the faces of every material for the named mesh on one line.
+ */
+void printMeshMaterials(const std::string &name, const MeshCacheMaterial *materials, size_t count);
+
+/**
+ * @brief Loads the mesh from its cache when it is valid, otherwise parses, welds and optimizes
+ * the OBJ and writes a fresh cache for next time. Faces are grouped by material, with the
+ * parameters read from the OBJ's mtllib files, and optimized within their material.
+ *
+ * @param objPath The OBJ file.
+ * @param out Receives the mesh; vertexData/indexData/lodIndexData point into whichever storage
+ * was used.
+ * @param threadCount Number of threads to parse with; 0 uses every hardware thread.
+ * @param lodRatios When not empty, out.lods receives a LOD chain per material for these ratios,
+ * from the cache if it holds one and otherwise built and written back to it.
+ * @return true if the mesh could be loaded one way or the other.
+ */
+bool loadMeshWithCache(const std::string &objPath, CachedMesh &out, unsigned int threadCount = 0,
+                       const std::vector<float> &lodRatios = std::vector<float>());
@@ -0,0 +1,145 @@
+#include "MeshIndexer.h"
+
+#include <cstdint>
+#include <iostream>
+
+namespace
+{
+    const unsigned int kEmptySlot = 0xffffffffu;
+
+    inline uint32_t hashCorner(const ObjCorner &corner)
+    {
+        uint64_t h = corner.position * 0x9E3779B97F4A7C15ull;
+        h ^= (corner.texCoord + 0x632BE59BD9B4E019ull) * 0xC2B2AE3D27D4EB4Full;
+        h ^= (corner.normal + 0x8CB92BA72F3D8DD7ull) * 0x165667B19E3779F9ull;
+        h ^= h >> 29;
+        return static_cast<uint32_t>(h ^ (h >> 32));
+    }
+
+    inline bool sameCorner(const ObjCorner &a, const ObjCorner &b)
+    {
+        return a.position == b.position && a.texCoord == b.texCoord && a.normal == b.normal;
+    }
+
+    size_t nextPowerOfTwo(size_t value)
+    {
+        size_t result = 16;
+        while (result < value)
+        {
+            result <<= 1;
+        }
+        return result;
+    }
+
+    /**
+     * @brief Linear-probing table from corner triple to unique vertex id. Slots hold ids into
+     * the list of unique corners, so the table itself stays at four bytes per slot.
+     */
+    class CornerTable
+    {
+    public:
+        explicit CornerTable(size_t expected) : slots(nextPowerOfTwo(expected * 2), kEmptySlot) {}
+
+        /**
+         * @brief Returns the id of the corner, adding it to uniqueCorners if it is new.
+         */
+        unsigned int findOrInsert(const ObjCorner &corner, std::vector<ObjCorner> &uniqueCorners)
+        {
+            if ((uniqueCorners.size() + 1) * 2 > slots.size())
+            {
+                grow(uniqueCorners);
+            }
+
+            size_t mask = slots.size() - 1;
+            size_t slot = hashCorner(corner) & mask;
+            while (slots[slot] != kEmptySlot)
+            {
+                if (sameCorner(uniqueCorners[slots[slot]], corner))
+                {
+                    return slots[slot];
+                }
+                slot = (slot + 1) & mask;
+            }
+
+            unsigned int id = static_cast<unsigned int>(uniqueCorners.size());
+            slots[slot] = id;
+            uniqueCorners.push_back(corner);
+            return id;
+        }
+
+    private:
+        void grow(const std::vector<ObjCorner> &uniqueCorners)
+        {
+            slots.assign(slots.size() * 2, kEmptySlot);
+            size_t mask = slots.size() - 1;
+            for (unsigned int id = 0; id < uniqueCorners.size(); ++id)
+            {
+                size_t slot = hashCorner(uniqueCorners[id]) & mask;
+                while (slots[slot] != kEmptySlot)
+                {
+                    slot = (slot + 1) & mask;
+                }
+                slots[slot] = id;
+            }
+        }
+
+        std::vector<unsigned int> slots;
+    };
+}
+
+void weldOBJ(const ObjData &data, std::vector<Vertex> &outVertices, std::vector<unsigned int> &outIndices,
+             WeldStats *stats)
+{
+    const size_t firstVertex = outVertices.size();
+    const size_t firstIndex = outIndices.size();
+    outIndices.resize(firstIndex + data.corners.size());
+
+    // Exported meshes share each vertex between roughly six corners, so size for a quarter of them
+    std::vector<ObjCorner> uniqueCorners;
+    uniqueCorners.reserve(data.corners.size() / 4);
+    CornerTable table(data.corners.size() / 4);
+
+    unsigned int *indices = outIndices.data() + firstIndex;
+    for (size_t c = 0; c < data.corners.size(); ++c)
+    {
+        indices[c] = static_cast<unsigned int>(firstVertex + table.findOrInsert(data.corners[c], uniqueCorners));
+    }
+
+    outVertices.resize(firstVertex + uniqueCorners.size());
+    Vertex *vertices = outVertices.data() + firstVertex;
+    for (size_t v = 0; v < uniqueCorners.size(); ++v)
+    {
+        const ObjCorner &corner = uniqueCorners[v];
+        vertices[v].Position = data.positions[corner.position];
+        vertices[v].Normal = corner.normal != kObjNoIndex ? data.normals[corner.normal] : glm::vec3(0.0f);
+    }
+
+    if (stats)
+    {
+        stats->inputVertices = data.corners.size();
+        stats->uniqueVertices = uniqueCorners.size();
+        stats->indexCount = data.corners.size();
+        stats->inputBytes = data.corners.size() * (sizeof(Vertex) + sizeof(unsigned int));
+        stats->outputBytes = uniqueCorners.size() * sizeof(Vertex) + data.corners.size() * sizeof(unsigned int);
+    }
+}
+
+bool loadOBJIndexed(const std::string &path, std::vector<Vertex> &outVertices, std::vector<unsigned int> &outIndices,
+                    WeldStats *stats, unsigned int threadCount)
+{
+    ObjData data;
+    if (!loadOBJData(path, data, threadCount))
+    {
+        return false;
+    }
+    weldOBJ(data, outVertices, outIndices, stats);
+    return true;
+}
+
+void printWeldStats(const std::string &name, const WeldStats &stats)
+{
+    std::cout << name << ": " << stats.inputVertices << " corners -> " << stats.uniqueVertices
+              << " unique vertices (" << stats.reductionRatio() << "x), "
+              << stats.inputBytes / 1024 << " KB -> " << stats.outputBytes / 1024 << " KB, saved "
+              << stats.bytesSaved() / 1024 << " KB\n";
+}
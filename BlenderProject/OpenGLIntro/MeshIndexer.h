@@ -0,0 +1,62 @@
+#pragma once
+
+#include "Mesh.h"
+#include "ObjParser.h"
+
+#include <cstddef>
+#include <string>
+#include <vector>
+
+/**
+ * @brief Before/after numbers from welding a mesh's face corners into unique vertices.
+ */
+struct WeldStats
+{
+    size_t inputVertices = 0;  // One per face corner, what loadOBJ produces
+    size_t uniqueVertices = 0; // Distinct (position, texcoord, normal) index triples
+    size_t indexCount = 0;
+    size_t inputBytes = 0;  // Vertex plus index buffer size without welding
+    size_t outputBytes = 0; // Vertex plus index buffer size after welding
+
+    double reductionRatio() const
+    {
+        return uniqueVertices ? static_cast<double>(inputVertices) / uniqueVertices : 0.0;
+    }
+
+    size_t bytesSaved() const
+    {
+        return inputBytes - outputBytes;
+    }
+};
+
+/**
+ * @brief Welds face corners that share the same (position, texcoord, normal) index triple.
+ *
+ * Uses an open-addressing hash table keyed on the triple. Unique vertices are emitted in the
+ * order they are first referenced, so the output is deterministic.
+ *
+ * @param data Parsed OBJ data.
+ * @param outVertices Unique vertices are appended here.
+ * @param outIndices Three indices per triangle are appended here.
+ * @param stats Optional, receives the reduction numbers.
+ */
+void weldOBJ(const ObjData &data, std::vector<Vertex> &outVertices, std::vector<unsigned int> &outIndices,
+             WeldStats *stats = nullptr);
+
+/**
+ * @brief Loads an OBJ file as an indexed mesh: loadOBJData followed by weldOBJ.
+ *
+ * @param path The OBJ file to load.
+ * @param outVertices Receives the unique vertices.
+ * @param outIndices Receives the triangle indices.
+ * @param stats Optional, receives the reduction numbers.
+ * @param threadCount Number of threads to parse with; 0 uses every hardware thread.
+ * @return true if the file was opened and parsed without errors.
+ */
+bool loadOBJIndexed(const std::string &path, std::vector<Vertex> &outVertices, std::vector<unsigned int> &outIndices,
+                    WeldStats *stats = nullptr, unsigned int threadCount = 1);
+
+/**
+ * @brief Prints one line summarizing the weld results for the named mesh to stdout.
+ */
+void printWeldStats(const std::string &name, const WeldStats &stats);
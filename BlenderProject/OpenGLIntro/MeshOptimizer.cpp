@@ -0,0 +1,325 @@
+#include "MeshOptimizer.h"
+
+#include <algorithm>
+#include <chrono>
+#include <iostream>
+
+namespace
+{
+    const unsigned int kUnused = 0xffffffffu;
+
+    /**
+     * @brief Vertex to triangle adjacency in compressed rows: the triangles using vertex v are
+     * triangles[offsets[v]] .. triangles[offsets[v + 1] - 1].
+     */
+    struct TriangleAdjacency
+    {
+        std::vector<unsigned int> offsets;
+        std::vector<unsigned int> triangles;
+
+        TriangleAdjacency(const std::vector<unsigned int> &indices, size_t vertexCount)
+            : offsets(vertexCount + 1, 0), triangles(indices.size())
+        {
+            for (unsigned int index : indices)
+            {
+                ++offsets[index + 1];
+            }
+            for (size_t v = 0; v < vertexCount; ++v)
+            {
+                offsets[v + 1] += offsets[v];
+            }
+
+            std::vector<unsigned int> fill(offsets.begin(), offsets.end() - 1);
+            for (size_t i = 0; i < indices.size(); ++i)
+            {
+                triangles[fill[indices[i]]++] = static_cast<unsigned int>(i / 3);
+            }
+        }
+
+        unsigned int count(unsigned int vertex) const
+        {
+            return offsets[vertex + 1] - offsets[vertex];
+        }
+    };
+
+    /**
+     * @brief Tipsify's choice of the next fanning vertex: the candidate still in the cache that
+     * entered it earliest and will not be evicted while its remaining triangles are emitted.
+     * Falls back to the dead-end stack and then to a scan over the input order.
+     */
+    long long nextFanningVertex(const std::vector<unsigned int> &candidates, const std::vector<unsigned int> &liveTriangles,
+                                const std::vector<long long> &cacheTime, long long timestamp, unsigned int cacheSize,
+                                std::vector<unsigned int> &deadEnds, size_t &cursor, bool &fromDeadEnd)
+    {
+        long long best = -1;
+        long long bestPriority = -1;
+        for (unsigned int v : candidates)
+        {
+            if (liveTriangles[v] == 0)
+            {
+                continue;
+            }
+            long long priority = 0;
+            if (timestamp - cacheTime[v] + 2 * static_cast<long long>(liveTriangles[v]) <= cacheSize)
+            {
+                priority = timestamp - cacheTime[v];
+            }
+            if (priority > bestPriority)
+            {
+                bestPriority = priority;
+                best = v;
+            }
+        }
+        if (best >= 0)
+        {
+            fromDeadEnd = false;
+            return best;
+        }
+
+        fromDeadEnd = true;
+        while (!deadEnds.empty())
+        {
+            unsigned int v = deadEnds.back();
+            deadEnds.pop_back();
+            if (liveTriangles[v] > 0)
+            {
+                return v;
+            }
+        }
+        while (cursor < liveTriangles.size())
+        {
+            if (liveTriangles[cursor] > 0)
+            {
+                return static_cast<long long>(cursor);
+            }
+            ++cursor;
+        }
+        return -1;
+    }
+}
+
+VertexCacheStats analyzeVertexCache(const std::vector<unsigned int> &indices, size_t vertexCount, unsigned int cacheSize)
+{
+    VertexCacheStats stats;
+    stats.triangles = indices.size() / 3;
+
+    // FIFO cache: a vertex is resident if fewer than cacheSize misses happened since it was loaded
+    std::vector<size_t> loadedAt(vertexCount, 0);
+    std::vector<bool> seen(vertexCount, false);
+    size_t misses = 0;
+    for (unsigned int index : indices)
+    {
+        if (!seen[index])
+        {
+            seen[index] = true;
+            ++stats.uniqueVertices;
+        }
+        else if (misses - loadedAt[index] < cacheSize)
+        {
+            continue;
+        }
+        loadedAt[index] = ++misses;
+    }
+    stats.transformedVertices = misses;
+    return stats;
+}
+
+void optimizeVertexCache(std::vector<unsigned int> &indices, size_t vertexCount, unsigned int cacheSize,
+                         std::vector<size_t> *clusterStarts)
+{
+    const size_t triangleCount = indices.size() / 3;
+    if (triangleCount == 0)
+    {
+        return;
+    }
+
+    TriangleAdjacency adjacency(indices, vertexCount);
+    std::vector<unsigned int> liveTriangles(vertexCount);
+    for (size_t v = 0; v < vertexCount; ++v)
+    {
+        liveTriangles[v] = adjacency.count(static_cast<unsigned int>(v));
+    }
+
+    std::vector<long long> cacheTime(vertexCount, 0);
+    std::vector<bool> emitted(triangleCount, false);
+    std::vector<unsigned int> deadEnds;
+    std::vector<unsigned int> candidates;
+    std::vector<unsigned int> output;
+    output.reserve(indices.size());
+    if (clusterStarts)
+    {
+        clusterStarts->clear();
+        clusterStarts->push_back(0);
+    }
+
+    long long timestamp = cacheSize + 1;
+    size_t cursor = 0;
+    long long fanning = indices[0];
+    while (fanning >= 0)
+    {
+        candidates.clear();
+        const unsigned int f = static_cast<unsigned int>(fanning);
+        for (unsigned int a = adjacency.offsets[f]; a < adjacency.offsets[f + 1]; ++a)
+        {
+            const unsigned int triangle = adjacency.triangles[a];
+            if (emitted[triangle])
+            {
+                continue;
+            }
+            emitted[triangle] = true;
+            for (int corner = 0; corner < 3; ++corner)
+            {
+                const unsigned int v = indices[triangle * 3 + corner];
+                output.push_back(v);
+                deadEnds.push_back(v);
+                candidates.push_back(v);
+                --liveTriangles[v];
+                if (timestamp - cacheTime[v] > cacheSize)
+                {
+                    cacheTime[v] = timestamp++;
+                }
+            }
+        }
+
+        bool fromDeadEnd;
+        fanning = nextFanningVertex(candidates, liveTriangles, cacheTime, timestamp, cacheSize, deadEnds, cursor, fromDeadEnd);
+        if (clusterStarts && fromDeadEnd && fanning >= 0 && output.size() / 3 != clusterStarts->back())
+        {
+            clusterStarts->push_back(output.size() / 3);
+        }
+    }
+
+    indices.swap(output);
+}
+
+void optimizeOverdraw(std::vector<unsigned int> &indices, const std::vector<Vertex> &vertices,
+                      const std::vector<size_t> &clusterStarts)
+{
+    const size_t triangleCount = indices.size() / 3;
+    if (clusterStarts.size() < 2 || triangleCount == 0)
+    {
+        return;
+    }
+
+    glm::vec3 meshCenter(0.0f);
+    for (const Vertex &vertex : vertices)
+    {
+        meshCenter += vertex.Position;
+    }
+    meshCenter /= static_cast<float>(std::max<size_t>(1, vertices.size()));
+
+    // Sort key per cluster: how far its area-weighted normal points away from the mesh center
+    struct Cluster
+    {
+        size_t begin;
+        size_t end;
+        float sortKey;
+    };
+    std::vector<Cluster> clusters;
+    clusters.reserve(clusterStarts.size());
+    for (size_t i = 0; i < clusterStarts.size(); ++i)
+    {
+        Cluster cluster = {clusterStarts[i], i + 1 < clusterStarts.size() ? clusterStarts[i + 1] : triangleCount, 0.0f};
+        glm::vec3 centroid(0.0f), normal(0.0f);
+        float area = 0.0f;
+        for (size_t t = cluster.begin; t < cluster.end; ++t)
+        {
+            const glm::vec3 &a = vertices[indices[t * 3 + 0]].Position;
+            const glm::vec3 &b = vertices[indices[t * 3 + 1]].Position;
+            const glm::vec3 &c = vertices[indices[t * 3 + 2]].Position;
+            glm::vec3 n = glm::cross(b - a, c - a);
+            float triangleArea = glm::length(n);
+            centroid += (a + b + c) * (triangleArea / 3.0f);
+            normal += n;
+            area += triangleArea;
+        }
+        if (area > 0.0f)
+        {
+            centroid /= area;
+            float normalLength = glm::length(normal);
+            if (normalLength > 0.0f)
+            {
+                cluster.sortKey = glm::dot(centroid - meshCenter, normal / normalLength);
+            }
+        }
+        clusters.push_back(cluster);
+    }
+
+    std::stable_sort(clusters.begin(), clusters.end(), [](const Cluster &a, const Cluster &b)
+    {
+        return a.sortKey > b.sortKey;
+    });
+
+    std::vector<unsigned int> output;
+    output.reserve(indices.size());
+    for (const Cluster &cluster : clusters)
+    {
+        output.insert(output.end(), indices.begin() + cluster.begin * 3, indices.begin() + cluster.end * 3);
+    }
+    indices.swap(output);
+}
+
+void optimizeVertexFetch(std::vector<Vertex> &vertices, std::vector<unsigned int> &indices)
+{
+    std::vector<unsigned int> remap(vertices.size(), kUnused);
+    std::vector<Vertex> output;
+    output.reserve(vertices.size());
+    for (unsigned int &index : indices)
+    {
+        if (remap[index] == kUnused)
+        {
+            remap[index] = static_cast<unsigned int>(output.size());
+            output.push_back(vertices[index]);
+        }
+        index = remap[index];
+    }
+    vertices.swap(output);
+}
+
+void optimizeMesh(std::vector<Vertex> &vertices, std::vector<unsigned int> &indices, MeshOptimizeStats *stats,
+                  const std::vector<IndexRange> *ranges)
+{
+    std::chrono::steady_clock::time_point start = std::chrono::steady_clock::now();
+    VertexCacheStats before = analyzeVertexCache(indices, vertices.size());
+
+    std::vector<size_t> clusterStarts;
+    size_t clusterCount = 0;
+    if (ranges && ranges->size() > 1)
+    {
+        // Each range is optimized on its own copy, then written back where it was
+        std::vector<unsigned int> part;
+        for (const IndexRange &range : *ranges)
+        {
+            part.assign(indices.begin() + range.firstIndex, indices.begin() + range.firstIndex + range.indexCount);
+            clusterStarts.clear();
+            optimizeVertexCache(part, vertices.size(), kVertexCacheSize, &clusterStarts);
+            optimizeOverdraw(part, vertices, clusterStarts);
+            std::copy(part.begin(), part.end(), indices.begin() + range.firstIndex);
+            clusterCount += clusterStarts.size();
+        }
+    }
+    else
+    {
+        optimizeVertexCache(indices, vertices.size(), kVertexCacheSize, &clusterStarts);
+        optimizeOverdraw(indices, vertices, clusterStarts);
+        clusterCount = clusterStarts.size();
+    }
+    optimizeVertexFetch(vertices, indices);
+
+    if (stats)
+    {
+        std::chrono::duration<double> elapsed = std::chrono::steady_clock::now() - start;
+        stats->before = before;
+        stats->after = analyzeVertexCache(indices, vertices.size());
+        stats->overdrawClusters = clusterCount;
+        stats->seconds = elapsed.count();
+    }
+}
+
+void printMeshOptimizeStats(const std::string &name, const MeshOptimizeStats &stats)
+{
+    std::cout << name << ": ACMR " << stats.before.acmr() << " -> " << stats.after.acmr()
+              << ", ATVR " << stats.before.atvr() << " -> " << stats.after.atvr()
+              << " (cache " << kVertexCacheSize << ", " << stats.overdrawClusters << " clusters, "
+              << stats.seconds * 1000.0 << " ms)\n";
+}
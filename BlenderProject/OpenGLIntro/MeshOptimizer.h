@@ -0,0 +1,97 @@
+#pragma once
+
+#include "Mesh.h"
+
+#include <cstddef>
+#include <string>
+#include <vector>
+
+// Post-transform cache size assumed by the optimizer and the statistics
+constexpr unsigned int kVertexCacheSize = 16;
+
+/**
+ * @brief Result of running an index buffer through a FIFO post-transform cache simulator.
+ */
+struct VertexCacheStats
+{
+    size_t transformedVertices = 0; // Cache misses, i.e. vertex shader invocations
+    size_t triangles = 0;
+    size_t uniqueVertices = 0; // Vertices referenced at least once
+
+    // Average cache miss ratio: vertex shader invocations per triangle (0.5 is the ideal for large grids)
+    double acmr() const { return triangles ? static_cast<double>(transformedVertices) / triangles : 0.0; }
+
+    // Average transform to vertex ratio: invocations per referenced vertex (1.0 is the ideal)
+    double atvr() const { return uniqueVertices ? static_cast<double>(transformedVertices) / uniqueVertices : 0.0; }
+};
+
+/**
+ * @brief Before/after numbers for optimizeMesh.
+ */
+struct MeshOptimizeStats
+{
+    VertexCacheStats before;
+    VertexCacheStats after;
+    size_t overdrawClusters = 0;
+    double seconds = 0.0;
+};
+
+/**
+ * @brief Simulates a FIFO post-transform vertex cache over the index buffer.
+ *
+ * @param indices Triangle list indices.
+ * @param vertexCount Number of vertices the indices refer to.
+ * @param cacheSize Number of entries in the simulated cache.
+ */
+VertexCacheStats analyzeVertexCache(const std::vector<unsigned int> &indices, size_t vertexCount,
+                                    unsigned int cacheSize = kVertexCacheSize);
+
+/**
+ * @brief Reorders triangles for post-transform cache locality using Tipsify (Sander et al. 2007).
+ *
+ * Runs in linear time. Fans triangles around one vertex at a time and picks the next fanning
+ * vertex among the ones still in the cache.
+ *
+ * @param indices Triangle list indices, reordered in place.
+ * @param vertexCount Number of vertices the indices refer to.
+ * @param cacheSize Cache size to optimize for.
+ * @param clusterStarts Optional, receives the first triangle of every run that began at a dead
+ * end. These make good cluster boundaries for optimizeOverdraw.
+ */
+void optimizeVertexCache(std::vector<unsigned int> &indices, size_t vertexCount,
+                         unsigned int cacheSize = kVertexCacheSize,
+                         std::vector<size_t> *clusterStarts = nullptr);
+
+/**
+ * @brief Sorts cache-optimized triangle clusters so outward-facing ones draw first, which cuts
+ * overdraw from any viewpoint without breaking up the vertex cache runs.
+ *
+ * @param indices Triangle list indices, reordered in place.
+ * @param vertices The mesh vertices.
+ * @param clusterStarts First triangle of every cluster, as produced by optimizeVertexCache.
+ */
+void optimizeOverdraw(std::vector<unsigned int> &indices, const std::vector<Vertex> &vertices,
+                      const std::vector<size_t> &clusterStarts);
+
+/**
+ * @brief Reorders the vertex buffer into first-use order for fetch locality and drops vertices
+ * no triangle refers to. Indices are remapped to match.
+ */
+void optimizeVertexFetch(std::vector<Vertex> &vertices, std::vector<unsigned int> &indices);
+
+/**
+ * @brief Runs the vertex cache, overdraw and vertex fetch passes in that order.
+ *
+ * @param vertices The mesh vertices, reordered in place.
+ * @param indices Triangle list indices, reordered in place.
+ * @param stats Optional, receives the cache statistics before and after.
+ * @param ranges Optional, triangles only move within their range, so ranges such as
+ * per-material sub-meshes stay contiguous. They must not overlap.
+ */
+void optimizeMesh(std::vector<Vertex> &vertices, std::vector<unsigned int> &indices, MeshOptimizeStats *stats = nullptr,
+                  const std::vector<IndexRange> *ranges = nullptr);
+
+/**
+ * @brief Prints the ACMR/ATVR before and after optimization for the named mesh to stdout.
+ */
+void printMeshOptimizeStats(const std::string &name, const MeshOptimizeStats &stats);
@@ -0,0 +1,769 @@
+#include "MeshSimplifier.h"
+#include "MeshOptimizer.h"
+
+#include <algorithm>
+#include <chrono>
+#include <climits>
+#include <cmath>
+#include <iostream>
+#include <numeric>
+#include <utility>
+
+namespace
+{
+    /**
+     * @brief Symmetric 4x4 quadric, sum of squared distances to a set of weighted planes.
+     */
+    struct Quadric
+    {
+        double a00 = 0, a01 = 0, a02 = 0, a03 = 0;
+        double a11 = 0, a12 = 0, a13 = 0;
+        double a22 = 0, a23 = 0;
+        double a33 = 0;
+        double weight = 0;
+
+        void addPlane(const glm::vec3 &normal, float distance, double planeWeight)
+        {
+            const double a = normal.x, b = normal.y, c = normal.z, d = distance;
+            a00 += planeWeight * a * a; a01 += planeWeight * a * b; a02 += planeWeight * a * c; a03 += planeWeight * a * d;
+            a11 += planeWeight * b * b; a12 += planeWeight * b * c; a13 += planeWeight * b * d;
+            a22 += planeWeight * c * c; a23 += planeWeight * c * d;
+            a33 += planeWeight * d * d;
+            weight += planeWeight;
+        }
+
+        void add(const Quadric &other)
+        {
+            a00 += other.a00; a01 += other.a01; a02 += other.a02; a03 += other.a03;
+            a11 += other.a11; a12 += other.a12; a13 += other.a13;
+            a22 += other.a22; a23 += other.a23;
+            a33 += other.a33;
+            weight += other.weight;
+        }
+
+        // Weighted sum of squared distances from the point to the planes
+        double evaluate(const glm::vec3 &p) const
+        {
+            const double x = p.x, y = p.y, z = p.z;
+            return a00 * x * x + a11 * y * y + a22 * z * z + a33
+                 + 2.0 * (a01 * x * y + a02 * x * z + a12 * y * z + a03 * x + a13 * y + a23 * z);
+        }
+    };
+
+    struct Collapse
+    {
+        float cost;
+        float error; // Positional part of the cost, squared model units
+        unsigned int from;
+        unsigned int to;
+    };
+
+    enum VertexKind : unsigned char
+    {
+        Interior,
+        Border, // On an open edge; may only slide along it
+        Locked  // Non-manifold or locked by the caller; never moves
+    };
+
+    /**
+     * @brief Numbers the distinct vertex positions and maps every vertex to its position's number.
+     *
+     * @return The number of distinct positions.
+     */
+    size_t positionGroups(const Vertex *vertices, size_t vertexCount, std::vector<unsigned int> &groupOf)
+    {
+        std::vector<unsigned int> order(vertexCount);
+        std::iota(order.begin(), order.end(), 0u);
+        std::sort(order.begin(), order.end(), [vertices](unsigned int a, unsigned int b)
+        {
+            const glm::vec3 &p = vertices[a].Position, &q = vertices[b].Position;
+            if (p.x != q.x) return p.x < q.x;
+            if (p.y != q.y) return p.y < q.y;
+            return p.z < q.z;
+        });
+        groupOf.assign(vertexCount, 0);
+        size_t groups = 0;
+        for (size_t i = 0; i < order.size(); ++i)
+        {
+            if (i > 0 && vertices[order[i]].Position != vertices[order[i - 1]].Position)
+            {
+                ++groups;
+            }
+            groupOf[order[i]] = static_cast<unsigned int>(groups);
+        }
+        return vertexCount > 0 ? groups + 1 : 0;
+    }
+
+    /**
+     * @brief Flags every vertex whose position is used by more than one of the ranges.
+     */
+    std::vector<unsigned char> rangeSeams(const Vertex *vertices, size_t vertexCount, const unsigned int *indices,
+                                          const std::vector<IndexRange> &ranges)
+    {
+        const unsigned int kUnused = UINT_MAX, kShared = UINT_MAX - 1;
+        std::vector<unsigned int> groupOf;
+        std::vector<unsigned int> owner(positionGroups(vertices, vertexCount, groupOf), kUnused);
+        for (size_t r = 0; r < ranges.size(); ++r)
+        {
+            for (size_t i = ranges[r].firstIndex; i < ranges[r].firstIndex + ranges[r].indexCount; ++i)
+            {
+                unsigned int &o = owner[groupOf[indices[i]]];
+                o = o == kUnused ? static_cast<unsigned int>(r) : o == r ? o : kShared;
+            }
+        }
+        std::vector<unsigned char> locked(vertexCount, 0);
+        for (size_t v = 0; v < vertexCount; ++v)
+        {
+            locked[v] = owner[groupOf[v]] == kShared ? 1 : 0;
+        }
+        return locked;
+    }
+
+    /**
+     * @brief Everything the collapse passes share. Vertices with the same position form one
+     * group; collapses happen between groups and the corners follow along.
+     */
+    struct Simplifier
+    {
+        const Vertex *vertices;
+        SimplifyOptions options;
+        float attributeScale; // Squared mesh extent, puts the normal term in the units of the quadric
+
+        std::vector<unsigned int> groupOf;      // Vertex -> group
+        std::vector<unsigned int> wedgeOffsets; // Group -> its vertices, in compressed rows
+        std::vector<unsigned int> wedges;
+        std::vector<glm::vec3> position; // Per group
+        std::vector<Quadric> quadrics;   // Per group
+
+        std::vector<unsigned int> corners; // Vertex per triangle corner, updated by collapses
+        std::vector<unsigned char> liveTriangle;
+        size_t liveTriangles = 0;
+
+        // Rebuilt every pass
+        std::vector<unsigned int> triangleOffsets; // Group -> live triangles, in compressed rows
+        std::vector<unsigned int> triangleList;
+        std::vector<unsigned char> kind;
+        std::vector<unsigned char> touched;
+        std::vector<unsigned int> scratchA, scratchB;
+
+        unsigned int group(size_t corner) const { return groupOf[corners[corner]]; }
+
+        void buildGroups(size_t vertexCount)
+        {
+            // Sort by position so identical positions end up next to each other
+            std::vector<unsigned int> order(vertexCount);
+            std::iota(order.begin(), order.end(), 0u);
+            std::sort(order.begin(), order.end(), [this](unsigned int a, unsigned int b)
+            {
+                const glm::vec3 &p = vertices[a].Position, &q = vertices[b].Position;
+                if (p.x != q.x) return p.x < q.x;
+                if (p.y != q.y) return p.y < q.y;
+                if (p.z != q.z) return p.z < q.z;
+                return a < b;
+            });
+
+            groupOf.assign(vertexCount, 0);
+            wedges = order;
+            wedgeOffsets.clear();
+            position.clear();
+            for (size_t i = 0; i < order.size(); ++i)
+            {
+                if (i == 0 || vertices[order[i]].Position != vertices[order[i - 1]].Position)
+                {
+                    wedgeOffsets.push_back(static_cast<unsigned int>(i));
+                    position.push_back(vertices[order[i]].Position);
+                }
+                groupOf[order[i]] = static_cast<unsigned int>(position.size() - 1);
+            }
+            wedgeOffsets.push_back(static_cast<unsigned int>(order.size()));
+        }
+
+        void buildAdjacency()
+        {
+            const size_t groupCount = position.size();
+            triangleOffsets.assign(groupCount + 1, 0);
+            for (size_t t = 0; t < liveTriangle.size(); ++t)
+            {
+                if (liveTriangle[t])
+                {
+                    for (int c = 0; c < 3; ++c)
+                    {
+                        ++triangleOffsets[group(t * 3 + c) + 1];
+                    }
+                }
+            }
+            for (size_t g = 0; g < groupCount; ++g)
+            {
+                triangleOffsets[g + 1] += triangleOffsets[g];
+            }
+            triangleList.resize(triangleOffsets[groupCount]);
+            std::vector<unsigned int> fill(triangleOffsets.begin(), triangleOffsets.end() - 1);
+            for (size_t t = 0; t < liveTriangle.size(); ++t)
+            {
+                if (liveTriangle[t])
+                {
+                    for (int c = 0; c < 3; ++c)
+                    {
+                        triangleList[fill[group(t * 3 + c)]++] = static_cast<unsigned int>(t);
+                    }
+                }
+            }
+        }
+
+        /**
+         * @brief Collects the other corners of every triangle around the group, sorted, so each
+         * neighbor appears once per triangle on the edge between them.
+         */
+        void neighbors(unsigned int g, std::vector<unsigned int> &out) const
+        {
+            out.clear();
+            for (unsigned int i = triangleOffsets[g]; i < triangleOffsets[g + 1]; ++i)
+            {
+                const unsigned int t = triangleList[i];
+                if (!liveTriangle[t])
+                {
+                    continue;
+                }
+                for (int c = 0; c < 3; ++c)
+                {
+                    const unsigned int other = group(t * 3 + c);
+                    if (other != g)
+                    {
+                        out.push_back(other);
+                    }
+                }
+            }
+            std::sort(out.begin(), out.end());
+        }
+
+        /**
+         * @brief Calls the visitor with every edge of the group and the number of triangles on it.
+         */
+        template <typename Visitor>
+        void forEachEdge(unsigned int g, std::vector<unsigned int> &scratch, const Visitor &visit) const
+        {
+            neighbors(g, scratch);
+            for (size_t i = 0; i < scratch.size();)
+            {
+                size_t j = i;
+                while (j < scratch.size() && scratch[j] == scratch[i])
+                {
+                    ++j;
+                }
+                visit(scratch[i], static_cast<unsigned int>(j - i));
+                i = j;
+            }
+        }
+
+        void classifyVertices(const unsigned char *lockedVertices)
+        {
+            kind.assign(position.size(), Interior);
+            if (lockedVertices)
+            {
+                for (unsigned int g = 0; g < position.size(); ++g)
+                {
+                    for (unsigned int w = wedgeOffsets[g]; w < wedgeOffsets[g + 1]; ++w)
+                    {
+                        if (lockedVertices[wedges[w]])
+                        {
+                            kind[g] = Locked;
+                        }
+                    }
+                }
+            }
+            for (unsigned int g = 0; g < position.size(); ++g)
+            {
+                forEachEdge(g, scratchA, [this, g](unsigned int, unsigned int count)
+                {
+                    if (count > 2 || kind[g] == Locked)
+                    {
+                        kind[g] = Locked;
+                    }
+                    else if (count == 1 && kind[g] == Interior)
+                    {
+                        kind[g] = Border;
+                    }
+                });
+            }
+        }
+
+        void buildQuadrics()
+        {
+            quadrics.assign(position.size(), Quadric());
+            for (size_t t = 0; t < liveTriangle.size(); ++t)
+            {
+                if (!liveTriangle[t])
+                {
+                    continue;
+                }
+                const glm::vec3 &a = position[group(t * 3)], &b = position[group(t * 3 + 1)], &c = position[group(t * 3 + 2)];
+                glm::vec3 normal = glm::cross(b - a, c - a);
+                float length = glm::length(normal);
+                if (length <= 0.0f)
+                {
+                    continue;
+                }
+                normal /= length;
+                for (int corner = 0; corner < 3; ++corner)
+                {
+                    quadrics[group(t * 3 + corner)].addPlane(normal, -glm::dot(normal, a), length * 0.5);
+                }
+            }
+
+            // Open edges get a plane through the edge, perpendicular to the face, so borders keep their shape
+            for (unsigned int g = 0; g < position.size(); ++g)
+            {
+                forEachEdge(g, scratchA, [this, g](unsigned int other, unsigned int count)
+                {
+                    if (count != 1 || other < g)
+                    {
+                        return;
+                    }
+                    for (unsigned int i = triangleOffsets[g]; i < triangleOffsets[g + 1]; ++i)
+                    {
+                        const unsigned int t = triangleList[i];
+                        if (group(t * 3) != other && group(t * 3 + 1) != other && group(t * 3 + 2) != other)
+                        {
+                            continue;
+                        }
+                        const glm::vec3 &a = position[group(t * 3)], &b = position[group(t * 3 + 1)], &c = position[group(t * 3 + 2)];
+                        glm::vec3 edge = position[other] - position[g];
+                        glm::vec3 plane = glm::cross(edge, glm::cross(b - a, c - a));
+                        float length = glm::length(plane);
+                        if (length > 0.0f)
+                        {
+                            plane /= length;
+                            double planeWeight = glm::dot(edge, edge) * options.borderWeight;
+                            quadrics[g].addPlane(plane, -glm::dot(plane, position[g]), planeWeight);
+                            quadrics[other].addPlane(plane, -glm::dot(plane, position[g]), planeWeight);
+                        }
+                        break;
+                    }
+                });
+            }
+        }
+
+        /**
+         * @brief The vertex of group `to` whose normal is closest to the given vertex's.
+         */
+        unsigned int closestWedge(unsigned int vertex, unsigned int to, float *distance = nullptr) const
+        {
+            unsigned int best = wedges[wedgeOffsets[to]];
+            float bestDistance = 1e30f;
+            for (unsigned int w = wedgeOffsets[to]; w < wedgeOffsets[to + 1]; ++w)
+            {
+                glm::vec3 delta = vertices[wedges[w]].Normal - vertices[vertex].Normal;
+                float d = glm::dot(delta, delta);
+                if (d < bestDistance)
+                {
+                    bestDistance = d;
+                    best = wedges[w];
+                }
+            }
+            if (distance)
+            {
+                *distance = bestDistance;
+            }
+            return best;
+        }
+
+        bool evaluate(unsigned int from, unsigned int to, Collapse &out) const
+        {
+            if (kind[from] == Locked || (kind[from] == Border && kind[to] != Border))
+            {
+                return false;
+            }
+            Quadric q = quadrics[from];
+            q.add(quadrics[to]);
+            double error = q.weight > 0.0 ? std::fabs(q.evaluate(position[to])) / q.weight : 0.0;
+
+            float normalError = 0.0f;
+            for (unsigned int w = wedgeOffsets[from]; w < wedgeOffsets[from + 1]; ++w)
+            {
+                float distance;
+                closestWedge(wedges[w], to, &distance);
+                normalError = std::max(normalError, distance);
+            }
+            // |a - b|^2 = 2 - 2 cos for unit normals
+            out.error = static_cast<float>(error);
+            out.cost = static_cast<float>(error + options.normalWeight * attributeScale * normalError * 0.5f);
+            out.from = from;
+            out.to = to;
+            return true;
+        }
+
+        /**
+         * @brief Topology and geometry checks for moving `from` onto `to`.
+         */
+        bool canCollapse(unsigned int from, unsigned int to)
+        {
+            // Link condition: the two vertices may only share the neighbors across the edge itself
+            unsigned int sharedTriangles = 0;
+            for (unsigned int i = triangleOffsets[from]; i < triangleOffsets[from + 1]; ++i)
+            {
+                const unsigned int t = triangleList[i];
+                if (!liveTriangle[t])
+                {
+                    continue;
+                }
+                sharedTriangles += (group(t * 3) == to || group(t * 3 + 1) == to || group(t * 3 + 2) == to) ? 1 : 0;
+            }
+            if (sharedTriangles == 0 || (kind[from] == Border && sharedTriangles != 1))
+            {
+                return false;
+            }
+            neighbors(from, scratchA);
+            neighbors(to, scratchB);
+            scratchA.erase(std::unique(scratchA.begin(), scratchA.end()), scratchA.end());
+            scratchB.erase(std::unique(scratchB.begin(), scratchB.end()), scratchB.end());
+            unsigned int common = 0;
+            for (size_t a = 0, b = 0; a < scratchA.size() && b < scratchB.size();)
+            {
+                if (scratchA[a] < scratchB[b]) ++a;
+                else if (scratchB[b] < scratchA[a]) ++b;
+                else { ++common; ++a; ++b; }
+            }
+            if (common != sharedTriangles)
+            {
+                return false;
+            }
+
+            // No surviving triangle may flip or collapse into a sliver
+            for (unsigned int i = triangleOffsets[from]; i < triangleOffsets[from + 1]; ++i)
+            {
+                const unsigned int t = triangleList[i];
+                if (!liveTriangle[t])
+                {
+                    continue;
+                }
+                glm::vec3 p[3];
+                bool hasTo = false;
+                for (int c = 0; c < 3; ++c)
+                {
+                    p[c] = position[group(t * 3 + c)];
+                    hasTo = hasTo || group(t * 3 + c) == to;
+                }
+                if (hasTo)
+                {
+                    continue;
+                }
+                glm::vec3 before = glm::cross(p[1] - p[0], p[2] - p[0]);
+                for (int c = 0; c < 3; ++c)
+                {
+                    if (group(t * 3 + c) == from)
+                    {
+                        p[c] = position[to];
+                    }
+                }
+                glm::vec3 after = glm::cross(p[1] - p[0], p[2] - p[0]);
+                if (glm::dot(before, after) <= 0.25f * glm::length(before) * glm::length(after))
+                {
+                    return false;
+                }
+            }
+            return true;
+        }
+
+        void collapse(unsigned int from, unsigned int to)
+        {
+            quadrics[to].add(quadrics[from]);
+            for (unsigned int i = triangleOffsets[from]; i < triangleOffsets[from + 1]; ++i)
+            {
+                const unsigned int t = triangleList[i];
+                if (!liveTriangle[t])
+                {
+                    continue;
+                }
+                bool hasTo = false;
+                for (int c = 0; c < 3; ++c)
+                {
+                    hasTo = hasTo || group(t * 3 + c) == to;
+                }
+                if (hasTo)
+                {
+                    liveTriangle[t] = 0;
+                    --liveTriangles;
+                    continue;
+                }
+                for (int c = 0; c < 3; ++c)
+                {
+                    if (group(t * 3 + c) == from)
+                    {
+                        corners[t * 3 + c] = closestWedge(corners[t * 3 + c], to);
+                    }
+                }
+            }
+        }
+    };
+}
+
+float simplifyMesh(const Vertex *vertices, size_t vertexCount, const unsigned int *indices, size_t indexCount,
+                   size_t targetIndexCount, std::vector<unsigned int> &out, const SimplifyOptions &options,
+                   const unsigned char *lockedVertices)
+{
+    Simplifier s;
+    s.vertices = vertices;
+    s.options = options;
+    s.buildGroups(vertexCount);
+
+    glm::vec3 minimum(0.0f), maximum(0.0f);
+    for (size_t g = 0; g < s.position.size(); ++g)
+    {
+        minimum = g == 0 ? s.position[g] : glm::min(minimum, s.position[g]);
+        maximum = g == 0 ? s.position[g] : glm::max(maximum, s.position[g]);
+    }
+    glm::vec3 extent = maximum - minimum;
+    s.attributeScale = glm::dot(extent, extent);
+
+    // Triangles that are already degenerate in position never take part
+    const size_t triangleCount = indexCount / 3;
+    s.corners.assign(indices, indices + triangleCount * 3);
+    s.liveTriangle.assign(triangleCount, 1);
+    s.liveTriangles = triangleCount;
+    for (size_t t = 0; t < triangleCount; ++t)
+    {
+        if (s.group(t * 3) == s.group(t * 3 + 1) || s.group(t * 3 + 1) == s.group(t * 3 + 2) || s.group(t * 3) == s.group(t * 3 + 2))
+        {
+            s.liveTriangle[t] = 0;
+            --s.liveTriangles;
+        }
+    }
+
+    // Collapses that pass the link condition keep borders on borders and never create
+    // non-manifold edges, so the classification holds for every pass
+    s.buildAdjacency();
+    s.buildQuadrics();
+    s.classifyVertices(lockedVertices);
+
+    const size_t targetTriangles = targetIndexCount / 3;
+    float maxError = 0.0f;
+    std::vector<Collapse> heap;
+    while (s.liveTriangles > targetTriangles)
+    {
+        s.buildAdjacency();
+
+        heap.clear();
+        for (size_t t = 0; t < s.liveTriangle.size(); ++t)
+        {
+            if (!s.liveTriangle[t])
+            {
+                continue;
+            }
+            for (int c = 0; c < 3; ++c)
+            {
+                // Interior edges show up in two triangles; queue them once
+                const unsigned int a = s.group(t * 3 + c), b = s.group(t * 3 + (c + 1) % 3);
+                if (a > b && !(s.kind[a] == Border && s.kind[b] == Border))
+                {
+                    continue;
+                }
+                Collapse forward, backward;
+                bool canForward = s.evaluate(a, b, forward);
+                bool canBackward = s.evaluate(b, a, backward);
+                if (canForward || canBackward)
+                {
+                    heap.push_back(!canBackward || (canForward && forward.cost <= backward.cost) ? forward : backward);
+                }
+            }
+        }
+        auto cheaper = [](const Collapse &a, const Collapse &b) { return a.cost > b.cost; };
+        std::make_heap(heap.begin(), heap.end(), cheaper);
+
+        // Each interior collapse removes two triangles
+        const size_t wanted = std::max<size_t>(1, (s.liveTriangles - targetTriangles + 1) / 2);
+        size_t collapses = 0;
+        s.touched.assign(s.position.size(), 0);
+        while (!heap.empty() && collapses < wanted && s.liveTriangles > targetTriangles)
+        {
+            std::pop_heap(heap.begin(), heap.end(), cheaper);
+            Collapse candidate = heap.back();
+            heap.pop_back();
+            if (s.touched[candidate.from] || s.touched[candidate.to] || !s.canCollapse(candidate.from, candidate.to))
+            {
+                continue;
+            }
+            // Only the target's triangle list is stale now; dead triangles are skipped everywhere
+            s.touched[candidate.from] = 1;
+            s.touched[candidate.to] = 1;
+            s.collapse(candidate.from, candidate.to);
+            maxError = std::max(maxError, candidate.error);
+            ++collapses;
+        }
+        // A pass that emptied the queue and still fell far short means the remaining edges are
+        // blocked by topology or flips; more passes would only repeat the same work
+        if (collapses == 0 || (heap.empty() && collapses < wanted / 16))
+        {
+            break;
+        }
+    }
+
+    out.clear();
+    out.reserve(s.liveTriangles * 3);
+    for (size_t t = 0; t < s.liveTriangle.size(); ++t)
+    {
+        if (s.liveTriangle[t])
+        {
+            out.insert(out.end(), s.corners.begin() + t * 3, s.corners.begin() + t * 3 + 3);
+        }
+    }
+    return std::sqrt(maxError);
+}
+
+size_t countOpenEdges(const Vertex *vertices, size_t vertexCount, const unsigned int *indices, size_t indexCount)
+{
+    std::vector<unsigned int> groupOf;
+    positionGroups(vertices, vertexCount, groupOf);
+    std::vector<std::pair<unsigned int, unsigned int>> edges;
+    edges.reserve(indexCount);
+    for (size_t t = 0; t + 2 < indexCount; t += 3)
+    {
+        for (int c = 0; c < 3; ++c)
+        {
+            const unsigned int a = groupOf[indices[t + c]], b = groupOf[indices[t + (c + 1) % 3]];
+            if (a != b)
+            {
+                edges.emplace_back(std::min(a, b), std::max(a, b));
+            }
+        }
+    }
+    std::sort(edges.begin(), edges.end());
+    size_t open = 0;
+    for (size_t i = 0; i < edges.size();)
+    {
+        size_t j = i;
+        while (j < edges.size() && edges[j] == edges[i])
+        {
+            ++j;
+        }
+        open += j - i == 1 ? 1 : 0;
+        i = j;
+    }
+    return open;
+}
+
+void buildLodChain(const Vertex *vertices, size_t vertexCount, const unsigned int *indices, size_t indexCount,
+                   const std::vector<float> &ratios, LodChain &out, const SimplifyOptions &options,
+                   const std::vector<IndexRange> *ranges)
+{
+    std::chrono::steady_clock::time_point start = std::chrono::steady_clock::now();
+    out.indices.assign(indices, indices + indexCount);
+    out.levels.assign(1, MeshLod{0, indexCount, 0.0f});
+    if (ranges && !ranges->empty())
+    {
+        out.ranges = *ranges;
+    }
+    else
+    {
+        out.ranges.assign(1, IndexRange{0, indexCount});
+    }
+    out.rangesPerLevel = out.ranges.size();
+
+    glm::vec3 minimum(0.0f), maximum(0.0f);
+    for (size_t v = 0; v < vertexCount; ++v)
+    {
+        minimum = v == 0 ? vertices[v].Position : glm::min(minimum, vertices[v].Position);
+        maximum = v == 0 ? vertices[v].Position : glm::max(maximum, vertices[v].Position);
+    }
+    out.center = (minimum + maximum) * 0.5f;
+    out.radius = glm::length(maximum - minimum) * 0.5f;
+
+    // Every range goes down the chain on its own; a level is the ranges put back together. The
+    // seams stay put, or ranges that simplify differently would pull apart along them.
+    std::vector<unsigned char> seams;
+    if (out.rangesPerLevel > 1)
+    {
+        seams = rangeSeams(vertices, vertexCount, indices, out.ranges);
+    }
+    const size_t sourceOpenEdges = countOpenEdges(vertices, vertexCount, indices, indexCount);
+    std::vector<std::vector<unsigned int>> previous(out.rangesPerLevel);
+    for (size_t r = 0; r < out.rangesPerLevel; ++r)
+    {
+        const IndexRange &range = out.ranges[r];
+        previous[r].assign(indices + range.firstIndex, indices + range.firstIndex + range.indexCount);
+    }
+    std::vector<unsigned int> simplified;
+    for (float ratio : ratios)
+    {
+        size_t previousSize = 0, levelSize = 0, target = 0;
+        float error = 0.0f;
+        std::vector<IndexRange> levelRanges(out.rangesPerLevel);
+        const size_t levelStart = out.indices.size();
+        for (size_t r = 0; r < out.rangesPerLevel; ++r)
+        {
+            const size_t rangeTarget = static_cast<size_t>(out.ranges[r].indexCount / 3 * ratio) * 3;
+            const float rangeError = simplifyMesh(vertices, vertexCount, previous[r].data(), previous[r].size(), rangeTarget,
+                                                  simplified, options, seams.empty() ? nullptr : seams.data());
+            previousSize += previous[r].size();
+            target += rangeTarget;
+            // A range that cannot be reduced any further stays as it was
+            if (simplified.size() < previous[r].size())
+            {
+                optimizeVertexCache(simplified, vertexCount);
+                previous[r].swap(simplified);
+                error = std::max(error, rangeError);
+            }
+            levelRanges[r] = {out.indices.size(), previous[r].size()};
+            out.indices.insert(out.indices.end(), previous[r].begin(), previous[r].end());
+            levelSize += previous[r].size();
+        }
+        // A level that opened the surface would show cracks, and every later level would inherit them
+        if (levelSize >= previousSize ||
+            countOpenEdges(vertices, vertexCount, out.indices.data() + levelStart, levelSize) > sourceOpenEdges)
+        {
+            out.indices.resize(levelStart);
+            break;
+        }
+
+        // Errors add up over the chain since each level starts from the previous one
+        out.levels.push_back(MeshLod{levelStart, levelSize, out.levels.back().error + error});
+        out.ranges.insert(out.ranges.end(), levelRanges.begin(), levelRanges.end());
+
+        // A level that got less than halfway to its target is as far as this mesh goes
+        if (levelSize > target + (previousSize - target) / 2)
+        {
+            break;
+        }
+    }
+
+    std::chrono::duration<double> elapsed = std::chrono::steady_clock::now() - start;
+    out.seconds = elapsed.count();
+}
+
+size_t selectLod(const LodChain &chain, const glm::mat4 &transform, const glm::mat4 &view, const glm::mat4 &projection,
+                 float viewportHeight, float maxPixelError)
+{
+    // Largest axis scale of the model matrix, so errors are measured in world units
+    float scale = std::max(glm::length(glm::vec3(transform[0])),
+                           std::max(glm::length(glm::vec3(transform[1])), glm::length(glm::vec3(transform[2]))));
+
+    // Distance to the nearest point of the bounding sphere; inside it, always draw the full mesh
+    glm::vec4 center = view * transform * glm::vec4(chain.center, 1.0f);
+    float distance = -center.z - chain.radius * scale;
+    if (distance <= 0.0f)
+    {
+        return 0;
+    }
+
+    // projection[1][1] is cot(fov / 2): world units at the given distance to normalized device units
+    float pixelsPerUnit = projection[1][1] * viewportHeight * 0.5f / distance;
+    size_t selected = 0;
+    for (size_t l = 1; l < chain.levels.size(); ++l)
+    {
+        if (chain.levels[l].error * scale * pixelsPerUnit <= maxPixelError)
+        {
+            selected = l;
+        }
+    }
+    return selected;
+}
+
+void printLodChain(const std::string &name, const LodChain &chain)
+{
+    std::cout << name << ": " << chain.levels.size() << " LODs in " << chain.seconds * 1000.0 << " ms\n";
+    for (size_t l = 0; l < chain.levels.size(); ++l)
+    {
+        std::cout << "  LOD " << l << ": " << chain.levels[l].indexCount / 3 << " triangles, error "
+                  << chain.levels[l].error << " (" << (chain.radius > 0.0f ? chain.levels[l].error / chain.radius * 100.0f : 0.0f)
+                  << "% of radius)\n";
+    }
+}
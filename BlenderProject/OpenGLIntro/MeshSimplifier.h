@@ -0,0 +1,121 @@
+#pragma once
+
+#include "Mesh.h"
+
+#include <cstddef>
+#include <string>
+#include <vector>
+
+/**
+ * @brief Tuning for simplifyMesh.
+ */
+struct SimplifyOptions
+{
+    // How much a collapse that changes a corner's normal costs, relative to moving the surface.
+    // 1 - cos of the normal change is scaled by the squared mesh extent and this weight.
+    float normalWeight = 0.001f;
+
+    // Extra weight of the planes that hold open borders in place
+    float borderWeight = 10.0f;
+};
+
+/**
+ * @brief Triangle ratios of the LOD levels the viewer builds when --lod-ratios says nothing else.
+ */
+inline std::vector<float> defaultLodRatios()
+{
+    return {0.5f, 0.25f, 0.125f};
+}
+
+/**
+ * @brief One level of detail: a range of LodChain::indices and its geometric error.
+ */
+struct MeshLod
+{
+    size_t firstIndex;
+    size_t indexCount;
+    float error; // Largest surface deviation from the full mesh, in model units
+};
+
+/**
+ * @brief Index buffers for every level of detail of one vertex buffer, concatenated so they
+ * can share a single EBO. Level 0 is the full mesh.
+ */
+struct LodChain
+{
+    std::vector<unsigned int> indices;
+    std::vector<MeshLod> levels;
+    // Each level split into the ranges it was built from, rangesPerLevel per level in level order
+    std::vector<IndexRange> ranges;
+    size_t rangesPerLevel = 1;
+    glm::vec3 center = glm::vec3(0.0f); // Bounding sphere of the mesh, for LOD selection
+    float radius = 0.0f;
+    double seconds = 0.0;
+};
+
+/**
+ * @brief Simplifies a triangle mesh with quadric error metrics (Garland and Heckbert 1997).
+ *
+ * Collapses edges onto one of their endpoints, so the result indexes the original vertex
+ * buffer. Vertices that share a position (split by normals) collapse together, and every corner
+ * moves to the wedge of the target whose normal is closest; the normal change is part of the
+ * collapse cost. Collapses that flip triangles or pinch the surface are rejected.
+ *
+ * Works in passes: each pass rebuilds a compact vertex to triangle adjacency, queues every edge
+ * in a min-heap by cost and collapses from the cheapest, skipping edges whose endpoints
+ * already moved in the same pass.
+ *
+ * @param vertices The mesh vertices.
+ * @param vertexCount Number of vertices.
+ * @param indices Triangle list indices.
+ * @param indexCount Number of indices.
+ * @param targetIndexCount Stop once the mesh has this many indices or fewer.
+ * @param out Receives the simplified indices.
+ * @param options Tuning.
+ * @param lockedVertices Optional, one flag per vertex: flagged vertices, and every vertex at the
+ * same position, never move.
+ * @return The largest surface deviation introduced, in model units.
+ */
+float simplifyMesh(const Vertex *vertices, size_t vertexCount, const unsigned int *indices, size_t indexCount,
+                   size_t targetIndexCount, std::vector<unsigned int> &out,
+                   const SimplifyOptions &options = SimplifyOptions(), const unsigned char *lockedVertices = nullptr);
+
+/**
+ * @brief Counts the edges, between positions, that only one triangle uses. A closed mesh has none.
+ */
+size_t countOpenEdges(const Vertex *vertices, size_t vertexCount, const unsigned int *indices, size_t indexCount);
+
+/**
+ * @brief Builds a LOD chain. Each level is simplified from the one before it and optimized for
+ * the vertex cache. The chain stops early once the mesh cannot be reduced any further.
+ *
+ * @param ratios Triangle count of each level relative to the full mesh, e.g. {0.5, 0.25, 0.125}.
+ * @param out Receives the concatenated index buffers and the level table.
+ * @param ranges Optional, such as one per material: each range is simplified on its own and
+ * every level keeps them contiguous and in the same order. Vertices whose position more than
+ * one range uses are locked, so the seams between ranges stay where they are and the ranges
+ * keep meeting on every level. A level with more open edges than the full mesh is dropped and
+ * ends the chain.
+ */
+void buildLodChain(const Vertex *vertices, size_t vertexCount, const unsigned int *indices, size_t indexCount,
+                   const std::vector<float> &ratios, LodChain &out,
+                   const SimplifyOptions &options = SimplifyOptions(), const std::vector<IndexRange> *ranges = nullptr);
+
+/**
+ * @brief Picks the coarsest level whose error, projected to the screen, stays under the limit.
+ *
+ * @param chain The LOD chain.
+ * @param transform The object's model matrix.
+ * @param view The camera view matrix.
+ * @param projection The camera projection matrix.
+ * @param viewportHeight Viewport height in pixels.
+ * @param maxPixelError Largest acceptable error in pixels.
+ * @return Index into chain.levels.
+ */
+size_t selectLod(const LodChain &chain, const glm::mat4 &transform, const glm::mat4 &view, const glm::mat4 &projection,
+                 float viewportHeight, float maxPixelError = 1.0f);
+
+/**
+ * @brief Prints the triangle count and error of every level for the named mesh to stdout.
+ */
+void printLodChain(const std::string &name, const LodChain &chain);
@@ -0,0 +1,323 @@
+#include "Meshlets.h"
+
+#include <algorithm>
+#include <cmath>
+#include <cstdint>
+
+namespace
+{
+    const unsigned int kUnused = 0xffffffffu;
+
+    /**
+     * @brief Ritter's approximate bounding sphere: start from the two points farthest apart along
+     * a rough diameter, then grow the sphere for every point left outside.
+     */
+    void boundingSphere(const std::vector<glm::vec3> &points, glm::vec3 &center, float &radius)
+    {
+        const glm::vec3 &first = points[0];
+        size_t a = 0;
+        float farthest = -1.0f;
+        for (size_t p = 0; p < points.size(); ++p)
+        {
+            glm::vec3 d = points[p] - first;
+            float distance = glm::dot(d, d);
+            if (distance > farthest)
+            {
+                farthest = distance;
+                a = p;
+            }
+        }
+        size_t b = a;
+        farthest = -1.0f;
+        for (size_t p = 0; p < points.size(); ++p)
+        {
+            glm::vec3 d = points[p] - points[a];
+            float distance = glm::dot(d, d);
+            if (distance > farthest)
+            {
+                farthest = distance;
+                b = p;
+            }
+        }
+
+        center = (points[a] + points[b]) * 0.5f;
+        radius = glm::length(points[b] - points[a]) * 0.5f;
+        for (const glm::vec3 &point : points)
+        {
+            float distance = glm::length(point - center);
+            if (distance > radius)
+            {
+                float grown = (radius + distance) * 0.5f;
+                center += (point - center) * ((grown - radius) / distance);
+                radius = grown;
+            }
+        }
+    }
+
+    inline float planeDistance(const float plane[4], float x, float y, float z)
+    {
+        return plane[0] * x + plane[1] * y + plane[2] * z + plane[3];
+    }
+
+    /**
+     * @brief Fills in the sphere and normal cone of a meshlet from its triangles.
+     */
+    void computeBounds(Meshlet &meshlet, const Vertex *vertices, const unsigned int *indices, std::vector<glm::vec3> &points)
+    {
+        points.clear();
+        glm::vec3 axis(0.0f);
+        const unsigned int *triangle = indices + meshlet.firstIndex;
+        for (unsigned int t = 0; t < meshlet.triangleCount; ++t, triangle += 3)
+        {
+            const glm::vec3 &a = vertices[triangle[0]].Position;
+            const glm::vec3 &b = vertices[triangle[1]].Position;
+            const glm::vec3 &c = vertices[triangle[2]].Position;
+            points.push_back(a);
+            points.push_back(b);
+            points.push_back(c);
+
+            glm::vec3 normal = glm::cross(b - a, c - a);
+            float length = glm::length(normal);
+            if (length > 0.0f)
+            {
+                axis += normal / length;
+            }
+        }
+        boundingSphere(points, meshlet.center, meshlet.radius);
+
+        // The cone's half-angle comes from the normal furthest from the average one. Past roughly
+        // 84 degrees the meshlet is never entirely back-facing, so the cone is switched off.
+        meshlet.coneAxis = glm::vec3(0.0f);
+        meshlet.coneCutoff = 1.0f;
+        float axisLength = glm::length(axis);
+        if (axisLength <= 0.0f)
+        {
+            return;
+        }
+        axis /= axisLength;
+
+        float minDot = 1.0f;
+        triangle = indices + meshlet.firstIndex;
+        for (unsigned int t = 0; t < meshlet.triangleCount; ++t, triangle += 3)
+        {
+            const glm::vec3 &a = vertices[triangle[0]].Position;
+            glm::vec3 normal = glm::cross(vertices[triangle[1]].Position - a, vertices[triangle[2]].Position - a);
+            float length = glm::length(normal);
+            if (length > 0.0f)
+            {
+                minDot = std::min(minDot, glm::dot(axis, normal / length));
+            }
+        }
+        if (minDot > 0.1f)
+        {
+            meshlet.coneAxis = axis;
+            meshlet.coneCutoff = std::sqrt(1.0f - minDot * minDot);
+        }
+    }
+}
+
+void buildMeshlets(const Vertex *vertices, size_t vertexCount, const unsigned int *indices, size_t indexCount,
+                   MeshletSet &out, const std::vector<IndexRange> *ranges)
+{
+    out = MeshletSet();
+    const size_t triangleCount = indexCount / 3;
+    if (triangleCount == 0)
+    {
+        out.rangeFirstMeshlet.assign(ranges && !ranges->empty() ? ranges->size() + 1 : 2, 0);
+        return;
+    }
+
+    // Triangles where a new range begins, so no meshlet straddles two
+    std::vector<size_t> rangeStarts;
+    if (ranges)
+    {
+        for (const IndexRange &range : *ranges)
+        {
+            rangeStarts.push_back(range.firstIndex / 3);
+        }
+    }
+    if (rangeStarts.empty())
+    {
+        rangeStarts.push_back(0);
+    }
+    size_t nextRange = 1;
+
+    // Greedy split along the existing order; a vertex counts once per meshlet it appears in
+    std::vector<unsigned int> owner(vertexCount, kUnused);
+    Meshlet current = {0, 0, glm::vec3(0.0f), 0.0f, glm::vec3(0.0f), 1.0f};
+    unsigned int currentVertices = 0;
+    out.rangeFirstMeshlet.push_back(0);
+    for (size_t t = 0; t < triangleCount; ++t)
+    {
+        const unsigned int *triangle = indices + t * 3;
+        const unsigned int meshletIndex = static_cast<unsigned int>(out.meshlets.size());
+        unsigned int newVertices = 0;
+        for (int corner = 0; corner < 3; ++corner)
+        {
+            newVertices += owner[triangle[corner]] != meshletIndex ? 1 : 0;
+        }
+        bool rangeStart = false;
+        while (nextRange < rangeStarts.size() && rangeStarts[nextRange] == t)
+        {
+            rangeStart = true;
+            ++nextRange;
+        }
+        if (current.triangleCount == kMeshletMaxTriangles || currentVertices + newVertices > kMeshletMaxVertices ||
+            (rangeStart && current.triangleCount > 0))
+        {
+            out.meshlets.push_back(current);
+            current.firstIndex = static_cast<unsigned int>(t * 3);
+            current.triangleCount = 0;
+            currentVertices = 0;
+        }
+        if (rangeStart)
+        {
+            // Empty ranges before this one get no meshlets
+            while (out.rangeFirstMeshlet.size() < nextRange)
+            {
+                out.rangeFirstMeshlet.push_back(out.meshlets.size());
+            }
+        }
+
+        const unsigned int owned = static_cast<unsigned int>(out.meshlets.size());
+        for (int corner = 0; corner < 3; ++corner)
+        {
+            if (owner[triangle[corner]] != owned)
+            {
+                owner[triangle[corner]] = owned;
+                ++currentVertices;
+            }
+        }
+        ++current.triangleCount;
+    }
+    out.meshlets.push_back(current);
+    while (out.rangeFirstMeshlet.size() <= rangeStarts.size())
+    {
+        out.rangeFirstMeshlet.push_back(out.meshlets.size());
+    }
+
+    std::vector<glm::vec3> points;
+    points.reserve(kMeshletMaxTriangles * 3);
+    const size_t meshletCount = out.meshlets.size();
+    out.centerX.resize(meshletCount);
+    out.centerY.resize(meshletCount);
+    out.centerZ.resize(meshletCount);
+    out.radius.resize(meshletCount);
+    out.axisX.resize(meshletCount);
+    out.axisY.resize(meshletCount);
+    out.axisZ.resize(meshletCount);
+    out.cutoff.resize(meshletCount);
+    for (size_t m = 0; m < meshletCount; ++m)
+    {
+        Meshlet &meshlet = out.meshlets[m];
+        computeBounds(meshlet, vertices, indices, points);
+        out.centerX[m] = meshlet.center.x;
+        out.centerY[m] = meshlet.center.y;
+        out.centerZ[m] = meshlet.center.z;
+        out.radius[m] = meshlet.radius;
+        out.axisX[m] = meshlet.coneAxis.x;
+        out.axisY[m] = meshlet.coneAxis.y;
+        out.axisZ[m] = meshlet.coneAxis.z;
+        out.cutoff[m] = meshlet.coneCutoff;
+    }
+}
+
+void cullMeshlets(const MeshletSet &set, const glm::mat4 &model, const glm::mat4 &view, const glm::mat4 &projection,
+                  const MeshletCullOptions &options, MeshletDrawList &out)
+{
+    const size_t meshletCount = set.meshlets.size();
+    out.counts.clear();
+    out.offsets.clear();
+    out.visible.resize(meshletCount);
+    out.visibleMeshlets = 0;
+    out.visibleTriangles = 0;
+    out.frustumCulled = 0;
+    out.backfaceCulled = 0;
+
+    // Frustum planes in model space, from the rows of projection * view * model (Gribb-Hartmann).
+    // Normalizing them makes the plane distance comparable with the sphere radius.
+    glm::mat4 clip = projection * view * model;
+    float planes[6][4];
+    for (int p = 0; p < 6; ++p)
+    {
+        const int row = p / 2;
+        const float sign = (p % 2 == 0) ? 1.0f : -1.0f;
+        glm::vec4 plane;
+        for (int column = 0; column < 4; ++column)
+        {
+            plane[column] = clip[column][3] + sign * clip[column][row];
+        }
+        float length = glm::length(glm::vec3(plane));
+        plane = length > 0.0f ? plane / length : glm::vec4(0.0f, 0.0f, 0.0f, 1.0f);
+        for (int c = 0; c < 4; ++c)
+        {
+            planes[p][c] = options.frustum ? plane[c] : (c == 3 ? 1.0f : 0.0f);
+        }
+    }
+
+    glm::vec4 eye = glm::inverse(view * model) * glm::vec4(0.0f, 0.0f, 0.0f, 1.0f);
+    const float cameraX = eye.x / eye.w, cameraY = eye.y / eye.w, cameraZ = eye.z / eye.w;
+    const float backface = options.backface ? 1.0f : 0.0f;
+
+    // Branch-free pass over the bounds so the compiler can vectorize it
+    const float *cx = set.centerX.data(), *cy = set.centerY.data(), *cz = set.centerZ.data(), *r = set.radius.data();
+    const float *ax = set.axisX.data(), *ay = set.axisY.data(), *az = set.axisZ.data(), *cut = set.cutoff.data();
+    unsigned char *visible = out.visible.data();
+    size_t frustumCulled = 0, backfaceCulled = 0;
+    for (size_t m = 0; m < meshletCount; ++m)
+    {
+        const float x = cx[m], y = cy[m], z = cz[m], limit = -r[m];
+        unsigned int inside = (planeDistance(planes[0], x, y, z) >= limit ? 1u : 0u) &
+                              (planeDistance(planes[1], x, y, z) >= limit ? 1u : 0u) &
+                              (planeDistance(planes[2], x, y, z) >= limit ? 1u : 0u) &
+                              (planeDistance(planes[3], x, y, z) >= limit ? 1u : 0u) &
+                              (planeDistance(planes[4], x, y, z) >= limit ? 1u : 0u) &
+                              (planeDistance(planes[5], x, y, z) >= limit ? 1u : 0u);
+
+        // dot(d, axis) >= cutoff * |d| + radius, squared to keep sqrt (and its errno branch) out
+        float dx = x - cameraX, dy = y - cameraY, dz = z - cameraZ;
+        float lhs = backface * (dx * ax[m] + dy * ay[m] + dz * az[m]) - r[m];
+        float rhs = cut[m] * cut[m] * (dx * dx + dy * dy + dz * dz);
+        unsigned int back = (lhs >= 0.0f ? 1u : 0u) & (lhs * lhs >= rhs ? 1u : 0u);
+
+        visible[m] = static_cast<unsigned char>(inside & (back ^ 1u));
+        frustumCulled += inside ^ 1u;
+        backfaceCulled += inside & back;
+    }
+    out.frustumCulled = frustumCulled;
+    out.backfaceCulled = backfaceCulled;
+
+    // Meshlets are consecutive in the index buffer, so runs of visible ones collapse into one
+    // draw, as long as the run stays inside one range
+    out.rangeFirstDraw.clear();
+    const size_t rangeCount = set.rangeFirstMeshlet.size() > 1 ? set.rangeFirstMeshlet.size() - 1 : 1;
+    for (size_t r = 0; r < rangeCount; ++r)
+    {
+        out.rangeFirstDraw.push_back(out.counts.size());
+        const size_t first = set.rangeFirstMeshlet.size() > 1 ? set.rangeFirstMeshlet[r] : 0;
+        const size_t last = set.rangeFirstMeshlet.size() > 1 ? set.rangeFirstMeshlet[r + 1] : meshletCount;
+        unsigned int runEnd = kUnused;
+        for (size_t m = first; m < last; ++m)
+        {
+            if (!visible[m])
+            {
+                continue;
+            }
+            const Meshlet &meshlet = set.meshlets[m];
+            const int count = static_cast<int>(meshlet.triangleCount * 3);
+            if (meshlet.firstIndex == runEnd)
+            {
+                out.counts.back() += count;
+            }
+            else
+            {
+                out.counts.push_back(count);
+                out.offsets.push_back(reinterpret_cast<const void *>(static_cast<uintptr_t>(meshlet.firstIndex) * sizeof(unsigned int)));
+            }
+            runEnd = meshlet.firstIndex + meshlet.triangleCount * 3;
+            ++out.visibleMeshlets;
+            out.visibleTriangles += meshlet.triangleCount;
+        }
+    }
+    out.rangeFirstDraw.push_back(out.counts.size());
+}
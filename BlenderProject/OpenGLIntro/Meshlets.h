@@ -0,0 +1,89 @@
+#pragma once
+
+#include "Mesh.h"
+
+#include <cstddef>
+#include <vector>
+
+constexpr unsigned int kMeshletMaxTriangles = 124;
+constexpr unsigned int kMeshletMaxVertices = 64;
+
+/**
+ * @brief A contiguous run of triangles in the index buffer with bounds for culling.
+ */
+struct Meshlet
+{
+    unsigned int firstIndex;
+    unsigned int triangleCount;
+    glm::vec3 center; // Bounding sphere
+    float radius;
+    glm::vec3 coneAxis; // Average facing direction of the triangles
+    float coneCutoff;   // 1 when the triangles face too many ways to ever be back-face culled
+};
+
+/**
+ * @brief Meshlets plus a structure-of-arrays copy of their bounds, laid out so the culling loop
+ * has no branches and vectorizes.
+ */
+struct MeshletSet
+{
+    std::vector<Meshlet> meshlets;
+    // First meshlet of every index range the set was built over, plus the meshlet count at the end
+    std::vector<size_t> rangeFirstMeshlet;
+
+    std::vector<float> centerX, centerY, centerZ, radius;
+    std::vector<float> axisX, axisY, axisZ, cutoff;
+};
+
+/**
+ * @brief The ranges of the index buffer that survived culling, ready for glMultiDrawElements.
+ */
+struct MeshletDrawList
+{
+    std::vector<int> counts;           // Index count per draw
+    std::vector<const void *> offsets; // Byte offset into the EBO per draw
+    std::vector<unsigned char> visible; // Per meshlet, 1 if drawn
+    // First draw of every index range, plus the draw count at the end; draws never span ranges
+    std::vector<size_t> rangeFirstDraw;
+
+    size_t visibleMeshlets = 0;
+    size_t visibleTriangles = 0;
+    size_t frustumCulled = 0;
+    size_t backfaceCulled = 0;
+};
+
+struct MeshletCullOptions
+{
+    bool frustum = true;
+    bool backface = true; // Leave off when drawing wireframe, where back faces stay visible
+};
+
+/**
+ * @brief Splits the index buffer into meshlets of at most kMeshletMaxTriangles triangles and
+ * kMeshletMaxVertices unique vertices, keeping the existing triangle order. Run it after the
+ * vertex cache optimizer so every meshlet is a spatially coherent patch.
+ *
+ * @param vertices The mesh vertices.
+ * @param vertexCount Number of vertices.
+ * @param indices Triangle list indices.
+ * @param indexCount Number of indices.
+ * @param out Receives the meshlets and their bounds.
+ * @param ranges Optional, such as one per material: no meshlet crosses from one range into the
+ * next. The ranges must cover the index buffer in order. Without them it is one range.
+ */
+void buildMeshlets(const Vertex *vertices, size_t vertexCount, const unsigned int *indices, size_t indexCount,
+                   MeshletSet &out, const std::vector<IndexRange> *ranges = nullptr);
+
+/**
+ * @brief Culls meshlets against the view frustum and by normal cone, then merges the visible
+ * ones into as few index ranges as possible.
+ *
+ * @param set Meshlets built by buildMeshlets.
+ * @param model The object's transform; must not contain a non-uniform scale for back-face culling.
+ * @param view The camera view matrix.
+ * @param projection The camera projection matrix.
+ * @param options Which tests to run.
+ * @param out Receives the draw ranges and counters.
+ */
+void cullMeshlets(const MeshletSet &set, const glm::mat4 &model, const glm::mat4 &view, const glm::mat4 &projection,
+                  const MeshletCullOptions &options, MeshletDrawList &out);
@@ -0,0 +1,845 @@
+#include "ObjParser.h"
+#include "MappedFile.h"
+#include "Profiler.h"
+
+#include <algorithm>
+#include <climits>
+#include <cmath>
+#include <cstdint>
+#include <cstdio>
+#include <cstring>
+#include <fstream>
+#include <iostream>
+#include <sstream>
+#include <thread>
+#include <unordered_map>
+
+#ifndef _MSC_VER
+#define sscanf_s sscanf
+#endif
+
+namespace
+{
+    // Powers of ten that are exactly representable as doubles
+    const double kPow10[] = {
+        1e0, 1e1, 1e2, 1e3, 1e4, 1e5, 1e6, 1e7, 1e8, 1e9, 1e10, 1e11,
+        1e12, 1e13, 1e14, 1e15, 1e16, 1e17, 1e18, 1e19, 1e20, 1e21, 1e22};
+
+    inline bool isBlank(char c)
+    {
+        return c == ' ' || c == '\t' || c == '\r';
+    }
+
+    inline bool isDigit(char c)
+    {
+        return static_cast<unsigned char>(c - '0') < 10;
+    }
+
+    inline void skipBlanks(const char *&p, const char *end)
+    {
+        while (p < end && isBlank(*p))
+        {
+            ++p;
+        }
+    }
+
+    inline const char *nextLine(const char *p, const char *end)
+    {
+        const char *newline = static_cast<const char *>(std::memchr(p, '\n', end - p));
+        return newline ? newline + 1 : end;
+    }
+
+    /**
+     * @brief Parses a decimal float such as "-1.25e-3" without going through the C locale.
+     *
+     * Up to 19 significant digits are kept in an integer mantissa and scaled by a power of ten.
+     * The result is exact for up to 15 significant digits, which covers what exporters write,
+     * and within 1 ulp otherwise: longer mantissas and the scaling each round once in double
+     * before the final rounding to float.
+     */
+    bool parseFloat(const char *&p, const char *end, float &out)
+    {
+        skipBlanks(p, end);
+
+        bool negative = false;
+        if (p < end && (*p == '-' || *p == '+'))
+        {
+            negative = *p == '-';
+            ++p;
+        }
+
+        uint64_t mantissa = 0;
+        int significant = 0;
+        int exponent = 0;
+        bool anyDigits = false;
+
+        while (p < end && isDigit(*p))
+        {
+            anyDigits = true;
+            if (significant < 19)
+            {
+                mantissa = mantissa * 10 + (*p - '0');
+                significant += mantissa != 0;
+            }
+            else
+            {
+                ++exponent;
+            }
+            ++p;
+        }
+
+        if (p < end && *p == '.')
+        {
+            ++p;
+            while (p < end && isDigit(*p))
+            {
+                anyDigits = true;
+                if (significant < 19)
+                {
+                    mantissa = mantissa * 10 + (*p - '0');
+                    significant += mantissa != 0;
+                    --exponent;
+                }
+                ++p;
+            }
+        }
+
+        if (!anyDigits)
+        {
+            return false;
+        }
+
+        if (p < end && (*p == 'e' || *p == 'E'))
+        {
+            ++p;
+            bool negativeExponent = false;
+            if (p < end && (*p == '-' || *p == '+'))
+            {
+                negativeExponent = *p == '-';
+                ++p;
+            }
+            if (p >= end || !isDigit(*p))
+            {
+                return false;
+            }
+            int value = 0;
+            while (p < end && isDigit(*p))
+            {
+                if (value < 10000)
+                {
+                    value = value * 10 + (*p - '0');
+                }
+                ++p;
+            }
+            exponent += negativeExponent ? -value : value;
+        }
+
+        double result = static_cast<double>(mantissa);
+        if (mantissa != 0 && exponent != 0)
+        {
+            if (exponent > 0 && exponent <= 22)
+            {
+                result *= kPow10[exponent];
+            }
+            else if (exponent < 0 && exponent >= -22)
+            {
+                result /= kPow10[-exponent];
+            }
+            else
+            {
+                result *= std::pow(10.0, exponent);
+            }
+        }
+
+        out = static_cast<float>(negative ? -result : result);
+        return true;
+    }
+
+    bool parseInt(const char *&p, const char *end, long long &out)
+    {
+        bool negative = false;
+        if (p < end && (*p == '-' || *p == '+'))
+        {
+            negative = *p == '-';
+            ++p;
+        }
+        if (p >= end || !isDigit(*p))
+        {
+            return false;
+        }
+        long long value = 0;
+        while (p < end && isDigit(*p))
+        {
+            // Stop accumulating before overflow; such an index is rejected as out of range anyway
+            if (value < (1LL << 53))
+            {
+                value = value * 10 + (*p - '0');
+            }
+            ++p;
+        }
+        out = negative ? -value : value;
+        return true;
+    }
+
+    // Flags describing how the indices of a RawCorner are stored
+    enum CornerFlags : unsigned char
+    {
+        PositionRelative = 1 << 0,
+        HasTexCoord = 1 << 1,
+        TexCoordRelative = 1 << 2,
+        HasNormal = 1 << 3,
+        NormalRelative = 1 << 4
+    };
+
+    /**
+     * @brief One face corner as written in a chunk, before the chunk's position in the file is known.
+     *
+     * Positive OBJ indices are stored as absolute 0-based indices. Negative (relative) indices are
+     * stored relative to the first element of the chunk and flagged, so they can be fixed up once
+     * the element counts of all earlier chunks are known.
+     */
+    struct RawCorner
+    {
+        int position;
+        int texCoord;
+        int normal;
+        unsigned char flags;
+    };
+
+    /**
+     * @brief Everything parsed out of one line-aligned slice of the file.
+     */
+    struct ObjChunk
+    {
+        const char *begin = nullptr;
+        const char *end = nullptr;
+
+        std::vector<glm::vec3> positions;
+        std::vector<glm::vec3> normals;
+        std::vector<glm::vec2> texCoords;
+        std::vector<RawCorner> corners; // Three per triangle, polygons already fan-triangulated
+
+        // usemtl records with the number of corners read before each one, and mtllib names
+        std::vector<std::pair<size_t, std::string>> materialSwitches;
+        std::vector<std::string> materialLibraries;
+
+        // Element counts of all earlier chunks, filled in by the prefix-sum pass
+        size_t positionBase = 0;
+        size_t normalBase = 0;
+        size_t texCoordBase = 0;
+        size_t cornerBase = 0;
+
+        bool ok = true;
+        size_t errorLine = 0; // Line number within the chunk, 1-based
+        const char *errorLineStart = nullptr;
+        size_t errorTriangle = 0; // Triangle within the chunk whose indices did not resolve
+    };
+
+    // Files smaller than this per extra thread are not worth splitting
+    const size_t kMinChunkBytes = 1 << 20;
+
+    /**
+     * @brief Reads one face index and stores it in the form described by RawCorner.
+     *
+     * @param localCount Number of elements of this kind read so far in the chunk.
+     */
+    inline bool readIndex(const char *&p, const char *end, size_t localCount, int &out, bool &relative)
+    {
+        long long index;
+        if (!parseInt(p, end, index) || index == 0)
+        {
+            return false;
+        }
+        relative = index < 0;
+        long long stored = relative ? static_cast<long long>(localCount) + index : index - 1;
+        if (stored < INT_MIN || stored > INT_MAX)
+        {
+            return false;
+        }
+        out = static_cast<int>(stored);
+        return true;
+    }
+
+    /**
+     * @brief Turns a stored corner index into its final 0-based index.
+     *
+     * @return false if the index falls outside the elements in the file.
+     */
+    inline bool resolveIndex(int stored, bool relative, size_t base, size_t count, size_t &out)
+    {
+        long long index = relative ? static_cast<long long>(base) + stored : static_cast<long long>(stored);
+        if (index < 0 || static_cast<unsigned long long>(index) >= count)
+        {
+            return false;
+        }
+        out = static_cast<size_t>(index);
+        return true;
+    }
+
+    /**
+     * @brief The rest of the line without surrounding blanks, for names that may contain spaces.
+     */
+    std::string restOfLine(const char *p, const char *end)
+    {
+        skipBlanks(p, end);
+        if (p >= end)
+        {
+            return std::string();
+        }
+        const char *lineEnd = static_cast<const char *>(std::memchr(p, '\n', static_cast<size_t>(end - p)));
+        lineEnd = lineEnd ? lineEnd : end;
+        while (lineEnd > p && isBlank(lineEnd[-1]))
+        {
+            --lineEnd;
+        }
+        return std::string(p, lineEnd);
+    }
+
+    inline bool isKeyword(const char *p, const char *end, const char *keyword, size_t length)
+    {
+        return p + length < end && std::memcmp(p, keyword, length) == 0 && isBlank(p[length]);
+    }
+
+    /**
+     * @brief Parses the v, vt, vn, f, usemtl and mtllib records of one chunk into its thread-local buffers.
+     */
+    void parseChunk(ObjChunk &chunk)
+    {
+        const char *end = chunk.end;
+
+        // Typical exporter output averages 30-40 bytes per record; reserving up front avoids
+        // repeated reallocation of the large arrays while parsing
+        const size_t estimatedRecords = static_cast<size_t>(end - chunk.begin) / 32;
+        chunk.positions.reserve(estimatedRecords / 4);
+        chunk.corners.reserve(estimatedRecords);
+
+        std::vector<RawCorner> face;
+        size_t lineNumber = 0;
+        const char *p = chunk.begin;
+        while (p < end)
+        {
+            const char *lineStart = p;
+            ++lineNumber;
+            skipBlanks(p, end);
+
+            bool ok = true;
+            if (p + 1 < end && p[0] == 'v' && isBlank(p[1]))
+            {
+                glm::vec3 position;
+                p += 1;
+                ok = parseFloat(p, end, position.x) && parseFloat(p, end, position.y) && parseFloat(p, end, position.z);
+                chunk.positions.push_back(position);
+            }
+            else if (p + 2 < end && p[0] == 'v' && p[1] == 'n' && isBlank(p[2]))
+            {
+                glm::vec3 normal;
+                p += 2;
+                ok = parseFloat(p, end, normal.x) && parseFloat(p, end, normal.y) && parseFloat(p, end, normal.z);
+                chunk.normals.push_back(normal);
+            }
+            else if (p + 2 < end && p[0] == 'v' && p[1] == 't' && isBlank(p[2]))
+            {
+                glm::vec2 texCoord;
+                p += 2;
+                ok = parseFloat(p, end, texCoord.x) && parseFloat(p, end, texCoord.y);
+                chunk.texCoords.push_back(texCoord);
+            }
+            else if (p + 1 < end && p[0] == 'f' && isBlank(p[1]))
+            {
+                p += 1;
+                face.clear();
+                while (ok)
+                {
+                    skipBlanks(p, end);
+                    if (p >= end || *p == '\n' || *p == '#')
+                    {
+                        break;
+                    }
+
+                    RawCorner corner = {0, 0, 0, 0};
+                    bool relative = false;
+                    ok = readIndex(p, end, chunk.positions.size(), corner.position, relative);
+                    corner.flags |= relative ? PositionRelative : 0;
+                    if (ok && p < end && *p == '/')
+                    {
+                        ++p;
+                        if (p < end && *p != '/')
+                        {
+                            ok = readIndex(p, end, chunk.texCoords.size(), corner.texCoord, relative);
+                            corner.flags |= HasTexCoord | (relative ? TexCoordRelative : 0);
+                        }
+                        if (ok && p < end && *p == '/')
+                        {
+                            ++p;
+                            ok = readIndex(p, end, chunk.normals.size(), corner.normal, relative);
+                            corner.flags |= HasNormal | (relative ? NormalRelative : 0);
+                        }
+                    }
+                    ok = ok && (p >= end || isBlank(*p) || *p == '\n');
+                    face.push_back(corner);
+                }
+                ok = ok && face.size() >= 3;
+
+                for (size_t i = 1; ok && i + 1 < face.size(); ++i)
+                {
+                    chunk.corners.push_back(face[0]);
+                    chunk.corners.push_back(face[i]);
+                    chunk.corners.push_back(face[i + 1]);
+                }
+            }
+            else if (isKeyword(p, end, "usemtl", 6))
+            {
+                chunk.materialSwitches.emplace_back(chunk.corners.size(), restOfLine(p + 6, end));
+            }
+            else if (isKeyword(p, end, "mtllib", 6))
+            {
+                // One file name; exporters write names with spaces unquoted
+                chunk.materialLibraries.push_back(restOfLine(p + 6, end));
+            }
+
+            if (!ok)
+            {
+                chunk.ok = false;
+                chunk.errorLine = lineNumber;
+                chunk.errorLineStart = lineStart;
+                return;
+            }
+
+            p = nextLine(p, end);
+        }
+    }
+
+    /**
+     * @brief Splits [begin, end) into up to count slices that each end just after a newline.
+     */
+    std::vector<ObjChunk> splitChunks(const char *begin, const char *end, size_t count)
+    {
+        std::vector<ObjChunk> chunks;
+        const size_t total = static_cast<size_t>(end - begin);
+        const char *chunkStart = begin;
+        for (size_t i = 1; i <= count && chunkStart < end; ++i)
+        {
+            const char *chunkEnd = end;
+            if (i < count)
+            {
+                const char *target = begin + total / count * i;
+                chunkEnd = target > chunkStart ? nextLine(target, end) : nextLine(chunkStart, end);
+            }
+            ObjChunk chunk;
+            chunk.begin = chunkStart;
+            chunk.end = chunkEnd;
+            chunks.push_back(std::move(chunk));
+            chunkStart = chunkEnd;
+        }
+        return chunks;
+    }
+
+    /**
+     * @brief Calls work(i) for every i in [0, count), one std::thread per item with the
+     * first item run on the calling thread.
+     */
+    template <typename Work>
+    void runOnThreads(size_t count, Work work)
+    {
+        std::vector<std::thread> workers;
+        workers.reserve(count > 0 ? count - 1 : 0);
+        for (size_t i = 1; i < count; ++i)
+        {
+            workers.emplace_back(work, i);
+        }
+        if (count > 0)
+        {
+            work(0);
+        }
+        for (std::thread &worker : workers)
+        {
+            worker.join();
+        }
+    }
+
+    size_t countLines(const char *begin, const char *end)
+    {
+        return static_cast<size_t>(std::count(begin, end, '\n'));
+    }
+
+    /**
+     * @brief Turns the chunks' usemtl records into material ranges over the whole file. A chunk's
+     * faces before its first usemtl carry on with the material the previous chunk ended on.
+     */
+    void collectMaterials(const std::vector<ObjChunk> &chunks, ObjData &out)
+    {
+        out.materialLibraries.clear();
+        out.materialNames.clear();
+        out.materialRanges.clear();
+        std::unordered_map<std::string, unsigned int> ids;
+        auto intern = [&](const std::string &name)
+        {
+            const auto inserted = ids.emplace(name, static_cast<unsigned int>(out.materialNames.size()));
+            if (inserted.second)
+            {
+                out.materialNames.push_back(name);
+            }
+            return inserted.first->second;
+        };
+
+        bool anySwitch = false;
+        for (const ObjChunk &chunk : chunks)
+        {
+            for (const std::string &library : chunk.materialLibraries)
+            {
+                if (std::find(out.materialLibraries.begin(), out.materialLibraries.end(), library) == out.materialLibraries.end())
+                {
+                    out.materialLibraries.push_back(library);
+                }
+            }
+            anySwitch = anySwitch || !chunk.materialSwitches.empty();
+        }
+        if (!anySwitch)
+        {
+            return;
+        }
+
+        std::string current;
+        auto addRange = [&](size_t first, size_t last)
+        {
+            if (last == first)
+            {
+                return;
+            }
+            const unsigned int material = intern(current);
+            ObjMaterialRange *back = out.materialRanges.empty() ? nullptr : &out.materialRanges.back();
+            if (back && back->material == material)
+            {
+                back->cornerCount += last - first;
+            }
+            else
+            {
+                out.materialRanges.push_back({material, first, last - first});
+            }
+        };
+        for (const ObjChunk &chunk : chunks)
+        {
+            size_t start = chunk.cornerBase;
+            for (const std::pair<size_t, std::string> &change : chunk.materialSwitches)
+            {
+                addRange(start, chunk.cornerBase + change.first);
+                start = chunk.cornerBase + change.first;
+                current = change.second;
+            }
+            addRange(start, chunk.cornerBase + chunk.corners.size());
+        }
+    }
+}
+
+bool parseOBJData(const char *begin, const char *end, const std::string &name, ObjData &out,
+                  unsigned int threadCount)
+{
+    if (threadCount == 0)
+    {
+        threadCount = std::max(1u, std::thread::hardware_concurrency());
+    }
+    const size_t bytes = static_cast<size_t>(end - begin);
+    const size_t chunkCount = std::max<size_t>(1, std::min<size_t>(threadCount, bytes / kMinChunkBytes));
+
+    // Parse every chunk into its own buffers
+    std::vector<ObjChunk> chunks = splitChunks(begin, end, chunkCount);
+    runOnThreads(chunks.size(), [&chunks](size_t i)
+    {
+        parseChunk(chunks[i]);
+    });
+
+    // Prefix sums give every chunk the number of elements that come before it in the file
+    size_t positionCount = 0, normalCount = 0, texCoordCount = 0, cornerCount = 0;
+    for (ObjChunk &chunk : chunks)
+    {
+        if (!chunk.ok)
+        {
+            const char *lineEnd = nextLine(chunk.errorLineStart, end);
+            std::cerr << "Error parsing OBJ file: " << name << " (line " << countLines(begin, chunk.begin) + chunk.errorLine << "): "
+                      << std::string(chunk.errorLineStart, lineEnd - chunk.errorLineStart) << std::endl;
+            return false;
+        }
+        chunk.positionBase = positionCount;
+        chunk.normalBase = normalCount;
+        chunk.texCoordBase = texCoordCount;
+        chunk.cornerBase = cornerCount;
+        positionCount += chunk.positions.size();
+        normalCount += chunk.normals.size();
+        texCoordCount += chunk.texCoords.size();
+        cornerCount += chunk.corners.size();
+    }
+    if (positionCount >= kObjNoIndex || normalCount >= kObjNoIndex || texCoordCount >= kObjNoIndex)
+    {
+        std::cerr << "Error parsing OBJ file: " << name << ": too many elements" << std::endl;
+        return false;
+    }
+
+    collectMaterials(chunks, out);
+
+    // Gather the attributes in file order, then resolve every chunk's corners into its slice
+    out.positions.resize(positionCount);
+    out.normals.resize(normalCount);
+    out.texCoords.resize(texCoordCount);
+    out.corners.resize(cornerCount);
+    runOnThreads(chunks.size(), [&](size_t i)
+    {
+        ObjChunk &chunk = chunks[i];
+        std::copy(chunk.positions.begin(), chunk.positions.end(), out.positions.begin() + chunk.positionBase);
+        std::copy(chunk.normals.begin(), chunk.normals.end(), out.normals.begin() + chunk.normalBase);
+        std::copy(chunk.texCoords.begin(), chunk.texCoords.end(), out.texCoords.begin() + chunk.texCoordBase);
+        std::vector<glm::vec3>().swap(chunk.positions);
+        std::vector<glm::vec3>().swap(chunk.normals);
+        std::vector<glm::vec2>().swap(chunk.texCoords);
+
+        ObjCorner *corners = out.corners.data() + chunk.cornerBase;
+        for (size_t c = 0; c < chunk.corners.size(); ++c)
+        {
+            const RawCorner &corner = chunk.corners[c];
+            size_t position, texCoord = kObjNoIndex, normal = kObjNoIndex;
+            bool ok = resolveIndex(corner.position, corner.flags & PositionRelative, chunk.positionBase, positionCount, position);
+            if (corner.flags & HasTexCoord)
+            {
+                ok = ok && resolveIndex(corner.texCoord, corner.flags & TexCoordRelative, chunk.texCoordBase, texCoordCount, texCoord);
+            }
+            if (corner.flags & HasNormal)
+            {
+                ok = ok && resolveIndex(corner.normal, corner.flags & NormalRelative, chunk.normalBase, normalCount, normal);
+            }
+            if (!ok)
+            {
+                chunk.ok = false;
+                chunk.errorTriangle = c / 3;
+                return;
+            }
+
+            corners[c].position = static_cast<unsigned int>(position);
+            corners[c].texCoord = static_cast<unsigned int>(texCoord);
+            corners[c].normal = static_cast<unsigned int>(normal);
+        }
+        std::vector<RawCorner>().swap(chunk.corners);
+    });
+
+    for (const ObjChunk &chunk : chunks)
+    {
+        if (!chunk.ok)
+        {
+            std::cerr << "Error parsing OBJ file: " << name << ": face index out of range in triangle "
+                      << chunk.cornerBase / 3 + chunk.errorTriangle + 1 << std::endl;
+            out = ObjData();
+            return false;
+        }
+    }
+
+    return true;
+}
+
+bool loadOBJData(const std::string &path, ObjData &out, unsigned int threadCount)
+{
+    MappedFile file(path);
+    if (!file.isOpen())
+    {
+        std::cerr << "Failed to open OBJ file: " << path << std::endl;
+        return false;
+    }
+
+    return parseOBJData(file.data(), file.data() + file.size(), path, out, threadCount);
+}
+
+void groupOBJByMaterial(ObjData &data)
+{
+    if (data.materialRanges.size() <= 1)
+    {
+        return;
+    }
+
+    // Corners per material, then where each material starts in the grouped order
+    std::vector<size_t> starts(data.materialNames.size() + 1, 0);
+    for (const ObjMaterialRange &range : data.materialRanges)
+    {
+        starts[range.material + 1] += range.cornerCount;
+    }
+    for (size_t m = 1; m < starts.size(); ++m)
+    {
+        starts[m] += starts[m - 1];
+    }
+
+    std::vector<ObjCorner> grouped(data.corners.size());
+    std::vector<size_t> next(starts.begin(), starts.end() - 1);
+    for (const ObjMaterialRange &range : data.materialRanges)
+    {
+        std::copy(data.corners.begin() + range.firstCorner, data.corners.begin() + range.firstCorner + range.cornerCount,
+                  grouped.begin() + next[range.material]);
+        next[range.material] += range.cornerCount;
+    }
+    data.corners.swap(grouped);
+
+    data.materialRanges.clear();
+    for (unsigned int m = 0; m + 1 < starts.size(); ++m)
+    {
+        if (starts[m + 1] > starts[m])
+        {
+            data.materialRanges.push_back({m, starts[m], starts[m + 1] - starts[m]});
+        }
+    }
+}
+
+bool parseMTL(const char *begin, const char *end, const std::string &name, std::vector<ObjMaterial> &out)
+{
+    size_t lineNumber = 0;
+    ObjMaterial *material = nullptr;
+    for (const char *p = begin; p < end; p = nextLine(p, end))
+    {
+        const char *lineStart = p;
+        ++lineNumber;
+        skipBlanks(p, end);
+
+        bool ok = true;
+        if (isKeyword(p, end, "newmtl", 6))
+        {
+            out.emplace_back();
+            material = &out.back();
+            material->name = restOfLine(p + 6, end);
+        }
+        else if (material && isKeyword(p, end, "Kd", 2))
+        {
+            p += 2;
+            glm::vec3 &kd = material->diffuse;
+            ok = parseFloat(p, end, kd.x) && parseFloat(p, end, kd.y) && parseFloat(p, end, kd.z);
+        }
+        else if (material && isKeyword(p, end, "Ks", 2))
+        {
+            p += 2;
+            glm::vec3 &ks = material->specular;
+            ok = parseFloat(p, end, ks.x) && parseFloat(p, end, ks.y) && parseFloat(p, end, ks.z);
+        }
+        else if (material && isKeyword(p, end, "Ns", 2))
+        {
+            p += 2;
+            ok = parseFloat(p, end, material->shininess);
+        }
+
+        if (!ok)
+        {
+            const char *lineEnd = nextLine(lineStart, end);
+            std::cerr << "Error parsing MTL file: " << name << " (line " << lineNumber << "): "
+                      << std::string(lineStart, lineEnd - lineStart) << std::endl;
+            return false;
+        }
+    }
+    return true;
+}
+
+bool loadMTL(const std::string &path, std::vector<ObjMaterial> &out)
+{
+    MappedFile file(path);
+    if (!file.isOpen())
+    {
+        std::cerr << "Failed to open MTL file: " << path << std::endl;
+        return false;
+    }
+
+    return parseMTL(file.data(), file.data() + file.size(), path, out);
+}
+
+void expandOBJ(const ObjData &data, std::vector<Vertex> &outVertices, std::vector<unsigned int> &outIndices)
+{
+    const size_t firstVertex = outVertices.size();
+    const size_t firstIndex = outIndices.size();
+    outVertices.resize(firstVertex + data.corners.size());
+    outIndices.resize(firstIndex + data.corners.size());
+
+    Vertex *vertices = outVertices.data() + firstVertex;
+    unsigned int *indices = outIndices.data() + firstIndex;
+    for (size_t c = 0; c < data.corners.size(); ++c)
+    {
+        const ObjCorner &corner = data.corners[c];
+        vertices[c].Position = data.positions[corner.position];
+        vertices[c].Normal = corner.normal != kObjNoIndex ? data.normals[corner.normal] : glm::vec3(0.0f);
+        indices[c] = static_cast<unsigned int>(firstVertex + c);
+    }
+}
+
+bool parseOBJ(const char *begin, const char *end, const std::string &name,
+              std::vector<Vertex> &outVertices, std::vector<unsigned int> &outIndices,
+              unsigned int threadCount)
+{
+    PROFILE_FUNCTION();
+    ObjData data;
+    if (!parseOBJData(begin, end, name, data, threadCount))
+    {
+        return false;
+    }
+    expandOBJ(data, outVertices, outIndices);
+    return true;
+}
+
+bool loadOBJ(const std::string &path, std::vector<Vertex> &outVertices, std::vector<unsigned int> &outIndices,
+             unsigned int threadCount)
+{
+    ObjData data;
+    if (!loadOBJData(path, data, threadCount))
+    {
+        return false;
+    }
+    expandOBJ(data, outVertices, outIndices);
+    return true;
+}
+
+bool loadOBJStream(const std::string &path, std::vector<Vertex> &outVertices, std::vector<unsigned int> &outIndices)
+{
+    std::ifstream file(path);
+    if (!file.is_open())
+    {
+        std::cerr << "Failed to open OBJ file: " << path << std::endl;
+        return false;
+    }
+
+    std::vector<glm::vec3> tempPositions;
+    std::vector<glm::vec3> tempNormals;
+    std::vector<glm::vec2> tempTexCoords;
+
+    std::string line;
+    while (std::getline(file, line))
+    {
+        std::istringstream iss(line);
+        std::string prefix;
+        iss >> prefix;
+
+        if (prefix == "v")
+        {
+            glm::vec3 position;
+            iss >> position.x >> position.y >> position.z;
+            tempPositions.push_back(position);
+        }
+        else if (prefix == "vt")
+        {
+            glm::vec2 texCoord;
+            iss >> texCoord.x >> texCoord.y;
+            tempTexCoords.push_back(texCoord);
+        }
+        else if (prefix == "vn")
+        {
+            glm::vec3 normal;
+            iss >> normal.x >> normal.y >> normal.z;
+            tempNormals.push_back(normal);
+        }
+        else if (prefix == "f")
+        {
+            std::string vertexData;
+            unsigned int vertexIndex[3], texCoordIndex[3], normalIndex[3];
+            for (int i = 0; i < 3; ++i)
+            {
+                iss >> vertexData;
+                sscanf_s(vertexData.c_str(), "%d/%d/%d", &vertexIndex[i], &texCoordIndex[i], &normalIndex[i]);
+
+                Vertex vertex;
+                vertex.Position = tempPositions[vertexIndex[i] - 1];
+                vertex.Normal = tempNormals[normalIndex[i] - 1];
+                outVertices.push_back(vertex);
+                outIndices.push_back(static_cast<unsigned int>(outVertices.size() - 1));
+            }
+        }
+    }
+
+    return true;
+}
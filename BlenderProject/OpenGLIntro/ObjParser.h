@@ -0,0 +1,149 @@
+#pragma once
+
+#include "Mesh.h"
+
+#include <string>
+#include <vector>
+
+/**
+ * Sustained throughput, in MB/s of OBJ text, that loadOBJ is expected to reach on a release
+ * build. The "--bench-obj" benchmark compares against this and fails when it falls short.
+ */
+constexpr double kObjParseTargetMBps = 200.0;
+
+// Marks a face corner that has no texture coordinate or normal
+constexpr unsigned int kObjNoIndex = 0xffffffffu;
+
+/**
+ * @brief Resolved 0-based indices of one face corner into the ObjData attribute arrays.
+ */
+struct ObjCorner
+{
+    unsigned int position;
+    unsigned int texCoord; // kObjNoIndex if the corner has none
+    unsigned int normal;   // kObjNoIndex if the corner has none
+};
+
+/**
+ * @brief A run of corners drawn with one material, as selected by usemtl.
+ */
+struct ObjMaterialRange
+{
+    unsigned int material; // Index into ObjData::materialNames
+    size_t firstCorner;
+    size_t cornerCount;
+};
+
+/**
+ * @brief The attribute arrays of an OBJ file plus one ObjCorner per triangle corner.
+ */
+struct ObjData
+{
+    std::vector<glm::vec3> positions;
+    std::vector<glm::vec2> texCoords;
+    std::vector<glm::vec3> normals;
+    std::vector<ObjCorner> corners; // Three per triangle, polygons already fan-triangulated
+
+    std::vector<std::string> materialLibraries; // mtllib file names as written, without repeats
+    std::vector<std::string> materialNames;     // usemtl names in first-use order; "" for faces before the first
+    std::vector<ObjMaterialRange> materialRanges; // Cover every corner in order; empty without usemtl
+};
+
+/**
+ * @brief One newmtl entry of an MTL file. Only the parameters the viewer uses are kept.
+ */
+struct ObjMaterial
+{
+    std::string name;
+    glm::vec3 diffuse = glm::vec3(0.8f); // Kd
+    glm::vec3 specular = glm::vec3(0.0f); // Ks
+    float shininess = 0.0f;               // Ns
+};
+
+/**
+ * @brief Loads an OBJ file by memory-mapping it and tokenizing it in place.
+ *
+ * Supports v, vt, vn and f records. Face corners may be written as v, v/vt, v//vn or v/vt/vn,
+ * with positive or negative (relative) indices, and polygons are fan-triangulated. Every face
+ * corner produces one Vertex and one index, same as before. Corners without a normal get a
+ * zero normal. usemtl and mtllib are read by loadOBJData and ignored here.
+ *
+ * With more than one thread the file is split at line boundaries, each slice is parsed on its
+ * own thread, and a prefix sum over the per-slice element counts fixes up the indices. The
+ * result is byte-identical to a single-threaded load.
+ *
+ * @param path The OBJ file to load.
+ * @param outVertices Receives one vertex per face corner.
+ * @param outIndices Receives the triangle indices into outVertices.
+ * @param threadCount Number of threads to parse with; 0 uses every hardware thread.
+ * @return true if the file was opened and parsed without errors.
+ */
+bool loadOBJ(const std::string &path, std::vector<Vertex> &outVertices, std::vector<unsigned int> &outIndices,
+             unsigned int threadCount = 1);
+
+/**
+ * @brief Parses OBJ text that is already in memory. The text does not need to be null-terminated.
+ *
+ * @param begin Start of the OBJ text.
+ * @param end One past the last character.
+ * @param name Name used in error messages.
+ * @param outVertices Receives one vertex per face corner.
+ * @param outIndices Receives the triangle indices into outVertices.
+ * @param threadCount Number of threads to parse with; 0 uses every hardware thread.
+ * @return true if the text parsed without errors.
+ */
+bool parseOBJ(const char *begin, const char *end, const std::string &name,
+              std::vector<Vertex> &outVertices, std::vector<unsigned int> &outIndices,
+              unsigned int threadCount = 1);
+
+/**
+ * @brief Loads an OBJ file into its attribute arrays and resolved face corners, without building
+ * vertices. Accepts the same input as loadOBJ.
+ *
+ * @param path The OBJ file to load.
+ * @param out Receives the attributes and corners.
+ * @param threadCount Number of threads to parse with; 0 uses every hardware thread.
+ * @return true if the file was opened and parsed without errors.
+ */
+bool loadOBJData(const std::string &path, ObjData &out, unsigned int threadCount = 1);
+
+/**
+ * @brief In-memory version of loadOBJData. The text does not need to be null-terminated.
+ */
+bool parseOBJData(const char *begin, const char *end, const std::string &name, ObjData &out,
+                  unsigned int threadCount = 1);
+
+/**
+ * @brief Reorders the corners so every material's faces are contiguous, leaving one
+ * materialRange per material in first-use order. Faces keep their order within a material.
+ * A counting sort over the ranges, so linear in the number of corners.
+ */
+void groupOBJByMaterial(ObjData &data);
+
+/**
+ * @brief Loads the newmtl, Kd, Ks and Ns records of an MTL file and appends the materials.
+ *
+ * @return true if the file was opened and parsed without errors.
+ */
+bool loadMTL(const std::string &path, std::vector<ObjMaterial> &out);
+
+/**
+ * @brief In-memory version of loadMTL. The text does not need to be null-terminated.
+ */
+bool parseMTL(const char *begin, const char *end, const std::string &name, std::vector<ObjMaterial> &out);
+
+/**
+ * @brief Builds one Vertex and one index per face corner, the layout loadOBJ returns.
+ *
+ * @param data Parsed OBJ data.
+ * @param outVertices Vertices are appended here.
+ * @param outIndices Indices are appended here.
+ */
+void expandOBJ(const ObjData &data, std::vector<Vertex> &outVertices, std::vector<unsigned int> &outIndices);
+
+/**
+ * @brief The original getline/istringstream loader, kept as the reference for benchmarks.
+ *
+ * Only handles triangles written as v/vt/vn.
+ */
+bool loadOBJStream(const std::string &path, std::vector<Vertex> &outVertices, std::vector<unsigned int> &outIndices);
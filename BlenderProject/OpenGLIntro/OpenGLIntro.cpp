@@ -4,119 +4,180 @@
 #include <glm/gtc/matrix_transform.hpp>
 #include <glm/gtc/type_ptr.hpp>
 
+#include <algorithm>
+#include <cmath>
+#include <cstdint>
+#include <cstdlib>
+#include <cstring>
+#include <future>
 #include <iostream>
-#include <fstream>
 #include <sstream>
 #include <vector>
 #include <string>
 
+#include "Benchmarks.h"
+#include "FramePipeline.h"
+#include "Headless.h"
+#include "Instancing.h"
+#include "Mesh.h"
+#include "MeshBvh.h"
+#include "MeshCache.h"
+#include "MeshSimplifier.h"
+#include "Meshlets.h"
+#include "Profiler.h"
+#include "RenderQueue.h"
+#include "SceneTransforms.h"
+#include "ShaderCache.h"
+#include "SoftwareRasterizer.h"
+#include "Telemetry.h"
+#include "ThreadPool.h"
+#include "UploadManager.h"
+#include "VertexQuantization.h"
+
 // Vertex Shader
 const char *vertexShaderSource = R"glsl(
     #version 330 core
     layout (location = 0) in vec3 aPos;  // Vertex position
 
-    uniform mat4 transform;
+    layout (std140) uniform ObjectBlock {
+        mat4 transform;
+    };
 
-    uniform mat4 view;
-    uniform mat4 projection;
+    layout (std140) uniform FrameBlock {
+        mat4 view;
+        mat4 projection;
+    };
 
     void main() {
         gl_Position = projection * view *transform* vec4(aPos, 1.0);
     }
 )glsl";
 
-// Fragment Shader
-const char *fragmentShaderSource = R"glsl(
-        #version 330 core
-        out vec4 color;
-        void main() {
-            color = vec4(1.0, 1.0, 1.0, 1.0); //White Color
-        }
-    )glsl";
+// Vertex Shader for the packed layout: positions are unorm16 against the mesh AABB and
+// normals are either octahedral snorm16 or 10:10:10:2
+const char *packedVertexShaderSource = R"glsl(
+    #version 330 core
+    layout (location = 0) in vec3 aPackedPos;    // Normalized to [0, 1]
+    layout (location = 1) in vec4 aPackedNormal; // xy octahedral, or xyz for 10:10:10:2
 
-unsigned int vertexShader, fragmentShader, shaderProgram;
-/**
- * @brief Compiles the vertex and fragment shaders and links them into a shader program.
- */
-void compileShaders()
-{
+    layout (std140) uniform ObjectBlock {
+        mat4 transform;
+    };
 
-    // Vertex shader
-    vertexShader = glCreateShader(GL_VERTEX_SHADER);
-    glShaderSource(vertexShader, 1, &vertexShaderSource, NULL);
-    glCompileShader(vertexShader);
+    layout (std140) uniform FrameBlock {
+        mat4 view;
+        mat4 projection;
+    };
 
-    // Check for vertex shader compilation errors
-    int success;
-    char infoLog[512];
-    glGetShaderiv(vertexShader, GL_COMPILE_STATUS, &success);
-    if (!success)
-    {
-        glGetShaderInfoLog(vertexShader, 512, NULL, infoLog);
-        std::cerr << "ERROR: vertex compliation failed\n"
-                  << infoLog << std::endl;
-    }
+    uniform vec3 positionScale;
+    uniform vec3 positionBias;
+    uniform bool octahedralNormals;
 
-    // Fragment shader
-    fragmentShader = glCreateShader(GL_FRAGMENT_SHADER);
-    glShaderSource(fragmentShader, 1, &fragmentShaderSource, NULL);
-    glCompileShader(fragmentShader);
+    out vec3 Normal;
 
-    // Check for fragment shader compilation errors
-    glGetShaderiv(fragmentShader, GL_COMPILE_STATUS, &success);
-    if (!success)
-    {
-        glGetShaderInfoLog(fragmentShader, 512, NULL, infoLog);
-        std::cerr << "ERROR: shader compliation failed\n"
-                  << infoLog << std::endl;
+    vec3 decodeOctahedral(vec2 e) {
+        vec3 n = vec3(e, 1.0 - abs(e.x) - abs(e.y));
+        if (n.z < 0.0) {
+            n.xy = (1.0 - abs(n.yx)) * vec2(n.x >= 0.0 ? 1.0 : -1.0, n.y >= 0.0 ? 1.0 : -1.0);
+        }
+        return normalize(n);
     }
 
-    // Link shaders into a program
-    shaderProgram = glCreateProgram();
-    glAttachShader(shaderProgram, vertexShader);
-    glAttachShader(shaderProgram, fragmentShader);
-    glLinkProgram(shaderProgram);
+    void main() {
+        vec3 aPos = aPackedPos * positionScale + positionBias;
+        Normal = octahedralNormals ? decodeOctahedral(aPackedNormal.xy) : normalize(aPackedNormal.xyz);
+        gl_Position = projection * view *transform* vec4(aPos, 1.0);
+    }
+)glsl";
 
-    // Check for linking errors
-    glGetProgramiv(shaderProgram, GL_LINK_STATUS, &success);
-    if (!success)
-    {
-        glGetProgramInfoLog(shaderProgram, 512, NULL, infoLog);
-        std::cerr << "ERROR: shader program linking failed\n"
-                  << infoLog << std::endl;
+// Vertex Shader for instanced drawing: each instance brings either a model matrix in
+// attributes 3-6 or a rotation quaternion in 3 and translation plus uniform scale in 4
+const char *instancedVertexShaderSource = R"glsl(
+    #version 330 core
+    layout (location = 0) in vec3 aPos;
+    layout (location = 3) in vec4 instance0;
+    layout (location = 4) in vec4 instance1;
+    layout (location = 5) in vec4 instance2;
+    layout (location = 6) in vec4 instance3;
+
+    layout (std140) uniform ObjectBlock {
+        mat4 transform;
+    };
+
+    layout (std140) uniform FrameBlock {
+        mat4 view;
+        mat4 projection;
+    };
+
+    uniform bool instanceMatrices;
+
+    vec3 rotate(vec4 q, vec3 v) {
+        return v + 2.0 * cross(q.xyz, cross(q.xyz, v) + q.w * v);
     }
 
-    // Clean up shaders as they're linked into our program now
-    glDeleteShader(vertexShader);
-    glDeleteShader(fragmentShader);
-}
+    void main() {
+        vec3 world;
+        if (instanceMatrices) {
+            world = (mat4(instance0, instance1, instance2, instance3) * vec4(aPos, 1.0)).xyz;
+        } else {
+            world = rotate(instance0, aPos * instance1.w) + instance1.xyz;
+        }
+        gl_Position = projection * view *transform* vec4(world, 1.0);
+    }
+)glsl";
+
+// Fragment Shader: the diffuse colour of the material being drawn
+const char *fragmentShaderSource = R"glsl(
+        #version 330 core
+        layout (std140) uniform MaterialBlock {
+            vec4 diffuse;
+            vec4 specular;
+        };
+        out vec4 color;
+        void main() {
+            color = vec4(diffuse.rgb, 1.0);
+        }
+    )glsl";
+
+unsigned int shaderProgram;
 
 unsigned int VBO[2], VAO[2], EBO;
 
-// Struct to store OBJ data
-struct Vertex
+/**
+ * @brief Creates the EBO for the full index buffer followed by the LOD levels after it. The two
+ * parts can live in separate storage, such as two sections of the mapped mesh cache, and are
+ * streamed from there without being joined first.
+ */
+unsigned int createIndexBuffer(UploadManager &uploads, const unsigned int *indices, size_t indexCount,
+                               const unsigned int *lodIndices, size_t lodIndexCount)
 {
-    glm::vec3 Position;
-    glm::vec3 Normal;
-};
+    const unsigned int buffer = uploads.createBuffer(nullptr, (indexCount + lodIndexCount) * sizeof(unsigned int));
+    uploads.upload(buffer, 0, indices, indexCount * sizeof(unsigned int));
+    if (lodIndexCount > 0)
+    {
+        uploads.upload(buffer, indexCount * sizeof(unsigned int), lodIndices, lodIndexCount * sizeof(unsigned int));
+    }
+    return buffer;
+}
+
 /**
  * @brief Sets up the Vertex Array Object (VAO), Vertex Buffer Object (VBO), and Element Buffer Object (EBO) for the triangle.
+ * The vertices and indices are streamed in chunks straight from the caller's memory.
  */
-void setupBuffers(std::vector<Vertex> vertices, std::vector<unsigned int> indices)
+void setupBuffers(UploadManager &uploads, const Vertex *vertices, size_t vertexCount, const unsigned int *indices, size_t indexCount,
+                  const unsigned int *lodIndices, size_t lodIndexCount)
 {
+    PROFILE_FUNCTION();
     // Setup the VAO, VBO, and EBO
     glGenVertexArrays(1, &VAO[0]);
-    glGenBuffers(1, &VBO[0]);
-    glGenBuffers(1, &EBO);
+    VBO[0] = uploads.createBuffer(vertices, vertexCount * sizeof(Vertex));
+    EBO = createIndexBuffer(uploads, indices, indexCount, lodIndices, lodIndexCount);
 
     // Bind the VAO for the object
     glBindVertexArray(VAO[0]);
 
     glBindBuffer(GL_ARRAY_BUFFER, VBO[0]);
-    glBufferData(GL_ARRAY_BUFFER, vertices.size() * sizeof(Vertex), vertices.data(), GL_STATIC_DRAW);
-
     glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, EBO);
-    glBufferData(GL_ELEMENT_ARRAY_BUFFER, indices.size() * sizeof(unsigned int), indices.data(), GL_STATIC_DRAW);
 
     glVertexAttribPointer(0, 3, GL_FLOAT, GL_FALSE, sizeof(Vertex), (void *)0);
     glEnableVertexAttribArray(0);
@@ -128,72 +189,219 @@ void setupBuffers(std::vector<Vertex> vertices, std::vector<unsigned int> indice
     glBindVertexArray(0);
 }
 
+/**
+ * @brief Same as setupBuffers, for vertices packed by quantizeMesh.
+ */
+void setupPackedBuffers(UploadManager &uploads, const QuantizedMesh &packed, const unsigned int *indices, size_t indexCount,
+                        const unsigned int *lodIndices, size_t lodIndexCount)
+{
+    PROFILE_FUNCTION();
+    glGenVertexArrays(1, &VAO[0]);
+    VBO[0] = uploads.createBuffer(packed.vertices.data(), packed.vertices.size() * sizeof(PackedVertex));
+    EBO = createIndexBuffer(uploads, indices, indexCount, lodIndices, lodIndexCount);
+
+    glBindVertexArray(VAO[0]);
+
+    glBindBuffer(GL_ARRAY_BUFFER, VBO[0]);
+    glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, EBO);
+
+    glVertexAttribPointer(0, 3, GL_UNSIGNED_SHORT, GL_TRUE, sizeof(PackedVertex), (void *)offsetof(PackedVertex, Position));
+    glEnableVertexAttribArray(0);
+    // Normal attribute
+    if (packed.encoding == NormalEncoding::Octahedral16)
+    {
+        glVertexAttribPointer(1, 2, GL_SHORT, GL_TRUE, sizeof(PackedVertex), (void *)offsetof(PackedVertex, Normal));
+    }
+    else
+    {
+        glVertexAttribPointer(1, 4, GL_INT_2_10_10_10_REV, GL_TRUE, sizeof(PackedVertex), (void *)offsetof(PackedVertex, Normal));
+    }
+    glEnableVertexAttribArray(1);
+
+    glBindBuffer(GL_ARRAY_BUFFER, 0);
+    glBindVertexArray(0);
+}
+
+/**
+ * @brief Checks whether a flag such as "--packed-vertices" was passed on the command line.
+ */
+bool hasArgument(int argc, char **argv, const char *flag)
+{
+    for (int i = 1; i < argc; ++i)
+    {
+        if (std::string(argv[i]) == flag)
+        {
+            return true;
+        }
+    }
+    return false;
+}
+
+/**
+ * @brief Returns the value after an option such as "--lod-ratios", or nullptr if it is absent.
+ */
+const char *argumentValue(int argc, char **argv, const char *option)
+{
+    for (int i = 1; i + 1 < argc; ++i)
+    {
+        if (std::string(argv[i]) == option)
+        {
+            return argv[i + 1];
+        }
+    }
+    return nullptr;
+}
+
+/**
+ * @brief Parses a comma-separated list of LOD triangle ratios such as "0.5,0.25,0.125".
+ */
+std::vector<float> parseLodRatios(const char *text)
+{
+    std::vector<float> ratios;
+    std::stringstream stream(text);
+    std::string item;
+    while (std::getline(stream, item, ','))
+    {
+        float ratio = static_cast<float>(std::atof(item.c_str()));
+        if (ratio > 0.0f && ratio < 1.0f)
+        {
+            ratios.push_back(ratio);
+        }
+    }
+    return ratios;
+}
+
+// Keys the viewer reacts to, in the bit order of FrameInput::keys
+const int kInputKeys[] = {GLFW_KEY_W, GLFW_KEY_S, GLFW_KEY_A, GLFW_KEY_D, GLFW_KEY_UP, GLFW_KEY_DOWN, GLFW_KEY_Q,
+                          GLFW_KEY_E, GLFW_KEY_Z, GLFW_KEY_X, GLFW_KEY_C, GLFW_KEY_V, GLFW_KEY_R, GLFW_KEY_F};
+
+/**
+ * @brief Keys and mouse state sampled on the main thread, which is the only thread GLFW lets
+ * read them, and handed to the update thread with the frame.
+ */
+struct FrameInput
+{
+    int frame = 0;
+    float seconds = 0.0f; // glfwGetTime() when the frame was sampled
+    uint32_t keys = 0;    // One bit per entry of kInputKeys that was held down
+    bool click = false;   // The left button went down since the previous frame
+    double cursorX = 0.0;
+    double cursorY = 0.0;
+    int windowWidth = 0;
+    int windowHeight = 0;
+};
+
+/**
+ * @brief Everything the render thread needs to draw one frame, built by the update thread.
+ */
+struct FrameState
+{
+    glm::mat4 transform;
+    glm::mat4 view;
+    glm::mat4 projection;
+    int frame = 0;
+    size_t lod = 0;
+    MeshletDrawList drawList;                 // Meshlets to draw when lod is 0
+    std::vector<unsigned char> instanceBytes; // Instance data in the instance buffer's layout
+};
+
+/**
+ * @brief Reads which of kInputKeys are held down.
+ */
+uint32_t sampleKeys(GLFWwindow *window)
+{
+    uint32_t keys = 0;
+    for (size_t i = 0; i < sizeof(kInputKeys) / sizeof(kInputKeys[0]); ++i)
+    {
+        if (glfwGetKey(window, kInputKeys[i]) == GLFW_PRESS)
+        {
+            keys |= 1u << i;
+        }
+    }
+    return keys;
+}
+
+/**
+ * @brief Checks whether a GLFW key was held down in a mask from sampleKeys.
+ */
+bool keyHeld(uint32_t keys, int key)
+{
+    for (size_t i = 0; i < sizeof(kInputKeys) / sizeof(kInputKeys[0]); ++i)
+    {
+        if (kInputKeys[i] == key)
+        {
+            return (keys >> i) & 1u;
+        }
+    }
+    return false;
+}
+
 /**
  * @brief Processes keyboard input to control the transformations of the triangle.
  *
- * @param window The GLFW window.
+ * @param keys Keys held down this frame, from sampleKeys.
  * @param xOffset The x-axis offset for translation.
  * @param yOffset The y-axis offset for translation.
  * @param angle The angle for rotation.
  * @param scale The scale factor.
  */
-void processInput(GLFWwindow *window, float &xOffset, float &yOffset, float &scale, float &rotationX, float &rotationY, float &rotationZ)
+void processInput(uint32_t keys, float &xOffset, float &yOffset, float &scale, float &rotationX, float &rotationY, float &rotationZ)
 {
-    if (glfwGetKey(window, GLFW_KEY_W) == GLFW_PRESS)
+    if (keyHeld(keys, GLFW_KEY_W))
     {
         yOffset += 0.01f;
     }
-    else if (glfwGetKey(window, GLFW_KEY_S) == GLFW_PRESS)
+    else if (keyHeld(keys, GLFW_KEY_S))
     {
         yOffset -= 0.01f;
     }
-    else if (glfwGetKey(window, GLFW_KEY_A) == GLFW_PRESS)
+    else if (keyHeld(keys, GLFW_KEY_A))
     {
         xOffset -= 0.01f;
     }
-    else if (glfwGetKey(window, GLFW_KEY_D) == GLFW_PRESS)
+    else if (keyHeld(keys, GLFW_KEY_D))
     {
         xOffset += 0.01f;
     }
-    else if (glfwGetKey(window, GLFW_KEY_UP) == GLFW_PRESS)
+    else if (keyHeld(keys, GLFW_KEY_UP))
     {
         xOffset -= 0.01f;
     }
-    else if (glfwGetKey(window, GLFW_KEY_DOWN) == GLFW_PRESS)
+    else if (keyHeld(keys, GLFW_KEY_DOWN))
     {
         xOffset += 0.01f;
     }
 
-    if (glfwGetKey(window, GLFW_KEY_Q) == GLFW_PRESS)
+    if (keyHeld(keys, GLFW_KEY_Q))
     {
         rotationX += 2.0f;
     }
-    else if (glfwGetKey(window, GLFW_KEY_E) == GLFW_PRESS)
+    else if (keyHeld(keys, GLFW_KEY_E))
     {
         rotationX -= 2.0f;
     }
-    if (glfwGetKey(window, GLFW_KEY_Z) == GLFW_PRESS)
+    if (keyHeld(keys, GLFW_KEY_Z))
     {
         rotationY += 2.0f;
     }
-    else if (glfwGetKey(window, GLFW_KEY_X) == GLFW_PRESS)
+    else if (keyHeld(keys, GLFW_KEY_X))
     {
         rotationY -= 2.0f;
     }
-    if (glfwGetKey(window, GLFW_KEY_C) == GLFW_PRESS)
+    if (keyHeld(keys, GLFW_KEY_C))
     {
         rotationZ += 2.0f;
     }
-    else if (glfwGetKey(window, GLFW_KEY_V) == GLFW_PRESS)
+    else if (keyHeld(keys, GLFW_KEY_V))
     {
         rotationZ -= 2.0f;
     }
 
-    if (glfwGetKey(window, GLFW_KEY_R) == GLFW_PRESS)
+    if (keyHeld(keys, GLFW_KEY_R))
     {
         scale += 0.01f;
     }
-    else if (glfwGetKey(window, GLFW_KEY_F) == GLFW_PRESS)
+    else if (keyHeld(keys, GLFW_KEY_F))
     {
         scale -= 0.01f;
     }
@@ -205,183 +413,594 @@ void processInput(GLFWwindow *window, float &xOffset, float &yOffset, float &sca
     }
 }
 
-// Function to load OBJ file
-bool loadOBJ(const std::string &path, std::vector<Vertex> &outVertices, std::vector<unsigned int> &outIndices)
+/**
+ * @brief Replaces processInput in headless runs: moves, spins and zooms the model along a fixed
+ * path so every run renders the same frames.
+ *
+ * @param frame Index of the frame being rendered.
+ */
+void scriptedInput(int frame, float &xOffset, float &yOffset, float &scale, float &rotationX, float &rotationY, float &rotationZ)
 {
-    std::ifstream file(path);
-    if (!file.is_open())
+    const float t = frame / 60.0f;
+    xOffset = 0.5f * std::sin(t);
+    yOffset = 0.3f * std::cos(t * 0.7f);
+    scale = 1.0f + 0.6f * std::sin(t * 0.5f); // Sweeps through the LOD levels
+    rotationX = 20.0f * std::sin(t * 0.3f);
+    rotationY = frame * 2.0f;
+    rotationZ = 0.0f;
+}
+
+/**
+ * @brief Casts a ray from the cursor into the model and prints the triangle under it.
+ *
+ * @param cursorX Cursor x in window coordinates.
+ * @param cursorY Cursor y in window coordinates.
+ * @param width Window width.
+ * @param height Window height.
+ * @param bvh BVH over the model's triangles, in model space.
+ * @param transform Model matrix.
+ * @param view View matrix.
+ * @param projection Projection matrix.
+ */
+void pickAtCursor(double cursorX, double cursorY, int width, int height, const MeshBvh &bvh, const glm::mat4 &transform,
+                  const glm::mat4 &view, const glm::mat4 &projection)
+{
+    if (width <= 0 || height <= 0)
     {
-        std::cerr << "Failed to open OBJ file: " << path << std::endl;
-        return false;
+        return;
     }
 
-    std::vector<glm::vec3> tempPositions;
-    std::vector<glm::vec3> tempNormals;
-    std::vector<glm::vec2> tempTexCoords;
+    // Unproject the cursor onto the near and far planes, straight into model space
+    const float ndcX = static_cast<float>(2.0 * cursorX / width - 1.0);
+    const float ndcY = static_cast<float>(1.0 - 2.0 * cursorY / height);
+    const glm::mat4 toModel = glm::inverse(projection * view * transform);
+    const glm::vec4 nearPoint = toModel * glm::vec4(ndcX, ndcY, -1.0f, 1.0f);
+    const glm::vec4 farPoint = toModel * glm::vec4(ndcX, ndcY, 1.0f, 1.0f);
+    Ray ray;
+    ray.origin = glm::vec3(nearPoint) / nearPoint.w;
+    ray.direction = glm::vec3(farPoint) / farPoint.w - ray.origin;
+    ray.tMax = 1.0f; // The far plane
+
+    RayHit hit;
+    if (bvh.intersect(ray, hit))
+    {
+        const glm::vec3 point = glm::vec3(transform * glm::vec4(ray.origin + ray.direction * hit.t, 1.0f));
+        std::cout << "Picked triangle " << hit.triangle << " at (" << point.x << ", " << point.y << ", " << point.z << ")" << std::endl;
+    }
+    else
+    {
+        std::cout << "Picked nothing" << std::endl;
+    }
+}
 
-    std::string line;
-    while (std::getline(file, line))
+/**
+ * @brief Renders the first frame of the viewer on the CPU and writes it to an image, for
+ * machines without a GPU. Nothing is created through GLFW or OpenGL.
+ *
+ * @param imagePath Output file; PNG if it ends in ".png", otherwise PPM.
+ * @param fill Draw filled, depth-tested triangles instead of the viewer's wireframe.
+ * @return 0 on success, -1 if the model could not be loaded or the image written.
+ */
+int renderSoftware(const char *imagePath, bool fill)
+{
+    CachedMesh mesh;
+    if (!loadMeshWithCache("bottle.obj", mesh, 0))
     {
-        std::istringstream iss(line);
-        std::string prefix;
-        iss >> prefix;
+        return -1;
+    }
 
-        if (prefix == "v")
-        {
-            glm::vec3 position;
-            iss >> position.x >> position.y >> position.z;
-            tempPositions.push_back(position);
-        }
-        else if (prefix == "vt")
+    // Same matrices as the main loop before any input
+    const glm::mat4 transform(1.0f);
+    const glm::mat4 view = glm::translate(glm::mat4(1.0f), glm::vec3(0.0f, 0.0f, -3.0f));
+    const glm::mat4 projection = glm::perspective(glm::radians(45.0f), 800.0f / 600.0f, 0.1f, 100.0f);
+
+    ThreadPool pool;
+    SoftwareRasterizer rasterizer(800, 600);
+    rasterizer.clear(glm::vec3(0.2f, 0.3f, 0.3f));
+    RasterOptions options;
+    options.mode = fill ? RasterMode::Fill : RasterMode::Wireframe;
+    options.depthTest = fill;
+    const RasterStats stats = rasterizer.draw(mesh.vertexData, mesh.vertexCount, mesh.indexData, mesh.indexCount,
+                                              transform, view, projection, options, &pool);
+    std::cout << "Software rasterizer: " << stats.triangles << " triangles, " << stats.pixels << " pixels in "
+              << stats.seconds * 1000.0 << " ms (" << stats.triangles / stats.seconds / 1e6 << " Mtris/s, "
+              << stats.pixels / stats.seconds / 1e6 << " Mpix/s) on " << pool.size() << " threads" << std::endl;
+    return rasterizer.writeImage(imagePath) ? 0 : -1;
+}
+
+int main(int argc, char **argv)
+{
+    if (isBenchmarkCommand(argc, argv))
+    {
+        return runBenchmark(argc, argv);
+    }
+
+    // --software <image> draws one frame with the CPU rasterizer instead of opening a window;
+    // --software-fill draws filled triangles instead of the wireframe
+    const char *softwareImage = argumentValue(argc, argv, "--software");
+    if (softwareImage)
+    {
+        return renderSoftware(softwareImage, hasArgument(argc, argv, "--software-fill"));
+    }
+
+    // --profile <trace.json> records the PROFILE_ZONE markers and writes them as a Chrome trace
+    const char *profilePath = argumentValue(argc, argv, "--profile");
+    if (profilePath && PROFILE_ZONES)
+    {
+        profilerStart();
+        PROFILE_THREAD_NAME("main");
+    }
+    else if (profilePath)
+    {
+        std::cerr << "--profile needs a build with PROFILE_ZONES=1" << std::endl;
+    }
+
+    // --headless renders a fixed number of frames offscreen with scripted input and prints
+    // frame time statistics as JSON, the only thing it writes to stdout
+    const HeadlessOptions headless = parseHeadlessOptions(argc, argv);
+    const HeadlessConsole console(headless);
+    GLFWwindow *window = nullptr;
+    if (headless.enabled)
+    {
+        window = createOffscreenContext(800, 600, "3D Model Loader");
+        if (!window)
         {
-            glm::vec2 texCoord;
-            iss >> texCoord.x >> texCoord.y;
-            tempTexCoords.push_back(texCoord);
+            return -1;
         }
-        else if (prefix == "vn")
+    }
+    else
+    {
+        // Initialize GLFW
+        if (!glfwInit())
         {
-            glm::vec3 normal;
-            iss >> normal.x >> normal.y >> normal.z;
-            tempNormals.push_back(normal);
+            std::cerr << "Failed to initialize GLFW" << std::endl;
+            return -1;
         }
-        else if (prefix == "f")
-        {
-            std::string vertexData;
-            unsigned int vertexIndex[3], texCoordIndex[3], normalIndex[3];
-            for (int i = 0; i < 3; ++i)
-            {
-                iss >> vertexData;
-
-                // Use sscanf_s for secure string parsing if you're on Windows (MSVC).
-                // For cross-platform code, use the safer sscanf version.
-                int matches = sscanf_s(vertexData.c_str(), "%d/%d/%d", &vertexIndex[i], &texCoordIndex[i], &normalIndex[i]);
 
-                // If you want to keep it platform independent, you can still use sscanf but check the return value.
-                // int matches = sscanf(vertexData.c_str(), "%d/%d/%d", &vertexIndex[i], &texCoordIndex[i], &normalIndex[i]);
+        // Configure GLFW
+        glfwWindowHint(GLFW_CONTEXT_VERSION_MAJOR, 3);
+        glfwWindowHint(GLFW_CONTEXT_VERSION_MINOR, 3);
+        glfwWindowHint(GLFW_OPENGL_PROFILE, GLFW_OPENGL_CORE_PROFILE);
 
-                // if (matches != 3) {
-                //     std::cerr << "Error parsing OBJ file: " << path << std::endl;
-                //     return false;
-                // }
+        // Create a windowed mode window and its OpenGL context
+        window = glfwCreateWindow(800, 600, "3D Model Loader", NULL, NULL);
+        if (!window)
+        {
+            std::cerr << "Failed to create GLFW window" << std::endl;
+            glfwTerminate();
+            return -1;
+        }
+        glfwMakeContextCurrent(window);
 
-                Vertex vertex;
-                vertex.Position = tempPositions[vertexIndex[i] - 1];
-                vertex.Normal = tempNormals[normalIndex[i] - 1];
-                outVertices.push_back(vertex);
-                outIndices.push_back(static_cast<unsigned int>(outVertices.size() - 1));
-            }
+        // Initialize GLEW
+        if (glewInit() != GLEW_OK)
+        {
+            std::cerr << "Failed to initialize GLEW" << std::endl;
+            return -1;
         }
     }
 
-    return true;
-}
-
-int main()
-{
-    // Initialize GLFW
-    if (!glfwInit())
+    // Define the viewport dimensions
+    glViewport(0, 0, 800, 600);
+    OffscreenTarget offscreen;
+    if (headless.enabled && !offscreen.create(800, 600))
     {
-        std::cerr << "Failed to initialize GLFW" << std::endl;
         return -1;
     }
 
-    // Configure GLFW
-    glfwWindowHint(GLFW_CONTEXT_VERSION_MAJOR, 3);
-    glfwWindowHint(GLFW_CONTEXT_VERSION_MINOR, 3);
-    glfwWindowHint(GLFW_OPENGL_PROFILE, GLFW_OPENGL_CORE_PROFILE);
+    // --instances N draws N copies of the model on a grid with one instanced draw call per frame;
+    // --instance-matrices sends full model matrices instead of the compact TRS layout
+    const char *instanceArgument = argumentValue(argc, argv, "--instances");
+    const size_t instanceCount = instanceArgument ? static_cast<size_t>(std::max(0, std::atoi(instanceArgument))) : 0;
+    const InstanceFormat instanceFormat = hasArgument(argc, argv, "--instance-matrices") ? InstanceFormat::Matrix : InstanceFormat::CompactTRS;
 
-    // Create a windowed mode window and its OpenGL context
-    GLFWwindow *window = glfwCreateWindow(800, 600, "3D Model Loader", NULL, NULL);
-    if (!window)
+    // --packed-vertices draws from the 12-byte quantized layout instead of the float one
+    bool packedVertices = hasArgument(argc, argv, "--packed-vertices");
+    if (packedVertices && instanceCount > 0)
+    {
+        std::cerr << "--packed-vertices is not available with --instances, using float vertices" << std::endl;
+        packedVertices = false;
+    }
+    // The driver compiles the shaders while the model loads, unless an earlier run cached them
+    ShaderCache shaderCache;
+    const char *modelVertexSource = instanceCount > 0 ? instancedVertexShaderSource : packedVertices ? packedVertexShaderSource : vertexShaderSource;
+    const size_t modelShader = shaderCache.request("model", modelVertexSource, fragmentShaderSource);
+
+    // Load the model and its LOD chain from the binary cache, or parse it on every hardware
+    // thread, simplify it and write the cache. Every level shares the vertex buffer, lives in the
+    // same EBO and keeps each material's faces together.
+    const char *lodRatioArgument = argumentValue(argc, argv, "--lod-ratios");
+    const std::vector<float> lodRatios = lodRatioArgument ? parseLodRatios(lodRatioArgument) : defaultLodRatios();
+    CachedMesh mesh;
+    if (!loadMeshWithCache("bottle.obj", mesh, 0, lodRatios))
     {
-        std::cerr << "Failed to create GLFW window" << std::endl;
-        glfwTerminate();
         return -1;
     }
-    glfwMakeContextCurrent(window);
+    // One draw per material; a mesh without usemtl is one white material
+    std::vector<IndexRange> materialRanges = ::materialRanges(mesh.materialData, mesh.materialCount);
+    std::vector<MaterialUniforms> materials;
+    for (size_t m = 0; m < mesh.materialCount; ++m)
+    {
+        const MeshCacheMaterial &material = mesh.materialData[m];
+        materials.push_back({glm::vec4(material.diffuse[0], material.diffuse[1], material.diffuse[2], 1.0f),
+                             glm::vec4(material.specular[0], material.specular[1], material.specular[2], material.shininess)});
+    }
+    if (materials.empty())
+    {
+        materialRanges.assign(1, IndexRange{0, mesh.indexCount});
+        materials.push_back({glm::vec4(1.0f), glm::vec4(0.0f)});
+    }
+    else
+    {
+        printMeshMaterials("bottle.obj", mesh.materialData, mesh.materialCount);
+    }
 
-    // Initialize GLEW
-    if (glewInit() != GLEW_OK)
+    LodChain &lods = mesh.lods;
+    if (lods.levels.empty())
     {
-        std::cerr << "Failed to initialize GLEW" << std::endl;
-        return -1;
+        // No usable ratios: the chain is the full mesh alone
+        buildLodChain(mesh.vertexData, mesh.vertexCount, mesh.indexData, mesh.indexCount, lodRatios, lods, SimplifyOptions(),
+                      &materialRanges);
+        mesh.lodIndexData = lods.indices.data() + mesh.indexCount;
+        mesh.lodIndexCount = lods.indices.size() - mesh.indexCount;
     }
+    printLodChain("bottle.obj", lods);
 
-    // Define the viewport dimensions
-    glViewport(0, 0, 800, 600);
+    // set object mode to wireframe
+    glPolygonMode(GL_FRONT_AND_BACK, GL_LINE);
+    QuantizedMesh packedMesh;
+    {
+        // The staging ring is only needed while the mesh goes up
+        UploadManager uploads;
+        if (!uploads.create())
+        {
+            return -1;
+        }
+        if (packedVertices)
+        {
+            QuantizationStats quantizationStats;
+            quantizeMesh(mesh.vertexData, mesh.vertexCount, NormalEncoding::Octahedral16, packedMesh, &quantizationStats);
+            printQuantizationStats("bottle.obj", packedMesh.encoding, quantizationStats);
+            setupPackedBuffers(uploads, packedMesh, mesh.indexData, mesh.indexCount, mesh.lodIndexData, mesh.lodIndexCount);
+        }
+        else
+        {
+            setupBuffers(uploads, mesh.vertexData, mesh.vertexCount, mesh.indexData, mesh.indexCount, mesh.lodIndexData,
+                         mesh.lodIndexCount);
+        }
+        printUploadStats("Upload", uploads.stats());
+    }
 
-    compileShaders();
+    // BVH over the full mesh for mouse picking. Nothing needs it before the first click, so it
+    // builds in the background while startup goes on; the first pick waits for it.
+    MeshBvh bvh;
+    std::future<BvhBuildStats> bvhBuild = std::async(std::launch::async, [&bvh, &mesh]()
+    {
+        ThreadPool pool;
+        return bvh.build(mesh.vertexData, mesh.vertexCount, mesh.indexData, mesh.indexCount, &pool);
+    });
+
+    // Split the mesh into meshlets so parts outside the view can be skipped every frame
+    MeshletSet meshlets;
+    buildMeshlets(mesh.vertexData, mesh.vertexCount, mesh.indexData, mesh.indexCount, meshlets, &materialRanges);
+    MeshletCullOptions cullOptions;
+    cullOptions.backface = false; // Back faces stay visible in wireframe
+
+    // Per-instance transforms live in their own buffer, attached to the model's VAO
+    std::vector<InstanceTRS> instances;
+    InstanceBuffer instanceBuffer;
+    if (instanceCount > 0)
+    {
+        makeInstanceGrid(instanceCount, lods.radius * 2.5f, instances);
+        if (!instanceBuffer.create(VAO[0], instanceFormat, instanceCount))
+        {
+            return -1;
+        }
+        std::cout << instanceCount << " instances, " << instanceStride(instanceFormat) << " bytes each, "
+                  << (instanceBuffer.isPersistent() ? "persistently mapped" : "orphaned") << " instance buffer" << std::endl;
+    }
 
-    // Load the model
-    std::vector<Vertex> vertices;
-    std::vector<unsigned int> indices;
-    if (!loadOBJ("bottle.obj", vertices, indices))
+    shaderProgram = shaderCache.program(modelShader);
+    printShaderCacheStats(shaderCache.stats());
+    if (!shaderProgram)
     {
         return -1;
     }
-
-    // set object mode to wireframe
-    glPolygonMode(GL_FRONT_AND_BACK, GL_LINE);
-    setupBuffers(vertices, indices);
+    // View and projection reach the shader through the queue's frame block, the model matrix
+    // through its object block and the colours through its material block
+    RenderQueue renderQueue;
+    renderQueue.create(1);
+    renderQueue.setMaterials(materials.data(), materials.size());
+    renderQueue.attachProgram(shaderProgram);
     glUseProgram(shaderProgram);
-    int transformLoc = glGetUniformLocation(shaderProgram, "transform");
+    glUniform1i(glGetUniformLocation(shaderProgram, "instanceMatrices"), instanceFormat == InstanceFormat::Matrix);
+    if (packedVertices)
+    {
+        glUniform3fv(glGetUniformLocation(shaderProgram, "positionScale"), 1, glm::value_ptr(packedMesh.positionScale));
+        glUniform3fv(glGetUniformLocation(shaderProgram, "positionBias"), 1, glm::value_ptr(packedMesh.positionBias));
+        glUniform1i(glGetUniformLocation(shaderProgram, "octahedralNormals"), packedMesh.encoding == NormalEncoding::Octahedral16);
+    }
 
-    int viewLoc = glGetUniformLocation(shaderProgram, "view");
-    int projLoc = glGetUniformLocation(shaderProgram, "projection");
+    // --pipeline-depth N lets the update run up to N frames ahead of rendering; 0 runs both
+    // in turn on the main thread
+    const char *depthArgument = argumentValue(argc, argv, "--pipeline-depth");
+    const unsigned int pipelineDepth = depthArgument ? static_cast<unsigned int>(std::max(0, std::atoi(depthArgument))) : 1;
 
+    // Input handling, transforms, culling and instance data run on the update thread; GLFW
+    // input and every OpenGL call stay on the main thread
     float xOffset = 0.0f;
     float yOffset = 0.0f;
     float scale = 1.0f;
     float rotationX = 0.0f;
     float rotationY = 0.0f;
     float rotationZ = 0.0f;
-    // Main loop
-    while (!glfwWindowShouldClose(window))
+    TransformSystem scene;
+    const size_t model = scene.add();
+
+    // Diagnostics are written by the telemetry thread, so neither loop waits on the terminal;
+    // --telemetry-binary <file> also writes them to a binary file. The text goes through C stdio,
+    // which HeadlessConsole does not redirect, so headless runs send it to stderr explicitly
+    TelemetryOptions telemetryOptions;
+    telemetryOptions.text = headless.enabled ? stderr : stdout;
+    telemetryOptions.binaryPath = argumentValue(argc, argv, "--telemetry-binary");
+    Telemetry telemetry(telemetryOptions);
+    TelemetryChannel transformChannel(1, 60.0); // Logged by the update thread
+    TelemetryChannel frameChannel(60);          // Logged by the render thread, one frame in 60
+    FrameCounters counters;
+    SubmissionStats submissionStats; // The last frame's, printed at exit
+
+    auto updateFrame = [&](const FrameInput &input, FrameState &state)
     {
+        if (pipelineDepth > 0)
+        {
+            PROFILE_THREAD_NAME("update");
+        }
+        PROFILE_ZONE("update");
+        {
+            PROFILE_ZONE("input");
+            if (headless.enabled)
+            {
+                scriptedInput(input.frame, xOffset, yOffset, scale, rotationX, rotationY, rotationZ);
+            }
+            else
+            {
+                // Update transformation values
+                processInput(input.keys, xOffset, yOffset, scale, rotationX, rotationY, rotationX);
+                // log the values
+                if (transformChannel.admit())
+                {
+                    TelemetryEvent event("transform");
+                    event.add("xOffset", xOffset).add("yOffset", yOffset).add("scale", scale);
+                    event.add("rotationX", rotationX).add("rotationY", rotationY).add("rotationZ", rotationZ);
+                    telemetry.log(event);
+                }
+            }
+        }
+
+        {
+            // The model's world matrix is recomposed only when one of its values changed
+            PROFILE_ZONE("transforms");
+            scene.setTranslation(model, glm::vec3(xOffset, yOffset, 0.0f));
+            scene.setRotation(model, glm::vec3(glm::radians(rotationX), glm::radians(rotationY), glm::radians(rotationZ)));
+            scene.setScale(model, glm::vec3(scale, scale, scale));
+            scene.update();
+            state.frame = input.frame;
+            state.transform = scene.world(model);
+
+            state.view = glm::translate(glm::mat4(1.0f), glm::vec3(0.0f, 0.0f, -3.0f));
+            state.projection = glm::perspective(glm::radians(45.0f), 800.0f / 600.0f, 0.1f, 100.0f);
+        }
+
+        // Left click picks the triangle under the cursor
+        if (input.click)
+        {
+            PROFILE_ZONE("pick");
+            if (bvhBuild.valid())
+            {
+                const BvhBuildStats bvhStats = bvhBuild.get();
+                std::cout << "BVH: " << bvhStats.nodes << " nodes, depth " << bvhStats.depth << ", built in "
+                          << bvhStats.seconds * 1000.0 << " ms" << std::endl;
+            }
+            pickAtCursor(input.cursorX, input.cursorY, input.windowWidth, input.windowHeight, bvh, state.transform, state.view, state.projection);
+        }
 
-        // Update transformation values
-        processInput(window, xOffset, yOffset, scale, rotationX, rotationY, rotationX);
-        // print the values
-        std::cout << "xOffset: " << xOffset << " yOffset: " << yOffset << " scale: " << scale << " rotationX: " << rotationX << " rotationY: " << rotationY << " rotationZ: " << rotationZ << std::endl;
-        glClearColor(0.2f, 0.3f, 0.3f, 1.0f);
-        glClear(GL_COLOR_BUFFER_BIT);
+        // The coarsest LOD that stays within a pixel of the full mesh. The full mesh is drawn as
+        // the meshlets that survive culling.
+        state.lod = selectLod(lods, state.transform, state.view, state.projection, 600.0f);
+        if (instanceCount > 0)
+        {
+            // One LOD for the whole crowd, picked for an instance at the origin
+            PROFILE_ZONE("instance data");
+            updateInstanceRotations(instances.data(), instances.size(), input.seconds);
+            state.instanceBytes.resize(instances.size() * instanceStride(instanceFormat));
+            writeInstances(instances.data(), instances.size(), instanceFormat, state.instanceBytes.data());
+        }
+        else if (state.lod == 0)
+        {
+            PROFILE_ZONE("meshlet culling");
+            cullMeshlets(meshlets, state.transform, state.view, state.projection, cullOptions, state.drawList);
+        }
+    };
+    FramePipeline<FrameInput, FrameState> pipeline(pipelineDepth, updateFrame);
 
-        glm::mat4 transform = glm::mat4(1.0f);
+    FrameTimer frameTimer(headless.enabled ? headless.frames : 0, headless.warmupFrames);
+    int frame = 0;
+    bool mouseWasDown = false;
+    auto sampleInput = [&]()
+    {
+        FrameInput input;
+        input.frame = frame++;
+        input.seconds = static_cast<float>(glfwGetTime());
+        if (!headless.enabled)
+        {
+            input.keys = sampleKeys(window);
+            const bool mouseDown = glfwGetMouseButton(window, GLFW_MOUSE_BUTTON_LEFT) == GLFW_PRESS;
+            input.click = mouseDown && !mouseWasDown;
+            mouseWasDown = mouseDown;
+            glfwGetCursorPos(window, &input.cursorX, &input.cursorY);
+            glfwGetWindowSize(window, &input.windowWidth, &input.windowHeight);
+        }
+        return input;
+    };
 
-        // Apply translation
-        transform = glm::translate(transform, glm::vec3(xOffset, yOffset, 0.0f));
+    // Main loop
+    while (headless.enabled ? !frameTimer.done() : !glfwWindowShouldClose(window))
+    {
+        PROFILE_ZONE("frame");
+        if (headless.enabled)
+        {
+            frameTimer.beginFrame();
+        }
+        {
+            // The first pass queues depth frames ahead of the one drawn; after that one per pass
+            PROFILE_ZONE("sample input");
+            do
+            {
+                pipeline.submit(sampleInput());
+            } while (!pipeline.frameReady());
+        }
 
-        // Apply rotation
-        transform = glm::rotate(transform, glm::radians(rotationX), glm::vec3(1.0f, 0.0f, 0.0f));
-        transform = glm::rotate(transform, glm::radians(rotationY), glm::vec3(0.0f, 1.0f, 0.0f));
-        transform = glm::rotate(transform, glm::radians(rotationZ), glm::vec3(0.0f, 0.0f, 1.0f));
+        const FrameState &state = [&]() -> const FrameState &
+        {
+            PROFILE_ZONE("wait for update");
+            return pipeline.acquire();
+        }();
+        {
+            PROFILE_ZONE("uniforms");
+            glClearColor(0.2f, 0.3f, 0.3f, 1.0f);
+            glClear(GL_COLOR_BUFFER_BIT);
 
+            renderQueue.beginFrame(state.view, state.projection);
+        }
 
-        glm::mat4 view = glm::translate(glm::mat4(1.0f), glm::vec3(0.0f, 0.0f, -3.0f));
-        glm::mat4 projection = glm::perspective(glm::radians(45.0f), 800.0f / 600.0f, 0.1f, 100.0f);
-        
-        // Apply scaling
-        transform = glm::scale(transform, glm::vec3(scale, scale, scale));
-        glUniformMatrix4fv(transformLoc, 1, GL_FALSE, glm::value_ptr(transform));
-        glUniformMatrix4fv(viewLoc, 1, GL_FALSE, glm::value_ptr(view));
-        glUniformMatrix4fv(projLoc, 1, GL_FALSE, glm::value_ptr(projection));
+        {
+            PROFILE_ZONE("draw");
+            DrawPacket packet;
+            packet.program = shaderProgram;
+            packet.vertexArray = VAO[0];
+            packet.object = renderQueue.addObject(state.transform);
+            bool instancesWritten = false;
+            if (instanceCount > 0)
+            {
+                void *instanceData = instanceBuffer.map(instances.size());
+                if (instanceData)
+                {
+                    std::memcpy(instanceData, state.instanceBytes.data(), state.instanceBytes.size());
+                    instanceBuffer.unmap();
+                    instancesWritten = true;
+                    counters.upload(state.instanceBytes.size());
+                }
+            }
+            // The selected level, one packet per material that has faces in it
+            for (size_t r = 0; r < lods.rangesPerLevel; ++r)
+            {
+                const IndexRange &range = lods.ranges[state.lod * lods.rangesPerLevel + r];
+                packet.material = static_cast<unsigned int>(r);
+                packet.firstIndex = range.firstIndex;
+                packet.indexCount = range.indexCount;
+                if (instanceCount > 0)
+                {
+                    if (!instancesWritten || range.indexCount == 0)
+                    {
+                        continue;
+                    }
+                    packet.kind = DrawKind::Instanced;
+                    packet.instanceCount = instances.size();
+                    renderQueue.submit(packet);
+                    counters.draw(range.indexCount / 3 * instances.size());
+                }
+                else if (state.lod == 0)
+                {
+                    // Meshlet draws never span materials, so each material has its own run of them
+                    const size_t firstDraw = state.drawList.rangeFirstDraw[r];
+                    const size_t drawCount = state.drawList.rangeFirstDraw[r + 1] - firstDraw;
+                    if (drawCount == 0)
+                    {
+                        continue;
+                    }
+                    packet.kind = DrawKind::MultiElements;
+                    packet.counts = state.drawList.counts.data() + firstDraw;
+                    packet.offsets = state.drawList.offsets.data() + firstDraw;
+                    packet.drawCount = drawCount;
+                    renderQueue.submit(packet);
+                    size_t visibleIndices = 0;
+                    for (size_t d = firstDraw; d < firstDraw + drawCount; ++d)
+                    {
+                        visibleIndices += static_cast<size_t>(state.drawList.counts[d]);
+                    }
+                    counters.draw(visibleIndices / 3);
+                }
+                else if (range.indexCount > 0)
+                {
+                    renderQueue.submit(packet);
+                    counters.draw(range.indexCount / 3);
+                }
+            }
+            submissionStats = renderQueue.flush();
+            counters.submission(submissionStats.stateChanges(), submissionStats.apiCalls);
+            if (instancesWritten)
+            {
+                instanceBuffer.fence();
+            }
+        }
+        counters.logAndReset(telemetry, frameChannel, state.frame);
+        // The draws have read everything they need from the state
+        pipeline.release();
 
-        // Render the loaded model
-        glBindVertexArray(VAO[0]);
-        glDrawElements(GL_TRIANGLES, indices.size(), GL_UNSIGNED_INT, 0);
+        if (headless.enabled)
+        {
+            PROFILE_ZONE("end frame");
+            frameTimer.endFrame();
+            continue;
+        }
 
         // Swap buffers and poll IO events
-        glfwSwapBuffers(window);
+        {
+            PROFILE_ZONE("swap");
+            glfwSwapBuffers(window);
+        }
+        PROFILE_ZONE("poll events");
         glfwPollEvents();
     }
+    if (profilePath && PROFILE_ZONES)
+    {
+        profilerStop();
+        const long long zones = profilerWriteTrace(profilePath);
+        if (zones < 0)
+        {
+            std::cerr << "Failed to write " << profilePath << std::endl;
+        }
+        else
+        {
+            std::cout << "Profile: " << zones << " zones written to " << profilePath << std::endl;
+        }
+    }
+    telemetry.flush();
+    printPipelineStats(pipeline.stats());
+    printSubmissionStats("Submission", submissionStats);
+    std::cout << "Materials: " << materials.size() << " materials, " << submissionStats.packets << " draws in the last frame"
+              << std::endl;
+    const TelemetryStats telemetryStats = telemetry.stats();
+    std::cout << "Telemetry: " << telemetryStats.logged << " events logged, " << telemetryStats.dropped << " dropped" << std::endl;
+
+    int status = 0;
+    if (headless.enabled)
+    {
+        frameTimer.finish();
+        status = reportHeadlessRun(frameTimer, headless, "BlenderProject");
+    }
 
     // Cleanup
+    frameTimer.destroy();
+    offscreen.destroy();
+    instanceBuffer.destroy();
+    renderQueue.destroy();
     glDeleteVertexArrays(2, VAO);
     glDeleteBuffers(2, VBO);
     glDeleteBuffers(1, &EBO);
-    glDeleteProgram(shaderProgram);
+    shaderCache.destroy();
 
     glfwDestroyWindow(window);
     glfwTerminate();
-    return 0;
+    return status;
 }
\ No newline at end of file
@@ -0,0 +1,209 @@
+#include "Profiler.h"
+
+#include <cstdio>
+#include <memory>
+#include <mutex>
+#include <vector>
+
+namespace
+{
+    struct ZoneRecord
+    {
+        const char *name;
+        uint64_t begin;
+        uint64_t end;
+    };
+
+    // Zones are appended to a list of fixed blocks, so a block never moves once the exporter can
+    // see it and recording never waits on a lock
+    struct ZoneBlock
+    {
+        static constexpr size_t kSize = 4096;
+
+        ZoneRecord records[kSize];
+        std::atomic<size_t> count{0};
+        std::atomic<ZoneBlock *> next{nullptr};
+    };
+
+    struct ThreadBuffer
+    {
+        explicit ThreadBuffer(unsigned int id) : id(id), head(new ZoneBlock), tail(head) {}
+
+        ~ThreadBuffer()
+        {
+            for (ZoneBlock *block = head; block;)
+            {
+                ZoneBlock *next = block->next.load();
+                delete block;
+                block = next;
+            }
+        }
+
+        unsigned int id;
+        std::atomic<const char *> name{nullptr};
+        ZoneBlock *head;
+        ZoneBlock *tail; // Only the owning thread touches tail and recorded
+        size_t recorded = 0;
+        std::atomic<uint64_t> dropped{0};
+    };
+
+    struct Registry
+    {
+        std::mutex mutex;
+        std::vector<std::unique_ptr<ThreadBuffer>> buffers; // Kept after their threads exit
+        uint64_t startTicks = 0;
+        std::chrono::steady_clock::time_point startTime;
+        uint64_t stopTicks = 0;
+        std::chrono::steady_clock::time_point stopTime;
+        bool stopped = false;
+    };
+
+    Registry &registry()
+    {
+        static Registry instance;
+        return instance;
+    }
+
+    ThreadBuffer &threadBuffer()
+    {
+        thread_local ThreadBuffer *buffer = nullptr;
+        if (!buffer)
+        {
+            Registry &r = registry();
+            std::lock_guard<std::mutex> lock(r.mutex);
+            r.buffers.emplace_back(new ThreadBuffer(static_cast<unsigned int>(r.buffers.size()) + 1));
+            buffer = r.buffers.back().get();
+        }
+        return *buffer;
+    }
+
+    void writeEscaped(std::FILE *file, const char *text)
+    {
+        for (; *text; ++text)
+        {
+            if (*text == '"' || *text == '\\')
+            {
+                std::fputc('\\', file);
+            }
+            std::fputc(*text, file);
+        }
+    }
+}
+
+void profilerStart()
+{
+    Registry &r = registry();
+    {
+        std::lock_guard<std::mutex> lock(r.mutex);
+        r.startTime = std::chrono::steady_clock::now();
+        r.startTicks = profileTimestamp();
+        r.stopped = false;
+    }
+    profilerActive().store(true);
+}
+
+void profilerStop()
+{
+    profilerActive().store(false);
+    Registry &r = registry();
+    std::lock_guard<std::mutex> lock(r.mutex);
+    r.stopTime = std::chrono::steady_clock::now();
+    r.stopTicks = profileTimestamp();
+    r.stopped = true;
+}
+
+void profilerSetThreadName(const char *name)
+{
+    if (profilerActive().load(std::memory_order_relaxed))
+    {
+        threadBuffer().name.store(name, std::memory_order_relaxed);
+    }
+}
+
+void profilerRecord(const char *name, uint64_t begin, uint64_t end)
+{
+    ThreadBuffer &buffer = threadBuffer();
+    if (buffer.recorded >= kProfileMaxZonesPerThread)
+    {
+        buffer.dropped.fetch_add(1, std::memory_order_relaxed);
+        return;
+    }
+    ZoneBlock *block = buffer.tail;
+    size_t count = block->count.load(std::memory_order_relaxed);
+    if (count == ZoneBlock::kSize)
+    {
+        ZoneBlock *next = new ZoneBlock;
+        block->next.store(next, std::memory_order_release);
+        buffer.tail = block = next;
+        count = 0;
+    }
+    block->records[count] = {name, begin, end};
+    block->count.store(count + 1, std::memory_order_release);
+    ++buffer.recorded;
+}
+
+long long profilerWriteTrace(const char *path)
+{
+    Registry &r = registry();
+    std::lock_guard<std::mutex> lock(r.mutex);
+
+    // Timestamp ticks per microsecond, measured over the run when they come from the TSC
+    double ticksPerMicrosecond = 1000.0;
+#ifdef PROFILE_RDTSC
+    const uint64_t endTicks = r.stopped ? r.stopTicks : profileTimestamp();
+    const std::chrono::steady_clock::time_point endTime = r.stopped ? r.stopTime : std::chrono::steady_clock::now();
+    const double microseconds = std::chrono::duration<double, std::micro>(endTime - r.startTime).count();
+    if (microseconds > 0.0 && endTicks > r.startTicks)
+    {
+        ticksPerMicrosecond = (endTicks - r.startTicks) / microseconds;
+    }
+#endif
+
+    std::FILE *file = std::fopen(path, "w");
+    if (!file)
+    {
+        return -1;
+    }
+    std::fputs("{\"displayTimeUnit\":\"ms\",\"traceEvents\":[\n", file);
+    long long zones = 0;
+    uint64_t dropped = 0;
+    bool first = true;
+    for (const std::unique_ptr<ThreadBuffer> &buffer : r.buffers)
+    {
+        if (const char *name = buffer->name.load(std::memory_order_relaxed))
+        {
+            std::fprintf(file, "%s{\"name\":\"thread_name\",\"ph\":\"M\",\"pid\":1,\"tid\":%u,\"args\":{\"name\":\"", first ? "" : ",\n", buffer->id);
+            writeEscaped(file, name);
+            std::fputs("\"}}", file);
+            first = false;
+        }
+        for (const ZoneBlock *block = buffer->head; block; block = block->next.load(std::memory_order_acquire))
+        {
+            const size_t count = block->count.load(std::memory_order_acquire);
+            for (size_t i = 0; i < count; ++i)
+            {
+                const ZoneRecord &zone = block->records[i];
+                // Zones from before the last profilerStart() would land at negative times
+                if (zone.begin < r.startTicks)
+                {
+                    continue;
+                }
+                std::fprintf(file, "%s{\"name\":\"", first ? "" : ",\n");
+                writeEscaped(file, zone.name);
+                std::fprintf(file, "\",\"ph\":\"X\",\"pid\":1,\"tid\":%u,\"ts\":%.3f,\"dur\":%.3f}", buffer->id,
+                             (zone.begin - r.startTicks) / ticksPerMicrosecond, (zone.end - zone.begin) / ticksPerMicrosecond);
+                first = false;
+                ++zones;
+            }
+        }
+        dropped += buffer->dropped.load(std::memory_order_relaxed);
+    }
+    std::fputs("\n]}\n", file);
+    const bool ok = std::fclose(file) == 0;
+    if (dropped > 0)
+    {
+        std::fprintf(stderr, "Profiler: %llu zones dropped after %zu per thread\n", static_cast<unsigned long long>(dropped),
+                     kProfileMaxZonesPerThread);
+    }
+    return ok ? zones : -1;
+}
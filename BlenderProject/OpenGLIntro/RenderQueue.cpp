@@ -0,0 +1,277 @@
+#include "RenderQueue.h"
+#include "Profiler.h"
+
+#include <GL/glew.h>
+#include <glm/gtc/type_ptr.hpp>
+
+#include <algorithm>
+#include <cstdint>
+#include <cstring>
+#include <iostream>
+
+static_assert(sizeof(FrameUniforms) == 128, "FrameUniforms must match the std140 FrameBlock");
+static_assert(sizeof(ObjectUniforms) == 64, "ObjectUniforms must match the std140 ObjectBlock");
+static_assert(sizeof(MaterialUniforms) == 32, "MaterialUniforms must match the std140 MaterialBlock");
+
+namespace
+{
+    size_t uniformStride(size_t size)
+    {
+        // Every glBindBufferRange offset has to be a multiple of the alignment
+        GLint alignment = 0;
+        glGetIntegerv(GL_UNIFORM_BUFFER_OFFSET_ALIGNMENT, &alignment);
+        const size_t align = static_cast<size_t>(std::max(alignment, 1));
+        return (size + align - 1) / align * align;
+    }
+}
+
+uint64_t drawSortKey(const DrawPacket &packet, uint32_t sequence)
+{
+    return (static_cast<uint64_t>(packet.program & 0xFFFFu) << 48) | (static_cast<uint64_t>(packet.vertexArray & 0xFFFFu) << 32) |
+           (static_cast<uint64_t>(packet.material & 0xFFFFu) << 16) | (sequence & 0xFFFFu);
+}
+
+void printSubmissionStats(const char *label, const SubmissionStats &stats)
+{
+    std::cout << label << ": " << stats.packets << " packets, " << stats.stateChanges() << " state changes ("
+              << stats.programBinds << " program, " << stats.vertexArrayBinds << " vertex array, " << stats.objectBinds
+              << " object, " << stats.materialBinds << " material), " << stats.redundantSkipped << " redundant binds skipped, " << stats.apiCalls << " GL calls"
+              << std::endl;
+}
+
+RenderQueue::~RenderQueue()
+{
+    destroy();
+}
+
+void RenderQueue::create(size_t objectCapacity)
+{
+    destroy();
+    maxObjects = std::max<size_t>(objectCapacity, 1);
+
+    stride = uniformStride(sizeof(ObjectUniforms));
+    objects.assign(maxObjects * stride, 0);
+
+    glGenBuffers(1, &frameBuffer);
+    glBindBuffer(GL_UNIFORM_BUFFER, frameBuffer);
+    glBufferData(GL_UNIFORM_BUFFER, sizeof(FrameUniforms), NULL, GL_DYNAMIC_DRAW);
+    glGenBuffers(1, &objectBuffer);
+    glBindBuffer(GL_UNIFORM_BUFFER, objectBuffer);
+    glBufferData(GL_UNIFORM_BUFFER, static_cast<GLsizeiptr>(maxObjects * stride * kRenderQueueRegions), NULL, GL_STREAM_DRAW);
+    glBindBuffer(GL_UNIFORM_BUFFER, 0);
+
+    // The frame block never moves, so it is bound once here
+    glBindBufferBase(GL_UNIFORM_BUFFER, kFrameBlockBinding, frameBuffer);
+}
+
+void RenderQueue::setMaterials(const MaterialUniforms *materials, size_t count)
+{
+    if (materialBuffer)
+    {
+        glDeleteBuffers(1, &materialBuffer);
+        materialBuffer = 0;
+    }
+    materialCount = count;
+    if (count == 0)
+    {
+        return;
+    }
+
+    materialStride = uniformStride(sizeof(MaterialUniforms));
+    std::vector<unsigned char> table(count * materialStride, 0);
+    for (size_t m = 0; m < count; ++m)
+    {
+        std::memcpy(table.data() + m * materialStride, &materials[m], sizeof(MaterialUniforms));
+    }
+    glGenBuffers(1, &materialBuffer);
+    glBindBuffer(GL_UNIFORM_BUFFER, materialBuffer);
+    glBufferData(GL_UNIFORM_BUFFER, static_cast<GLsizeiptr>(table.size()), table.data(), GL_STATIC_DRAW);
+    glBindBuffer(GL_UNIFORM_BUFFER, 0);
+}
+
+bool RenderQueue::attachProgram(unsigned int program) const
+{
+    const GLuint frameBlock = glGetUniformBlockIndex(program, "FrameBlock");
+    const GLuint objectBlock = glGetUniformBlockIndex(program, "ObjectBlock");
+    const GLuint materialBlock = glGetUniformBlockIndex(program, "MaterialBlock");
+    if (frameBlock != GL_INVALID_INDEX)
+    {
+        glUniformBlockBinding(program, frameBlock, kFrameBlockBinding);
+    }
+    if (objectBlock != GL_INVALID_INDEX)
+    {
+        glUniformBlockBinding(program, objectBlock, kObjectBlockBinding);
+    }
+    if (materialBlock != GL_INVALID_INDEX)
+    {
+        glUniformBlockBinding(program, materialBlock, kMaterialBlockBinding);
+    }
+    return frameBlock != GL_INVALID_INDEX || objectBlock != GL_INVALID_INDEX || materialBlock != GL_INVALID_INDEX;
+}
+
+void RenderQueue::beginFrame(const glm::mat4 &view, const glm::mat4 &projection)
+{
+    FrameUniforms frame;
+    frame.view = view;
+    frame.projection = projection;
+    glBindBuffer(GL_UNIFORM_BUFFER, frameBuffer);
+    glBufferSubData(GL_UNIFORM_BUFFER, 0, sizeof(frame), &frame);
+    counters.apiCalls += 2;
+    ++counters.uploads;
+    objectCount = 0;
+}
+
+size_t RenderQueue::addObject(const glm::mat4 &transform)
+{
+    if (objectCount == maxObjects)
+    {
+        return SIZE_MAX;
+    }
+    std::memcpy(objects.data() + objectCount * stride, glm::value_ptr(transform), sizeof(ObjectUniforms));
+    return objectCount++;
+}
+
+void RenderQueue::submit(const DrawPacket &packet)
+{
+    if (packet.object >= objectCount)
+    {
+        std::cerr << "Draw packet refers to object " << packet.object << " of " << objectCount << std::endl;
+        return;
+    }
+    if (materialCount > 0 && packet.material >= materialCount)
+    {
+        std::cerr << "Draw packet refers to material " << packet.material << " of " << materialCount << std::endl;
+        return;
+    }
+    packets.push_back(packet);
+}
+
+SubmissionStats RenderQueue::flush()
+{
+    PROFILE_FUNCTION();
+    SubmissionStats stats = counters;
+    counters = SubmissionStats();
+    stats.packets = packets.size();
+
+    // This frame's objects go into the next section in one write
+    const size_t regionOffset = region * maxObjects * stride;
+    if (objectCount > 0)
+    {
+        glBindBuffer(GL_UNIFORM_BUFFER, objectBuffer);
+        glBufferSubData(GL_UNIFORM_BUFFER, static_cast<GLintptr>(regionOffset), static_cast<GLsizeiptr>(objectCount * stride),
+                        objects.data());
+        stats.apiCalls += 2;
+        ++stats.uploads;
+    }
+
+    order.clear();
+    for (size_t i = 0; i < packets.size(); ++i)
+    {
+        order.push_back({drawSortKey(packets[i], static_cast<uint32_t>(i)), static_cast<uint32_t>(i)});
+    }
+    std::sort(order.begin(), order.end(), [](const SortedPacket &a, const SortedPacket &b)
+              { return a.key != b.key ? a.key < b.key : a.index < b.index; });
+
+    // Nothing is known to be bound until the first packet binds it
+    bool bound = false;
+    unsigned int boundProgram = 0;
+    unsigned int boundVertexArray = 0;
+    size_t boundObject = 0;
+    unsigned int boundMaterial = 0;
+    for (const SortedPacket &sorted : order)
+    {
+        const DrawPacket &packet = packets[sorted.index];
+        if (!bound || packet.program != boundProgram)
+        {
+            glUseProgram(packet.program);
+            boundProgram = packet.program;
+            ++stats.programBinds;
+        }
+        else
+        {
+            ++stats.redundantSkipped;
+        }
+        if (!bound || packet.vertexArray != boundVertexArray)
+        {
+            glBindVertexArray(packet.vertexArray);
+            boundVertexArray = packet.vertexArray;
+            ++stats.vertexArrayBinds;
+        }
+        else
+        {
+            ++stats.redundantSkipped;
+        }
+        if (!bound || packet.object != boundObject)
+        {
+            glBindBufferRange(GL_UNIFORM_BUFFER, kObjectBlockBinding, objectBuffer,
+                              static_cast<GLintptr>(regionOffset + packet.object * stride), sizeof(ObjectUniforms));
+            boundObject = packet.object;
+            ++stats.objectBinds;
+        }
+        else
+        {
+            ++stats.redundantSkipped;
+        }
+        if (materialBuffer)
+        {
+            if (!bound || packet.material != boundMaterial)
+            {
+                glBindBufferRange(GL_UNIFORM_BUFFER, kMaterialBlockBinding, materialBuffer,
+                                  static_cast<GLintptr>(packet.material * materialStride), sizeof(MaterialUniforms));
+                boundMaterial = packet.material;
+                ++stats.materialBinds;
+            }
+            else
+            {
+                ++stats.redundantSkipped;
+            }
+        }
+        bound = true;
+
+        switch (packet.kind)
+        {
+        case DrawKind::Elements:
+            glDrawElements(GL_TRIANGLES, static_cast<GLsizei>(packet.indexCount), GL_UNSIGNED_INT,
+                           reinterpret_cast<const void *>(packet.firstIndex * sizeof(unsigned int)));
+            break;
+        case DrawKind::MultiElements:
+            glMultiDrawElements(GL_TRIANGLES, packet.counts, GL_UNSIGNED_INT, packet.offsets, static_cast<GLsizei>(packet.drawCount));
+            break;
+        case DrawKind::Instanced:
+            glDrawElementsInstanced(GL_TRIANGLES, static_cast<GLsizei>(packet.indexCount), GL_UNSIGNED_INT,
+                                    reinterpret_cast<const void *>(packet.firstIndex * sizeof(unsigned int)),
+                                    static_cast<GLsizei>(packet.instanceCount));
+            break;
+        }
+    }
+    stats.apiCalls += stats.stateChanges() + packets.size();
+
+    packets.clear();
+    objectCount = 0;
+    region = (region + 1) % kRenderQueueRegions;
+    return stats;
+}
+
+void RenderQueue::destroy()
+{
+    if (frameBuffer)
+    {
+        glDeleteBuffers(1, &frameBuffer);
+        frameBuffer = 0;
+    }
+    if (objectBuffer)
+    {
+        glDeleteBuffers(1, &objectBuffer);
+        objectBuffer = 0;
+    }
+    if (materialBuffer)
+    {
+        glDeleteBuffers(1, &materialBuffer);
+        materialBuffer = 0;
+    }
+    materialCount = 0;
+    packets.clear();
+    objectCount = 0;
+    region = 0;
+    counters = SubmissionStats();
+}
@@ -0,0 +1,186 @@
+#pragma once
+
+#include <glm/glm.hpp>
+
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+// Uniform block bindings shared by every program the queue draws with
+constexpr unsigned int kFrameBlockBinding = 0;
+constexpr unsigned int kObjectBlockBinding = 1;
+constexpr unsigned int kMaterialBlockBinding = 2;
+
+// Sections of the per-object uniform buffer, so a frame's writes never land on data an earlier
+// frame's draws may still be reading
+constexpr unsigned int kRenderQueueRegions = 3;
+
+/**
+ * @brief std140 layout of the FrameBlock uniform block, written once per frame.
+ */
+struct FrameUniforms
+{
+    glm::mat4 view;
+    glm::mat4 projection;
+};
+
+/**
+ * @brief std140 layout of the ObjectBlock uniform block, one per object.
+ */
+struct ObjectUniforms
+{
+    glm::mat4 transform;
+};
+
+/**
+ * @brief std140 layout of the MaterialBlock uniform block, one per material.
+ */
+struct MaterialUniforms
+{
+    glm::vec4 diffuse;  // rgb, w unused
+    glm::vec4 specular; // rgb, shininess in w
+};
+
+/**
+ * @brief How a DrawPacket draws its indices.
+ */
+enum class DrawKind : uint8_t
+{
+    Elements,      // glDrawElements over firstIndex and indexCount
+    MultiElements, // glMultiDrawElements over counts and offsets
+    Instanced      // glDrawElementsInstanced, instanceCount copies of firstIndex and indexCount
+};
+
+/**
+ * @brief One draw, with the state it needs. Every index buffer holds 32-bit triangle lists.
+ */
+struct DrawPacket
+{
+    unsigned int program = 0;
+    unsigned int vertexArray = 0;
+    unsigned int material = 0; // Index into setMaterials(); same-material packets draw together
+    size_t object = 0;         // From RenderQueue::addObject
+    DrawKind kind = DrawKind::Elements;
+    size_t firstIndex = 0;
+    size_t indexCount = 0;
+    size_t instanceCount = 0;
+    // MultiElements only; the arrays must stay alive until flush()
+    const int *counts = nullptr;
+    const void *const *offsets = nullptr;
+    size_t drawCount = 0;
+};
+
+/**
+ * @brief Sort key for a packet: program in the top 16 bits, then vertex array, then material,
+ * then the order it was submitted in. Names that do not fit in 16 bits only change the order.
+ */
+uint64_t drawSortKey(const DrawPacket &packet, uint32_t sequence);
+
+/**
+ * @brief What one flush() sent to OpenGL.
+ */
+struct SubmissionStats
+{
+    size_t packets = 0;
+    size_t programBinds = 0;
+    size_t vertexArrayBinds = 0;
+    size_t objectBinds = 0;      // glBindBufferRange on the object block
+    size_t materialBinds = 0;    // glBindBufferRange on the material block
+    size_t redundantSkipped = 0; // Binds the state cache found already in place
+    size_t uploads = 0;          // Uniform buffer writes
+    size_t apiCalls = 0;         // Every GL call, draws included
+
+    size_t stateChanges() const { return programBinds + vertexArrayBinds + objectBinds + materialBinds; }
+};
+
+/**
+ * @brief Prints a flush's packets, state changes and GL calls on one line.
+ */
+void printSubmissionStats(const char *label, const SubmissionStats &stats);
+
+/**
+ * @brief Collects a frame's draws, sorts them by state and submits them with as few state changes
+ * as it can.
+ *
+ * View and projection go into one uniform buffer written once per frame. Object transforms are
+ * packed into a second uniform buffer split into kRenderQueueRegions sections, written with one
+ * call per frame and bound per draw with glBindBufferRange. Programs read both through the
+ * FrameBlock and ObjectBlock std140 uniform blocks. Materials, when set, live in a third buffer
+ * that does not change between frames and is read through the MaterialBlock.
+ *
+ * flush() remembers the program, vertex array, object range and material range it has bound and
+ * skips binding them again. It assumes nothing about the state other code left behind, so the
+ * first draw of every flush binds them all. It leaves the program and vertex array bound.
+ */
+class RenderQueue
+{
+public:
+    RenderQueue() = default;
+    RenderQueue(const RenderQueue &) = delete;
+    RenderQueue &operator=(const RenderQueue &) = delete;
+    ~RenderQueue();
+
+    /**
+     * @brief Creates both uniform buffers and binds the frame block.
+     *
+     * @param maxObjects Most objects added in one frame.
+     */
+    void create(size_t maxObjects);
+
+    /**
+     * @brief Writes the material table that DrawPacket::material indexes, replacing any earlier one.
+     */
+    void setMaterials(const MaterialUniforms *materials, size_t count);
+
+    /**
+     * @brief Points a program's FrameBlock, ObjectBlock and MaterialBlock at the queue's bindings.
+     * Call once per program, after it is linked.
+     *
+     * @return false if the program uses none of the blocks.
+     */
+    bool attachProgram(unsigned int program) const;
+
+    /**
+     * @brief Starts a frame and writes its view and projection.
+     */
+    void beginFrame(const glm::mat4 &view, const glm::mat4 &projection);
+
+    /**
+     * @brief Adds an object for this frame's packets to draw.
+     *
+     * @return The object's index for DrawPacket::object, or SIZE_MAX when the frame is full.
+     */
+    size_t addObject(const glm::mat4 &transform);
+
+    void submit(const DrawPacket &packet);
+
+    /**
+     * @brief Uploads the objects, sorts the packets and draws them, then empties the queue.
+     */
+    SubmissionStats flush();
+
+    void destroy();
+
+    size_t objectStride() const { return stride; }
+
+private:
+    struct SortedPacket
+    {
+        uint64_t key;
+        uint32_t index;
+    };
+
+    unsigned int frameBuffer = 0;
+    unsigned int objectBuffer = 0;
+    unsigned int materialBuffer = 0;
+    size_t materialCount = 0;
+    size_t materialStride = 0;
+    size_t maxObjects = 0;
+    size_t stride = 0; // sizeof(ObjectUniforms) rounded up to the uniform offset alignment
+    unsigned int region = 0;
+    std::vector<unsigned char> objects; // This frame's objects, stride apart
+    size_t objectCount = 0;
+    std::vector<DrawPacket> packets;
+    std::vector<SortedPacket> order;
+    SubmissionStats counters; // Since the last flush, beginFrame's upload included
+};
@@ -0,0 +1,302 @@
+#include "SceneTransforms.h"
+#include "ThreadPool.h"
+
+#include <algorithm>
+#include <cmath>
+#include <cstring>
+
+#if defined(_M_X64) || defined(_M_IX86) || defined(__x86_64__) || defined(__i386__)
+#define TRANSFORMS_X86 1
+#include <immintrin.h>
+#if defined(_MSC_VER)
+#include <intrin.h>
+#define TRANSFORMS_AVX_TARGET
+#else
+#define TRANSFORMS_AVX_TARGET __attribute__((target("avx")))
+#endif
+#endif
+
+namespace
+{
+    /**
+     * @brief Raw pointers into the structure-of-arrays state for the kernels.
+     */
+    struct TransformArrays
+    {
+        const float *tx, *ty, *tz;
+        const float *sa, *ca, *sb, *cb, *sc, *cc; // sin/cos of the X, Y and Z angles
+        const float *sx, *sy, *sz;
+        float *out; // 16 floats per object, column-major
+    };
+
+    /**
+     * @brief translate * rotateX(a) * rotateY(b) * rotateZ(c) * scale, written out in closed form.
+     */
+    void composeScalar(const TransformArrays &s, size_t i)
+    {
+        const float sa = s.sa[i], ca = s.ca[i], sb = s.sb[i], cb = s.cb[i], sc = s.sc[i], cc = s.cc[i];
+        float *m = s.out + i * 16;
+        m[0] = cb * cc * s.sx[i];
+        m[1] = (sa * sb * cc + ca * sc) * s.sx[i];
+        m[2] = (sa * sc - ca * sb * cc) * s.sx[i];
+        m[3] = 0.0f;
+        m[4] = -cb * sc * s.sy[i];
+        m[5] = (ca * cc - sa * sb * sc) * s.sy[i];
+        m[6] = (ca * sb * sc + sa * cc) * s.sy[i];
+        m[7] = 0.0f;
+        m[8] = sb * s.sz[i];
+        m[9] = -sa * cb * s.sz[i];
+        m[10] = ca * cb * s.sz[i];
+        m[11] = 0.0f;
+        m[12] = s.tx[i];
+        m[13] = s.ty[i];
+        m[14] = s.tz[i];
+        m[15] = 1.0f;
+    }
+
+#ifdef TRANSFORMS_X86
+    /**
+     * @brief Four objects at once. Each matrix element is computed for all four, then every
+     * column is transposed out of the lanes into its object's matrix.
+     */
+    void composeSSE(const TransformArrays &s, size_t i)
+    {
+        const __m128 sa = _mm_loadu_ps(s.sa + i), ca = _mm_loadu_ps(s.ca + i);
+        const __m128 sb = _mm_loadu_ps(s.sb + i), cb = _mm_loadu_ps(s.cb + i);
+        const __m128 sc = _mm_loadu_ps(s.sc + i), cc = _mm_loadu_ps(s.cc + i);
+        const __m128 sx = _mm_loadu_ps(s.sx + i), sy = _mm_loadu_ps(s.sy + i), sz = _mm_loadu_ps(s.sz + i);
+        const __m128 zero = _mm_setzero_ps(), one = _mm_set1_ps(1.0f);
+        const __m128 sasb = _mm_mul_ps(sa, sb), casb = _mm_mul_ps(ca, sb);
+
+        __m128 columns[4][4] = {
+            {_mm_mul_ps(_mm_mul_ps(cb, cc), sx),
+             _mm_mul_ps(_mm_add_ps(_mm_mul_ps(sasb, cc), _mm_mul_ps(ca, sc)), sx),
+             _mm_mul_ps(_mm_sub_ps(_mm_mul_ps(sa, sc), _mm_mul_ps(casb, cc)), sx),
+             zero},
+            {_mm_mul_ps(_mm_sub_ps(zero, _mm_mul_ps(cb, sc)), sy),
+             _mm_mul_ps(_mm_sub_ps(_mm_mul_ps(ca, cc), _mm_mul_ps(sasb, sc)), sy),
+             _mm_mul_ps(_mm_add_ps(_mm_mul_ps(casb, sc), _mm_mul_ps(sa, cc)), sy),
+             zero},
+            {_mm_mul_ps(sb, sz),
+             _mm_mul_ps(_mm_sub_ps(zero, _mm_mul_ps(sa, cb)), sz),
+             _mm_mul_ps(_mm_mul_ps(ca, cb), sz),
+             zero},
+            {_mm_loadu_ps(s.tx + i), _mm_loadu_ps(s.ty + i), _mm_loadu_ps(s.tz + i), one}};
+
+        float *out = s.out + i * 16;
+        for (int c = 0; c < 4; ++c)
+        {
+            __m128 r0 = columns[c][0], r1 = columns[c][1], r2 = columns[c][2], r3 = columns[c][3];
+            _MM_TRANSPOSE4_PS(r0, r1, r2, r3);
+            _mm_storeu_ps(out + 0 * 16 + c * 4, r0);
+            _mm_storeu_ps(out + 1 * 16 + c * 4, r1);
+            _mm_storeu_ps(out + 2 * 16 + c * 4, r2);
+            _mm_storeu_ps(out + 3 * 16 + c * 4, r3);
+        }
+    }
+
+    /**
+     * @brief Eight objects at once; same scheme as composeSSE with a 4x8 transpose per column.
+     */
+    TRANSFORMS_AVX_TARGET void composeAVX(const TransformArrays &s, size_t i)
+    {
+        const __m256 sa = _mm256_loadu_ps(s.sa + i), ca = _mm256_loadu_ps(s.ca + i);
+        const __m256 sb = _mm256_loadu_ps(s.sb + i), cb = _mm256_loadu_ps(s.cb + i);
+        const __m256 sc = _mm256_loadu_ps(s.sc + i), cc = _mm256_loadu_ps(s.cc + i);
+        const __m256 sx = _mm256_loadu_ps(s.sx + i), sy = _mm256_loadu_ps(s.sy + i), sz = _mm256_loadu_ps(s.sz + i);
+        const __m256 zero = _mm256_setzero_ps(), one = _mm256_set1_ps(1.0f);
+        const __m256 sasb = _mm256_mul_ps(sa, sb), casb = _mm256_mul_ps(ca, sb);
+
+        __m256 columns[4][4] = {
+            {_mm256_mul_ps(_mm256_mul_ps(cb, cc), sx),
+             _mm256_mul_ps(_mm256_add_ps(_mm256_mul_ps(sasb, cc), _mm256_mul_ps(ca, sc)), sx),
+             _mm256_mul_ps(_mm256_sub_ps(_mm256_mul_ps(sa, sc), _mm256_mul_ps(casb, cc)), sx),
+             zero},
+            {_mm256_mul_ps(_mm256_sub_ps(zero, _mm256_mul_ps(cb, sc)), sy),
+             _mm256_mul_ps(_mm256_sub_ps(_mm256_mul_ps(ca, cc), _mm256_mul_ps(sasb, sc)), sy),
+             _mm256_mul_ps(_mm256_add_ps(_mm256_mul_ps(casb, sc), _mm256_mul_ps(sa, cc)), sy),
+             zero},
+            {_mm256_mul_ps(sb, sz),
+             _mm256_mul_ps(_mm256_sub_ps(zero, _mm256_mul_ps(sa, cb)), sz),
+             _mm256_mul_ps(_mm256_mul_ps(ca, cb), sz),
+             zero},
+            {_mm256_loadu_ps(s.tx + i), _mm256_loadu_ps(s.ty + i), _mm256_loadu_ps(s.tz + i), one}};
+
+        float *out = s.out + i * 16;
+        for (int c = 0; c < 4; ++c)
+        {
+            // Lane k of the four row vectors becomes column c of object k
+            __m256 t0 = _mm256_unpacklo_ps(columns[c][0], columns[c][1]);
+            __m256 t1 = _mm256_unpackhi_ps(columns[c][0], columns[c][1]);
+            __m256 t2 = _mm256_unpacklo_ps(columns[c][2], columns[c][3]);
+            __m256 t3 = _mm256_unpackhi_ps(columns[c][2], columns[c][3]);
+            __m256 objects[4] = {_mm256_shuffle_ps(t0, t2, 0x44), _mm256_shuffle_ps(t0, t2, 0xEE),
+                                 _mm256_shuffle_ps(t1, t3, 0x44), _mm256_shuffle_ps(t1, t3, 0xEE)};
+            for (int k = 0; k < 4; ++k)
+            {
+                _mm_storeu_ps(out + k * 16 + c * 4, _mm256_castps256_ps128(objects[k]));
+                _mm_storeu_ps(out + (k + 4) * 16 + c * 4, _mm256_extractf128_ps(objects[k], 1));
+            }
+        }
+    }
+#endif
+
+    size_t kernelWidth(TransformKernel kernel)
+    {
+        return kernel == TransformKernel::AVX ? 8 : kernel == TransformKernel::SSE ? 4 : 1;
+    }
+}
+
+size_t TransformSystem::add()
+{
+    translationX.push_back(0.0f);
+    translationY.push_back(0.0f);
+    translationZ.push_back(0.0f);
+    sinX.push_back(0.0f);
+    cosX.push_back(1.0f);
+    sinY.push_back(0.0f);
+    cosY.push_back(1.0f);
+    sinZ.push_back(0.0f);
+    cosZ.push_back(1.0f);
+    scaleX.push_back(1.0f);
+    scaleY.push_back(1.0f);
+    scaleZ.push_back(1.0f);
+    dirty.push_back(0);
+    worlds.push_back(glm::mat4(1.0f));
+    return worlds.size() - 1;
+}
+
+void TransformSystem::setTranslation(size_t id, const glm::vec3 &translation)
+{
+    if (translationX[id] == translation.x && translationY[id] == translation.y && translationZ[id] == translation.z)
+    {
+        return;
+    }
+    translationX[id] = translation.x;
+    translationY[id] = translation.y;
+    translationZ[id] = translation.z;
+    dirtyCount += dirty[id] ? 0 : 1;
+    dirty[id] = 1;
+}
+
+void TransformSystem::setRotation(size_t id, const glm::vec3 &radians)
+{
+    const float sa = std::sin(radians.x), ca = std::cos(radians.x);
+    const float sb = std::sin(radians.y), cb = std::cos(radians.y);
+    const float sc = std::sin(radians.z), cc = std::cos(radians.z);
+    if (sinX[id] == sa && cosX[id] == ca && sinY[id] == sb && cosY[id] == cb && sinZ[id] == sc && cosZ[id] == cc)
+    {
+        return;
+    }
+    sinX[id] = sa;
+    cosX[id] = ca;
+    sinY[id] = sb;
+    cosY[id] = cb;
+    sinZ[id] = sc;
+    cosZ[id] = cc;
+    dirtyCount += dirty[id] ? 0 : 1;
+    dirty[id] = 1;
+}
+
+void TransformSystem::setScale(size_t id, const glm::vec3 &scale)
+{
+    if (scaleX[id] == scale.x && scaleY[id] == scale.y && scaleZ[id] == scale.z)
+    {
+        return;
+    }
+    scaleX[id] = scale.x;
+    scaleY[id] = scale.y;
+    scaleZ[id] = scale.z;
+    dirtyCount += dirty[id] ? 0 : 1;
+    dirty[id] = 1;
+}
+
+void TransformSystem::markAllDirty()
+{
+    std::fill(dirty.begin(), dirty.end(), static_cast<uint8_t>(1));
+    dirtyCount = dirty.size();
+}
+
+size_t TransformSystem::update(ThreadPool *pool)
+{
+    const size_t updated = dirtyCount;
+    if (updated == 0)
+    {
+        return 0;
+    }
+
+    const size_t count = worlds.size();
+    if (pool && pool->size() > 1 && count >= kParallelTransformThreshold)
+    {
+        // Chunks are whole multiples of the widest batch so no batch straddles two threads
+        pool->parallelFor(count, 4096, [this](size_t begin, size_t end)
+        {
+            compose(begin, end);
+        });
+    }
+    else
+    {
+        compose(0, count);
+    }
+    dirtyCount = 0;
+    return updated;
+}
+
+void TransformSystem::compose(size_t begin, size_t end)
+{
+    const TransformArrays arrays = {
+        translationX.data(), translationY.data(), translationZ.data(),
+        sinX.data(), cosX.data(), sinY.data(), cosY.data(), sinZ.data(), cosZ.data(),
+        scaleX.data(), scaleY.data(), scaleZ.data(),
+        &worlds[0][0][0]};
+
+    // Whole batches first; a batch with any dirty object is recomposed as a unit, which is
+    // harmless for the clean ones since their inputs did not change
+    size_t i = begin;
+    const size_t width = kernelWidth(selectedKernel);
+#ifdef TRANSFORMS_X86
+    for (; width > 1 && i + width <= end; i += width)
+    {
+        uint64_t anyDirty = 0;
+        std::memcpy(&anyDirty, &dirty[i], width);
+        if (anyDirty == 0)
+        {
+            continue;
+        }
+        if (width == 8)
+        {
+            composeAVX(arrays, i);
+        }
+        else
+        {
+            composeSSE(arrays, i);
+        }
+        std::memset(&dirty[i], 0, width);
+    }
+#endif
+    for (; i < end; ++i)
+    {
+        if (dirty[i])
+        {
+            composeScalar(arrays, i);
+            dirty[i] = 0;
+        }
+    }
+}
+
+TransformKernel TransformSystem::bestKernel()
+{
+#ifdef TRANSFORMS_X86
+#if defined(_MSC_VER)
+    // AVX needs the CPU flag and the OS saving the YMM registers (OSXSAVE + XCR0 bits 1 and 2)
+    int info[4];
+    __cpuid(info, 1);
+    const bool avx = (info[2] & (1 << 28)) && (info[2] & (1 << 27)) && (_xgetbv(0) & 6) == 6;
+#else
+    const bool avx = __builtin_cpu_supports("avx");
+#endif
+    return avx ? TransformKernel::AVX : TransformKernel::SSE;
+#else
+    return TransformKernel::Scalar;
+#endif
+}
@@ -0,0 +1,91 @@
+#pragma once
+
+#include <glm/glm.hpp>
+
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+class ThreadPool;
+
+// Below this many objects an update stays on the calling thread
+constexpr size_t kParallelTransformThreshold = 16384;
+
+/**
+ * @brief Instruction set used to compose world matrices.
+ */
+enum class TransformKernel
+{
+    Scalar,
+    SSE, // 4 objects per step
+    AVX  // 8 objects per step
+};
+
+/**
+ * @brief Object transforms stored as structure-of-arrays.
+ *
+ * Each object has a translation, Euler rotation and scale, and a world matrix equal to
+ * translate(T) * rotate(X) * rotate(Y) * rotate(Z) * scale(S), the chain the viewer used to build
+ * with glm every frame. Setting a value only marks the object dirty; update() recomposes dirty
+ * objects in SIMD batches. Sines and cosines are taken when a rotation is set, so the batch
+ * kernels are nothing but multiplies and adds.
+ */
+class TransformSystem
+{
+public:
+    /**
+     * @brief Adds an object with the identity transform.
+     *
+     * @return The object's id, an index into worlds().
+     */
+    size_t add();
+
+    void setTranslation(size_t id, const glm::vec3 &translation);
+
+    /**
+     * @param radians Rotation about X, then Y, then Z, applied in that order after scaling.
+     */
+    void setRotation(size_t id, const glm::vec3 &radians);
+
+    void setScale(size_t id, const glm::vec3 &scale);
+
+    /**
+     * @brief Recomposes the world matrices of every object that changed since the last update.
+     *
+     * @param pool Optional; spreads large updates over its threads.
+     * @return Number of objects recomposed.
+     */
+    size_t update(ThreadPool *pool = nullptr);
+
+    /**
+     * @brief Marks every object dirty, e.g. to time a full update.
+     */
+    void markAllDirty();
+
+    const glm::mat4 &world(size_t id) const { return worlds[id]; }
+    const std::vector<glm::mat4> &worldMatrices() const { return worlds; }
+    size_t size() const { return worlds.size(); }
+
+    /**
+     * @brief Picks the kernel update() uses; the default is the widest the CPU supports.
+     */
+    void setKernel(TransformKernel kernel) { selectedKernel = kernel; }
+    TransformKernel kernel() const { return selectedKernel; }
+
+    /**
+     * @brief The widest kernel this CPU can run.
+     */
+    static TransformKernel bestKernel();
+
+private:
+    void compose(size_t begin, size_t end);
+
+    // Structure-of-arrays state, one entry per object
+    std::vector<float> translationX, translationY, translationZ;
+    std::vector<float> sinX, cosX, sinY, cosY, sinZ, cosZ;
+    std::vector<float> scaleX, scaleY, scaleZ;
+    std::vector<uint8_t> dirty;
+    std::vector<glm::mat4> worlds;
+    size_t dirtyCount = 0;
+    TransformKernel selectedKernel = bestKernel();
+};
@@ -0,0 +1,307 @@
+#include "ShaderCache.h"
+#include "Profiler.h"
+
+#include <GL/glew.h>
+
+#include <chrono>
+#include <cstdio>
+#include <cstring>
+#include <filesystem>
+#include <fstream>
+#include <iostream>
+
+namespace
+{
+    const char kMagic[8] = {'S', 'H', 'A', 'D', 'E', 'R', 'B', 'N'};
+
+    const uint64_t kHashSeed = 0xcbf29ce484222325ull;
+
+    // FNV-1a; sources and driver strings are short, and only need telling apart
+    uint64_t hashBytes(const void *data, size_t size, uint64_t hash)
+    {
+        const unsigned char *bytes = static_cast<const unsigned char *>(data);
+        for (size_t i = 0; i < size; ++i)
+        {
+            hash = (hash ^ bytes[i]) * 0x100000001b3ull;
+        }
+        return hash;
+    }
+
+    // The terminator goes into the hash too, so "ab" + "c" differs from "a" + "bc"
+    uint64_t hashString(const char *text, uint64_t hash)
+    {
+        return hashBytes(text, std::strlen(text) + 1, hash);
+    }
+
+    const char *glString(GLenum name)
+    {
+        const GLubyte *text = glGetString(name);
+        return text ? reinterpret_cast<const char *>(text) : "";
+    }
+
+    // Hands the source to the driver; the status is checked when the program is finished
+    GLuint startShader(GLenum type, const char *source)
+    {
+        const GLuint shader = glCreateShader(type);
+        glShaderSource(shader, 1, &source, NULL);
+        glCompileShader(shader);
+        return shader;
+    }
+
+    bool checkShader(GLuint shader, const std::string &name, const char *stage)
+    {
+        int success;
+        glGetShaderiv(shader, GL_COMPILE_STATUS, &success);
+        if (!success)
+        {
+            char infoLog[512];
+            glGetShaderInfoLog(shader, 512, NULL, infoLog);
+            std::cerr << "ERROR: " << name << " " << stage << " shader compilation failed\n"
+                      << infoLog << std::endl;
+        }
+        return success != 0;
+    }
+
+    class ScopedMilliseconds
+    {
+    public:
+        explicit ScopedMilliseconds(double &total) : total(total), start(std::chrono::steady_clock::now()) {}
+        ~ScopedMilliseconds() { total += std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count(); }
+
+    private:
+        double &total;
+        std::chrono::steady_clock::time_point start;
+    };
+}
+
+ShaderCache::ShaderCache(const std::string &directory) : directory(directory)
+{
+    driverHash = kHashSeed;
+    for (GLenum name : {GL_VENDOR, GL_RENDERER, GL_VERSION, GL_SHADING_LANGUAGE_VERSION})
+    {
+        driverHash = hashString(glString(name), driverHash);
+    }
+
+    GLint formats = 0;
+    if (GLEW_ARB_get_program_binary)
+    {
+        glGetIntegerv(GL_NUM_PROGRAM_BINARY_FORMATS, &formats);
+    }
+    counters.binaries = formats > 0;
+
+    if (GLEW_KHR_parallel_shader_compile)
+    {
+        // Let the driver pick how many compiler threads to use
+        glMaxShaderCompilerThreadsKHR(0xFFFFFFFFu);
+        counters.parallelCompile = true;
+    }
+}
+
+size_t ShaderCache::request(const char *name, const char *vertexSource, const char *fragmentSource)
+{
+    PROFILE_FUNCTION();
+    ScopedMilliseconds timer(counters.milliseconds);
+
+    Entry entry;
+    entry.name = name;
+    entry.sourceHash = hashString(fragmentSource, hashString(vertexSource, kHashSeed));
+    if (!counters.binaries || !loadBinary(entry))
+    {
+        entry.vertexShader = startShader(GL_VERTEX_SHADER, vertexSource);
+        entry.fragmentShader = startShader(GL_FRAGMENT_SHADER, fragmentSource);
+        entry.program = glCreateProgram();
+        if (counters.binaries)
+        {
+            glProgramParameteri(entry.program, GL_PROGRAM_BINARY_RETRIEVABLE_HINT, GL_TRUE);
+        }
+        glAttachShader(entry.program, entry.vertexShader);
+        glAttachShader(entry.program, entry.fragmentShader);
+        glLinkProgram(entry.program);
+    }
+    entries.push_back(std::move(entry));
+    return entries.size() - 1;
+}
+
+bool ShaderCache::isReady(size_t handle)
+{
+    const Entry &entry = entries[handle];
+    if (entry.finished || !counters.parallelCompile)
+    {
+        return true;
+    }
+    GLint done = GL_FALSE;
+    glGetProgramiv(entry.program, GL_COMPLETION_STATUS_KHR, &done);
+    return done != GL_FALSE;
+}
+
+unsigned int ShaderCache::program(size_t handle)
+{
+    Entry &entry = entries[handle];
+    if (!entry.finished)
+    {
+        PROFILE_FUNCTION();
+        ScopedMilliseconds timer(counters.milliseconds);
+        finish(entry);
+    }
+    return entry.program;
+}
+
+void ShaderCache::destroy()
+{
+    for (const Entry &entry : entries)
+    {
+        if (entry.program)
+        {
+            glDeleteProgram(entry.program);
+        }
+    }
+    entries.clear();
+}
+
+std::string ShaderCache::cachePath(const Entry &entry) const
+{
+    char hash[17];
+    std::snprintf(hash, sizeof(hash), "%016llx", static_cast<unsigned long long>(entry.sourceHash));
+    return directory + "/" + entry.name + "-" + hash + ".bin";
+}
+
+bool ShaderCache::loadBinary(Entry &entry)
+{
+    std::ifstream file(cachePath(entry), std::ios::binary);
+    if (!file.is_open())
+    {
+        return false;
+    }
+    ShaderCacheHeader header;
+    if (!file.read(reinterpret_cast<char *>(&header), sizeof(header)) ||
+        std::memcmp(header.magic, kMagic, sizeof(kMagic)) != 0 || header.version != kShaderCacheVersion ||
+        header.sourceHash != entry.sourceHash || header.driverHash != driverHash || header.binaryLength == 0)
+    {
+        return false;
+    }
+    std::vector<char> binary(static_cast<size_t>(header.binaryLength));
+    if (!file.read(binary.data(), static_cast<std::streamsize>(binary.size())) ||
+        hashBytes(binary.data(), binary.size(), kHashSeed) != header.binaryChecksum)
+    {
+        return false;
+    }
+
+    // The driver may still turn the binary down, and then the sources are compiled as usual
+    const GLuint program = glCreateProgram();
+    glProgramBinary(program, header.binaryFormat, binary.data(), static_cast<GLsizei>(binary.size()));
+    GLint linked = GL_FALSE;
+    glGetProgramiv(program, GL_LINK_STATUS, &linked);
+    if (!linked)
+    {
+        glDeleteProgram(program);
+        return false;
+    }
+    entry.program = program;
+    entry.finished = true;
+    ++counters.loaded;
+    return true;
+}
+
+void ShaderCache::saveBinary(const Entry &entry)
+{
+    GLint length = 0;
+    glGetProgramiv(entry.program, GL_PROGRAM_BINARY_LENGTH, &length);
+    if (length <= 0)
+    {
+        return;
+    }
+    std::vector<char> binary(static_cast<size_t>(length));
+    GLsizei written = 0;
+    GLenum format = 0;
+    glGetProgramBinary(entry.program, length, &written, &format, binary.data());
+    if (written <= 0)
+    {
+        return;
+    }
+    binary.resize(static_cast<size_t>(written));
+
+    ShaderCacheHeader header;
+    std::memcpy(header.magic, kMagic, sizeof(kMagic));
+    header.version = kShaderCacheVersion;
+    header.binaryFormat = format;
+    header.sourceHash = entry.sourceHash;
+    header.driverHash = driverHash;
+    header.binaryLength = binary.size();
+    header.binaryChecksum = hashBytes(binary.data(), binary.size(), kHashSeed);
+
+    std::error_code error;
+    std::filesystem::create_directories(directory, error);
+    const std::string path = cachePath(entry);
+    const std::string tempPath = path + ".tmp";
+    {
+        std::ofstream file(tempPath, std::ios::binary | std::ios::trunc);
+        if (!file.is_open())
+        {
+            std::cerr << "Failed to write shader cache: " << path << std::endl;
+            return;
+        }
+        file.write(reinterpret_cast<const char *>(&header), sizeof(header));
+        file.write(binary.data(), static_cast<std::streamsize>(binary.size()));
+        if (!file)
+        {
+            std::cerr << "Failed to write shader cache: " << path << std::endl;
+            file.close();
+            std::remove(tempPath.c_str());
+            return;
+        }
+    }
+    std::filesystem::rename(tempPath, path, error);
+    if (error)
+    {
+        std::cerr << "Failed to write shader cache: " << path << " (" << error.message() << ")" << std::endl;
+        std::remove(tempPath.c_str());
+        return;
+    }
+    ++counters.saved;
+}
+
+bool ShaderCache::finish(Entry &entry)
+{
+    // These queries wait for the driver if it has not finished compiling
+    const bool compiled = checkShader(entry.vertexShader, entry.name, "vertex") &
+                          checkShader(entry.fragmentShader, entry.name, "fragment");
+    int linked = 0;
+    glGetProgramiv(entry.program, GL_LINK_STATUS, &linked);
+    if (compiled && !linked)
+    {
+        char infoLog[512];
+        glGetProgramInfoLog(entry.program, 512, NULL, infoLog);
+        std::cerr << "ERROR: " << entry.name << " shader program linking failed\n"
+                  << infoLog << std::endl;
+    }
+
+    // Clean up shaders as they're linked into the program now
+    glDetachShader(entry.program, entry.vertexShader);
+    glDetachShader(entry.program, entry.fragmentShader);
+    glDeleteShader(entry.vertexShader);
+    glDeleteShader(entry.fragmentShader);
+    entry.vertexShader = entry.fragmentShader = 0;
+    entry.finished = true;
+
+    if (!compiled || !linked)
+    {
+        glDeleteProgram(entry.program);
+        entry.program = 0;
+        ++counters.failed;
+        return false;
+    }
+    ++counters.compiled;
+    if (counters.binaries)
+    {
+        saveBinary(entry);
+    }
+    return true;
+}
+
+void printShaderCacheStats(const ShaderCacheStats &stats)
+{
+    std::cout << "Shaders: " << stats.loaded << " loaded from the cache, " << stats.compiled << " compiled, "
+              << stats.failed << " failed in " << stats.milliseconds << " ms ("
+              << (stats.binaries ? "program binaries" : "no program binaries") << ", "
+              << (stats.parallelCompile ? "parallel compile" : "serial compile") << ")" << std::endl;
+}
@@ -0,0 +1,686 @@
+#include "SoftwareRasterizer.h"
+#include "ThreadPool.h"
+
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cmath>
+#include <fstream>
+#include <functional>
+#include <iostream>
+#include <string>
+
+#if defined(_M_X64) || defined(__x86_64__) || defined(__SSE2__)
+#define RASTER_SSE 1
+#include <emmintrin.h>
+#endif
+
+namespace
+{
+    // Screen positions are snapped to 1 / 16 of a pixel, like a GPU's subpixel grid
+    constexpr int kSubpixelBits = 4;
+    constexpr int kSubpixelSteps = 1 << kSubpixelBits;
+    constexpr int kHalfPixel = kSubpixelSteps / 2;
+
+    // Triangles reaching further than this past the target are clipped. Within the band,
+    // an edge function changes by less than 2^31 across a tile, so a tile that an edge crosses
+    // can be walked with 32-bit integers.
+    constexpr float kGuardBandPixels = 4096.0f;
+
+    // Half the width of a wireframe line, in pixels
+    constexpr float kLineHalfWidth = 0.5f;
+
+    // Near clipping plus four guard band planes can add one vertex each
+    constexpr int kMaxClippedVertices = 8;
+
+    struct ScreenVertex
+    {
+        int32_t x, y; // Subpixels, row 0 at the top
+        float z;
+    };
+
+    void runParallel(ThreadPool *pool, size_t count, size_t grain, const std::function<void(size_t, size_t)> &body)
+    {
+        if (pool)
+        {
+            pool->parallelFor(count, grain, body);
+        }
+        else if (count > 0)
+        {
+            body(0, count);
+        }
+    }
+
+    uint32_t packColor(const glm::vec3 &color)
+    {
+        auto channel = [](float value)
+        {
+            return static_cast<uint32_t>(std::min(std::max(value, 0.0f), 1.0f) * 255.0f + 0.5f);
+        };
+        return channel(color.x) | channel(color.y) << 8 | channel(color.z) << 16 | 0xFF000000u;
+    }
+
+    int64_t floorDivide(int64_t value, int64_t divisor)
+    {
+        return value >= 0 ? value / divisor : -((-value + divisor - 1) / divisor);
+    }
+
+    /**
+     * @brief Clips a convex polygon against one plane, keeping the side where
+     * dot(plane, vertex) >= 0 (Sutherland-Hodgman).
+     *
+     * @return Number of vertices written to out.
+     */
+    int clipPolygon(const glm::vec4 *in, int count, const glm::vec4 &plane, glm::vec4 *out)
+    {
+        int written = 0;
+        for (int i = 0; i < count; ++i)
+        {
+            const glm::vec4 &a = in[i];
+            const glm::vec4 &b = in[(i + 1) % count];
+            const float da = glm::dot(plane, a);
+            const float db = glm::dot(plane, b);
+            if (da >= 0.0f)
+            {
+                out[written++] = a;
+            }
+            if ((da >= 0.0f) != (db >= 0.0f))
+            {
+                out[written++] = a + (b - a) * (da / (da - db));
+            }
+        }
+        return written;
+    }
+
+    bool outsideFrustum(const glm::vec4 &a, const glm::vec4 &b, const glm::vec4 &c)
+    {
+        return (a.x > a.w && b.x > b.w && c.x > c.w) || (a.x < -a.w && b.x < -b.w && c.x < -c.w) ||
+               (a.y > a.w && b.y > b.w && c.y > c.w) || (a.y < -a.w && b.y < -b.w && c.y < -c.w) ||
+               (a.z > a.w && b.z > b.w && c.z > c.w) || (a.z < -a.w && b.z < -b.w && c.z < -c.w);
+    }
+
+    ScreenVertex toScreen(const glm::vec4 &clip, float width, float height)
+    {
+        const float invW = 1.0f / clip.w;
+        const float x = (clip.x * invW * 0.5f + 0.5f) * width;
+        const float y = (0.5f - clip.y * invW * 0.5f) * height;
+        return {static_cast<int32_t>(std::floor(x * kSubpixelSteps + 0.5f)),
+                static_cast<int32_t>(std::floor(y * kSubpixelSteps + 0.5f)),
+                clip.z * invW * 0.5f + 0.5f};
+    }
+
+    /**
+     * @brief Computes edge functions, depth plane and pixel bounds.
+     *
+     * @return false if the triangle has no area or covers no pixel of the target.
+     */
+    bool setupTriangle(ScreenVertex v[3], uint32_t color, bool wireframe, int width, int height, RasterTriangle &out)
+    {
+        const int64_t area = static_cast<int64_t>(v[1].x - v[0].x) * (v[2].y - v[0].y) -
+                             static_cast<int64_t>(v[1].y - v[0].y) * (v[2].x - v[0].x);
+        if (area == 0)
+        {
+            return false;
+        }
+        if (area < 0)
+        {
+            std::swap(v[1], v[2]);
+        }
+
+        for (int i = 0; i < 3; ++i)
+        {
+            const ScreenVertex &a = v[i];
+            const ScreenVertex &b = v[(i + 1) % 3];
+            const int32_t edgeA = a.y - b.y;
+            const int32_t edgeB = b.x - a.x;
+            int64_t edgeC = -(static_cast<int64_t>(edgeA) * a.x + static_cast<int64_t>(edgeB) * a.y);
+            // A sample exactly on an edge belongs to the triangle only if that is a top or left
+            // edge, so samples on an edge shared by two triangles are drawn once. The gradient
+            // points inside: a left edge has the interior to its right (A > 0) and a top edge,
+            // being horizontal, has it below (B > 0 with y down).
+            const bool topLeft = edgeA > 0 || (edgeA == 0 && edgeB > 0);
+            if (!topLeft)
+            {
+                edgeC -= 1;
+            }
+            out.edgeA[i] = edgeA;
+            out.edgeB[i] = edgeB;
+            out.edgeC[i] = edgeC;
+
+            // The same line in pixels, scaled to unit length for wireframe distances
+            const float ax = static_cast<float>(a.x) / kSubpixelSteps, ay = static_cast<float>(a.y) / kSubpixelSteps;
+            const float bx = static_cast<float>(b.x) / kSubpixelSteps, by = static_cast<float>(b.y) / kSubpixelSteps;
+            const float lineA = ay - by, lineB = bx - ax;
+            const float invLength = 1.0f / std::sqrt(lineA * lineA + lineB * lineB);
+            out.lineA[i] = lineA * invLength;
+            out.lineB[i] = lineB * invLength;
+            out.lineC[i] = -(lineA * ax + lineB * ay) * invLength;
+        }
+
+        // Depth is linear in screen space: the plane through the three vertices, in pixels
+        const float x0 = static_cast<float>(v[0].x) / kSubpixelSteps, y0 = static_cast<float>(v[0].y) / kSubpixelSteps;
+        const float d1x = static_cast<float>(v[1].x - v[0].x) / kSubpixelSteps, d1y = static_cast<float>(v[1].y - v[0].y) / kSubpixelSteps;
+        const float d2x = static_cast<float>(v[2].x - v[0].x) / kSubpixelSteps, d2y = static_cast<float>(v[2].y - v[0].y) / kSubpixelSteps;
+        const float d1z = v[1].z - v[0].z, d2z = v[2].z - v[0].z;
+        const float nx = d1y * d2z - d1z * d2y;
+        const float ny = d1z * d2x - d1x * d2z;
+        const float nz = d1x * d2y - d1y * d2x;
+        out.depthA = -nx / nz;
+        out.depthB = -ny / nz;
+        out.depthC = v[0].z - out.depthA * x0 - out.depthB * y0;
+
+        // Pixels whose centers fall inside the bounding box, grown by half a line for wireframe
+        const int32_t margin = wireframe ? static_cast<int32_t>(kLineHalfWidth * kSubpixelSteps) : 0;
+        const int64_t minX = std::min(v[0].x, std::min(v[1].x, v[2].x)) - margin;
+        const int64_t minY = std::min(v[0].y, std::min(v[1].y, v[2].y)) - margin;
+        const int64_t maxX = std::max(v[0].x, std::max(v[1].x, v[2].x)) + margin;
+        const int64_t maxY = std::max(v[0].y, std::max(v[1].y, v[2].y)) + margin;
+        out.minX = static_cast<int>(std::max<int64_t>(0, -floorDivide(kHalfPixel - minX, kSubpixelSteps)));
+        out.minY = static_cast<int>(std::max<int64_t>(0, -floorDivide(kHalfPixel - minY, kSubpixelSteps)));
+        out.maxX = static_cast<int>(std::min<int64_t>(width - 1, floorDivide(maxX - kHalfPixel, kSubpixelSteps)));
+        out.maxY = static_cast<int>(std::min<int64_t>(height - 1, floorDivide(maxY - kHalfPixel, kSubpixelSteps)));
+        out.color = color;
+        return out.minX <= out.maxX && out.minY <= out.maxY;
+    }
+
+    int64_t evaluateEdge(const RasterTriangle &t, int i, int x, int y)
+    {
+        return static_cast<int64_t>(t.edgeA[i]) * (x * kSubpixelSteps + kHalfPixel) +
+               static_cast<int64_t>(t.edgeB[i]) * (y * kSubpixelSteps + kHalfPixel) + t.edgeC[i];
+    }
+
+    /**
+     * @brief Draws the part of a triangle inside one tile.
+     *
+     * @return Number of pixels written.
+     */
+    size_t rasterizeTile(const RasterTriangle &t, int tileX, int tileY, bool wireframe, bool depthTest,
+                         uint32_t *colors, float *depths, int quadsPerRow)
+    {
+        // Tiles start on even pixels, so rounding down to a quad stays inside the tile
+        const int x0 = std::max(t.minX, tileX) & ~1;
+        const int y0 = std::max(t.minY, tileY) & ~1;
+        const int x1 = std::min(t.maxX, tileX + kRasterTileSize - 1);
+        const int y1 = std::min(t.maxY, tileY + kRasterTileSize - 1);
+        if (x0 > x1 || y0 > y1)
+        {
+            return 0;
+        }
+
+        // Edge functions are linear, so checking the corner samples of the block rejects it when
+        // it is outside an edge and drops edges it is fully inside, whose values may not fit in
+        // 32 bits; the edges left cross the block and do fit.
+        bool crossing[3] = {};
+        if (!wireframe)
+        {
+            for (int i = 0; i < 3; ++i)
+            {
+                const int64_t corners[4] = {evaluateEdge(t, i, x0, y0), evaluateEdge(t, i, x1, y0),
+                                            evaluateEdge(t, i, x0, y1), evaluateEdge(t, i, x1, y1)};
+                const int64_t lowest = std::min(std::min(corners[0], corners[1]), std::min(corners[2], corners[3]));
+                const int64_t highest = std::max(std::max(corners[0], corners[1]), std::max(corners[2], corners[3]));
+                if (highest < 0)
+                {
+                    return 0;
+                }
+                crossing[i] = lowest < 0;
+            }
+        }
+        size_t written = 0;
+
+#ifdef RASTER_SSE
+        static const int kBitCount[16] = {0, 1, 1, 2, 1, 2, 2, 3, 1, 2, 2, 3, 2, 3, 3, 4};
+        // Lanes of a quad: (0, 0), (1, 0), (0, 1), (1, 1), sampled at pixel centers
+        const __m128 offsetX = _mm_setr_ps(0.5f, 1.5f, 0.5f, 1.5f);
+        const __m128 offsetY = _mm_setr_ps(0.5f, 0.5f, 1.5f, 1.5f);
+        const __m128i laneX = _mm_setr_epi32(0, 1, 0, 1);
+        const __m128i laneY = _mm_setr_epi32(0, 0, 1, 1);
+        const __m128i minusOne = _mm_set1_epi32(-1);
+        const __m128 halfWidth = _mm_set1_ps(kLineHalfWidth);
+        const __m128 minusHalfWidth = _mm_set1_ps(-kLineHalfWidth);
+        const __m128i color = _mm_set1_epi32(static_cast<int>(t.color));
+        const __m128 depthA = _mm_set1_ps(t.depthA), depthB = _mm_set1_ps(t.depthB), depthC = _mm_set1_ps(t.depthC);
+        const __m128 depthStep = _mm_set1_ps(2.0f * t.depthA);
+
+        // Lanes past the last column or row of an odd-sized block are outside the bounds
+        const __m128i lastColumn = _mm_cmpgt_epi32(_mm_set1_epi32(((x1 - x0) & 1) + 1), laneX);
+        const __m128i lastRow = _mm_cmpgt_epi32(_mm_set1_epi32(((y1 - y0) & 1) + 1), laneY);
+
+        __m128i rowEdge[3], edgeStep[3], rowStep[3];
+        __m128 lineA[3], lineB[3], lineC[3], lineStep[3];
+        for (int i = 0; i < 3; ++i)
+        {
+            // An edge the block is inside stays at zero, which passes the test
+            const int32_t origin = crossing[i] ? static_cast<int32_t>(evaluateEdge(t, i, x0, y0)) : 0;
+            const int32_t stepX = crossing[i] ? t.edgeA[i] * kSubpixelSteps : 0;
+            const int32_t stepY = crossing[i] ? t.edgeB[i] * kSubpixelSteps : 0;
+            rowEdge[i] = _mm_add_epi32(_mm_set1_epi32(origin), _mm_setr_epi32(0, stepX, stepY, stepX + stepY));
+            edgeStep[i] = _mm_set1_epi32(2 * stepX);
+            rowStep[i] = _mm_set1_epi32(2 * stepY);
+            lineA[i] = _mm_set1_ps(t.lineA[i]);
+            lineB[i] = _mm_set1_ps(t.lineB[i]);
+            lineC[i] = _mm_set1_ps(t.lineC[i]);
+            lineStep[i] = _mm_set1_ps(2.0f * t.lineA[i]);
+        }
+
+        for (int y = y0; y <= y1; y += 2)
+        {
+            // Depth and line distances restart from the plane equations each row, so float
+            // stepping error never builds up; the integer edges step exactly
+            const __m128 px = _mm_add_ps(_mm_set1_ps(static_cast<float>(x0)), offsetX);
+            const __m128 py = _mm_add_ps(_mm_set1_ps(static_cast<float>(y)), offsetY);
+            __m128 z = _mm_add_ps(_mm_add_ps(_mm_mul_ps(depthA, px), _mm_mul_ps(depthB, py)), depthC);
+            __m128i e0 = rowEdge[0], e1 = rowEdge[1], e2 = rowEdge[2];
+            __m128 d0 = _mm_setzero_ps(), d1 = d0, d2 = d0;
+            if (wireframe)
+            {
+                d0 = _mm_add_ps(_mm_add_ps(_mm_mul_ps(lineA[0], px), _mm_mul_ps(lineB[0], py)), lineC[0]);
+                d1 = _mm_add_ps(_mm_add_ps(_mm_mul_ps(lineA[1], px), _mm_mul_ps(lineB[1], py)), lineC[1]);
+                d2 = _mm_add_ps(_mm_add_ps(_mm_mul_ps(lineA[2], px), _mm_mul_ps(lineB[2], py)), lineC[2]);
+            }
+            const __m128i rowMask = y + 1 > y1 ? lastRow : minusOne;
+
+            const size_t quad = (static_cast<size_t>(y >> 1) * quadsPerRow + (x0 >> 1)) * 4;
+            uint32_t *colorQuad = colors + quad;
+            float *depthQuad = depths + quad;
+            for (int x = x0; x <= x1; x += 2, colorQuad += 4, depthQuad += 4)
+            {
+                __m128 mask;
+                if (wireframe)
+                {
+                    // Inside the triangle grown by half a line, and within half a line of an edge
+                    const __m128 inside = _mm_and_ps(_mm_and_ps(_mm_cmpge_ps(d0, minusHalfWidth), _mm_cmpge_ps(d1, minusHalfWidth)),
+                                                     _mm_cmpge_ps(d2, minusHalfWidth));
+                    mask = _mm_and_ps(inside, _mm_cmple_ps(_mm_min_ps(_mm_min_ps(d0, d1), d2), halfWidth));
+                    d0 = _mm_add_ps(d0, lineStep[0]);
+                    d1 = _mm_add_ps(d1, lineStep[1]);
+                    d2 = _mm_add_ps(d2, lineStep[2]);
+                }
+                else
+                {
+                    // All three edges non-negative: the sign bits of e0 | e1 | e2 are clear
+                    mask = _mm_castsi128_ps(_mm_cmpgt_epi32(_mm_or_si128(_mm_or_si128(e0, e1), e2), minusOne));
+                    e0 = _mm_add_epi32(e0, edgeStep[0]);
+                    e1 = _mm_add_epi32(e1, edgeStep[1]);
+                    e2 = _mm_add_epi32(e2, edgeStep[2]);
+                }
+                mask = _mm_and_ps(mask, _mm_castsi128_ps(x + 1 > x1 ? _mm_and_si128(rowMask, lastColumn) : rowMask));
+
+                if (_mm_movemask_ps(mask))
+                {
+                    if (depthTest)
+                    {
+                        const __m128 oldDepth = _mm_loadu_ps(depthQuad);
+                        mask = _mm_and_ps(mask, _mm_cmplt_ps(z, oldDepth));
+                        _mm_storeu_ps(depthQuad, _mm_or_ps(_mm_and_ps(mask, z), _mm_andnot_ps(mask, oldDepth)));
+                    }
+                    const int bits = _mm_movemask_ps(mask);
+                    if (bits)
+                    {
+                        const __m128i lanes = _mm_castps_si128(mask);
+                        const __m128i oldColor = _mm_loadu_si128(reinterpret_cast<const __m128i *>(colorQuad));
+                        _mm_storeu_si128(reinterpret_cast<__m128i *>(colorQuad),
+                                         _mm_or_si128(_mm_and_si128(lanes, color), _mm_andnot_si128(lanes, oldColor)));
+                        written += kBitCount[bits];
+                    }
+                }
+                z = _mm_add_ps(z, depthStep);
+            }
+
+            for (int i = 0; i < 3; ++i)
+            {
+                rowEdge[i] = _mm_add_epi32(rowEdge[i], rowStep[i]);
+            }
+        }
+#else
+        static const int kOffsetX[4] = {0, 1, 0, 1};
+        static const int kOffsetY[4] = {0, 0, 1, 1};
+        for (int y = y0; y <= y1; y += 2)
+        {
+            for (int x = x0; x <= x1; x += 2)
+            {
+                const size_t quad = (static_cast<size_t>(y >> 1) * quadsPerRow + (x >> 1)) * 4;
+                for (int lane = 0; lane < 4; ++lane)
+                {
+                    const int sx = x + kOffsetX[lane];
+                    const int sy = y + kOffsetY[lane];
+                    if (sx > x1 || sy > y1)
+                    {
+                        continue;
+                    }
+                    const float px = sx + 0.5f;
+                    const float py = sy + 0.5f;
+                    bool covered;
+                    if (wireframe)
+                    {
+                        float nearest = t.lineA[0] * px + t.lineB[0] * py + t.lineC[0];
+                        for (int i = 1; i < 3; ++i)
+                        {
+                            nearest = std::min(nearest, t.lineA[i] * px + t.lineB[i] * py + t.lineC[i]);
+                        }
+                        covered = nearest >= -kLineHalfWidth && nearest <= kLineHalfWidth;
+                    }
+                    else
+                    {
+                        covered = (!crossing[0] || evaluateEdge(t, 0, sx, sy) >= 0) &&
+                                  (!crossing[1] || evaluateEdge(t, 1, sx, sy) >= 0) &&
+                                  (!crossing[2] || evaluateEdge(t, 2, sx, sy) >= 0);
+                    }
+                    const float z = t.depthA * px + t.depthB * py + t.depthC;
+                    if (!covered || (depthTest && !(z < depths[quad + lane])))
+                    {
+                        continue;
+                    }
+                    if (depthTest)
+                    {
+                        depths[quad + lane] = z;
+                    }
+                    colors[quad + lane] = t.color;
+                    ++written;
+                }
+            }
+        }
+#endif
+        return written;
+    }
+
+    uint32_t crc32(const unsigned char *data, size_t size, uint32_t crc)
+    {
+        static const std::vector<uint32_t> table = []()
+        {
+            std::vector<uint32_t> entries(256);
+            for (uint32_t n = 0; n < 256; ++n)
+            {
+                uint32_t c = n;
+                for (int k = 0; k < 8; ++k)
+                {
+                    c = (c & 1) ? 0xEDB88320u ^ (c >> 1) : c >> 1;
+                }
+                entries[n] = c;
+            }
+            return entries;
+        }();
+        crc = ~crc;
+        for (size_t i = 0; i < size; ++i)
+        {
+            crc = table[(crc ^ data[i]) & 0xFF] ^ (crc >> 8);
+        }
+        return ~crc;
+    }
+
+    void appendBigEndian(std::vector<unsigned char> &out, uint32_t value)
+    {
+        out.push_back(static_cast<unsigned char>(value >> 24));
+        out.push_back(static_cast<unsigned char>(value >> 16));
+        out.push_back(static_cast<unsigned char>(value >> 8));
+        out.push_back(static_cast<unsigned char>(value));
+    }
+
+    void writePngChunk(std::ostream &out, const char *type, const std::vector<unsigned char> &data)
+    {
+        std::vector<unsigned char> chunk;
+        appendBigEndian(chunk, static_cast<uint32_t>(data.size()));
+        chunk.insert(chunk.end(), type, type + 4);
+        chunk.insert(chunk.end(), data.begin(), data.end());
+        appendBigEndian(chunk, crc32(chunk.data() + 4, chunk.size() - 4, 0));
+        out.write(reinterpret_cast<const char *>(chunk.data()), chunk.size());
+    }
+
+    /**
+     * @brief Writes 8-bit RGB as a PNG. The image data goes into stored (uncompressed) deflate
+     * blocks, which every decoder reads and which needs no compression library.
+     */
+    void writePng(std::ostream &out, const std::vector<unsigned char> &rgb, int width, int height)
+    {
+        static const unsigned char kSignature[8] = {0x89, 'P', 'N', 'G', '\r', '\n', 0x1A, '\n'};
+        out.write(reinterpret_cast<const char *>(kSignature), sizeof(kSignature));
+
+        std::vector<unsigned char> header;
+        appendBigEndian(header, static_cast<uint32_t>(width));
+        appendBigEndian(header, static_cast<uint32_t>(height));
+        header.insert(header.end(), {8, 2, 0, 0, 0}); // 8 bits, RGB, deflate, no filter, no interlace
+        writePngChunk(out, "IHDR", header);
+
+        // Every row starts with filter type 0
+        const size_t rowBytes = static_cast<size_t>(width) * 3;
+        std::vector<unsigned char> raw;
+        raw.reserve((rowBytes + 1) * height);
+        for (int y = 0; y < height; ++y)
+        {
+            raw.push_back(0);
+            raw.insert(raw.end(), rgb.begin() + y * rowBytes, rgb.begin() + (y + 1) * rowBytes);
+        }
+
+        std::vector<unsigned char> zlib = {0x78, 0x01};
+        uint32_t adlerA = 1, adlerB = 0;
+        for (size_t offset = 0; offset < raw.size() || offset == 0; offset += 65535)
+        {
+            const size_t size = std::min<size_t>(65535, raw.size() - offset);
+            const bool last = offset + size >= raw.size();
+            zlib.push_back(last ? 1 : 0);
+            zlib.push_back(static_cast<unsigned char>(size));
+            zlib.push_back(static_cast<unsigned char>(size >> 8));
+            zlib.push_back(static_cast<unsigned char>(~size));
+            zlib.push_back(static_cast<unsigned char>(~size >> 8));
+            zlib.insert(zlib.end(), raw.begin() + offset, raw.begin() + offset + size);
+            for (size_t i = offset; i < offset + size; ++i)
+            {
+                adlerA = (adlerA + raw[i]) % 65521;
+                adlerB = (adlerB + adlerA) % 65521;
+            }
+            if (last)
+            {
+                break;
+            }
+        }
+        appendBigEndian(zlib, adlerB << 16 | adlerA);
+        writePngChunk(out, "IDAT", zlib);
+        writePngChunk(out, "IEND", {});
+    }
+}
+
+SoftwareRasterizer::SoftwareRasterizer(int width, int height)
+    : imageWidth(std::max(1, width)), imageHeight(std::max(1, height))
+{
+    quadsPerRow = (imageWidth + 1) / 2;
+    tilesX = (imageWidth + kRasterTileSize - 1) / kRasterTileSize;
+    tilesY = (imageHeight + kRasterTileSize - 1) / kRasterTileSize;
+    const size_t pixels = static_cast<size_t>(quadsPerRow) * ((imageHeight + 1) / 2) * 4;
+    colors.assign(pixels, 0xFF000000u);
+    depths.assign(pixels, 1.0f);
+}
+
+void SoftwareRasterizer::clear(const glm::vec3 &color)
+{
+    std::fill(colors.begin(), colors.end(), packColor(color));
+    std::fill(depths.begin(), depths.end(), 1.0f);
+}
+
+RasterStats SoftwareRasterizer::draw(const Vertex *vertices, size_t vertexCount, const unsigned int *indices, size_t indexCount,
+                                     const glm::mat4 &transform, const glm::mat4 &view, const glm::mat4 &projection,
+                                     const RasterOptions &options, ThreadPool *pool)
+{
+    const std::chrono::steady_clock::time_point start = std::chrono::steady_clock::now();
+    RasterStats stats;
+    stats.triangles = indexCount / 3;
+    const bool wireframe = options.mode == RasterMode::Wireframe;
+
+    // Vertex stage: what the vertex shader does, plus view-space positions for face shading
+    const glm::mat4 modelView = view * transform;
+    clipPositions.resize(vertexCount);
+    viewPositions.resize(vertexCount);
+    runParallel(pool, vertexCount, 16384, [&](size_t begin, size_t end)
+    {
+        for (size_t i = begin; i < end; ++i)
+        {
+            const glm::vec4 position = modelView * glm::vec4(vertices[i].Position, 1.0f);
+            viewPositions[i] = glm::vec3(position);
+            clipPositions[i] = projection * position;
+        }
+    });
+
+    // Setup and binning: each chunk of triangles goes to its own bins, so threads never share
+    // a list and tiles can replay the chunks in submission order
+    const size_t triangleCount = indexCount / 3;
+    const size_t threads = pool ? pool->size() : 1;
+    const size_t grain = std::max<size_t>(4096, (triangleCount + threads * 4 - 1) / (threads * 4));
+    const size_t chunkCount = std::max<size_t>(1, (triangleCount + grain - 1) / grain);
+    const size_t tileCount = static_cast<size_t>(tilesX) * tilesY;
+    if (chunks.size() < chunkCount)
+    {
+        chunks.resize(chunkCount);
+    }
+    for (size_t c = 0; c < chunkCount; ++c)
+    {
+        chunks[c].triangles.clear();
+        chunks[c].bins.resize(tileCount);
+        for (std::vector<uint32_t> &bin : chunks[c].bins)
+        {
+            bin.clear();
+        }
+    }
+
+    const float width = static_cast<float>(imageWidth);
+    const float height = static_cast<float>(imageHeight);
+    const uint32_t lineColor = packColor(options.color);
+    // Near plane z >= -w, then the guard band |x| <= bandX * w and |y| <= bandY * w
+    const float bandX = 1.0f + 2.0f * kGuardBandPixels / width;
+    const float bandY = 1.0f + 2.0f * kGuardBandPixels / height;
+    const glm::vec4 clipPlanes[5] = {glm::vec4(0.0f, 0.0f, 1.0f, 1.0f), glm::vec4(-1.0f, 0.0f, 0.0f, bandX),
+                                     glm::vec4(1.0f, 0.0f, 0.0f, bandX), glm::vec4(0.0f, -1.0f, 0.0f, bandY),
+                                     glm::vec4(0.0f, 1.0f, 0.0f, bandY)};
+    runParallel(pool, triangleCount, grain, [&](size_t begin, size_t end)
+    {
+        RasterChunk &chunk = chunks[begin / grain];
+        for (size_t triangle = begin; triangle < end; ++triangle)
+        {
+            const unsigned int *corner = indices + triangle * 3;
+            glm::vec4 polygon[kMaxClippedVertices] = {clipPositions[corner[0]], clipPositions[corner[1]], clipPositions[corner[2]]};
+            if (outsideFrustum(polygon[0], polygon[1], polygon[2]))
+            {
+                continue;
+            }
+            int count = 3;
+            for (const glm::vec4 &plane : clipPlanes)
+            {
+                if (glm::dot(plane, polygon[0]) >= 0.0f && glm::dot(plane, polygon[1]) >= 0.0f && glm::dot(plane, polygon[2]) >= 0.0f)
+                {
+                    continue;
+                }
+                // Rarely taken: only triangles crossing the near plane or far off screen
+                glm::vec4 clipped[kMaxClippedVertices];
+                for (const glm::vec4 &clipPlane : clipPlanes)
+                {
+                    count = clipPolygon(polygon, count, clipPlane, clipped);
+                    std::copy(clipped, clipped + count, polygon);
+                }
+                break;
+            }
+
+            uint32_t color = lineColor;
+            if (!wireframe)
+            {
+                // Two-sided headlight on the face normal
+                const glm::vec3 &a = viewPositions[corner[0]];
+                const glm::vec3 normal = glm::cross(viewPositions[corner[1]] - a, viewPositions[corner[2]] - a);
+                const float length = glm::length(normal);
+                const float facing = length > 0.0f ? std::fabs(normal.z) / length : 0.0f;
+                color = packColor(options.color * (0.25f + 0.75f * facing));
+            }
+
+            ScreenVertex screen[kMaxClippedVertices];
+            for (int i = 0; i < count; ++i)
+            {
+                screen[i] = toScreen(polygon[i], width, height);
+            }
+            for (int i = 1; i + 1 < count; ++i)
+            {
+                ScreenVertex fan[3] = {screen[0], screen[i], screen[i + 1]};
+                RasterTriangle setup;
+                if (!setupTriangle(fan, color, wireframe, imageWidth, imageHeight, setup))
+                {
+                    continue;
+                }
+                const uint32_t index = static_cast<uint32_t>(chunk.triangles.size());
+                chunk.triangles.push_back(setup);
+                for (int ty = setup.minY / kRasterTileSize; ty <= setup.maxY / kRasterTileSize; ++ty)
+                {
+                    for (int tx = setup.minX / kRasterTileSize; tx <= setup.maxX / kRasterTileSize; ++tx)
+                    {
+                        chunk.bins[static_cast<size_t>(ty) * tilesX + tx].push_back(index);
+                    }
+                }
+            }
+        }
+    });
+
+    // Tiles: one thread owns a tile's pixels, so no writes are shared
+    std::atomic<size_t> pixels{0};
+    runParallel(pool, tileCount, 1, [&](size_t begin, size_t end)
+    {
+        size_t written = 0;
+        for (size_t tile = begin; tile < end; ++tile)
+        {
+            const int tileX = static_cast<int>(tile % tilesX) * kRasterTileSize;
+            const int tileY = static_cast<int>(tile / tilesX) * kRasterTileSize;
+            for (size_t c = 0; c < chunkCount; ++c)
+            {
+                const RasterChunk &chunk = chunks[c];
+                for (uint32_t index : chunk.bins[tile])
+                {
+                    written += rasterizeTile(chunk.triangles[index], tileX, tileY, wireframe, options.depthTest,
+                                             colors.data(), depths.data(), quadsPerRow);
+                }
+            }
+        }
+        pixels += written;
+    });
+
+    for (size_t c = 0; c < chunkCount; ++c)
+    {
+        stats.rasterizedTriangles += chunks[c].triangles.size();
+    }
+    stats.pixels = pixels.load();
+    std::chrono::duration<double> elapsed = std::chrono::steady_clock::now() - start;
+    stats.seconds = elapsed.count();
+    return stats;
+}
+
+bool SoftwareRasterizer::writeImage(const char *path) const
+{
+    std::vector<unsigned char> rgb(static_cast<size_t>(imageWidth) * imageHeight * 3);
+    for (int y = 0; y < imageHeight; ++y)
+    {
+        for (int x = 0; x < imageWidth; ++x)
+        {
+            const uint32_t color = pixel(x, y);
+            unsigned char *out = &rgb[(static_cast<size_t>(y) * imageWidth + x) * 3];
+            out[0] = static_cast<unsigned char>(color);
+            out[1] = static_cast<unsigned char>(color >> 8);
+            out[2] = static_cast<unsigned char>(color >> 16);
+        }
+    }
+
+    std::ofstream file(path, std::ios::binary);
+    if (!file)
+    {
+        std::cerr << "Failed to open " << path << " for writing" << std::endl;
+        return false;
+    }
+    const std::string name(path);
+    if (name.size() >= 4 && name.compare(name.size() - 4, 4, ".png") == 0)
+    {
+        writePng(file, rgb, imageWidth, imageHeight);
+    }
+    else
+    {
+        file << "P6\n" << imageWidth << " " << imageHeight << "\n255\n";
+        file.write(reinterpret_cast<const char *>(rgb.data()), rgb.size());
+    }
+    if (!file)
+    {
+        std::cerr << "Failed to write " << path << std::endl;
+        return false;
+    }
+    return true;
+}
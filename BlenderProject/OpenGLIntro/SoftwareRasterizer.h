@@ -0,0 +1,142 @@
+#pragma once
+
+#include "Mesh.h"
+
+#include <glm/glm.hpp>
+
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+class ThreadPool;
+
+// Side of the square screen tiles triangles are binned into; each tile is rasterized by one thread
+constexpr int kRasterTileSize = 32;
+
+/**
+ * @brief What the software rasterizer draws for each triangle, like glPolygonMode.
+ */
+enum class RasterMode
+{
+    Fill,     // GL_FILL
+    Wireframe // GL_LINE, one pixel wide edges
+};
+
+struct RasterOptions
+{
+    RasterMode mode = RasterMode::Fill;
+    bool depthTest = true;             // GL_LESS against the depth buffer
+    glm::vec3 color = glm::vec3(1.0f); // Filled triangles are shaded with a headlight, lines are flat
+};
+
+/**
+ * @brief Counts from one draw, for throughput reporting.
+ */
+struct RasterStats
+{
+    size_t triangles = 0;           // Submitted
+    size_t rasterizedTriangles = 0; // Left after clipping, culling off-screen and degenerate ones
+    size_t pixels = 0;              // Pixels written, after the depth test
+    double seconds = 0.0;
+};
+
+/**
+ * @brief A triangle in screen space, ready for the tile loop.
+ *
+ * Coverage uses fixed-point edge functions on a 1/16 pixel grid, which are exact, so two
+ * triangles sharing an edge never both draw or both miss a pixel. Wireframe uses the same edges
+ * scaled to distances in pixels.
+ */
+struct RasterTriangle
+{
+    int32_t edgeA[3], edgeB[3]; // edge(x, y) = A * x + B * y + C, x and y in subpixels, >= 0 inside
+    int64_t edgeC[3];
+    float lineA[3], lineB[3], lineC[3]; // Distance to each edge in pixels, x and y in pixels
+    float depthA, depthB, depthC;       // depth(x, y) = A * x + B * y + C, in [0, 1]
+    int minX, minY, maxX, maxY;         // Pixel bounds, clamped to the target
+    uint32_t color;
+};
+
+/**
+ * @brief Triangles set up by one thread and the tiles each one touches, kept in submission
+ * order so every tile draws them in the order they were given.
+ */
+struct RasterChunk
+{
+    std::vector<RasterTriangle> triangles;
+    std::vector<std::vector<uint32_t>> bins; // Per tile, indices into triangles
+};
+
+/**
+ * @brief A CPU-only renderer for the viewer's meshes, for machines without a GPU.
+ *
+ * draw() takes the same vertex and index buffers and transform/view/projection matrices as the
+ * OpenGL path. Vertices are transformed, triangles clipped against the near plane (and a guard
+ * band well outside the screen, which keeps the fixed-point math in range), set up and binned
+ * into kRasterTileSize tiles; tiles are then rasterized in parallel with edge functions,
+ * a 2x2 pixel quad at a time with SSE. Color and depth are stored quad by quad so a quad is one
+ * aligned load; writeImage converts back to rows.
+ */
+class SoftwareRasterizer
+{
+public:
+    SoftwareRasterizer(int width, int height);
+
+    /**
+     * @brief Fills the color buffer and resets the depth buffer to the far plane.
+     */
+    void clear(const glm::vec3 &color);
+
+    /**
+     * @brief Draws indexed triangles, like glDrawElements(GL_TRIANGLES).
+     *
+     * @param vertices Vertex buffer.
+     * @param vertexCount Number of vertices.
+     * @param indices Index buffer, three per triangle.
+     * @param indexCount Number of indices.
+     * @param transform Model matrix.
+     * @param view View matrix.
+     * @param projection Projection matrix.
+     * @param options Fill or wireframe, depth test and color.
+     * @param pool Optional; spreads vertex, setup and tile work over its threads.
+     * @return Triangle and pixel counts and the time taken.
+     */
+    RasterStats draw(const Vertex *vertices, size_t vertexCount, const unsigned int *indices, size_t indexCount,
+                     const glm::mat4 &transform, const glm::mat4 &view, const glm::mat4 &projection,
+                     const RasterOptions &options, ThreadPool *pool = nullptr);
+
+    /**
+     * @brief Color of a pixel as RGBA8 (red in the lowest byte); y = 0 is the top row.
+     */
+    uint32_t pixel(int x, int y) const { return colors[pixelIndex(x, y)]; }
+    float depth(int x, int y) const { return depths[pixelIndex(x, y)]; }
+
+    /**
+     * @brief Writes the color buffer as a binary PPM, or as a PNG when the path ends in ".png".
+     *
+     * @return false if the file could not be written.
+     */
+    bool writeImage(const char *path) const;
+
+    int width() const { return imageWidth; }
+    int height() const { return imageHeight; }
+
+private:
+    size_t pixelIndex(int x, int y) const
+    {
+        return (static_cast<size_t>(y >> 1) * quadsPerRow + (x >> 1)) * 4 + (y & 1) * 2 + (x & 1);
+    }
+
+    int imageWidth;
+    int imageHeight;
+    int quadsPerRow;
+    int tilesX;
+    int tilesY;
+    std::vector<uint32_t> colors; // 2x2 quads, row by row
+    std::vector<float> depths;
+
+    // Scratch kept between draws
+    std::vector<glm::vec4> clipPositions;
+    std::vector<glm::vec3> viewPositions;
+    std::vector<RasterChunk> chunks;
+};
@@ -0,0 +1,308 @@
+#include "Telemetry.h"
+
+#include <algorithm>
+#include <charconv>
+#include <cstring>
+#include <iostream>
+
+namespace
+{
+    // How long the background thread naps when the ring is empty
+    constexpr std::chrono::milliseconds kDrainInterval(1);
+
+    const char kBinaryMagic[8] = {'T', 'L', 'M', 'T', 'R', 'Y', '0', '1'};
+
+    void appendInteger(std::string &out, int64_t value)
+    {
+        char digits[24];
+        const std::to_chars_result result = std::to_chars(digits, digits + sizeof(digits), value);
+        out.append(digits, result.ptr);
+    }
+
+    // Six significant digits, the way cout prints a double by default
+    void appendReal(std::string &out, double value)
+    {
+        char digits[32];
+        const std::to_chars_result result = std::to_chars(digits, digits + sizeof(digits), value, std::chars_format::general, 6);
+        out.append(digits, result.ptr);
+    }
+
+    void appendText(const TelemetryEvent &event, std::string &out)
+    {
+        out += event.name;
+        out += ':';
+        for (uint32_t f = 0; f < event.fieldCount; ++f)
+        {
+            const TelemetryField &field = event.fields[f];
+            out += ' ';
+            out += field.name;
+            out += '=';
+            if (field.type == TelemetryField::Type::Integer)
+            {
+                appendInteger(out, field.integer);
+            }
+            else
+            {
+                appendReal(out, field.real);
+            }
+        }
+        out += '\n';
+    }
+
+    void appendName(std::vector<char> &out, const char *name)
+    {
+        const size_t length = std::min<size_t>(std::strlen(name), 255);
+        out.push_back(static_cast<char>(length));
+        out.insert(out.end(), name, name + length);
+    }
+
+    template <typename T>
+    void appendRaw(std::vector<char> &out, const T &value)
+    {
+        const char *bytes = reinterpret_cast<const char *>(&value);
+        out.insert(out.end(), bytes, bytes + sizeof(T));
+    }
+
+    void appendBinary(const TelemetryEvent &event, std::vector<char> &out)
+    {
+        appendRaw(out, event.nanoseconds);
+        appendName(out, event.name);
+        out.push_back(static_cast<char>(event.fieldCount));
+        for (uint32_t f = 0; f < event.fieldCount; ++f)
+        {
+            const TelemetryField &field = event.fields[f];
+            appendName(out, field.name);
+            out.push_back(static_cast<char>(field.type));
+            if (field.type == TelemetryField::Type::Integer)
+            {
+                appendRaw(out, field.integer);
+            }
+            else
+            {
+                appendRaw(out, field.real);
+            }
+        }
+    }
+}
+
+TelemetryEvent &TelemetryEvent::add(const char *fieldName, double value)
+{
+    if (fieldCount < kTelemetryMaxFields)
+    {
+        TelemetryField &field = fields[fieldCount++];
+        field.name = fieldName;
+        field.type = TelemetryField::Type::Real;
+        field.real = value;
+    }
+    return *this;
+}
+
+TelemetryEvent &TelemetryEvent::add(const char *fieldName, int64_t value)
+{
+    if (fieldCount < kTelemetryMaxFields)
+    {
+        TelemetryField &field = fields[fieldCount++];
+        field.name = fieldName;
+        field.type = TelemetryField::Type::Integer;
+        field.integer = value;
+    }
+    return *this;
+}
+
+Telemetry::Telemetry(const TelemetryOptions &options)
+    : start(std::chrono::steady_clock::now()), text(options.text), binaryRequested(options.binaryPath != nullptr)
+{
+    // A power of two, so positions map to slots with a mask
+    size_t capacity = 2;
+    while (capacity < options.capacity)
+    {
+        capacity <<= 1;
+    }
+    slots.reset(new Slot[capacity]);
+    mask = capacity - 1;
+    for (size_t i = 0; i < capacity; ++i)
+    {
+        slots[i].sequence.store(i, std::memory_order_relaxed);
+    }
+
+    if (binaryRequested)
+    {
+        binary = std::fopen(options.binaryPath, "wb");
+        if (binary)
+        {
+            std::fwrite(kBinaryMagic, 1, sizeof(kBinaryMagic), binary);
+        }
+        else
+        {
+            std::cerr << "Failed to open " << options.binaryPath << " for telemetry" << std::endl;
+        }
+    }
+    drainer = std::thread(&Telemetry::drainLoop, this);
+}
+
+Telemetry::~Telemetry()
+{
+    stopping.store(true);
+    drainer.join();
+    if (binary)
+    {
+        std::fclose(binary);
+    }
+}
+
+bool Telemetry::log(TelemetryEvent &event)
+{
+    event.nanoseconds = static_cast<uint64_t>(std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::steady_clock::now() - start).count());
+
+    // Each slot's sequence says whose turn it is: equal to the position when free for that
+    // producer, position + 1 once filled, position + capacity once drained
+    size_t position = head.load(std::memory_order_relaxed);
+    while (true)
+    {
+        Slot &slot = slots[position & mask];
+        const size_t sequence = slot.sequence.load(std::memory_order_acquire);
+        const intptr_t difference = static_cast<intptr_t>(sequence) - static_cast<intptr_t>(position);
+        if (difference == 0)
+        {
+            if (head.compare_exchange_weak(position, position + 1, std::memory_order_relaxed))
+            {
+                slot.event = event;
+                slot.sequence.store(position + 1, std::memory_order_release);
+                return true;
+            }
+        }
+        else if (difference < 0)
+        {
+            dropped.fetch_add(1, std::memory_order_relaxed);
+            return false;
+        }
+        else
+        {
+            position = head.load(std::memory_order_relaxed);
+        }
+    }
+}
+
+void Telemetry::flush()
+{
+    const uint64_t logged = head.load(std::memory_order_acquire);
+    while (written.load(std::memory_order_acquire) < logged)
+    {
+        std::this_thread::sleep_for(std::chrono::microseconds(100));
+    }
+}
+
+TelemetryStats Telemetry::stats() const
+{
+    TelemetryStats stats;
+    stats.logged = head.load(std::memory_order_acquire);
+    stats.dropped = dropped.load(std::memory_order_relaxed);
+    stats.written = written.load(std::memory_order_acquire);
+    return stats;
+}
+
+void Telemetry::drainLoop()
+{
+    while (true)
+    {
+        if (drain() > 0)
+        {
+            continue;
+        }
+        if (stopping.load(std::memory_order_acquire))
+        {
+            // Whatever was logged before the destructor ran
+            while (drain() > 0)
+            {
+            }
+            return;
+        }
+        std::this_thread::sleep_for(kDrainInterval);
+    }
+}
+
+size_t Telemetry::drain()
+{
+    lines.clear();
+    records.clear();
+    size_t count = 0;
+    size_t position = tail.load(std::memory_order_relaxed);
+    // Up to one ring's worth per block, so a busy producer cannot hold the output back forever
+    for (; count <= mask; ++count, ++position)
+    {
+        Slot &slot = slots[position & mask];
+        if (slot.sequence.load(std::memory_order_acquire) != position + 1)
+        {
+            break;
+        }
+        if (text)
+        {
+            appendText(slot.event, lines);
+        }
+        if (binary)
+        {
+            appendBinary(slot.event, records);
+        }
+        slot.sequence.store(position + mask + 1, std::memory_order_release);
+    }
+    tail.store(position, std::memory_order_relaxed);
+    if (count == 0)
+    {
+        return 0;
+    }
+
+    if (!lines.empty())
+    {
+        std::fwrite(lines.data(), 1, lines.size(), text);
+        std::fflush(text);
+    }
+    if (!records.empty())
+    {
+        std::fwrite(records.data(), 1, records.size(), binary);
+    }
+    written.fetch_add(count, std::memory_order_release);
+    return count;
+}
+
+TelemetryChannel::TelemetryChannel(uint32_t sampleEvery, double maxPerSecond)
+    : sampleEvery(std::max<uint32_t>(sampleEvery, 1)), maxPerSecond(maxPerSecond), tokens(std::max(maxPerSecond, 1.0)),
+      lastRefill(std::chrono::steady_clock::now())
+{
+}
+
+bool TelemetryChannel::admit()
+{
+    const bool sampled = sampleCounter == 0;
+    sampleCounter = (sampleCounter + 1) % sampleEvery;
+    if (!sampled)
+    {
+        ++skippedCount;
+        return false;
+    }
+    if (maxPerSecond > 0.0)
+    {
+        // Token bucket: refills at maxPerSecond and holds at most one second's worth
+        const std::chrono::steady_clock::time_point now = std::chrono::steady_clock::now();
+        tokens = std::min(std::max(maxPerSecond, 1.0), tokens + std::chrono::duration<double>(now - lastRefill).count() * maxPerSecond);
+        lastRefill = now;
+        if (tokens < 1.0)
+        {
+            ++skippedCount;
+            return false;
+        }
+        tokens -= 1.0;
+    }
+    return true;
+}
+
+void FrameCounters::logAndReset(Telemetry &telemetry, TelemetryChannel &channel, int frame)
+{
+    if (channel.admit())
+    {
+        TelemetryEvent event("frame");
+        event.add("frame", frame).add("drawCalls", drawCalls).add("triangles", triangles).add("uploadBytes", uploadBytes);
+        event.add("stateChanges", stateChanges).add("apiCalls", apiCalls);
+        telemetry.log(event);
+    }
+    *this = FrameCounters();
+}
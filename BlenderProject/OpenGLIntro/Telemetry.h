@@ -0,0 +1,219 @@
+#pragma once
+
+#include <atomic>
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
+#include <cstdio>
+#include <memory>
+#include <string>
+#include <thread>
+#include <vector>
+
+// Most fields one event can carry
+constexpr size_t kTelemetryMaxFields = 8;
+
+// Mean cost of Telemetry::log on the logging thread that --bench-telemetry must stay under
+constexpr double kTelemetryTargetLogNanoseconds = 500.0;
+
+// Events the ring holds before new ones are dropped
+constexpr size_t kTelemetryDefaultCapacity = 4096;
+
+/**
+ * @brief One named value of an event. Names must outlive the Telemetry, which string literals do;
+ * they are stored as pointers so recording never copies text.
+ */
+struct TelemetryField
+{
+    enum class Type : uint8_t
+    {
+        Integer,
+        Real
+    };
+
+    const char *name;
+    Type type;
+    union
+    {
+        int64_t integer;
+        double real;
+    };
+};
+
+/**
+ * @brief A fixed-size record of a name and up to kTelemetryMaxFields fields, built on the stack
+ * and copied into the ring as is.
+ */
+struct TelemetryEvent
+{
+    explicit TelemetryEvent(const char *name) : name(name) {}
+
+    TelemetryEvent &add(const char *fieldName, double value);
+    TelemetryEvent &add(const char *fieldName, float value) { return add(fieldName, static_cast<double>(value)); }
+    TelemetryEvent &add(const char *fieldName, int64_t value);
+    TelemetryEvent &add(const char *fieldName, int value) { return add(fieldName, static_cast<int64_t>(value)); }
+    TelemetryEvent &add(const char *fieldName, size_t value) { return add(fieldName, static_cast<int64_t>(value)); }
+
+    const char *name;
+    uint64_t nanoseconds = 0; // Since the Telemetry started; set when the event is logged
+    uint32_t fieldCount = 0;  // Fields past kTelemetryMaxFields are ignored
+    TelemetryField fields[kTelemetryMaxFields];
+};
+
+/**
+ * @brief Where the drained events go and how much they may queue.
+ */
+struct TelemetryOptions
+{
+    std::FILE *text = stdout;         // One "name: field=value ..." line per event, or nullptr
+    const char *binaryPath = nullptr; // Optional file of binary records, see Telemetry
+    size_t capacity = kTelemetryDefaultCapacity;
+};
+
+/**
+ * @brief Counts since the Telemetry started.
+ */
+struct TelemetryStats
+{
+    uint64_t logged = 0;  // Accepted into the ring
+    uint64_t dropped = 0; // Rejected because the ring was full
+    uint64_t written = 0; // Drained to the sinks
+};
+
+/**
+ * @brief Asynchronous event log: any thread logs into a bounded lock-free ring and a background
+ * thread formats the events and writes them out in blocks, so the frame loop never waits on a
+ * terminal or a pipe. A full ring drops the event rather than block.
+ *
+ * The binary sink starts with the 8 bytes "TLMTRY01" followed by one record per event: the
+ * timestamp in nanoseconds (u64), the name (u8 length, bytes), the field count (u8), then per
+ * field the name (u8 length, bytes), the type (u8, 0 integer, 1 real) and the value (8 bytes).
+ * All numbers are little endian, as written by the machine that logged them.
+ */
+class Telemetry
+{
+public:
+    explicit Telemetry(const TelemetryOptions &options = TelemetryOptions());
+
+    /**
+     * @brief Writes out everything still queued, then stops the background thread.
+     */
+    ~Telemetry();
+
+    Telemetry(const Telemetry &) = delete;
+    Telemetry &operator=(const Telemetry &) = delete;
+
+    /**
+     * @brief Timestamps the event and queues a copy of it. Safe from any thread; never blocks.
+     *
+     * @return false if the ring was full and the event was dropped.
+     */
+    bool log(TelemetryEvent &event);
+
+    /**
+     * @brief Waits until every event logged so far has been written out.
+     */
+    void flush();
+
+    TelemetryStats stats() const;
+
+    /**
+     * @brief False if the binary sink was requested but its file could not be opened.
+     */
+    bool isOpen() const { return !binaryRequested || binary != nullptr; }
+
+private:
+    struct alignas(64) Slot
+    {
+        std::atomic<size_t> sequence;
+        TelemetryEvent event{""};
+    };
+
+    void drainLoop();
+    size_t drain();
+
+    std::unique_ptr<Slot[]> slots;
+    size_t mask;
+    std::chrono::steady_clock::time_point start;
+    std::FILE *text;
+    std::FILE *binary = nullptr;
+    bool binaryRequested;
+
+    // Producers claim positions from head; the background thread alone advances tail
+    alignas(64) std::atomic<size_t> head{0};
+    alignas(64) std::atomic<size_t> tail{0};
+    std::atomic<uint64_t> dropped{0};
+    std::atomic<uint64_t> written{0};
+    std::atomic<bool> stopping{false};
+
+    // Reused by the background thread for each block it writes
+    std::string lines;
+    std::vector<char> records;
+
+    std::thread drainer;
+};
+
+/**
+ * @brief A kind of event with its own sampling and rate limit, such as the per-frame transform
+ * values. Meant to be owned by the thread that logs it.
+ */
+class TelemetryChannel
+{
+public:
+    /**
+     * @param sampleEvery Keep one event in this many; 1 keeps them all.
+     * @param maxPerSecond Most events kept per second after sampling; 0 for no limit. Bursts of
+     * up to one second's worth are let through.
+     */
+    explicit TelemetryChannel(uint32_t sampleEvery = 1, double maxPerSecond = 0.0);
+
+    /**
+     * @brief True if the next event should be logged. Call it before building the event, so a
+     * skipped one costs nothing else.
+     */
+    bool admit();
+
+    /**
+     * @brief Events turned away by admit().
+     */
+    uint64_t skipped() const { return skippedCount; }
+
+private:
+    uint32_t sampleEvery;
+    uint32_t sampleCounter = 0;
+    double maxPerSecond;
+    double tokens;
+    std::chrono::steady_clock::time_point lastRefill;
+    uint64_t skippedCount = 0;
+};
+
+/**
+ * @brief What the render thread submitted in one frame.
+ */
+struct FrameCounters
+{
+    uint64_t drawCalls = 0;
+    uint64_t triangles = 0;
+    uint64_t uploadBytes = 0;
+    uint64_t stateChanges = 0;
+    uint64_t apiCalls = 0;
+
+    void draw(uint64_t triangleCount)
+    {
+        ++drawCalls;
+        triangles += triangleCount;
+    }
+
+    void upload(uint64_t bytes) { uploadBytes += bytes; }
+
+    void submission(uint64_t stateChangeCount, uint64_t apiCallCount)
+    {
+        stateChanges += stateChangeCount;
+        apiCalls += apiCallCount;
+    }
+
+    /**
+     * @brief Logs the counters as a "frame" event if the channel admits it, then clears them.
+     */
+    void logAndReset(Telemetry &telemetry, TelemetryChannel &channel, int frame);
+};
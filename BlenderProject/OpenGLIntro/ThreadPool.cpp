@@ -0,0 +1,98 @@
+#include "ThreadPool.h"
+
+#include <algorithm>
+
+ThreadPool::ThreadPool(unsigned int threadCount)
+{
+    if (threadCount == 0)
+    {
+        threadCount = std::max(1u, std::thread::hardware_concurrency());
+    }
+    workers.reserve(threadCount - 1);
+    for (unsigned int i = 1; i < threadCount; ++i)
+    {
+        workers.emplace_back(&ThreadPool::workerLoop, this);
+    }
+}
+
+ThreadPool::~ThreadPool()
+{
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        stopping = true;
+    }
+    wake.notify_all();
+    for (std::thread &worker : workers)
+    {
+        worker.join();
+    }
+}
+
+void ThreadPool::parallelFor(size_t count, size_t grain, const std::function<void(size_t, size_t)> &body)
+{
+    grain = std::max<size_t>(1, grain);
+    if (workers.empty() || count <= grain)
+    {
+        if (count > 0)
+        {
+            body(0, count);
+        }
+        return;
+    }
+
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        job = &body;
+        jobCount = count;
+        jobGrain = grain;
+        nextChunk.store(0);
+        busyWorkers = static_cast<unsigned int>(workers.size());
+        ++generation;
+    }
+    wake.notify_all();
+
+    runChunks();
+
+    // Workers still holding a chunk must finish before body goes out of scope
+    std::unique_lock<std::mutex> lock(mutex);
+    finished.wait(lock, [this]() { return busyWorkers == 0; });
+    job = nullptr;
+}
+
+void ThreadPool::workerLoop()
+{
+    uint64_t seen = 0;
+    for (;;)
+    {
+        {
+            std::unique_lock<std::mutex> lock(mutex);
+            wake.wait(lock, [this, seen]() { return stopping || generation != seen; });
+            if (stopping)
+            {
+                return;
+            }
+            seen = generation;
+        }
+
+        runChunks();
+
+        std::lock_guard<std::mutex> lock(mutex);
+        if (--busyWorkers == 0)
+        {
+            finished.notify_one();
+        }
+    }
+}
+
+void ThreadPool::runChunks()
+{
+    for (;;)
+    {
+        size_t begin = nextChunk.fetch_add(jobGrain);
+        if (begin >= jobCount)
+        {
+            return;
+        }
+        (*job)(begin, std::min(jobCount, begin + jobGrain));
+    }
+}
@@ -0,0 +1,59 @@
+#pragma once
+
+#include <atomic>
+#include <condition_variable>
+#include <cstddef>
+#include <cstdint>
+#include <functional>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+/**
+ * @brief Fixed set of worker threads for data-parallel loops that run every frame, where
+ * starting threads per call would cost more than the work itself.
+ */
+class ThreadPool
+{
+public:
+    /**
+     * @brief Starts the workers.
+     *
+     * @param threadCount Threads taking part in a loop, the caller included; 0 uses every
+     * hardware thread.
+     */
+    explicit ThreadPool(unsigned int threadCount = 0);
+    ~ThreadPool();
+
+    ThreadPool(const ThreadPool &) = delete;
+    ThreadPool &operator=(const ThreadPool &) = delete;
+
+    /**
+     * @brief Number of threads that share a loop, the caller included.
+     */
+    unsigned int size() const { return static_cast<unsigned int>(workers.size()) + 1; }
+
+    /**
+     * @brief Calls body(begin, end) over [0, count) in chunks of `grain` items, on the workers
+     * and the calling thread, and returns once every chunk is done. Small loops run inline.
+     * Only one loop may be in flight at a time.
+     */
+    void parallelFor(size_t count, size_t grain, const std::function<void(size_t begin, size_t end)> &body);
+
+private:
+    void workerLoop();
+    void runChunks();
+
+    std::vector<std::thread> workers;
+    std::mutex mutex;
+    std::condition_variable wake;
+    std::condition_variable finished;
+
+    const std::function<void(size_t, size_t)> *job = nullptr;
+    size_t jobCount = 0;
+    size_t jobGrain = 1;
+    std::atomic<size_t> nextChunk{0};
+    unsigned int busyWorkers = 0;
+    uint64_t generation = 0;
+    bool stopping = false;
+};
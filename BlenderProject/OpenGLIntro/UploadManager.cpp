@@ -0,0 +1,189 @@
+#include "UploadManager.h"
+#include "Profiler.h"
+
+#include <GL/glew.h>
+
+#include <algorithm>
+#include <chrono>
+#include <cstring>
+#include <iostream>
+
+#ifdef _WIN32
+#ifndef NOMINMAX
+#define NOMINMAX
+#endif
+#include <windows.h>
+#include <psapi.h>
+#else
+#include <sys/resource.h>
+#endif
+
+namespace
+{
+    class ScopedSeconds
+    {
+    public:
+        explicit ScopedSeconds(double &total) : total(total), start(std::chrono::steady_clock::now()) {}
+        ~ScopedSeconds() { total += std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count(); }
+
+    private:
+        double &total;
+        std::chrono::steady_clock::time_point start;
+    };
+}
+
+void printUploadStats(const char *label, const UploadStats &stats)
+{
+    std::cout << label << ": " << stats.bytes / (1024.0 * 1024.0) << " MB in " << stats.seconds * 1000.0 << " ms ("
+              << stats.megabytesPerSecond() << " MB/s), " << stats.chunks << " chunks, " << stats.stalls << " stalls, "
+              << stats.stagingBytes / 1024 << " KB " << (stats.persistent ? "persistent staging ring" : "glBufferSubData")
+              << std::endl;
+}
+
+size_t peakResidentBytes()
+{
+#ifdef _WIN32
+    PROCESS_MEMORY_COUNTERS counters;
+    if (GetProcessMemoryInfo(GetCurrentProcess(), &counters, sizeof(counters)))
+    {
+        return counters.PeakWorkingSetSize;
+    }
+    return 0;
+#else
+    struct rusage usage;
+    if (getrusage(RUSAGE_SELF, &usage) != 0)
+    {
+        return 0;
+    }
+#ifdef __APPLE__
+    return static_cast<size_t>(usage.ru_maxrss);
+#else
+    return static_cast<size_t>(usage.ru_maxrss) * 1024; // Kilobytes on Linux
+#endif
+#endif
+}
+
+UploadManager::~UploadManager()
+{
+    destroy();
+}
+
+bool UploadManager::create(size_t chunkBytes, unsigned int chunks, bool allowPersistent)
+{
+    destroy();
+    chunkSize = std::max<size_t>(chunkBytes, 1);
+    fences.assign(std::max(chunks, 1u), 0);
+    counters.persistent = allowPersistent && GLEW_ARB_buffer_storage;
+    if (!counters.persistent)
+    {
+        return true;
+    }
+
+    const GLbitfield flags = GL_MAP_WRITE_BIT | GL_MAP_PERSISTENT_BIT | GL_MAP_COHERENT_BIT;
+    const GLsizeiptr size = static_cast<GLsizeiptr>(chunkSize * fences.size());
+    glGenBuffers(1, &staging);
+    glBindBuffer(GL_COPY_READ_BUFFER, staging);
+    glBufferStorage(GL_COPY_READ_BUFFER, size, NULL, flags);
+    mapped = static_cast<unsigned char *>(glMapBufferRange(GL_COPY_READ_BUFFER, 0, size, flags));
+    glBindBuffer(GL_COPY_READ_BUFFER, 0);
+    if (!mapped)
+    {
+        std::cerr << "Failed to map the upload staging ring persistently" << std::endl;
+        destroy();
+        return false;
+    }
+    counters.stagingBytes = chunkSize * fences.size();
+    return true;
+}
+
+unsigned int UploadManager::createBuffer(const void *data, size_t size, bool dynamic)
+{
+    GLuint buffer = 0;
+    glGenBuffers(1, &buffer);
+    glBindBuffer(GL_COPY_WRITE_BUFFER, buffer);
+    // Storage only; the contents follow in chunks, so the driver never holds a copy of all of it
+    glBufferData(GL_COPY_WRITE_BUFFER, static_cast<GLsizeiptr>(size), NULL, dynamic ? GL_DYNAMIC_DRAW : GL_STATIC_DRAW);
+    glBindBuffer(GL_COPY_WRITE_BUFFER, 0);
+    if (data)
+    {
+        upload(buffer, 0, data, size);
+    }
+    return buffer;
+}
+
+void UploadManager::upload(unsigned int buffer, size_t offset, const void *data, size_t size)
+{
+    PROFILE_FUNCTION();
+    ScopedSeconds timer(counters.seconds);
+    glBindBuffer(GL_COPY_WRITE_BUFFER, buffer);
+    if (mapped)
+    {
+        glBindBuffer(GL_COPY_READ_BUFFER, staging);
+    }
+    const unsigned char *bytes = static_cast<const unsigned char *>(data);
+    for (size_t done = 0; done < size; done += chunkSize)
+    {
+        copyChunk(offset + done, bytes + done, std::min(chunkSize, size - done));
+    }
+    glBindBuffer(GL_COPY_READ_BUFFER, 0);
+    glBindBuffer(GL_COPY_WRITE_BUFFER, 0);
+    counters.bytes += size;
+}
+
+void UploadManager::copyChunk(size_t offset, const unsigned char *data, size_t size)
+{
+    // Expects the destination on GL_COPY_WRITE_BUFFER and the ring on GL_COPY_READ_BUFFER
+    ++counters.chunks;
+    if (!mapped)
+    {
+        glBufferSubData(GL_COPY_WRITE_BUFFER, static_cast<GLintptr>(offset), static_cast<GLsizeiptr>(size), data);
+        return;
+    }
+
+    // Wait until the GPU has copied out what this slot held last time round the ring
+    GLsync &fence = fences[slot];
+    if (fence)
+    {
+        if (glClientWaitSync(fence, 0, 0) == GL_TIMEOUT_EXPIRED)
+        {
+            ++counters.stalls;
+            while (glClientWaitSync(fence, GL_SYNC_FLUSH_COMMANDS_BIT, 1000000) == GL_TIMEOUT_EXPIRED)
+            {
+            }
+        }
+        glDeleteSync(fence);
+        fence = 0;
+    }
+    const size_t slotOffset = slot * chunkSize;
+    std::memcpy(mapped + slotOffset, data, size);
+    glCopyBufferSubData(GL_COPY_READ_BUFFER, GL_COPY_WRITE_BUFFER, static_cast<GLintptr>(slotOffset), static_cast<GLintptr>(offset),
+                        static_cast<GLsizeiptr>(size));
+    fence = glFenceSync(GL_SYNC_GPU_COMMANDS_COMPLETE, 0);
+    slot = (slot + 1) % static_cast<unsigned int>(fences.size());
+}
+
+void UploadManager::destroy()
+{
+    for (GLsync &fence : fences)
+    {
+        if (fence)
+        {
+            glDeleteSync(fence);
+            fence = 0;
+        }
+    }
+    if (staging)
+    {
+        if (mapped)
+        {
+            glBindBuffer(GL_COPY_READ_BUFFER, staging);
+            glUnmapBuffer(GL_COPY_READ_BUFFER);
+            glBindBuffer(GL_COPY_READ_BUFFER, 0);
+            mapped = nullptr;
+        }
+        glDeleteBuffers(1, &staging);
+        staging = 0;
+    }
+    slot = 0;
+    counters = UploadStats();
+}
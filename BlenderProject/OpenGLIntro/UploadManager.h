@@ -0,0 +1,96 @@
+#pragma once
+
+#include <GL/glew.h>
+
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+// Bytes copied per step; a larger upload is split into chunks of this size
+constexpr size_t kUploadChunkBytes = 1 << 20;
+
+// Chunks in the staging ring, so the CPU fills one while the GPU copies out of the others
+constexpr unsigned int kUploadRingChunks = 4;
+
+/**
+ * @brief What an UploadManager has sent to the GPU.
+ */
+struct UploadStats
+{
+    uint64_t bytes = 0;       // Copied into buffers
+    uint64_t chunks = 0;      // Copies issued
+    uint64_t stalls = 0;      // Chunks that had to wait for the GPU before they could be reused
+    double seconds = 0.0;     // Spent inside upload() and createBuffer()
+    size_t stagingBytes = 0;  // Host memory the staging ring holds, the most an upload adds
+    bool persistent = false;  // Staging through a persistently mapped ring
+
+    double megabytesPerSecond() const { return seconds > 0.0 ? bytes / seconds / (1024.0 * 1024.0) : 0.0; }
+};
+
+/**
+ * @brief Prints bytes, throughput, chunks, stalls and staging memory on one line.
+ */
+void printUploadStats(const char *label, const UploadStats &stats);
+
+/**
+ * @brief Peak resident memory of the process so far, in bytes; 0 where it cannot be read.
+ */
+size_t peakResidentBytes();
+
+/**
+ * @brief Streams data from the caller's memory into buffer objects in fixed-size chunks.
+ *
+ * With GL_ARB_buffer_storage each chunk is copied into a slot of a persistently mapped staging
+ * ring and from there into the destination with glCopyBufferSubData, and a fence per slot says
+ * when the GPU is done with it. Without it each chunk goes straight in with glBufferSubData. In
+ * both cases neither the caller nor the driver needs a second copy of the whole upload, and a
+ * partial update of a mesh that changes every frame costs only the bytes that changed.
+ *
+ * Destinations are bound to GL_COPY_WRITE_BUFFER, so uploads leave the array, element and VAO
+ * bindings alone.
+ */
+class UploadManager
+{
+public:
+    UploadManager() = default;
+    UploadManager(const UploadManager &) = delete;
+    UploadManager &operator=(const UploadManager &) = delete;
+    ~UploadManager();
+
+    /**
+     * @param chunkBytes Size of one copy and one ring slot.
+     * @param chunks Slots in the staging ring.
+     * @param allowPersistent Use the persistently mapped ring when the driver supports it.
+     * @return false if the staging ring could not be mapped.
+     */
+    bool create(size_t chunkBytes = kUploadChunkBytes, unsigned int chunks = kUploadRingChunks, bool allowPersistent = true);
+
+    /**
+     * @brief Creates a buffer of the given size and streams data into it.
+     *
+     * @param data Contents, or nullptr to leave the buffer uninitialized.
+     * @param dynamic The buffer will be updated often; a usage hint for the driver.
+     * @return The buffer object.
+     */
+    unsigned int createBuffer(const void *data, size_t size, bool dynamic = false);
+
+    /**
+     * @brief Copies size bytes into the buffer at offset, one chunk at a time. data only has to
+     * stay alive until the call returns.
+     */
+    void upload(unsigned int buffer, size_t offset, const void *data, size_t size);
+
+    void destroy();
+
+    UploadStats stats() const { return counters; }
+
+private:
+    void copyChunk(size_t offset, const unsigned char *data, size_t size);
+
+    unsigned int staging = 0;
+    size_t chunkSize = kUploadChunkBytes;
+    unsigned int slot = 0;
+    unsigned char *mapped = nullptr;
+    std::vector<GLsync> fences; // One per slot
+    UploadStats counters;
+};
@@ -0,0 +1,153 @@
+#include "VertexQuantization.h"
+
+#include <algorithm>
+#include <cmath>
+#include <iostream>
+
+namespace
+{
+    inline float signNotZero(float value)
+    {
+        return value >= 0.0f ? 1.0f : -1.0f;
+    }
+
+    inline int16_t toSnorm16(float value)
+    {
+        return static_cast<int16_t>(std::lround(glm::clamp(value, -1.0f, 1.0f) * 32767.0f));
+    }
+
+    inline float fromSnorm16(int16_t value)
+    {
+        return std::max(static_cast<float>(value) / 32767.0f, -1.0f);
+    }
+
+    inline uint32_t toSnorm10(float value)
+    {
+        return static_cast<uint32_t>(std::lround(glm::clamp(value, -1.0f, 1.0f) * 511.0f)) & 0x3FFu;
+    }
+
+    inline float fromSnorm10(uint32_t bits)
+    {
+        // Sign-extend the 10-bit field
+        int value = static_cast<int>(bits << 22) >> 22;
+        return std::max(static_cast<float>(value) / 511.0f, -1.0f);
+    }
+
+    uint32_t encodeNormal(const glm::vec3 &normal, NormalEncoding encoding)
+    {
+        if (encoding == NormalEncoding::Packed1010102)
+        {
+            return toSnorm10(normal.x) | (toSnorm10(normal.y) << 10) | (toSnorm10(normal.z) << 20);
+        }
+
+        // Octahedral: project onto the octahedron, then fold the lower half over the upper one
+        float l1 = std::fabs(normal.x) + std::fabs(normal.y) + std::fabs(normal.z);
+        float x = l1 > 0.0f ? normal.x / l1 : 0.0f;
+        float y = l1 > 0.0f ? normal.y / l1 : 0.0f;
+        if (l1 > 0.0f && normal.z < 0.0f)
+        {
+            float foldedX = (1.0f - std::fabs(y)) * signNotZero(x);
+            float foldedY = (1.0f - std::fabs(x)) * signNotZero(y);
+            x = foldedX;
+            y = foldedY;
+        }
+        return static_cast<uint16_t>(toSnorm16(x)) | (static_cast<uint32_t>(static_cast<uint16_t>(toSnorm16(y))) << 16);
+    }
+
+    glm::vec3 decodeNormal(uint32_t packed, NormalEncoding encoding)
+    {
+        glm::vec3 normal;
+        if (encoding == NormalEncoding::Packed1010102)
+        {
+            normal = glm::vec3(fromSnorm10(packed), fromSnorm10(packed >> 10), fromSnorm10(packed >> 20));
+        }
+        else
+        {
+            float x = fromSnorm16(static_cast<int16_t>(packed & 0xFFFFu));
+            float y = fromSnorm16(static_cast<int16_t>(packed >> 16));
+            normal = glm::vec3(x, y, 1.0f - std::fabs(x) - std::fabs(y));
+            if (normal.z < 0.0f)
+            {
+                normal.x = (1.0f - std::fabs(y)) * signNotZero(x);
+                normal.y = (1.0f - std::fabs(x)) * signNotZero(y);
+            }
+        }
+        float length = glm::length(normal);
+        return length > 0.0f ? normal / length : normal;
+    }
+}
+
+void quantizeMesh(const Vertex *vertices, size_t vertexCount, NormalEncoding encoding, QuantizedMesh &out,
+                  QuantizationStats *stats)
+{
+    glm::vec3 minimum(0.0f), maximum(0.0f);
+    if (vertexCount > 0)
+    {
+        minimum = maximum = vertices[0].Position;
+    }
+    for (size_t v = 1; v < vertexCount; ++v)
+    {
+        minimum = glm::min(minimum, vertices[v].Position);
+        maximum = glm::max(maximum, vertices[v].Position);
+    }
+
+    out.encoding = encoding;
+    out.positionBias = minimum;
+    out.positionScale = maximum - minimum;
+    out.vertices.resize(vertexCount);
+
+    for (size_t v = 0; v < vertexCount; ++v)
+    {
+        PackedVertex &packed = out.vertices[v];
+        for (int axis = 0; axis < 3; ++axis)
+        {
+            float extent = out.positionScale[axis];
+            float t = extent > 0.0f ? (vertices[v].Position[axis] - minimum[axis]) / extent : 0.0f;
+            packed.Position[axis] = static_cast<uint16_t>(std::lround(glm::clamp(t, 0.0f, 1.0f) * 65535.0f));
+        }
+        packed.Position[3] = 0;
+        packed.Normal = encodeNormal(vertices[v].Normal, encoding);
+    }
+
+    if (stats)
+    {
+        *stats = QuantizationStats();
+        for (size_t v = 0; v < vertexCount; ++v)
+        {
+            Vertex decoded = dequantizeVertex(out.vertices[v], out);
+            glm::vec3 delta = glm::abs(decoded.Position - vertices[v].Position);
+            stats->maxPositionError = std::max(stats->maxPositionError, std::max(delta.x, std::max(delta.y, delta.z)));
+
+            // Missing normals are stored as zero and have no direction to compare
+            float length = glm::length(vertices[v].Normal);
+            if (length > 0.0f)
+            {
+                float cosine = glm::clamp(glm::dot(decoded.Normal, vertices[v].Normal / length), -1.0f, 1.0f);
+                stats->maxNormalErrorDegrees = std::max(stats->maxNormalErrorDegrees, glm::degrees(std::acos(cosine)));
+            }
+        }
+        float largestExtent = std::max(out.positionScale.x, std::max(out.positionScale.y, out.positionScale.z));
+        stats->maxPositionErrorRatio = largestExtent > 0.0f ? stats->maxPositionError / largestExtent : 0.0f;
+        stats->floatBytes = vertexCount * sizeof(Vertex);
+        stats->packedBytes = vertexCount * sizeof(PackedVertex);
+    }
+}
+
+Vertex dequantizeVertex(const PackedVertex &vertex, const QuantizedMesh &mesh)
+{
+    Vertex decoded;
+    for (int axis = 0; axis < 3; ++axis)
+    {
+        decoded.Position[axis] = vertex.Position[axis] / 65535.0f * mesh.positionScale[axis] + mesh.positionBias[axis];
+    }
+    decoded.Normal = decodeNormal(vertex.Normal, mesh.encoding);
+    return decoded;
+}
+
+void printQuantizationStats(const std::string &name, NormalEncoding encoding, const QuantizationStats &stats)
+{
+    std::cout << name << " (" << (encoding == NormalEncoding::Octahedral16 ? "octahedral 2x16" : "10:10:10:2")
+              << " normals): max position error " << stats.maxPositionError << " (" << stats.maxPositionErrorRatio * 100.0f
+              << "% of extent), max normal error " << stats.maxNormalErrorDegrees << " deg, "
+              << stats.floatBytes / 1024 << " KB -> " << stats.packedBytes / 1024 << " KB\n";
+}
@@ -0,0 +1,69 @@
+#pragma once
+
+#include "Mesh.h"
+
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include <vector>
+
+/**
+ * @brief How PackedVertex::Normal is encoded.
+ */
+enum class NormalEncoding
+{
+    Octahedral16, // Two snorm16 octahedral coordinates, attribute 2 x GL_SHORT normalized
+    Packed1010102 // x, y, z as snorm10, attribute 4 x GL_INT_2_10_10_10_REV normalized
+};
+
+/**
+ * @brief 12-byte vertex: position quantized to 16 bits per axis against the mesh AABB, normal
+ * packed into 32 bits. The vertex shader dequantizes with position * scale + bias.
+ */
+struct PackedVertex
+{
+    uint16_t Position[4]; // x, y, z as unorm16; the fourth is padding for alignment
+    uint32_t Normal;
+};
+
+/**
+ * @brief Worst-case error of a quantized mesh and its size next to the float layout.
+ */
+struct QuantizationStats
+{
+    float maxPositionError = 0.0f;      // In model units
+    float maxPositionErrorRatio = 0.0f; // maxPositionError over the largest AABB extent
+    float maxNormalErrorDegrees = 0.0f;
+    size_t floatBytes = 0;
+    size_t packedBytes = 0;
+};
+
+struct QuantizedMesh
+{
+    std::vector<PackedVertex> vertices;
+    glm::vec3 positionScale = glm::vec3(1.0f); // AABB extent
+    glm::vec3 positionBias = glm::vec3(0.0f);  // AABB minimum
+    NormalEncoding encoding = NormalEncoding::Octahedral16;
+};
+
+/**
+ * @brief Packs float vertices and measures the error by decoding every vertex again.
+ *
+ * @param vertices Source vertices.
+ * @param vertexCount Number of source vertices.
+ * @param encoding Normal encoding to use.
+ * @param out Receives the packed vertices and the dequantization scale and bias.
+ * @param stats Optional, receives the error bounds and memory footprint.
+ */
+void quantizeMesh(const Vertex *vertices, size_t vertexCount, NormalEncoding encoding, QuantizedMesh &out,
+                  QuantizationStats *stats = nullptr);
+
+/**
+ * @brief Decodes one packed vertex on the CPU, exactly as the packed vertex shader does.
+ */
+Vertex dequantizeVertex(const PackedVertex &vertex, const QuantizedMesh &mesh);
+
+/**
+ * @brief Prints the error bounds and memory footprint for the named mesh to stdout.
+ */
+void printQuantizationStats(const std::string &name, NormalEncoding encoding, const QuantizationStats &stats);
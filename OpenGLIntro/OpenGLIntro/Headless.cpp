@@ -0,0 +1,339 @@
+#include "Headless.h"
+
+#include <algorithm>
+#include <cmath>
+#include <cstdlib>
+#include <cstring>
+#include <fstream>
+#include <iostream>
+#include <sstream>
+
+namespace
+{
+    // The real stdout while a HeadlessConsole sends std::cout to stderr
+    std::streambuf *reportBuffer = nullptr;
+
+    void setContextHints()
+    {
+        glfwWindowHint(GLFW_CONTEXT_VERSION_MAJOR, 3);
+        glfwWindowHint(GLFW_CONTEXT_VERSION_MINOR, 3);
+        glfwWindowHint(GLFW_OPENGL_PROFILE, GLFW_OPENGL_CORE_PROFILE);
+        glfwWindowHint(GLFW_VISIBLE, GLFW_FALSE);
+    }
+
+    /**
+     * @brief Writes text as a JSON string literal.
+     */
+    void writeJsonString(std::ostream &out, const char *text)
+    {
+        out << '"';
+        for (const char *c = text; *c; ++c)
+        {
+            if (*c == '"' || *c == '\\')
+            {
+                out << '\\' << *c;
+            }
+            else if (static_cast<unsigned char>(*c) >= 0x20)
+            {
+                out << *c;
+            }
+        }
+        out << '"';
+    }
+
+    void writeJsonStats(std::ostream &out, const FrameStats &stats)
+    {
+        out << "{\"mean\":" << stats.mean << ",\"p50\":" << stats.p50 << ",\"p95\":" << stats.p95
+            << ",\"p99\":" << stats.p99 << ",\"max\":" << stats.max << "}";
+    }
+
+    void writeJsonArray(std::ostream &out, const std::vector<double> &values)
+    {
+        out << '[';
+        for (size_t i = 0; i < values.size(); ++i)
+        {
+            out << (i ? "," : "") << values[i];
+        }
+        out << ']';
+    }
+}
+
+HeadlessOptions parseHeadlessOptions(int argc, char **argv)
+{
+    HeadlessOptions options;
+    for (int i = 1; i < argc; ++i)
+    {
+        const bool hasValue = i + 1 < argc;
+        if (std::strcmp(argv[i], "--headless") == 0)
+        {
+            options.enabled = true;
+        }
+        else if (std::strcmp(argv[i], "--frames") == 0 && hasValue)
+        {
+            options.frames = std::max(1, std::atoi(argv[++i]));
+        }
+        else if (std::strcmp(argv[i], "--warmup") == 0 && hasValue)
+        {
+            options.warmupFrames = std::max(0, std::atoi(argv[++i]));
+        }
+        else if (std::strcmp(argv[i], "--json") == 0 && hasValue)
+        {
+            options.jsonPath = argv[++i];
+        }
+        else if (std::strcmp(argv[i], "--max-p95-ms") == 0 && hasValue)
+        {
+            options.maxP95Milliseconds = std::atof(argv[++i]);
+        }
+    }
+    return options;
+}
+
+GLFWwindow *createOffscreenContext(int width, int height, const char *title)
+{
+    GLFWwindow *window = nullptr;
+    if (glfwInit())
+    {
+        setContextHints();
+        window = glfwCreateWindow(width, height, title, NULL, NULL);
+        if (!window)
+        {
+            glfwTerminate();
+        }
+    }
+#ifdef GLFW_PLATFORM_NULL
+    // No display: GLFW's null platform has no windows to show, only an OSMesa context
+    if (!window)
+    {
+        glfwInitHint(GLFW_PLATFORM, GLFW_PLATFORM_NULL);
+        if (glfwInit())
+        {
+            setContextHints();
+            glfwWindowHint(GLFW_CONTEXT_CREATION_API, GLFW_OSMESA_CONTEXT_API);
+            window = glfwCreateWindow(width, height, title, NULL, NULL);
+            if (!window)
+            {
+                glfwTerminate();
+            }
+        }
+    }
+#endif
+    if (!window)
+    {
+        std::cerr << "Failed to create an offscreen OpenGL context" << std::endl;
+        return nullptr;
+    }
+    glfwMakeContextCurrent(window);
+
+    GLenum status = glewInit();
+#ifdef GLEW_ERROR_NO_GLX_DISPLAY
+    // A GLX build of GLEW still loads the core entry points on an OSMesa context
+    if (status == GLEW_ERROR_NO_GLX_DISPLAY)
+    {
+        status = GLEW_OK;
+    }
+#endif
+    if (status != GLEW_OK)
+    {
+        std::cerr << "Failed to initialize GLEW" << std::endl;
+        glfwDestroyWindow(window);
+        glfwTerminate();
+        return nullptr;
+    }
+    return window;
+}
+
+OffscreenTarget::~OffscreenTarget()
+{
+    destroy();
+}
+
+bool OffscreenTarget::create(int width, int height)
+{
+    glGenRenderbuffers(2, renderbuffers);
+    glBindRenderbuffer(GL_RENDERBUFFER, renderbuffers[0]);
+    glRenderbufferStorage(GL_RENDERBUFFER, GL_RGBA8, width, height);
+    glBindRenderbuffer(GL_RENDERBUFFER, renderbuffers[1]);
+    glRenderbufferStorage(GL_RENDERBUFFER, GL_DEPTH24_STENCIL8, width, height);
+    glBindRenderbuffer(GL_RENDERBUFFER, 0);
+
+    glGenFramebuffers(1, &framebuffer);
+    glBindFramebuffer(GL_FRAMEBUFFER, framebuffer);
+    glFramebufferRenderbuffer(GL_FRAMEBUFFER, GL_COLOR_ATTACHMENT0, GL_RENDERBUFFER, renderbuffers[0]);
+    glFramebufferRenderbuffer(GL_FRAMEBUFFER, GL_DEPTH_STENCIL_ATTACHMENT, GL_RENDERBUFFER, renderbuffers[1]);
+    if (glCheckFramebufferStatus(GL_FRAMEBUFFER) != GL_FRAMEBUFFER_COMPLETE)
+    {
+        std::cerr << "ERROR: offscreen framebuffer is incomplete" << std::endl;
+        destroy();
+        return false;
+    }
+    glViewport(0, 0, width, height);
+    return true;
+}
+
+void OffscreenTarget::destroy()
+{
+    if (framebuffer)
+    {
+        glBindFramebuffer(GL_FRAMEBUFFER, 0);
+        glDeleteFramebuffers(1, &framebuffer);
+        framebuffer = 0;
+    }
+    if (renderbuffers[0])
+    {
+        glDeleteRenderbuffers(2, renderbuffers);
+        renderbuffers[0] = renderbuffers[1] = 0;
+    }
+}
+
+FrameStats computeFrameStats(std::vector<double> milliseconds)
+{
+    FrameStats stats;
+    if (milliseconds.empty())
+    {
+        return stats;
+    }
+    std::sort(milliseconds.begin(), milliseconds.end());
+    auto percentile = [&milliseconds](double p)
+    {
+        size_t rank = static_cast<size_t>(std::ceil(p * milliseconds.size()));
+        return milliseconds[std::min(milliseconds.size(), std::max<size_t>(1, rank)) - 1];
+    };
+    double total = 0.0;
+    for (double value : milliseconds)
+    {
+        total += value;
+    }
+    stats.mean = total / milliseconds.size();
+    stats.p50 = percentile(0.50);
+    stats.p95 = percentile(0.95);
+    stats.p99 = percentile(0.99);
+    stats.max = milliseconds.back();
+    return stats;
+}
+
+FrameTimer::FrameTimer(int frames, int warmupFrames)
+    : queries(static_cast<size_t>(std::max(0, frames))), warmup(static_cast<size_t>(std::max(0, warmupFrames)))
+{
+    cpuMilliseconds.reserve(queries.size());
+    if (!queries.empty())
+    {
+        glGenQueries(static_cast<GLsizei>(queries.size()), queries.data());
+    }
+}
+
+FrameTimer::~FrameTimer()
+{
+    destroy();
+}
+
+void FrameTimer::destroy()
+{
+    if (!queries.empty())
+    {
+        glDeleteQueries(static_cast<GLsizei>(queries.size()), queries.data());
+        queries.clear();
+    }
+}
+
+void FrameTimer::beginFrame()
+{
+    frameStart = std::chrono::steady_clock::now();
+    if (frame >= warmup && frame - warmup < queries.size())
+    {
+        glBeginQuery(GL_TIME_ELAPSED, queries[frame - warmup]);
+    }
+}
+
+void FrameTimer::endFrame()
+{
+    const bool measured = frame >= warmup && frame - warmup < queries.size();
+    if (measured)
+    {
+        glEndQuery(GL_TIME_ELAPSED);
+    }
+    // Nothing is presented offscreen, so flush in place of the buffer swap
+    glFlush();
+    if (measured)
+    {
+        std::chrono::duration<double, std::milli> elapsed = std::chrono::steady_clock::now() - frameStart;
+        cpuMilliseconds.push_back(elapsed.count());
+    }
+    ++frame;
+}
+
+void FrameTimer::finish()
+{
+    glFinish();
+    const size_t measured = cpuMilliseconds.size();
+    gpuMilliseconds.resize(measured);
+    for (size_t i = 0; i < measured; ++i)
+    {
+        GLuint64 nanoseconds = 0;
+        glGetQueryObjectui64v(queries[i], GL_QUERY_RESULT, &nanoseconds);
+        gpuMilliseconds[i] = nanoseconds / 1.0e6;
+    }
+}
+
+void FrameTimer::writeJson(std::ostream &out, const char *label) const
+{
+    const GLubyte *renderer = glGetString(GL_RENDERER);
+    out << "{\"label\":";
+    writeJsonString(out, label);
+    out << ",\"frames\":" << cpuMilliseconds.size() << ",\"warmup_frames\":" << warmup << ",\"renderer\":";
+    writeJsonString(out, renderer ? reinterpret_cast<const char *>(renderer) : "unknown");
+    out << ",\"cpu_ms\":";
+    writeJsonStats(out, cpuStats());
+    out << ",\"gpu_ms\":";
+    writeJsonStats(out, gpuStats());
+    out << ",\"cpu_frame_ms\":";
+    writeJsonArray(out, cpuMilliseconds);
+    out << ",\"gpu_frame_ms\":";
+    writeJsonArray(out, gpuMilliseconds);
+    out << "}";
+}
+
+HeadlessConsole::HeadlessConsole(const HeadlessOptions &options)
+{
+    if (options.enabled)
+    {
+        stdoutBuffer = std::cout.rdbuf(std::cerr.rdbuf());
+        reportBuffer = stdoutBuffer;
+    }
+}
+
+HeadlessConsole::~HeadlessConsole()
+{
+    if (stdoutBuffer)
+    {
+        std::cout.rdbuf(stdoutBuffer);
+        reportBuffer = nullptr;
+    }
+}
+
+int reportHeadlessRun(const FrameTimer &timer, const HeadlessOptions &options, const char *label)
+{
+    std::ostringstream json;
+    timer.writeJson(json, label);
+    std::ostream report(reportBuffer ? reportBuffer : std::cout.rdbuf());
+    report << json.str() << std::endl;
+
+    if (options.jsonPath)
+    {
+        std::ofstream file(options.jsonPath);
+        file << json.str() << "\n";
+        if (!file)
+        {
+            std::cerr << "Failed to write " << options.jsonPath << std::endl;
+            return 1;
+        }
+    }
+
+    const double p95 = timer.cpuStats().p95;
+    if (options.maxP95Milliseconds > 0.0 && p95 > options.maxP95Milliseconds)
+    {
+        std::cerr << "95th percentile CPU frame time " << p95 << " ms exceeds the " << options.maxP95Milliseconds
+                  << " ms limit" << std::endl;
+        return 1;
+    }
+    return 0;
+}
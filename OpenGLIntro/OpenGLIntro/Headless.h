@@ -0,0 +1,173 @@
+#pragma once
+
+#include <GL/glew.h>
+#include <GLFW/glfw3.h>
+
+#include <chrono>
+#include <ostream>
+#include <vector>
+
+/**
+ * @brief Command line settings for a headless run.
+ *
+ *   --headless             Render offscreen with scripted input instead of opening a window
+ *   --frames N             Frames to measure (default 300)
+ *   --warmup N             Frames rendered first and left out of the statistics (default 10)
+ *   --json <file>          Also write the timing report to a file
+ *   --max-p95-ms X         Exit with an error when the 95th percentile CPU frame time exceeds X
+ *
+ * In a headless run stdout carries the JSON report and nothing else; see HeadlessConsole.
+ */
+struct HeadlessOptions
+{
+    bool enabled = false;
+    int frames = 300;
+    int warmupFrames = 10; // Shader compilation and first uploads land here
+    const char *jsonPath = nullptr;
+    double maxP95Milliseconds = 0.0; // 0 disables the check
+};
+
+/**
+ * @brief Reads the headless flags from the command line.
+ *
+ * @param argc Argument count from main.
+ * @param argv Argument vector from main.
+ * @return The options; enabled stays false unless --headless was passed.
+ */
+HeadlessOptions parseHeadlessOptions(int argc, char **argv);
+
+/**
+ * @brief Keeps stdout free for the JSON report of a headless run: while it lives, everything
+ * else written to std::cout goes to stderr. reportHeadlessRun still writes to stdout. Does
+ * nothing when the run is not headless.
+ */
+class HeadlessConsole
+{
+public:
+    explicit HeadlessConsole(const HeadlessOptions &options);
+    HeadlessConsole(const HeadlessConsole &) = delete;
+    HeadlessConsole &operator=(const HeadlessConsole &) = delete;
+    ~HeadlessConsole();
+
+private:
+    std::streambuf *stdoutBuffer = nullptr;
+};
+
+/**
+ * @brief Initializes GLFW and creates an invisible window whose only purpose is the context.
+ *
+ * On a machine with a display the window is simply hidden. Without one, and with GLFW 3.4 or
+ * later, it falls back to GLFW's null platform with an OSMesa context (Mesa's llvmpipe). The
+ * context is made current and GLEW is initialized.
+ *
+ * @param width Framebuffer width.
+ * @param height Framebuffer height.
+ * @param title Window title, never shown.
+ * @return The window, or nullptr with GLFW terminated if no context could be created.
+ */
+GLFWwindow *createOffscreenContext(int width, int height, const char *title);
+
+/**
+ * @brief A framebuffer object with color and depth renderbuffers that frames are drawn into
+ * instead of the default framebuffer.
+ */
+class OffscreenTarget
+{
+public:
+    OffscreenTarget() = default;
+    OffscreenTarget(const OffscreenTarget &) = delete;
+    OffscreenTarget &operator=(const OffscreenTarget &) = delete;
+    ~OffscreenTarget();
+
+    /**
+     * @brief Creates the framebuffer and leaves it bound for drawing.
+     *
+     * @return false if the framebuffer is incomplete.
+     */
+    bool create(int width, int height);
+
+    void destroy();
+
+private:
+    unsigned int framebuffer = 0;
+    unsigned int renderbuffers[2] = {}; // color, depth
+};
+
+/**
+ * @brief Percentiles of a set of frame times, in milliseconds.
+ */
+struct FrameStats
+{
+    double mean = 0.0;
+    double p50 = 0.0;
+    double p95 = 0.0;
+    double p99 = 0.0;
+    double max = 0.0;
+};
+
+/**
+ * @brief Computes FrameStats with the nearest-rank method.
+ */
+FrameStats computeFrameStats(std::vector<double> milliseconds);
+
+/**
+ * @brief Records CPU and GPU time for a fixed number of frames.
+ *
+ * CPU time is the wall time between beginFrame and endFrame. GPU time comes from a
+ * GL_TIME_ELAPSED query per frame; results are only read in finish(), so measuring never makes
+ * the CPU wait for the GPU mid-run. The first warmupFrames frames are not recorded.
+ */
+class FrameTimer
+{
+public:
+    FrameTimer(int frames, int warmupFrames);
+    FrameTimer(const FrameTimer &) = delete;
+    FrameTimer &operator=(const FrameTimer &) = delete;
+    ~FrameTimer();
+
+    void beginFrame();
+    void endFrame();
+
+    /**
+     * @brief True once every warm-up and measured frame has ended.
+     */
+    bool done() const { return frame >= warmup + queries.size(); }
+
+    /**
+     * @brief Waits for the GPU and collects the query results.
+     */
+    void finish();
+
+    /**
+     * @brief Writes the report as a single line of JSON: frame count, renderer, CPU and GPU
+     * statistics and the per-frame times.
+     *
+     * @param out Stream to write to.
+     * @param label Name of the program or scene being measured.
+     */
+    void writeJson(std::ostream &out, const char *label) const;
+
+    /**
+     * @brief Deletes the queries; call while the context is still current.
+     */
+    void destroy();
+
+    FrameStats cpuStats() const { return computeFrameStats(cpuMilliseconds); }
+    FrameStats gpuStats() const { return computeFrameStats(gpuMilliseconds); }
+
+private:
+    std::vector<unsigned int> queries;
+    std::vector<double> cpuMilliseconds;
+    std::vector<double> gpuMilliseconds;
+    std::chrono::steady_clock::time_point frameStart;
+    size_t warmup = 0;
+    size_t frame = 0; // Frames ended so far, warm-up included
+};
+
+/**
+ * @brief Prints the report to stdout, past any HeadlessConsole, writes it to options.jsonPath if given, and applies the
+ * --max-p95-ms check.
+ *
+ * @return 0 if the run passed, otherwise 1.
+ */
+int reportHeadlessRun(const FrameTimer &timer, const HeadlessOptions &options, const char *label);
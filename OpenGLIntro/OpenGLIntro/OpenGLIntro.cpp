@@ -7,6 +7,12 @@
 #include <glm/glm.hpp>
 #include <glm/gtc/matrix_transform.hpp>
 #include <glm/gtc/type_ptr.hpp>
+#include <cmath>
+#include <cstring>
+
+#include "Headless.h"
+#include "Profiler.h"
+#include "ShaderCache.h"
 
 // Define Vertex and Fragment Shader
 const char* vertexShaderSource = R"glsl(
@@ -33,62 +39,7 @@ float verticesTriangle[] = {
     0.0f, 0.5f, 0.0f
 };
 
-unsigned int vertexShader, fragmentShader, shaderProgram;
-
-/**
- * @brief Compiles the vertex and fragment shaders and links them into a shader program.
- */
-void compileShaders()
-{
-    // Vertex shader
-    vertexShader = glCreateShader(GL_VERTEX_SHADER);
-    glShaderSource(vertexShader, 1, &vertexShaderSource, NULL);
-    glCompileShader(vertexShader);
-
-    // Check for vertex shader compilation errors
-    int success;
-    char infoLog[512];
-    glGetShaderiv(vertexShader, GL_COMPILE_STATUS, &success);
-    if (!success)
-    {
-        glGetShaderInfoLog(vertexShader, 512, NULL, infoLog);
-        std::cerr << "ERROR: vertex compliation failed\n"
-            << infoLog << std::endl;
-    }
-
-    // Fragment shader
-    fragmentShader = glCreateShader(GL_FRAGMENT_SHADER);
-    glShaderSource(fragmentShader, 1, &fragmentShaderSource, NULL);
-    glCompileShader(fragmentShader);
-
-    // Check for fragment shader compilation errors
-    glGetShaderiv(fragmentShader, GL_COMPILE_STATUS, &success);
-    if (!success)
-    {
-        glGetShaderInfoLog(fragmentShader, 512, NULL, infoLog);
-        std::cerr << "ERROR: shader compliation failed\n"
-            << infoLog << std::endl;
-    }
-
-    // Link shaders into a program
-    shaderProgram = glCreateProgram();
-    glAttachShader(shaderProgram, vertexShader);
-    glAttachShader(shaderProgram, fragmentShader);
-    glLinkProgram(shaderProgram);
-
-    // Check for linking errors
-    glGetProgramiv(shaderProgram, GL_LINK_STATUS, &success);
-    if (!success)
-    {
-        glGetProgramInfoLog(shaderProgram, 512, NULL, infoLog);
-        std::cerr << "ERROR: shader program linking failed\n"
-            << infoLog << std::endl;
-    }
-
-    // Clean up shaders as they're linked into our program now
-    glDeleteShader(vertexShader);
-    glDeleteShader(fragmentShader);
-}
+unsigned int shaderProgram;
 
 unsigned int VBO[2], VAO[2], EBO;
 
@@ -97,6 +48,7 @@ unsigned int VBO[2], VAO[2], EBO;
  */
 void setupBuffers()
 {
+    PROFILE_FUNCTION();
     // Setup the VAO, VBO, and EBO
     glGenVertexArrays(2, VAO);
     glGenBuffers(2, VBO);
@@ -161,40 +113,104 @@ void processInput(GLFWwindow* window, float& xOffset, float& yOffset, float& ang
     }
 }
 
+/**
+ * @brief Replaces processInput in headless runs: moves, spins and scales the triangle along a
+ * fixed path so every run renders the same frames.
+ *
+ * @param frame Index of the frame being rendered.
+ */
+void scriptedInput(int frame, float& xOffset, float& yOffset, float& angle, float& scale)
+{
+    const float t = frame / 60.0f;
+    xOffset = 0.3f * std::sin(t);
+    yOffset = 0.3f * std::cos(t);
+    angle = frame * 3.0f;
+    scale = 1.0f + 0.5f * std::sin(t * 0.5f);
+}
+
 /**
  * @brief Main function where program execution begins.
  *
+ * --headless [--frames N] [--warmup N] [--json file] [--max-p95-ms X] renders offscreen with scripted input
+ * and prints frame time statistics as JSON.
+ *
  * @return int Returns 0 if the program executes successfully, otherwise returns -1.
  */
-int main()
+int main(int argc, char** argv)
 {
-    if (!glfwInit())
+    // --profile <trace.json> records the PROFILE_ZONE markers and writes them as a Chrome trace
+    const char* profilePath = nullptr;
+    for (int i = 1; i + 1 < argc; ++i)
     {
-        std::cerr << "Failed to initialize GLFW" << std::endl;
-        return -1;
+        if (std::strcmp(argv[i], "--profile") == 0)
+        {
+            profilePath = argv[i + 1];
+        }
     }
-
-    GLFWwindow* window = glfwCreateWindow(800, 600, "OpenGL Triangle", NULL, NULL);
-
-    if (!window)
+    if (profilePath && PROFILE_ZONES)
     {
-        std::cerr << "Failed to create GLFW window" << std::endl;
-        glfwTerminate();
-        return -1;
+        profilerStart();
+        PROFILE_THREAD_NAME("main");
+    }
+    else if (profilePath)
+    {
+        std::cerr << "--profile needs a build with PROFILE_ZONES=1" << std::endl;
     }
 
-    glfwMakeContextCurrent(window);
+    const HeadlessOptions headless = parseHeadlessOptions(argc, argv);
+    const HeadlessConsole console(headless);
+    GLFWwindow* window = nullptr;
+    if (headless.enabled)
+    {
+        window = createOffscreenContext(800, 600, "OpenGL Triangle");
+        if (!window)
+        {
+            return -1;
+        }
+    }
+    else
+    {
+        if (!glfwInit())
+        {
+            std::cerr << "Failed to initialize GLFW" << std::endl;
+            return -1;
+        }
+
+        window = glfwCreateWindow(800, 600, "OpenGL Triangle", NULL, NULL);
+
+        if (!window)
+        {
+            std::cerr << "Failed to create GLFW window" << std::endl;
+            glfwTerminate();
+            return -1;
+        }
+
+        glfwMakeContextCurrent(window);
+
+        if (glewInit() != GLEW_OK)
+        {
+            std::cerr << "Failed to initialize GLEW" << std::endl;
+            return -1;
+        }
+    }
 
-    if (glewInit() != GLEW_OK)
+    OffscreenTarget offscreen;
+    if (headless.enabled && !offscreen.create(800, 600))
     {
-        std::cerr << "Failed to initialize GLEW" << std::endl;
         return -1;
     }
 
-    // Setup Buffers
-    compileShaders();
+    // Setup Buffers; the driver compiles the shaders meanwhile, unless an earlier run cached them
+    ShaderCache shaderCache;
+    const size_t triangleShader = shaderCache.request("triangle", vertexShaderSource, fragmentShaderSource);
     setupBuffers();
 
+    shaderProgram = shaderCache.program(triangleShader);
+    printShaderCacheStats(shaderCache.stats());
+    if (!shaderProgram)
+    {
+        return -1;
+    }
     glUseProgram(shaderProgram);
     int transformLoc = glGetUniformLocation(shaderProgram, "transform");
 
@@ -203,45 +219,107 @@ int main()
     float angle = 0.0f;
     float scale = 1.0f;
 
-    while (!glfwWindowShouldClose(window))
+    FrameTimer frameTimer(headless.enabled ? headless.frames : 0, headless.warmupFrames);
+    int frame = 0;
+
+    while (headless.enabled ? !frameTimer.done() : !glfwWindowShouldClose(window))
     {
+        PROFILE_ZONE("frame");
+        if (headless.enabled)
+        {
+            frameTimer.beginFrame();
+        }
+
         // Render commands
         glClearColor(0.2f, 0.3f, 0.3f, 1.0f);
         glClear(GL_COLOR_BUFFER_BIT);
 
         // Update transformation values
-        processInput(window, xOffset, yOffset, angle, scale);
+        {
+            PROFILE_ZONE("input");
+            if (headless.enabled)
+            {
+                scriptedInput(frame, xOffset, yOffset, angle, scale);
+            }
+            else
+            {
+                processInput(window, xOffset, yOffset, angle, scale);
+            }
+        }
 
         glm::mat4 transform = glm::mat4(1.0f);
-
-        // Apply translation
-        transform = glm::translate(transform, glm::vec3(xOffset, yOffset, 0.0f));
-
-        // Apply rotation
-        transform = glm::rotate(transform, glm::radians(angle), glm::vec3(0.0f, 0.0f, 1.0f));
-
-        // Apply scaling
-        transform = glm::scale(transform, glm::vec3(scale, scale, scale));
-
-        glUniformMatrix4fv(transformLoc, 1, GL_FALSE, glm::value_ptr(transform));
-
-        glUseProgram(shaderProgram);
-        glBindVertexArray(VAO[0]);
-        glDrawArrays(GL_TRIANGLES, 0, 3);
-
-        glfwSwapBuffers(window);
+        {
+            PROFILE_ZONE("matrices");
+
+            // Apply translation
+            transform = glm::translate(transform, glm::vec3(xOffset, yOffset, 0.0f));
+
+            // Apply rotation
+            transform = glm::rotate(transform, glm::radians(angle), glm::vec3(0.0f, 0.0f, 1.0f));
+
+            // Apply scaling
+            transform = glm::scale(transform, glm::vec3(scale, scale, scale));
+        }
+
+        {
+            PROFILE_ZONE("uniforms");
+            glUniformMatrix4fv(transformLoc, 1, GL_FALSE, glm::value_ptr(transform));
+        }
+
+        {
+            PROFILE_ZONE("draw");
+            glUseProgram(shaderProgram);
+            glBindVertexArray(VAO[0]);
+            glDrawArrays(GL_TRIANGLES, 0, 3);
+        }
+
+        ++frame;
+        if (headless.enabled)
+        {
+            PROFILE_ZONE("end frame");
+            frameTimer.endFrame();
+            continue;
+        }
+
+        {
+            PROFILE_ZONE("swap");
+            glfwSwapBuffers(window);
+        }
+        PROFILE_ZONE("poll events");
         glfwPollEvents();
     }
+    if (profilePath && PROFILE_ZONES)
+    {
+        profilerStop();
+        const long long zones = profilerWriteTrace(profilePath);
+        if (zones < 0)
+        {
+            std::cerr << "Failed to write " << profilePath << std::endl;
+        }
+        else
+        {
+            std::cout << "Profile: " << zones << " zones written to " << profilePath << std::endl;
+        }
+    }
+
+    int status = 0;
+    if (headless.enabled)
+    {
+        frameTimer.finish();
+        status = reportHeadlessRun(frameTimer, headless, "OpenGLIntro");
+    }
 
     // Cleanup
+    frameTimer.destroy();
+    offscreen.destroy();
     glDeleteVertexArrays(2, VAO);
     glDeleteBuffers(2, VBO);
     glDeleteBuffers(1, &EBO);
-    glDeleteProgram(shaderProgram);
+    shaderCache.destroy();
 
     glfwDestroyWindow(window);
     glfwTerminate();
-    return 0;
+    return status;
 }
 
 
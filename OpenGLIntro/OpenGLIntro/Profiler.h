@@ -0,0 +1,123 @@
+#pragma once
+
+#include <atomic>
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
+
+// PROFILE_ZONES 1 compiles the PROFILE_ZONE markers in and 0 compiles them out to nothing.
+// Release builds (NDEBUG) leave them out unless the project sets PROFILE_ZONES=1.
+#ifndef PROFILE_ZONES
+#ifdef NDEBUG
+#define PROFILE_ZONES 0
+#else
+#define PROFILE_ZONES 1
+#endif
+#endif
+
+#if defined(_M_X64) || defined(__x86_64__)
+#define PROFILE_RDTSC 1
+#if defined(_MSC_VER)
+#include <intrin.h>
+#else
+#include <x86intrin.h>
+#endif
+#endif
+
+// Zones one thread keeps before it drops new ones, about 24 MB
+constexpr size_t kProfileMaxZonesPerThread = 1 << 20;
+
+/**
+ * @brief Reads the timestamp counter, or steady_clock nanoseconds where there is none. The
+ * trace export converts either to microseconds.
+ */
+inline uint64_t profileTimestamp()
+{
+#ifdef PROFILE_RDTSC
+    return __rdtsc();
+#else
+    return static_cast<uint64_t>(std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::steady_clock::now().time_since_epoch()).count());
+#endif
+}
+
+/**
+ * @brief True between profilerStart() and profilerStop(). Zones opened while it is false record
+ * nothing, so a build with the zones compiled in costs one load and branch per zone until
+ * profiling starts.
+ */
+inline std::atomic<bool> &profilerActive()
+{
+    static std::atomic<bool> active{false};
+    return active;
+}
+
+/**
+ * @brief Starts recording zones on every thread.
+ */
+void profilerStart();
+
+/**
+ * @brief Stops recording; zones already recorded are kept for profilerWriteTrace.
+ */
+void profilerStop();
+
+/**
+ * @brief Names the calling thread in the trace, such as "main" or "update". The name must be a
+ * string literal or otherwise outlive the trace export.
+ */
+void profilerSetThreadName(const char *name);
+
+/**
+ * @brief Adds one finished zone to the calling thread's buffer.
+ */
+void profilerRecord(const char *name, uint64_t begin, uint64_t end);
+
+/**
+ * @brief Writes every recorded zone as Chrome trace-event JSON, which chrome://tracing and
+ * Perfetto open directly. Call it once the other threads have stopped recording.
+ *
+ * @return Number of zones written, or -1 if the file could not be written.
+ */
+long long profilerWriteTrace(const char *path);
+
+/**
+ * @brief Times the scope it lives in, from construction to destruction.
+ */
+class ProfileZone
+{
+public:
+    explicit ProfileZone(const char *name)
+        : name(name), active(profilerActive().load(std::memory_order_relaxed)), begin(active ? profileTimestamp() : 0)
+    {
+    }
+
+    ~ProfileZone()
+    {
+        if (active)
+        {
+            profilerRecord(name, begin, profileTimestamp());
+        }
+    }
+
+    ProfileZone(const ProfileZone &) = delete;
+    ProfileZone &operator=(const ProfileZone &) = delete;
+
+private:
+    const char *name;
+    bool active;
+    uint64_t begin;
+};
+
+#define PROFILE_JOIN_INNER(a, b) a##b
+#define PROFILE_JOIN(a, b) PROFILE_JOIN_INNER(a, b)
+
+#if PROFILE_ZONES
+// Times the rest of the enclosing scope under the given name, which must be a string literal
+#define PROFILE_ZONE(name) ProfileZone PROFILE_JOIN(profileZone, __LINE__)(name)
+#define PROFILE_FUNCTION() PROFILE_ZONE(__func__)
+#define PROFILE_THREAD_NAME(name) profilerSetThreadName(name)
+#else
+#define PROFILE_ZONE(name) ((void)0)
+#define PROFILE_FUNCTION() ((void)0)
+#define PROFILE_THREAD_NAME(name) ((void)0)
+#endif
@@ -0,0 +1,124 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include <vector>
+
+/*
+ * Program binary cache, one file per program in kShaderCacheDirectory:
+ *
+ *   ShaderCacheHeader
+ *   program binary     binaryLength bytes from glGetProgramBinary
+ *
+ * Files are named after the program and the hash of its sources, so editing a shader writes a new
+ * file instead of overwriting the old one. The header also records a hash of the GL vendor,
+ * renderer and version strings; a driver update or a different GPU invalidates the file, and so
+ * does a binary the driver refuses, which drivers are allowed to do at any time.
+ */
+
+constexpr uint32_t kShaderCacheVersion = 1;
+
+// Relative to the working directory, like the mesh cache next to bottle.obj
+constexpr const char *kShaderCacheDirectory = "shadercache";
+
+struct ShaderCacheHeader
+{
+    char magic[8];         // "SHADERBN"
+    uint32_t version;      // kShaderCacheVersion
+    uint32_t binaryFormat; // As returned by glGetProgramBinary
+    uint64_t sourceHash;
+    uint64_t driverHash;
+    uint64_t binaryLength;
+    uint64_t binaryChecksum;
+};
+
+/**
+ * @brief Where a ShaderCache's programs came from and what they cost.
+ */
+struct ShaderCacheStats
+{
+    size_t loaded = 0;            // Programs restored from a binary
+    size_t compiled = 0;          // Programs compiled from source
+    size_t failed = 0;            // Programs that did not compile or link
+    size_t saved = 0;             // Binaries written
+    double milliseconds = 0.0;    // Spent inside request() and program()
+    bool binaries = false;        // The driver can save and restore programs
+    bool parallelCompile = false; // GL_KHR_parallel_shader_compile is in use
+};
+
+/**
+ * @brief Prints where the programs came from and the time spent on them on one line.
+ */
+void printShaderCacheStats(const ShaderCacheStats &stats);
+
+/**
+ * @brief Builds shader programs from GLSL sources, restoring them from program binaries saved by
+ * an earlier run when it can.
+ *
+ * request() only starts the work: it restores the binary, or hands the sources to the driver and
+ * returns without waiting for the compile or the link. With GL_KHR_parallel_shader_compile the
+ * driver compiles on its own threads, so requesting every program first and calling program()
+ * later overlaps the compiles with each other and with whatever the caller does in between.
+ * Without it the driver compiles when the status is first queried, which is the old behaviour.
+ *
+ * Every call needs the OpenGL context that the cache was created under to be current.
+ */
+class ShaderCache
+{
+public:
+    /**
+     * @param directory Where the program binaries are kept; created on the first save.
+     */
+    explicit ShaderCache(const std::string &directory = kShaderCacheDirectory);
+
+    /**
+     * @brief Starts building a program from a vertex and a fragment shader.
+     *
+     * @param name Used in the cache file name and error messages.
+     * @return A handle for program().
+     */
+    size_t request(const char *name, const char *vertexSource, const char *fragmentSource);
+
+    /**
+     * @brief True once program() would return without waiting on the driver. Without
+     * GL_KHR_parallel_shader_compile there is no way to ask, and it is always true.
+     */
+    bool isReady(size_t handle);
+
+    /**
+     * @brief The linked program, waiting for the driver if it is not done. A program compiled from
+     * source is saved to the cache the first time it is returned.
+     *
+     * @return The program object, or 0 if it failed to compile or link; the error was printed.
+     */
+    unsigned int program(size_t handle);
+
+    /**
+     * @brief Deletes every program the cache built.
+     */
+    void destroy();
+
+    ShaderCacheStats stats() const { return counters; }
+
+private:
+    struct Entry
+    {
+        std::string name;
+        uint64_t sourceHash = 0;
+        unsigned int program = 0;
+        unsigned int vertexShader = 0;
+        unsigned int fragmentShader = 0;
+        bool finished = false;
+    };
+
+    std::string cachePath(const Entry &entry) const;
+    bool loadBinary(Entry &entry);
+    void saveBinary(const Entry &entry);
+    bool finish(Entry &entry);
+
+    std::string directory;
+    uint64_t driverHash = 0;
+    std::vector<Entry> entries;
+    ShaderCacheStats counters;
+};